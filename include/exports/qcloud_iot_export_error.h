@@ -106,6 +106,7 @@ typedef enum {
     QCLOUD_ERR_GATEWAY_SESSION_TIMEOUT     = -223,  // Gateway sub-device session timeout
     QCLOUD_ERR_GATEWAY_SUBDEV_ONLINE       = -224,  // Gateway sub-device online
     QCLOUD_ERR_GATEWAY_SUBDEV_OFFLINE      = -225,  // Gateway sub-device offline
+    QCLOUD_ERR_GATEWAY_SUBDEV_BUSY         = -226,  // Gateway sub-device has a request waiting for result
 
     QCLOUD_ERR_TCP_SOCKET_FAILED   = -601,  // TLS TCP socket connect fail
     QCLOUD_ERR_TCP_UNKNOWN_HOST    = -602,  // TCP unknown host (DNS fail)
@@ -116,6 +117,7 @@ typedef enum {
     QCLOUD_ERR_TCP_WRITE_FAIL      = -607,  // TCP write error
     QCLOUD_ERR_TCP_PEER_SHUTDOWN   = -608,  // TCP server close connection
     QCLOUD_ERR_TCP_NOTHING_TO_READ = -609,  // TCP socket nothing to read
+    QCLOUD_ERR_TCP_CONNECTING      = -610,  // TCP connect in progress
 
     QCLOUD_ERR_SSL_INIT            = -701,  // TLS/SSL init fail
     QCLOUD_ERR_SSL_CERT            = -702,  // TLS/SSL certificate issue
@@ -126,6 +128,7 @@ typedef enum {
     QCLOUD_ERR_SSL_READ_TIMEOUT    = -707,  // TLS/SSL read timeout
     QCLOUD_ERR_SSL_READ            = -708,  // TLS/SSL read error
     QCLOUD_ERR_SSL_NOTHING_TO_READ = -709,  // TLS/SSL nothing to read
+    QCLOUD_ERR_SSL_CONNECTING      = -710,  // TLS/SSL handshake in progress
 
     QCLOUD_ERR_BIND_PARA_ERR        = -801,  // bind sub device param error
     QCLOUD_ERR_BIND_SUBDEV_ERR      = -802,  // sub device not exist or illegal
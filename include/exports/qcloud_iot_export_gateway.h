@@ -57,14 +57,15 @@ typedef void (*GatewayEventHandleFun)(void *client, void *context, void *msg);
 
 /* The structure of gateway init param */
 typedef struct {
-    MQTTInitParams        init_param;    /* MQTT params */
-    void *                event_context; /* the user context */
-    GatewayEventHandleFun event_handler; /* event handler for gateway user*/
+    MQTTInitParams        init_param;          /* MQTT params */
+    void *                event_context;       /* the user context */
+    GatewayEventHandleFun event_handler;       /* event handler for gateway user*/
+    uint32_t              max_subdev_sessions; /* max sub-devices online at once, 0 for no limit */
 } GatewayInitParam;
 
-#define DEFAULT_GATEWAY_INIT_PARAMS         \
-    {                                       \
-        DEFAULT_MQTTINIT_PARAMS, NULL, NULL \
+#define DEFAULT_GATEWAY_INIT_PARAMS            \
+    {                                          \
+        DEFAULT_MQTTINIT_PARAMS, NULL, NULL, 0 \
     }
 
 /**
@@ -105,6 +106,68 @@ int IOT_Gateway_Subdev_Online(void *client, GatewayParam *param);
  */
 int IOT_Gateway_Subdev_Offline(void *client, GatewayParam *param);
 
+/**
+ * @brief Define a callback to be invoked with the result of one sub-device in a batch online/offline request
+ *
+ * @param client        handle to gateway client
+ * @param product_id    sub-device product id
+ * @param device_name   sub-device name
+ * @param result        0 for success, result code from platform, or QCLOUD_ERR_GATEWAY_SESSION_TIMEOUT
+ *                      and other err code if the request failed on device side
+ * @param user_data     user data of the batch request
+ *
+ * @return none
+ */
+typedef void (*GatewaySubdevResultCallback)(void *client, const char *product_id, const char *device_name,
+                                            int result, void *user_data);
+
+/**
+ * @brief Make many sub-devices online without waiting for the results
+ *
+ * Sub-devices are packed into requests of up to GATEWAY_BATCH_MAX_DEVICES, fewer
+ * if their reply would not fit in the MQTT Rx buffer (rx_buf_size), and all
+ * requests are sent before returning. The result of each sub-device is
+ * delivered to callback when its reply is handled by IOT_Gateway_Yield() or the
+ * yield thread, or right away if the sub-device can not be sent. Timeout is only
+ * checked by IOT_Gateway_Yield() and IOT_Gateway_Subdev_Batch_Pending(), so call
+ * the latter now and then when the yield thread is used.
+ *
+ * @param client    handle to gateway client
+ * @param param     array of sub-device parameters, gateway info is taken from the first one
+ * @param count     number of sub-devices
+ * @param callback  result callback of each sub-device, could be NULL
+ * @param user_data user data passed to callback
+ *
+ * @return QCLOUD_RET_SUCCESS if all requests are sent, or err code for failure
+ */
+int IOT_Gateway_Subdev_Online_Batch(void *client, GatewayParam param[], int count, GatewaySubdevResultCallback callback,
+                                    void *user_data);
+
+/**
+ * @brief Make many sub-devices offline without waiting for the results
+ *
+ * @param client    handle to gateway client
+ * @param param     array of sub-device parameters, gateway info is taken from the first one
+ * @param count     number of sub-devices
+ * @param callback  result callback of each sub-device, could be NULL
+ * @param user_data user data passed to callback
+ *
+ * @return QCLOUD_RET_SUCCESS if all requests are sent, or err code for failure
+ */
+int IOT_Gateway_Subdev_Offline_Batch(void *client, GatewayParam param[], int count,
+                                     GatewaySubdevResultCallback callback, void *user_data);
+
+/**
+ * @brief Get number of sub-devices in batch requests still waiting for result, timed out ones are called back
+ *
+ * Besides IOT_Gateway_Yield(), this is where batch timeout is checked, the yield thread does not do it
+ *
+ * @param client    handle to gateway client
+ *
+ * @return number of pending sub-devices, or err code for failure
+ */
+int IOT_Gateway_Subdev_Batch_Pending(void *client);
+
 /**
  * @brief Make sub-device bind
  *
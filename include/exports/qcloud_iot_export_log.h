@@ -27,6 +27,7 @@ extern "C" {
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -82,6 +83,13 @@ typedef struct {
     LogReadFunc    read_func;
     LogDelFunc     del_func;
     LogGetSizeFunc get_size_func;
+    /* deflate the log post body, log server should accept Content-Encoding: deflate */
+    bool compress_enabled;
+    /* path prefix of the on-disk log spool (HAL_File*), used instead of the
+     * callbacks above if not NULL */
+    const char *spool_path;
+    /* size cap of the log spool, 0 for LOG_SPOOL_MAX_SIZE */
+    size_t spool_max_size;
 } LogUploadInitParams;
 
 /**
@@ -145,6 +153,28 @@ void IOT_Log_Fini_Uploader(void);
  */
 int IOT_Log_Upload(bool force_upload);
 
+/**
+ * @brief Format and output logs in a background thread
+ *
+ * Once started, IOT_Log_Gen only copies the format pointer, level, time and
+ * arguments into a lock-free ring and returns. A background thread formats
+ * the records, prints them and feeds the log uploader. Records that find the
+ * ring full are counted and reported by the background thread, records whose
+ * arguments exceed LOG_ASYNC_ARG_LEN are logged synchronously.
+ *
+ * Needs MULTITHREAD_ENABLED and a GCC compatible compiler.
+ *
+ * @param ring_records  capacity of the ring, rounded up to a power of two.
+ *                      0 for LOG_ASYNC_RING_RECORDS
+ * @return QCLOUD_RET_SUCCESS when success, or error code when fail
+ */
+int IOT_Log_Init_Async(uint32_t ring_records);
+
+/**
+ * @brief Output the records still queued, then go back to synchronous logging
+ */
+void IOT_Log_Fini_Async(void);
+
 /**
  * @brief Generate log for print/upload, call LogMessageHandler if defined
  *
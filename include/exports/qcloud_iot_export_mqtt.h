@@ -121,27 +121,47 @@ typedef enum {
  */
 typedef void (*OnMessageHandler)(void *pClient, MQTTMessage *message, void *pUserData);
 
+/**
+ * @brief Define MQTT SUBSCRIBE callback when message arrived in chunks
+ *
+ * Used for message larger than MQTT Rx buffer, which is handed to subscriber chunk by
+ * chunk as it arrives instead of being dropped. message->payload and payload_len give the
+ * current chunk, which starts at offset of the whole payload of total_len bytes. The chunk
+ * is not valid anymore after the callback returns.
+ */
+typedef void (*OnMessageChunkHandler)(void *pClient, MQTTMessage *message, size_t offset, size_t total_len,
+                                      void *pUserData);
+
 /**
  * @brief Define MQTT SUBSCRIBE callback when event happened
  */
 typedef void (*OnSubEventHandler)(void *pClient, MQTTEventType event_type, void *pUserData);
 
+/**
+ * @brief Define MQTT PUBLISH callback when QoS1 publish is acked or timeout
+ *
+ * event_type is MQTT_EVENT_PUBLISH_SUCCESS when PUBACK arrived, or
+ * MQTT_EVENT_PUBLISH_TIMEOUT when PUBACK waiting timeout
+ */
+typedef void (*OnPublishAckHandler)(void *pClient, uint16_t packet_id, MQTTEventType event_type, void *pUserData);
+
 /**
  * @brief Define structure to do MQTT subscription
  */
 typedef struct {
-    QoS               qos;                   // MQTT QoS level
-    OnMessageHandler  on_message_handler;    // callback when message arrived
-    OnSubEventHandler on_sub_event_handler;  // callback when event happened
-    void *            user_data;             // user context for callback
+    QoS                   qos;                       // MQTT QoS level
+    OnMessageHandler      on_message_handler;        // callback when message arrived
+    OnSubEventHandler     on_sub_event_handler;      // callback when event happened
+    void *                user_data;                 // user context for callback
+    OnMessageChunkHandler on_message_chunk_handler;  // callback when message larger than Rx buffer arrived, optional
 } SubscribeParams;
 
 /**
  * Default MQTT subscription parameters
  */
-#define DEFAULT_SUB_PARAMS     \
-    {                          \
-        QOS0, NULL, NULL, NULL \
+#define DEFAULT_SUB_PARAMS           \
+    {                                \
+        QOS0, NULL, NULL, NULL, NULL \
     }
 
 typedef struct {
@@ -194,20 +214,25 @@ typedef struct {
 
     MQTTEventHandler event_handle;  // event callback
 
+    uint16_t pub_window_size;  // max QoS1 publish waiting for PUBACK at the same time, 0 for default 20
+
+    uint32_t tx_buf_size;  // size of MQTT Tx buffer, 0 for default QCLOUD_IOT_MQTT_TX_BUF_LEN
+    uint32_t rx_buf_size;  // size of MQTT Rx buffer, 0 for default QCLOUD_IOT_MQTT_RX_BUF_LEN
+
 } MQTTInitParams;
 
 /**
  * Default MQTT init parameters
  */
 #ifdef AUTH_MODE_CERT
-#define DEFAULT_MQTTINIT_PARAMS                                        \
-    {                                                                  \
-        "china", NULL, NULL, NULL, NULL, 5000, 240 * 1000, 1, 1, { 0 } \
+#define DEFAULT_MQTTINIT_PARAMS                                                 \
+    {                                                                           \
+        "china", NULL, NULL, NULL, NULL, 5000, 240 * 1000, 1, 1, { 0 }, 0, 0, 0 \
     }
 #else
-#define DEFAULT_MQTTINIT_PARAMS                                  \
-    {                                                            \
-        "china", NULL, NULL, NULL, 5000, 240 * 1000, 1, 1, { 0 } \
+#define DEFAULT_MQTTINIT_PARAMS                                           \
+    {                                                                     \
+        "china", NULL, NULL, NULL, 5000, 240 * 1000, 1, 1, { 0 }, 0, 0, 0 \
     }
 #endif
 
@@ -272,9 +297,66 @@ void IOT_MQTT_StopLoop(void *pClient);
 bool IOT_MQTT_GetLoopStatus(void *pClient, int *exit_code);
 #endif
 
+#if defined(__linux__)
+/**
+ * @brief Create a reactor to drive many MQTT clients from one thread
+ *
+ * The sockets of the clients added are multiplexed by one poller (epoll), and a client
+ * is read only when its socket is readable, while its puback/suback timeout and keep
+ * alive are checked when due, by a timer heap of clients. Run one reactor per thread to spread
+ * the clients over a few threads. Reconnecting is still blocking for the reactor thread.
+ *
+ * @param max_clients   max number of clients driven by this reactor
+ * @return reactor handle when success, or NULL otherwise
+ */
+void *IOT_MQTT_ReactorCreate(uint32_t max_clients);
+
+/**
+ * @brief Destroy the reactor, the clients still added are removed but not destroyed
+ *
+ * @param reactor       handle to reactor
+ */
+void IOT_MQTT_ReactorDestroy(void *reactor);
+
+/**
+ * @brief Add a connected MQTT client to reactor, instead of IOT_MQTT_Yield or IOT_MQTT_StartLoop
+ *
+ * @param reactor       handle to reactor
+ * @param pClient       handle to MQTT client, not driven by yield thread or other reactor
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_MQTT_ReactorAdd(void *reactor, void *pClient);
+
+/**
+ * @brief Remove MQTT client from reactor, IOT_MQTT_Destroy does it as well
+ *
+ * May be called from the callbacks of the clients driven by the same reactor, the client
+ * itself included, then its slot is freed once the callback returns
+ *
+ * @param reactor       handle to reactor
+ * @param pClient       handle to MQTT client
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_MQTT_ReactorRemove(void *reactor, void *pClient);
+
+/**
+ * @brief Run one round of reactor: wait for readable sockets, read/handle MQTT packets of
+ * the clients ready, and check timers of the clients due
+ *
+ * @param reactor       handle to reactor
+ * @param timeout_ms    max time (unit: ms) to wait for readable sockets
+ * @return number of clients read in this round, or err code (<0) for failure
+ */
+int IOT_MQTT_ReactorRun(void *reactor, uint32_t timeout_ms);
+#endif
+
 /**
  * @brief Publish MQTT message
  *
+ * Payload is sent from caller buffer directly, without copying into client write buffer,
+ * so its length is not limited by tx_buf_size of MQTTInitParams. The buffer is not used
+ * anymore once this function returns.
+ *
  * @param pClient       handle to MQTT client
  * @param topicName     MQTT topic name
  * @param pParams       publish parameters
@@ -283,9 +365,31 @@ bool IOT_MQTT_GetLoopStatus(void *pClient, int *exit_code);
  */
 int IOT_MQTT_Publish(void *pClient, char *topicName, PublishParams *pParams);
 
+/**
+ * @brief Publish MQTT message without waiting for the result
+ *
+ * Return as soon as the packet is sent. For QoS1, ack_handler is called from the
+ * yield context when PUBACK arrives or its waiting times out. Up to pub_window_size
+ * of MQTTInitParams publish could wait for PUBACK at the same time.
+ *
+ * @param pClient       handle to MQTT client
+ * @param topicName     MQTT topic name
+ * @param pParams       publish parameters
+ * @param ack_handler   callback for QoS1 publish result, could be NULL
+ * @param user_data     user context for callback
+ *
+ * @return packet id (>=0) when success, or err code (<0) for failure
+ */
+int IOT_MQTT_PublishAsync(void *pClient, char *topicName, PublishParams *pParams, OnPublishAckHandler ack_handler,
+                          void *user_data);
+
 /**
  * @brief Subscribe MQTT topic
  *
+ * Message larger than rx_buf_size of MQTTInitParams is dropped, unless on_message_chunk_handler
+ * is set in pParams. Then it is streamed to that handler chunk by chunk. Message fitting in
+ * Rx buffer goes to on_message_handler, or to on_message_chunk_handler as one chunk if the former is NULL.
+ *
  * @param pClient       handle to MQTT client
  * @param topicFilter   MQTT topic filter
  * @param pParams       subscribe parameters
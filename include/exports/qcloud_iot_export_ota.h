@@ -103,6 +103,27 @@ typedef enum {
 
 } IOT_OTAReportType;
 
+/* byte range of firmware fetched over its own HTTP connection in segmented download */
+typedef struct {
+    uint32_t offset;  /* offset of segment in firmware */
+    uint32_t size;    /* size of segment */
+    uint32_t fetched; /* bytes of segment written already */
+} IOT_OTA_Segment;
+
+/**
+ * @brief Write firmware data at the given offset, segments arrive interleaved
+ *
+ * @return QCLOUD_RET_SUCCESS when success, or err code to stop the download
+ */
+typedef int (*OTASegmentWriteCb)(void *user_data, uint32_t offset, const char *data, uint32_t len);
+
+/**
+ * @brief Read back firmware data at the given offset, for MD5 check after the download
+ *
+ * @return length read, or err code for failure
+ */
+typedef int (*OTASegmentReadCb)(void *user_data, uint32_t offset, char *buf, uint32_t len);
+
 /**
  * @brief Init OTA module and resources
  *        MQTT/COAP Client should be constructed beforehand
@@ -124,6 +145,19 @@ void *IOT_OTA_Init(const char *product_id, const char *device_name, void *ch_sig
  */
 int IOT_OTA_Destroy(void *handle);
 
+/**
+ * @brief Accept firmware compressed by HTTP Content-Encoding (gzip/deflate) in following
+ *        IOT_OTA_StartDownload. It is decoded on the fly, so the buffer of IOT_OTA_FetchYield
+ *        and the MD5 are of the firmware itself. Download from an offset other than 0 is always
+ *        asked uncompressed, as byte ranges refer to the compressed data otherwise.
+ *
+ * @param handle: OTA module handle
+ * @param enable: true to accept compressed firmware
+ *
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_OTA_SetContentDecode(void *handle, bool enable);
+
 /**
  * @brief Setup HTTP connection and prepare OTA download
  *
@@ -135,6 +169,60 @@ int IOT_OTA_Destroy(void *handle);
  */
 int IOT_OTA_StartDownload(void *handle, uint32_t offset, uint32_t size);
 
+/**
+ * @brief Prepare segmented OTA download: firmware is split into byte ranges, each
+ *        fetched over its own HTTP connection by IOT_OTA_SegmentedFetchYield
+ *
+ * @param handle:   OTA module handle
+ * @param segs:     segment array kept by user. Zero segs[0].size to split the firmware
+ *                  into seg_cnt segments; otherwise the download resumes from the
+ *                  fetched size of each segment, saved from a former download
+ * @param seg_cnt:  number of segments, [1, OTA_SEGMENT_MAX_NUM]
+ * @param write_cb: callback to write firmware data at offset
+ * @param read_cb:  callback to read firmware back for MD5 check. If NULL, user should
+ *                  feed the firmware to IOT_OTA_UpdateClientMd5 before IOT_OTAG_CHECK_FIRMWARE
+ * @param user_data: user data of callbacks
+ *
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_OTA_StartSegmentedDownload(void *handle, IOT_OTA_Segment *segs, uint32_t seg_cnt, OTASegmentWriteCb write_cb,
+                                   OTASegmentReadCb read_cb, void *user_data);
+
+/**
+ * @brief Resume download from the checkpoint file at path, which is also used by
+ *        IOT_OTA_SaveCheckpoint afterwards. The checkpoint is taken only if it is of the
+ *        same firmware (version, size, MD5 and URL without query), then the MD5 state
+ *        is restored and no re-hashing of the downloaded part is needed.
+ *        Call it in fetching state, before IOT_OTA_StartDownload.
+ *
+ * @param handle:   OTA module handle
+ * @param path:     path of checkpoint file
+ * @param offset:   offset to download from, 0 if there's no valid checkpoint
+ *
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_OTA_ResumeFromCheckpoint(void *handle, const char *path, uint32_t *offset);
+
+/**
+ * @brief Save download offset and MD5 state to the checkpoint file, replacing the old one
+ *        atomically. Call it after the data fetched is persisted; it's skipped if the
+ *        last one is saved within OTA_CHECKPOINT_INTERVAL_MS, unless force is set.
+ *
+ * @param handle:   OTA module handle
+ * @param force:    save even if the interval is not over
+ *
+ * @return QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+int IOT_OTA_SaveCheckpoint(void *handle, bool force);
+
+/**
+ * @brief Remove the checkpoint file, when the download is over
+ *
+ * @param handle:   OTA module handle
+ *
+ */
+void IOT_OTA_ClearCheckpoint(void *handle);
+
 /**
  * @brief Update MD5 of local firmware
  *
@@ -227,6 +315,20 @@ int IOT_OTA_IsFetchFinish(void *handle);
  */
 int IOT_OTA_FetchYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s);
 
+/**
+ * @brief Download firmware segments started by IOT_OTA_StartSegmentedDownload,
+ *        reading each open connection in turn and writing the data by write_cb
+ *
+ * @param handle:       OTA module handle
+ * @param buf:          work buffer
+ * @param buf_len:      length of buffer
+ * @param timeout_s:    timeout value in second for each read
+ *
+ * @retval      < 0 : error code
+ * @retval     >= 0 : size of the data downloaded in this call
+ */
+int IOT_OTA_SegmentedFetchYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s);
+
 /**
  * @brief Get OTA info (version, file_size, MD5, download state) from OTA module
  *
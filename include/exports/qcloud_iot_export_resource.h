@@ -269,6 +269,22 @@ int IOT_Resource_DownloadYield(void *handle, char *buf, uint32_t buf_len, uint32
  */
 int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s);
 
+/**
+ * @brief upload resource from file to HTTP server, without reading it into a user buffer.
+ *        The file is mapped where supported so disk reads overlap with sending,
+ *        and the MD5 for QCLOUD_IOT_RESOURCE_MD5CHECK_E is computed as it is sent.
+ *
+ * @param handle:       resource handle
+ * @param fp:           resource file opened by HAL_FileOpen, positioned at the data to upload next
+ * @param len:          max length of data to upload in this period
+ * @param timeout_s:    timeout value in second
+ *
+ * @retval      < 0 : error code
+ * @retval        0 : no data is upload in this period and timeout happen
+ * @retval (0, len] : size of the uploaded data
+ */
+int IOT_Resource_UploadFileYield(void *handle, void *fp, uint32_t len, uint32_t timeout_s);
+
 /**
  * @brief Check if resource fetching/downloading is finished
  *
@@ -61,6 +61,13 @@
 #define MAX_LOG_MSG_LEN (1023)
 #endif
 
+/* default number of records in the async log ring, see IOT_Log_Init_Async */
+#define LOG_ASYNC_RING_RECORDS (256)
+
+/* MAX size of the arguments (including copied strings) of one async log record,
+ * a record with larger arguments is logged synchronously */
+#define LOG_ASYNC_ARG_LEN (96)
+
 /*
  * Log upload related params, which will affect the size of device memory/disk
  * consumption
@@ -79,4 +86,41 @@
 // LOG_UPLOAD_BUFFER_SIZE is small
 #define LOG_UPLOAD_INTERVAL_MS 2000
 
+// size of one segment file of the on-disk log spool
+#define LOG_SPOOL_SEGMENT_SIZE (2 * LOG_UPLOAD_BUFFER_SIZE)
+
+// MAX number of segment files of the on-disk log spool
+#define LOG_SPOOL_MAX_SEGMENTS 16
+
+// default size cap of the on-disk log spool, oldest segment is evicted beyond it
+#define LOG_SPOOL_MAX_SIZE (8 * LOG_SPOOL_SEGMENT_SIZE)
+
+// min interval (unit: ms) between two batches of spooled log replay
+#define LOG_SPOOL_REPLAY_INTERVAL_MS 1000
+
+/* MAX number of segments (HTTP connections) of segmented OTA download */
+#define OTA_SEGMENT_MAX_NUM 8
+
+/* times one segment reconnects after a fetch error before the download fails */
+#define OTA_SEGMENT_RETRY 3
+
+/* min interval (unit: ms) between two OTA download checkpoints, see IOT_OTA_SaveCheckpoint */
+#define OTA_CHECKPOINT_INTERVAL_MS 1000
+
+/* max LZ77 window (power of 2 up to 32768) for decoding gzip/deflate HTTP content, a smaller one
+ * only decodes content compressed with a window no larger (e.g. zlib wbits) */
+#define HTTP_INFLATE_WINDOW_SIZE (32768)
+
+/* MAX number of servers (scheme, host, port) with a kept-alive HTTP connection and TLS session */
+#define HTTP_CONN_POOL_SIZE 4
+
+/* idle time (unit: ms) after which a kept-alive HTTP connection is closed, keep it below the server's */
+#define HTTP_CONN_POOL_IDLE_MS 30000
+
+/* part (unit: byte) of a file mapped at a time by HTTP file upload, where HAL_FileMap is supported */
+#define HTTP_UPLOAD_FILE_MAP_SIZE (256 * 1024)
+
+/* data (unit: byte) of HTTP file upload written at a time, also the read buffer size if the file can't be mapped */
+#define HTTP_UPLOAD_FILE_SLICE_SIZE (16 * 1024)
+
 #endif /* QCLOUD_IOT_EXPORT_VARIABLES_H_ */
@@ -175,6 +175,18 @@ unsigned long HAL_QueueItemWaitingCount(void *queue_handle);
 unsigned long HAL_QueueItemPop(void *queue_handle, void *const item_buffer, uint32_t wait_timeout);
 
 unsigned long HAL_QueueItemPush(void *queue_handle, void *const item_buffer, uint32_t wait_timeout);
+
+/**
+ * @brief pop up to max_items items in one call
+ * @param queue_handle
+ * @param item_buffer   room for max_items items
+ * @param max_items
+ * @param wait_timeout  time to wait for the first item, in ms
+ *
+ * @return number of items popped, 0 if none arrived in time
+ */
+unsigned long HAL_QueueItemPopBatch(void *queue_handle, void *const item_buffer, unsigned long max_items,
+                                    uint32_t wait_timeout);
 #endif  // WIFI_CONFIG_ENABLED
 
 /**
@@ -347,6 +359,15 @@ void HAL_Timer_init(Timer *timer);
  */
 char *HAL_Timer_current(char *time_str);
 
+/**
+ * @brief Format a timestamp from HAL_Timer_current_sec() the way HAL_Timer_current does
+ *
+ * @param time_sec  timestamp in second
+ * @param time_str  buffer of TIME_FORMAT_STR_LEN
+ * @return string of formatted time
+ */
+char *HAL_Timer_format(long time_sec, char *time_str);
+
 /**
  * @brief Get timestamp in second
  *
@@ -365,6 +386,9 @@ int HAL_AT_Uart_Init(void);
 int HAL_AT_Uart_Deinit(void);
 int HAL_AT_Uart_Send(void *data, uint32_t size);
 int HAL_AT_Uart_Recv(void *data, uint32_t expect_size, uint32_t *recv_size, uint32_t timeout);
+/* stop (enable = false) or restart taking rx data from the uart, the port
+ * should hold the module off (e.g. RTS) meanwhile if it can */
+void HAL_AT_Uart_SetRxFlow(bool enable);
 #endif
 
 /********** TLS/DTLS network sturcture and operations **********/
@@ -399,6 +423,8 @@ typedef struct {
 
     unsigned int timeout_ms;  // SSL handshake timeout in millisecond
 
+    void *cache;  // contexts kept across connections by HAL_TLS_CacheCreate, NULL to set up all on each connect
+
 } SSLConnectParams;
 
 typedef SSLConnectParams TLSConnectParams;
@@ -413,6 +439,24 @@ typedef SSLConnectParams TLSConnectParams;
  */
 uintptr_t HAL_TLS_Connect(TLSConnectParams *pConnectParams, const char *host, int port);
 
+/**
+ * @brief Create contexts to keep across TLS connections with the same connection parameters
+ *
+ * Random generator, parsed CA chain and client cert/key are set up once, and the last session is
+ * kept for an abbreviated handshake on reconnect. Set it as cache of connection parameters.
+ *
+ * @param   pConnectParams reference to TLS connection parameters
+ * @return  TLS cache, or NULL if failed or not supported
+ */
+void *HAL_TLS_CacheCreate(TLSConnectParams *pConnectParams);
+
+/**
+ * @brief Release TLS cache, after all connections using it are disconnected
+ *
+ * @param cache TLS cache
+ */
+void HAL_TLS_CacheDestroy(void *cache);
+
 /**
  * @brief Disconnect with TLS server and release resources
  *
@@ -438,7 +482,7 @@ int HAL_TLS_Write(uintptr_t handle, unsigned char *data, size_t totalLen, uint32
  * @param handle        TLS connect handle
  * @param data          destination data buffer where to put data
  * @param totalLen      length of data
- * @param timeout_ms    timeout value in millisecond
+ * @param timeout_ms    timeout value in millisecond, 0 to return only the data already available without blocking
  * @param read_len      length of data read successfully
  * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
  */
@@ -522,13 +566,21 @@ int HAL_TCP_Disconnect(uintptr_t fd);
  */
 int HAL_TCP_Write(uintptr_t fd, const unsigned char *data, uint32_t len, uint32_t timeout_ms, size_t *written_len);
 
+/**
+ * @brief Data segment for vectored (scatter/gather) write
+ */
+typedef struct {
+    const unsigned char *data;  // segment start
+    size_t               len;   // segment length
+} NetIovec;
+
 /**
  * @brief Read data via TCP connection
  *
  * @param fd            TCP socket handle
  * @param data          destination data buffer where to put data
  * @param len           length of data
- * @param timeout_ms    timeout value in millisecond
+ * @param timeout_ms    timeout value in millisecond, 0 to return only the data already available without blocking
  * @param read_len      length of data read successfully
  * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
  */
@@ -697,6 +749,22 @@ char *HAL_FileGets(char *str, int n, void *fp);
  */
 int HAL_FileFlush(void *fp);
 
+/**
+ * @brief Map len bytes of the stream from offset into memory to read them without a copy,
+ * and have the system read in the data after them in the background.
+ *
+ * @param fp        stream opened for reading
+ * @param offset    offset of data in the stream
+ * @param len       length of data, offset + len no larger than the stream size
+ * @return          address of the data, or NULL if mapping is not supported (use HAL_FileRead then)
+ */
+const void *HAL_FileMap(void *fp, long offset, size_t len);
+
+/**
+ * @brief Unmap data mapped by HAL_FileMap.
+ */
+void HAL_FileUnmap(const void *addr, size_t len);
+
 #if defined(__cplusplus)
 }
 #endif
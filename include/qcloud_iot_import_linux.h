@@ -0,0 +1,177 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2018-2020 THL A29 Limited, a Tencent company. All rights
+ reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef QCLOUD_IOT_IMPORT_LINUX_H_
+#define QCLOUD_IOT_IMPORT_LINUX_H_
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * HAL interfaces implemented for Linux only: non-blocking connect, vectored write,
+ * readiness polling. The SDK uses them on Linux, other platforms need not port them.
+ */
+
+#include "qcloud_iot_import.h"
+
+/********** TLS network **********/
+#ifndef AUTH_WITH_NOTLS
+/**
+ * @brief Get the socket under TLS connection, for readiness polling
+ *
+ * @param handle    TLS connect handle
+ * @return          socket descriptor, or -1 if not available
+ */
+int HAL_TLS_GetFd(uintptr_t handle);
+
+/**
+ * @brief Get a hint of bytes that can be read from TLS connection without blocking
+ *
+ * @param handle    TLS connect handle
+ * @return          plaintext decrypted plus bytes in socket receive buffer, or err code (<0) for failure
+ */
+int HAL_TLS_ReadableBytes(uintptr_t handle);
+
+/**
+ * @brief Start TLS connection with server without blocking, advanced by HAL_TLS_ConnectPoll
+ *
+ * Optional for porting: the SDK falls back to HAL_TLS_Connect when it is not available
+ *
+ * @param   pConnectParams reference to TLS connection parameters
+ * @host    server address
+ * @port    server port
+ * @return  TLS connect handle to poll and to disconnect, or 0 for failure
+ */
+uintptr_t HAL_TLS_ConnectStart(TLSConnectParams *pConnectParams, const char *host, int port);
+
+/**
+ * @brief Advance TLS connection started by HAL_TLS_ConnectStart, through TCP connect and handshake steps
+ *
+ * @param handle    TLS connect handle
+ * @return          QCLOUD_RET_SUCCESS when connected, QCLOUD_ERR_TCP_CONNECTING or QCLOUD_ERR_SSL_CONNECTING when
+ *                  in progress, or err code for failure
+ */
+int HAL_TLS_ConnectPoll(uintptr_t handle);
+#endif  // AUTH_WITH_NOTLS
+
+/********** TCP network **********/
+/**
+ * @brief Write several data segments via TCP connection without joining them first
+ *
+ * Optional for porting: the SDK falls back to HAL_TCP_Write per segment when it is not available
+ *
+ * @param fd            TCP socket handle
+ * @param iov           data segments to write, in order
+ * @param iovcnt        count of data segments
+ * @param timeout_ms    timeout value in millisecond
+ * @param written_len   total length of data written successfully
+ * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int HAL_TCP_Writev(uintptr_t fd, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len);
+
+/**
+ * @brief Start TCP connection with server without blocking, advanced by HAL_TCP_ConnectPoll
+ *
+ * Optional for porting: the SDK falls back to HAL_TCP_Connect when it is not available
+ *
+ * @param host  server address
+ * @param port  server port
+ * @return      connect context, or NULL for failure
+ */
+void *HAL_TCP_ConnectStart(const char *host, uint16_t port);
+
+/**
+ * @brief Advance TCP connection started by HAL_TCP_ConnectStart, through DNS and connect steps
+ *
+ * @param ctx   connect context
+ * @param fd    TCP socket handle, valid when connected
+ * @return      QCLOUD_RET_SUCCESS when connected, QCLOUD_ERR_TCP_CONNECTING when in progress, or err code for failure
+ */
+int HAL_TCP_ConnectPoll(void *ctx, uintptr_t *fd);
+
+/**
+ * @brief Release connect context, the socket not yet connected is closed. Never waits, a DNS
+ *        lookup still running keeps the context until a later start or stop finds it done
+ *
+ * @param ctx   connect context
+ */
+void HAL_TCP_ConnectStop(void *ctx);
+
+/**
+ * @brief Get the number of bytes that can be read from TCP connection without blocking
+ *
+ * Optional for porting: a hint for the MQTT reactor to stop reading a drained socket early
+ *
+ * @param fd    TCP socket handle
+ * @return      bytes in socket receive buffer, or err code (<0) for failure
+ */
+int HAL_TCP_ReadableBytes(uintptr_t fd);
+
+/**
+ * @brief Create a poller to wait for read readiness of many sockets at once
+ *
+ * Optional for porting: only needed by the MQTT reactor (IOT_MQTT_Reactor*)
+ *
+ * @return  poller handle, or NULL for failure
+ */
+void *HAL_PollerCreate(void);
+
+/**
+ * @brief Destroy the poller, the sockets added are not closed
+ *
+ * @param poller    poller handle
+ */
+void HAL_PollerDestroy(void *poller);
+
+/**
+ * @brief Add socket to poller
+ *
+ * @param poller    poller handle
+ * @param fd        socket descriptor
+ * @param ctx       user context returned by HAL_PollerWait when the socket is readable
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int HAL_PollerAdd(void *poller, int fd, void *ctx);
+
+/**
+ * @brief Remove socket from poller
+ *
+ * @param poller    poller handle
+ * @param fd        socket descriptor
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int HAL_PollerDel(void *poller, int fd);
+
+/**
+ * @brief Wait until some of the sockets added are readable, closed or broken
+ *
+ * @param poller        poller handle
+ * @param ready_ctx     output array for context of the ready sockets
+ * @param max_cnt       size of ready_ctx
+ * @param timeout_ms    timeout value in millisecond
+ * @return              number of ready sockets, 0 for timeout, or err code (<0) for failure
+ */
+int HAL_PollerWait(void *poller, void **ready_ctx, int max_cnt, uint32_t timeout_ms);
+
+#if defined(__cplusplus)
+}
+#endif
+#endif /* QCLOUD_IOT_IMPORT_LINUX_H_ */
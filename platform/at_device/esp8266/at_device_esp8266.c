@@ -106,9 +106,8 @@ static void urc_close_func(const char *data, size_t size)
 static void urc_recv_func(const char *data, size_t size)
 {
     int      fd;
-    size_t   bfsz = 0, temp_size = 0;
+    size_t   bfsz = 0;
     uint32_t timeout;
-    char *   recv_buf, temp[8];
 
     POINTER_SANITY_CHECK_RTN(data);
 
@@ -121,31 +120,9 @@ static void urc_recv_func(const char *data, size_t size)
     if (fd < 0 || bfsz == 0)
         return;
 
-    recv_buf = HAL_Malloc(bfsz);
-    if (NULL == recv_buf) {
-        Log_e("no memory for URC receive buffer (%d)!", bfsz);
-        /* read and clean the coming data */
-        while (temp_size < bfsz) {
-            if (bfsz - temp_size > sizeof(temp)) {
-                at_client_recv(temp, sizeof(temp), timeout);
-            } else {
-                at_client_recv(temp, bfsz - temp_size, timeout);
-            }
-            temp_size += sizeof(temp);
-        }
-        return;
-    }
-
-    /* sync receive data */
-    if (at_client_recv(recv_buf, bfsz, timeout) != bfsz) {
+    /* copy the data straight into the socket receive ring */
+    if (at_socket_recv_fill(fd, bfsz, timeout) != bfsz) {
         Log_e("receive size(%d) data failed!", bfsz);
-        HAL_Free(recv_buf);
-        return;
-    }
-
-    /* notice the receive buffer and buffer size */
-    if (at_evt_cb_table[AT_SOCKET_EVT_RECV]) {
-        at_evt_cb_table[AT_SOCKET_EVT_RECV](fd, AT_SOCKET_EVT_RECV, recv_buf, bfsz);
     }
 }
 
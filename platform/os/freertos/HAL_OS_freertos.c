@@ -38,25 +38,39 @@
 // TODO platform dependant
 
 #ifdef WIFI_CONFIG_ENABLED
+/* item size is kept with the queue, FreeRTOS before V10.5.0 can not tell it */
+typedef struct {
+    QueueHandle_t handle;
+    unsigned long item_size;
+} HALQueue;
+
 void *HAL_QueueCreate(unsigned long queue_length, unsigned long queue_item_size)
 {
-    QueueHandle_t queue_handle = NULL;
-    queue_handle               = xQueueCreate(queue_length, queue_item_size);
-    if (NULL == queue_handle) {
+    HALQueue *queue = (HALQueue *)pvPortMalloc(sizeof(HALQueue));
+
+    if (NULL == queue) {
         return NULL;
-    } else {
-        return (void *)queue_handle;
     }
+
+    queue->handle = xQueueCreate(queue_length, queue_item_size);
+    if (NULL == queue->handle) {
+        vPortFree(queue);
+        return NULL;
+    }
+    queue->item_size = queue_item_size;
+
+    return (void *)queue;
 }
 
 void HAL_QueueDestory(void *queue_handle)
 {
-    vQueueDelete(queue_handle);
+    vQueueDelete(((HALQueue *)queue_handle)->handle);
+    vPortFree(queue_handle);
 }
 
 uint32_t HAL_QueueReset(void *queue_handle)
 {
-    if (pdPASS == xQueueReset(queue_handle)) {
+    if (pdPASS == xQueueReset(((HALQueue *)queue_handle)->handle)) {
         return QCLOUD_RET_SUCCESS;
     } else {
         return QCLOUD_ERR_FAILURE;
@@ -65,12 +79,12 @@ uint32_t HAL_QueueReset(void *queue_handle)
 
 unsigned long HAL_QueueItemWaitingCount(void *queue_handle)
 {
-    return uxQueueMessagesWaiting(queue_handle);
+    return uxQueueMessagesWaiting(((HALQueue *)queue_handle)->handle);
 }
 
 unsigned long HAL_QueueItemPop(void *queue_handle, void *const item_buffer, uint32_t wait_timeout)
 {
-    if (pdPASS == xQueueReceive(queue_handle, item_buffer, wait_timeout)) {
+    if (pdPASS == xQueueReceive(((HALQueue *)queue_handle)->handle, item_buffer, wait_timeout)) {
         return QCLOUD_RET_SUCCESS;
     } else {
         return QCLOUD_ERR_FAILURE;
@@ -79,12 +93,27 @@ unsigned long HAL_QueueItemPop(void *queue_handle, void *const item_buffer, uint
 
 unsigned long HAL_QueueItemPush(void *queue_handle, void *const item_buffer, uint32_t wait_timeout)
 {
-    if (pdPASS == xQueueSend(queue_handle, item_buffer, wait_timeout)) {
+    if (pdPASS == xQueueSend(((HALQueue *)queue_handle)->handle, item_buffer, wait_timeout)) {
         return QCLOUD_RET_SUCCESS;
     } else {
         return QCLOUD_ERR_FAILURE;
     }
 }
+
+unsigned long HAL_QueueItemPopBatch(void *queue_handle, void *const item_buffer, unsigned long max_items,
+                                    uint32_t wait_timeout)
+{
+    HALQueue *    queue = (HALQueue *)queue_handle;
+    unsigned long num   = 0;
+
+    /* only the first item waits, the rest are drained without blocking */
+    while (num < max_items && pdPASS == xQueueReceive(queue->handle, (char *)item_buffer + num * queue->item_size,
+                                                      num ? 0 : wait_timeout)) {
+        num++;
+    }
+
+    return num;
+}
 #endif
 
 void HAL_SleepMs(_IN_ uint32_t ms)
@@ -66,13 +66,20 @@ char *HAL_Timer_current(char *time_str)
 #if defined PLATFORM_HAS_TIME_FUNCS
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    time_t    now_time = tv.tv_sec;
+    return HAL_Timer_format(tv.tv_sec, time_str);
+#else
+    return HAL_Timer_format(HAL_Timer_current_sec(), time_str);
+#endif
+}
+
+char *HAL_Timer_format(long time_sec, char *time_str)
+{
+#if defined PLATFORM_HAS_TIME_FUNCS
+    time_t    now_time = time_sec;
     struct tm tm_tmp   = *localtime(&now_time);
     strftime(time_str, TIME_FORMAT_STR_LEN, "%F %T", &tm_tmp);
     return time_str;
 #else
-    long time_sec;
-    time_sec = HAL_Timer_current_sec();
     memset(time_str, 0, TIME_FORMAT_STR_LEN);
     snprintf(time_str, TIME_FORMAT_STR_LEN, "%ld", time_sec);
     return time_str;
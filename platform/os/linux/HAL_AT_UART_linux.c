@@ -43,6 +43,7 @@
 #include "at_client.h"
 #include "utils_ringbuff.h"
 static void at_uart_irq_recv(void *userContex);
+static volatile bool sg_at_uart_rx_paused = false;
 #endif
 
 #define AT_UART_LINUX_DEV "/dev/ttyUSB0"
@@ -224,6 +225,15 @@ int HAL_AT_Uart_Recv(void *data, uint32_t expect_size, uint32_t *recv_size, uint
     return ret;
 }
 
+/* stop reading the tty, data waits in the kernel buffer and the module is
+ * held off by RTS if the port is set up with hardware flow control */
+void HAL_AT_Uart_SetRxFlow(bool enable)
+{
+#ifdef AT_UART_RECV_IRQ
+    sg_at_uart_rx_paused = !enable;
+#endif
+}
+
 // simulate IRQ
 #ifdef AT_UART_RECV_IRQ
 extern void at_client_uart_rx_isr_cb(uint8_t *pdata, uint8_t len);
@@ -232,6 +242,11 @@ static void at_uart_irq_recv(void *userContex)
     uint8_t data[64];
     int     readlen;
     while (1) {
+        if (sg_at_uart_rx_paused) {
+            HAL_SleepMs(1);
+            continue;
+        }
+
         if ((readlen = read(sg_at_uart.fd, data, sizeof(data))) == -1) {
             continue;
         }
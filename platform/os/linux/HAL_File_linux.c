@@ -18,8 +18,13 @@
  * limitations under the License.
  *
  */
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 void *HAL_FileOpen(const char *filename, const char *mode)
 {
@@ -93,3 +98,35 @@ int HAL_FileFlush(void *fp)
 {
     return fflush((FILE *)fp);
 }
+
+const void *HAL_FileMap(void *fp, long offset, size_t len)
+{
+    int         fd   = fileno((FILE *)fp);
+    long        page = sysconf(_SC_PAGESIZE);
+    long        head;
+    struct stat st;
+    void *      addr;
+
+    if (fd < 0 || page <= 0 || offset < 0 || len == 0 || fstat(fd, &st) != 0 || offset + (off_t)len > st.st_size) {
+        return NULL;
+    }
+
+    /* mmap offset must be page aligned */
+    head = offset % page;
+    addr = mmap(NULL, len + head, PROT_READ, MAP_PRIVATE, fd, offset - head);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    /* start reading this and the next part, so disk reads overlap with the use of the data */
+    posix_fadvise(fd, offset, 2 * len, POSIX_FADV_WILLNEED);
+
+    return (const char *)addr + head;
+}
+
+void HAL_FileUnmap(const void *addr, size_t len)
+{
+    long head = (long)((uintptr_t)addr % sysconf(_SC_PAGESIZE));
+
+    munmap((char *)addr - head, len + head);
+}
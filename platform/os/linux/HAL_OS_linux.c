@@ -35,43 +35,83 @@
 #include "qcloud_iot_export.h"
 
 #ifdef WIFI_CONFIG_ENABLED
-#include "utils_ringbuff.h"
-#include "utils_timer.h"
+#include <time.h>
 
+/* bounded MPMC queue of fixed size items. Waiters block on a condition
+ * variable and are woken as soon as the other side pops or pushes */
 typedef struct qcloud_message_queue {
-    sRingbuff ring_buff;
-    uint32_t  queue_item_size;
-    void *    queue_mutex;
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    char *          items;
+    uint32_t        queue_item_size;
+    uint32_t        queue_length;
+    uint32_t        head;  // slot of the oldest item
+    uint32_t        count;
 } QCLOUD_MESSAGE_QUEUE_T;
 
+static void _queue_deadline(struct timespec *ts, uint32_t timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/* wait for an item (or a free slot when for_space is set) until the timeout,
+ * called with the queue lock held */
+static int _queue_wait(QCLOUD_MESSAGE_QUEUE_T *queue, pthread_cond_t *cond, int for_space, uint32_t wait_timeout)
+{
+    struct timespec deadline = {0, 0};
+    int             rc = 0;
+
+    if (wait_timeout) {
+        _queue_deadline(&deadline, wait_timeout);
+    }
+
+    while (for_space ? (queue->count == queue->queue_length) : (queue->count == 0)) {
+        if (!wait_timeout || rc == ETIMEDOUT) {
+            return QCLOUD_ERR_FAILURE;
+        }
+        rc = pthread_cond_timedwait(cond, &queue->lock, &deadline);
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
 void *HAL_QueueCreate(unsigned long queue_length, unsigned long queue_item_size)
 {
-    QCLOUD_MESSAGE_QUEUE_T *queue = HAL_Malloc(sizeof(QCLOUD_MESSAGE_QUEUE_T));
-    char *                  buff  = NULL;
-    void *                  mutex = NULL;
+    QCLOUD_MESSAGE_QUEUE_T *queue = NULL;
+    pthread_condattr_t      attr;
 
-    if (NULL == queue) {
+    if (!queue_length || !queue_item_size) {
         return NULL;
     }
-    memset(queue, 0, sizeof(QCLOUD_MESSAGE_QUEUE_T));
 
-    buff = HAL_Malloc(queue_length * queue_item_size);
-    if (NULL == buff) {
-        HAL_Free(queue);
+    queue = HAL_Malloc(sizeof(QCLOUD_MESSAGE_QUEUE_T));
+    if (NULL == queue) {
         return NULL;
     }
+    memset(queue, 0, sizeof(QCLOUD_MESSAGE_QUEUE_T));
 
-    mutex = HAL_MutexCreate();
-    if (mutex == NULL) {
-        HAL_Free(buff);
+    queue->items = HAL_Malloc(queue_length * queue_item_size);
+    if (NULL == queue->items) {
         HAL_Free(queue);
         return NULL;
     }
 
-    ring_buff_init(&(queue->ring_buff), buff, queue_length * queue_item_size);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, &attr);
+    pthread_cond_init(&queue->not_full, &attr);
+    pthread_condattr_destroy(&attr);
 
     queue->queue_item_size = queue_item_size;
-    queue->queue_mutex     = mutex;
+    queue->queue_length    = queue_length;
 
     return queue;
 }
@@ -79,106 +119,102 @@ void *HAL_QueueCreate(unsigned long queue_length, unsigned long queue_item_size)
 void HAL_QueueDestory(void *queue_handle)
 {
     QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
-    void *                  mutex = queue->queue_mutex;
 
-    HAL_MutexLock(mutex);
-    HAL_Free(queue->ring_buff.buffer);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    pthread_mutex_destroy(&queue->lock);
+    HAL_Free(queue->items);
     HAL_Free(queue);
-    HAL_MutexUnlock(mutex);
-
-    HAL_MutexDestroy(mutex);
 }
 
 uint32_t HAL_QueueReset(void *queue_handle)
 {
     QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
-    void *                  mutex = queue->queue_mutex;
 
-    HAL_MutexLock(mutex);
-    ring_buff_flush(&(queue->ring_buff));
-    HAL_MutexUnlock(mutex);
+    pthread_mutex_lock(&queue->lock);
+    queue->head  = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
 
     return QCLOUD_RET_SUCCESS;
 }
 
 unsigned long HAL_QueueItemWaitingCount(void *queue_handle)
 {
-    QCLOUD_MESSAGE_QUEUE_T *queue     = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
-    sRingbuff *             ring_buff = &(queue->ring_buff);
-    void *                  mutex     = queue->queue_mutex;
-    int                     len       = 0;
+    QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
+    unsigned long           count;
 
-    HAL_MutexLock(mutex);
+    pthread_mutex_lock(&queue->lock);
+    count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
 
-    if (ring_buff->readpoint > ring_buff->writepoint) {
-        len = ring_buff->size - ring_buff->readpoint;
-        len += ring_buff->writepoint;
-    } else {
-        len = ring_buff->writepoint - ring_buff->readpoint;
+    return count;
+}
+
+unsigned long HAL_QueueItemPopBatch(void *queue_handle, void *const item_buffer, unsigned long max_items,
+                                    uint32_t wait_timeout)
+{
+    QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
+    uint32_t                item_size;
+    uint32_t                num, first;
+
+    if (!max_items) {
+        return 0;
     }
 
-    HAL_MutexUnlock(mutex);
+    pthread_mutex_lock(&queue->lock);
+    if (QCLOUD_RET_SUCCESS != _queue_wait(queue, &queue->not_empty, 0, wait_timeout)) {
+        pthread_mutex_unlock(&queue->lock);
+        return 0;
+    }
 
-    if (len % queue->queue_item_size) {
-        Log_e("error ring buff size error");
+    item_size = queue->queue_item_size;
+    num       = queue->count < max_items ? queue->count : max_items;
+    first     = queue->queue_length - queue->head;
+    if (first > num) {
+        first = num;
     }
+    memcpy(item_buffer, queue->items + queue->head * item_size, first * item_size);
+    memcpy((char *)item_buffer + first * item_size, queue->items, (num - first) * item_size);
 
-    return len / queue->queue_item_size;
+    queue->head = (queue->head + num) % queue->queue_length;
+    queue->count -= num;
+
+    if (num > 1) {
+        pthread_cond_broadcast(&queue->not_full);
+    } else {
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return num;
 }
 
 unsigned long HAL_QueueItemPop(void *queue_handle, void *const item_buffer, uint32_t wait_timeout)
 {
-    QCLOUD_MESSAGE_QUEUE_T *queue     = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
-    sRingbuff *             ring_buff = &(queue->ring_buff);
-    void *                  mutex     = queue->queue_mutex;
-    int                     ret       = 0;
-
-    Timer timer;
-    InitTimer(&timer);
-    countdown_ms(&timer, (unsigned int)wait_timeout);
-
-    while (1) {
-        HAL_MutexLock(mutex);
-        ret = ring_buff_pop_data(ring_buff, item_buffer, queue->queue_item_size);
-        HAL_MutexUnlock(mutex);
-
-        if (ret == queue->queue_item_size) {
-            break;
-        } else if (expired(&timer)) {
-            return QCLOUD_ERR_FAILURE;
-        }
-
-        HAL_SleepMs(200);
-    }
-
-    return QCLOUD_RET_SUCCESS;
+    return HAL_QueueItemPopBatch(queue_handle, item_buffer, 1, wait_timeout) ? QCLOUD_RET_SUCCESS
+                                                                            : QCLOUD_ERR_FAILURE;
 }
 
 unsigned long HAL_QueueItemPush(void *queue_handle, void *const item_buffer, uint32_t wait_timeout)
 {
-    QCLOUD_MESSAGE_QUEUE_T *queue     = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
-    sRingbuff *             ring_buff = &(queue->ring_buff);
-    void *                  mutex     = queue->queue_mutex;
-    int                     ret       = 0;
-    Timer                   timer;
-
-    InitTimer(&timer);
-    countdown_ms(&timer, (unsigned int)wait_timeout);
-
-    while (1) {
-        HAL_MutexLock(mutex);
-        ret = ring_buff_push_data(ring_buff, item_buffer, queue->queue_item_size);
-        HAL_MutexUnlock(mutex);
-
-        if (ret == RINGBUFF_OK) {
-            break;
-        } else if (expired(&timer)) {
-            return QCLOUD_ERR_FAILURE;
-        }
+    QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
+    uint32_t                tail;
 
-        HAL_SleepMs(200);
+    pthread_mutex_lock(&queue->lock);
+    if (QCLOUD_RET_SUCCESS != _queue_wait(queue, &queue->not_full, 1, wait_timeout)) {
+        pthread_mutex_unlock(&queue->lock);
+        return QCLOUD_ERR_FAILURE;
     }
 
+    tail = (queue->head + queue->count) % queue->queue_length;
+    memcpy(queue->items + tail * queue->queue_item_size, item_buffer, queue->queue_item_size);
+    queue->count++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+
     return QCLOUD_RET_SUCCESS;
 }
 #endif  // WIFI_CONFIG_ENABLED
@@ -0,0 +1,123 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2018-2020 THL A29 Limited, a Tencent company. All rights
+ reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "qcloud_iot_export_error.h"
+#include "qcloud_iot_export_log.h"
+#include "qcloud_iot_import.h"
+#include "qcloud_iot_import_linux.h"
+
+/* max events taken by one epoll_wait */
+#define HAL_POLLER_MAX_EVENTS 128
+
+typedef struct {
+    int                epfd;
+    struct epoll_event events[HAL_POLLER_MAX_EVENTS];
+} EpollPoller;
+
+void *HAL_PollerCreate(void)
+{
+    EpollPoller *poller = (EpollPoller *)HAL_Malloc(sizeof(EpollPoller));
+    if (NULL == poller) {
+        Log_e("malloc poller failed");
+        return NULL;
+    }
+
+    poller->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (poller->epfd < 0) {
+        Log_e("epoll_create1 error: %s", strerror(errno));
+        HAL_Free(poller);
+        return NULL;
+    }
+
+    return poller;
+}
+
+void HAL_PollerDestroy(void *poller)
+{
+    if (NULL == poller) {
+        return;
+    }
+
+    close(((EpollPoller *)poller)->epfd);
+    HAL_Free(poller);
+}
+
+int HAL_PollerAdd(void *poller, int fd, void *ctx)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    /* level triggered, so a socket not drained in one round is reported again */
+    ev.events   = EPOLLIN | EPOLLRDHUP;
+    ev.data.ptr = ctx;
+
+    if (0 != epoll_ctl(((EpollPoller *)poller)->epfd, EPOLL_CTL_ADD, fd, &ev)) {
+        Log_e("epoll_ctl add fd %d error: %s", fd, strerror(errno));
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int HAL_PollerDel(void *poller, int fd)
+{
+    struct epoll_event ev;
+
+    /* closed socket is removed by kernel already */
+    memset(&ev, 0, sizeof(ev));
+    if (0 != epoll_ctl(((EpollPoller *)poller)->epfd, EPOLL_CTL_DEL, fd, &ev) && EBADF != errno && ENOENT != errno) {
+        Log_e("epoll_ctl del fd %d error: %s", fd, strerror(errno));
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int HAL_PollerWait(void *poller, void **ready_ctx, int max_cnt, uint32_t timeout_ms)
+{
+    EpollPoller *p = (EpollPoller *)poller;
+    int          i, ret;
+
+    if (max_cnt > HAL_POLLER_MAX_EVENTS) {
+        max_cnt = HAL_POLLER_MAX_EVENTS;
+    }
+
+    do {
+        ret = epoll_wait(p->epfd, p->events, max_cnt, (int)timeout_ms);
+    } while (ret < 0 && EINTR == errno);
+
+    if (ret < 0) {
+        Log_e("epoll_wait error: %s", strerror(errno));
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    for (i = 0; i < ret; i++) {
+        ready_ctx[i] = p->events[i].data.ptr;
+    }
+
+    return ret;
+}
@@ -19,23 +19,40 @@
  *
  */
 
+/* getaddrinfo_a() for DNS without blocking */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "qcloud_iot_common.h"
 #include "qcloud_iot_export_error.h"
 #include "qcloud_iot_export_log.h"
 #include "qcloud_iot_import.h"
+#include "qcloud_iot_import_linux.h"
+
+/* getaddrinfo_a() is in libc itself since glibc 2.34, older ones need libanl */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+#define TCP_ASYNC_RESOLVE
+#endif
 
 static uint64_t _linux_get_time_ms(void)
 {
@@ -62,60 +79,597 @@ static uint64_t _linux_time_left(uint64_t t_end, uint64_t t_now)
     return t_left;
 }
 
-uintptr_t HAL_TCP_Connect(const char *host, uint16_t port)
+/* TCP keepalive: idle time before probing, probe interval (unit: s) and count */
+#define HAL_TCP_KEEPIDLE  60
+#define HAL_TCP_KEEPINTVL 10
+#define HAL_TCP_KEEPCNT   3
+
+/* MQTT packets are small and written in one go, no need to wait for Nagle; and find dead peer while idle */
+static void _tcp_set_sockopt(int fd)
 {
-    int             ret;
-    struct addrinfo hints, *addr_list, *cur;
-    int             fd = 0;
+    int opt = 1;
+
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt)) < 0) {
+        Log_w("setsockopt error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+        return;
+    }
 
-    char port_str[6];
-    HAL_Snprintf(port_str, 6, "%d", port);
+    opt = HAL_TCP_KEEPIDLE;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &opt, sizeof(opt));
+    opt = HAL_TCP_KEEPINTVL;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &opt, sizeof(opt));
+    opt = HAL_TCP_KEEPCNT;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &opt, sizeof(opt));
+}
 
-    memset(&hints, 0x00, sizeof(hints));
-    hints.ai_family   = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
+/* addresses kept per host, and raced in one connect */
+#define HAL_TCP_MAX_ADDRS 8
 
-    ret = getaddrinfo(host, port_str, &hints, &addr_list);
-    if (ret) {
-        if (ret == EAI_SYSTEM)
-            Log_e("getaddrinfo(%s:%s) error: %s", STRING_PTR_PRINT_SANITY_CHECK(host), port_str, strerror(errno));
-        else
-            Log_e("getaddrinfo(%s:%s) error: %s", STRING_PTR_PRINT_SANITY_CHECK(host), port_str, gai_strerror(ret));
+/* resolved addresses are reused for this long, getaddrinfo() doesn't tell the record TTL */
+#define HAL_DNS_CACHE_SIZE   4
+#define HAL_DNS_CACHE_TTL_MS (300 * 1000)
+#define HAL_DNS_HOST_LEN     128
+
+/* next address is tried when the previous one hasn't connected within the delay (RFC 8305),
+ * and each attempt is given up after its own timeout */
+#define HAL_TCP_CONNECT_DELAY_MS   250
+#define HAL_TCP_CONNECT_TIMEOUT_MS 5000
+
+typedef struct {
+    socklen_t               len;
+    struct sockaddr_storage addr;
+} TCPAddr;
+
+typedef struct {
+    char     host[HAL_DNS_HOST_LEN];  // empty if entry not used
+    uint64_t expire_ms;
+    int      addr_cnt;
+    TCPAddr  addrs[HAL_TCP_MAX_ADDRS];  // port not set
+} DNSCacheEntry;
+
+/* shared by every connection of the process: MQTT, HTTP(S) and log upload */
+static DNSCacheEntry   sg_dns_cache[HAL_DNS_CACHE_SIZE];
+static pthread_mutex_t sg_dns_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool _dns_cache_get(const char *host, TCPAddr *addrs, int *addr_cnt)
+{
+    uint64_t now   = _linux_get_time_ms();
+    bool     found = false;
+    int      i;
+
+    pthread_mutex_lock(&sg_dns_lock);
+    for (i = 0; i < HAL_DNS_CACHE_SIZE; i++) {
+        if (0 == strcmp(sg_dns_cache[i].host, host) && now < sg_dns_cache[i].expire_ms) {
+            *addr_cnt = sg_dns_cache[i].addr_cnt;
+            memcpy(addrs, sg_dns_cache[i].addrs, sizeof(TCPAddr) * (*addr_cnt));
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sg_dns_lock);
+
+    return found;
+}
+
+static void _dns_cache_put(const char *host, const TCPAddr *addrs, int addr_cnt)
+{
+    DNSCacheEntry *entry = &sg_dns_cache[0];
+    int            i;
+
+    if (strlen(host) >= HAL_DNS_HOST_LEN || 0 == addr_cnt) {
+        return;
+    }
+
+    /* same host, or the one expiring first */
+    pthread_mutex_lock(&sg_dns_lock);
+    for (i = 0; i < HAL_DNS_CACHE_SIZE; i++) {
+        if (0 == strcmp(sg_dns_cache[i].host, host)) {
+            entry = &sg_dns_cache[i];
+            break;
+        }
+        if (sg_dns_cache[i].expire_ms < entry->expire_ms) {
+            entry = &sg_dns_cache[i];
+        }
+    }
+    strcpy(entry->host, host);
+    entry->expire_ms = _linux_get_time_ms() + HAL_DNS_CACHE_TTL_MS;
+    entry->addr_cnt  = addr_cnt;
+    memcpy(entry->addrs, addrs, sizeof(TCPAddr) * addr_cnt);
+    pthread_mutex_unlock(&sg_dns_lock);
+}
+
+/* none of the addresses connects, resolve again next time */
+static void _dns_cache_drop(const char *host)
+{
+    int i;
+
+    pthread_mutex_lock(&sg_dns_lock);
+    for (i = 0; i < HAL_DNS_CACHE_SIZE; i++) {
+        if (0 == strcmp(sg_dns_cache[i].host, host)) {
+            sg_dns_cache[i].host[0]   = '\0';
+            sg_dns_cache[i].expire_ms = 0;
+        }
+    }
+    pthread_mutex_unlock(&sg_dns_lock);
+}
+
+/* copy the resolved addresses, alternating the families so that both IPv6 and IPv4 are raced early */
+static int _tcp_addr_from_list(const struct addrinfo *addr_list, TCPAddr *addrs)
+{
+    const struct addrinfo *fam[2][HAL_TCP_MAX_ADDRS];
+    const struct addrinfo *cur;
+    int                    cnt[2] = {0, 0};
+    int                    first, f, i, n = 0;
+
+    if (NULL == addr_list) {
         return 0;
     }
 
+    /* keep the resolver's order inside each family, and start with its preferred one */
+    first = addr_list->ai_family;
     for (cur = addr_list; cur != NULL; cur = cur->ai_next) {
-        fd = (int)socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+        if ((AF_INET != cur->ai_family && AF_INET6 != cur->ai_family) || cur->ai_addrlen > sizeof(addrs[0].addr)) {
+            continue;
+        }
+        f = (cur->ai_family == first) ? 0 : 1;
+        if (cnt[f] < HAL_TCP_MAX_ADDRS) {
+            fam[f][cnt[f]++] = cur;
+        }
+    }
+
+    for (i = 0; n < HAL_TCP_MAX_ADDRS && (i < cnt[0] || i < cnt[1]); i++) {
+        for (f = 0; f < 2 && n < HAL_TCP_MAX_ADDRS; f++) {
+            if (i < cnt[f]) {
+                addrs[n].len = fam[f][i]->ai_addrlen;
+                memcpy(&addrs[n].addr, fam[f][i]->ai_addr, fam[f][i]->ai_addrlen);
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static void _tcp_addr_set_port(TCPAddr *addrs, int addr_cnt, uint16_t port)
+{
+    int i;
+
+    for (i = 0; i < addr_cnt; i++) {
+        if (AF_INET6 == addrs[i].addr.ss_family) {
+            ((struct sockaddr_in6 *)&addrs[i].addr)->sin6_port = htons(port);
+        } else {
+            ((struct sockaddr_in *)&addrs[i].addr)->sin_port = htons(port);
+        }
+    }
+}
+
+/* resolve host from the cache, or by getaddrinfo() which blocks */
+static int _tcp_resolve(const char *host, uint16_t port, TCPAddr *addrs)
+{
+    struct addrinfo hints, *addr_list;
+    int             addr_cnt, ret;
+
+    if (!_dns_cache_get(host, addrs, &addr_cnt)) {
+        memset(&hints, 0x00, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        ret = getaddrinfo(host, NULL, &hints, &addr_list);
+        if (ret) {
+            if (ret == EAI_SYSTEM)
+                Log_e("getaddrinfo(%s:%u) error: %s", host, port, strerror(errno));
+            else
+                Log_e("getaddrinfo(%s:%u) error: %s", host, port, gai_strerror(ret));
+            return QCLOUD_ERR_TCP_UNKNOWN_HOST;
+        }
+
+        addr_cnt = _tcp_addr_from_list(addr_list, addrs);
+        freeaddrinfo(addr_list);
+        _dns_cache_put(host, addrs, addr_cnt);
+    }
+
+    _tcp_addr_set_port(addrs, addr_cnt, port);
+
+    return addr_cnt;
+}
+
+/**
+ * @brief connect attempts racing across the addresses of one host
+ */
+typedef struct {
+    TCPAddr  addrs[HAL_TCP_MAX_ADDRS];
+    int      fds[HAL_TCP_MAX_ADDRS];      // socket connecting to each address, -1 if none
+    uint64_t t_start[HAL_TCP_MAX_ADDRS];  // when the attempt started
+    int      addr_cnt;
+    int      next;    // next address to try
+    uint64_t t_next;  // when to try the next address even though others are in progress
+} TCPConnectRace;
+
+static void _tcp_race_init(TCPConnectRace *race, int addr_cnt)
+{
+    int i;
+
+    for (i = 0; i < HAL_TCP_MAX_ADDRS; i++) {
+        race->fds[i] = -1;
+    }
+    race->addr_cnt = addr_cnt;
+    race->next     = 0;
+    race->t_next   = 0;
+}
+
+static void _tcp_race_close(TCPConnectRace *race)
+{
+    int i;
+
+    for (i = 0; i < race->addr_cnt; i++) {
+        if (race->fds[i] >= 0) {
+            close(race->fds[i]);
+            race->fds[i] = -1;
+        }
+    }
+}
+
+/* start connecting to the next addresses, until one is in progress or connected (index returned) */
+static int _tcp_race_start(TCPConnectRace *race, uint64_t now)
+{
+    TCPAddr *addr;
+    int      fd, flags, i;
+
+    while (race->next < race->addr_cnt) {
+        i    = race->next++;
+        addr = &race->addrs[i];
+
+        fd = (int)socket(addr->addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
         if (fd < 0) {
-            ret = 0;
             continue;
         }
 
-        if (connect(fd, cur->ai_addr, cur->ai_addrlen) == 0) {
-            ret = fd;
-            break;
+        flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            close(fd);
+            continue;
+        }
+
+        if (connect(fd, (struct sockaddr *)&addr->addr, addr->len) == 0) {
+            race->fds[i] = fd;
+            return i;
+        }
+
+        if (EINPROGRESS == errno) {
+            race->fds[i]     = fd;
+            race->t_start[i] = now;
+            race->t_next     = now + HAL_TCP_CONNECT_DELAY_MS;
+            return QCLOUD_ERR_TCP_CONNECTING;
         }
 
         close(fd);
-        ret = 0;
     }
 
-    if (0 == ret) {
-        Log_e("fail to connect with TCP server: %s:%s", STRING_PTR_PRINT_SANITY_CHECK(host), port_str);
-    } else {
-        /* reduce log print due to frequent log server connect/disconnect */
-        if (strstr(host, LOG_UPLOAD_SERVER_PATTEN))
-            UPLOAD_DBG("connected with TCP server: %s:%s", STRING_PTR_PRINT_SANITY_CHECK(host), port_str);
-        else
-            Log_i("connected with TCP server: %s:%s", STRING_PTR_PRINT_SANITY_CHECK(host), port_str);
+    return QCLOUD_ERR_TCP_CONNECTING;
+}
+
+/**
+ * @brief Advance the attempts for wait_ms at most
+ *
+ * @return  index of the connected address, QCLOUD_ERR_TCP_CONNECTING when still in progress,
+ *          or QCLOUD_ERR_TCP_CONNECT when every address failed
+ */
+static int _tcp_race_step(TCPConnectRace *race, uint32_t wait_ms)
+{
+    struct pollfd pfds[HAL_TCP_MAX_ADDRS];
+    int           idx[HAL_TCP_MAX_ADDRS];
+    uint64_t      now, t_end, t_wake;
+    int           i, n, ret, err;
+    socklen_t     len;
+
+    t_end = _linux_get_time_ms() + wait_ms;
+
+    for (;;) {
+        now = _linux_get_time_ms();
+
+        /* give up attempts over their timeout, and move on to the next address at once */
+        n = 0;
+        for (i = 0; i < race->addr_cnt; i++) {
+            if (race->fds[i] < 0) {
+                continue;
+            }
+            if (now - race->t_start[i] >= HAL_TCP_CONNECT_TIMEOUT_MS) {
+                close(race->fds[i]);
+                race->fds[i] = -1;
+                race->t_next = now;
+                continue;
+            }
+            pfds[n].fd      = race->fds[i];
+            pfds[n].events  = POLLOUT;
+            pfds[n].revents = 0;
+            idx[n++]        = i;
+        }
+
+        if (race->next < race->addr_cnt && (0 == n || now >= race->t_next)) {
+            ret = _tcp_race_start(race, now);
+            if (ret >= 0) {
+                return ret;
+            }
+            continue;
+        }
+
+        if (0 == n) {
+            return QCLOUD_ERR_TCP_CONNECT;
+        }
+
+        t_wake = t_end;
+        if (race->next < race->addr_cnt && race->t_next < t_wake) {
+            t_wake = race->t_next;
+        }
+        for (i = 0; i < n; i++) {
+            if (race->t_start[idx[i]] + HAL_TCP_CONNECT_TIMEOUT_MS < t_wake) {
+                t_wake = race->t_start[idx[i]] + HAL_TCP_CONNECT_TIMEOUT_MS;
+            }
+        }
+
+        ret = poll(pfds, n, (int)_linux_time_left(t_wake, now));
+        if (ret < 0 && EINTR != errno) {
+            Log_e("poll error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+            return QCLOUD_ERR_TCP_CONNECT;
+        }
+
+        for (i = 0; ret > 0 && i < n; i++) {
+            if (0 == pfds[i].revents) {
+                continue;
+            }
+
+            err = 0;
+            len = sizeof(err);
+            if (getsockopt(pfds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && 0 == err) {
+                return idx[i];
+            }
+
+            close(pfds[i].fd);
+            race->fds[idx[i]] = -1;
+            race->t_next      = _linux_get_time_ms();
+        }
+
+        if (_linux_get_time_ms() >= t_end) {
+            return QCLOUD_ERR_TCP_CONNECTING;
+        }
+    }
+}
+
+/* take the connected socket out of the race, back to blocking mode as HAL_TCP_Connect gives */
+static int _tcp_race_take(TCPConnectRace *race, int index)
+{
+    int fd = race->fds[index];
+
+    race->fds[index] = -1;
+    _tcp_race_close(race);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    _tcp_set_sockopt(fd);
+
+    return fd;
+}
+
+static void _tcp_log_connected(const char *host, uint16_t port)
+{
+    /* reduce log print due to frequent log server connect/disconnect */
+    if (strstr(host, LOG_UPLOAD_SERVER_PATTEN))
+        UPLOAD_DBG("connected with TCP server: %s:%u", host, port);
+    else
+        Log_i("connected with TCP server: %s:%u", host, port);
+}
+
+uintptr_t HAL_TCP_Connect(const char *host, uint16_t port)
+{
+    TCPConnectRace race;
+    int            ret;
+
+    host = STRING_PTR_PRINT_SANITY_CHECK(host);
+
+    ret = _tcp_resolve(host, port, race.addrs);
+    if (ret < 0) {
+        return 0;
+    }
+
+    _tcp_race_init(&race, ret);
+    do {
+        ret = _tcp_race_step(&race, HAL_TCP_CONNECT_TIMEOUT_MS);
+    } while (QCLOUD_ERR_TCP_CONNECTING == ret);
+
+    if (ret < 0) {
+        Log_e("fail to connect with TCP server: %s:%u", host, port);
+        _tcp_race_close(&race);
+        _dns_cache_drop(host);
+        return 0;
     }
 
-    freeaddrinfo(addr_list);
+    ret = _tcp_race_take(&race, ret);
+    _tcp_log_connected(host, port);
 
     return (uintptr_t)ret;
 }
 
+/**
+ * @brief context of TCP connect without blocking
+ */
+typedef struct _TCPConnectCtx {
+#ifdef TCP_ASYNC_RESOLVE
+    struct gaicb           request;    // DNS request in progress
+    bool                   resolving;  // waiting for DNS result
+    struct _TCPConnectCtx *next;       // in the orphan list once stopped while the resolver still uses it
+#endif
+    struct addrinfo hints;
+    TCPConnectRace  race;
+    uint16_t        port;
+    char            host[];
+} TCPConnectCtx;
+
+#ifdef TCP_ASYNC_RESOLVE
+/* stopped contexts whose DNS request could not be cancelled, freed once the request is done */
+static TCPConnectCtx * sg_tcp_orphans     = NULL;
+static pthread_mutex_t sg_tcp_orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void _tcp_orphans_reap(void)
+{
+    TCPConnectCtx **pp, *ctx;
+
+    pthread_mutex_lock(&sg_tcp_orphan_lock);
+    pp = &sg_tcp_orphans;
+    while (NULL != (ctx = *pp)) {
+        if (EAI_INPROGRESS == gai_error(&ctx->request)) {
+            pp = &ctx->next;
+            continue;
+        }
+        *pp = ctx->next;
+        if (NULL != ctx->request.ar_result) {
+            freeaddrinfo(ctx->request.ar_result);
+        }
+        HAL_Free(ctx);
+    }
+    pthread_mutex_unlock(&sg_tcp_orphan_lock);
+}
+#endif
+
+void *HAL_TCP_ConnectStart(const char *host, uint16_t port)
+{
+    TCPConnectCtx *ctx;
+    size_t         host_len = strlen(STRING_PTR_PRINT_SANITY_CHECK(host));
+    int            ret;
+#ifdef TCP_ASYNC_RESOLVE
+    struct gaicb *list[1];
+#endif
+
+#ifdef TCP_ASYNC_RESOLVE
+    _tcp_orphans_reap();
+#endif
+
+    ctx = (TCPConnectCtx *)HAL_Malloc(sizeof(TCPConnectCtx) + host_len + 1);
+    if (NULL == ctx) {
+        Log_e("memory not enough to malloc TCP connect context");
+        return NULL;
+    }
+
+    memset(ctx, 0, sizeof(TCPConnectCtx));
+    memcpy(ctx->host, STRING_PTR_PRINT_SANITY_CHECK(host), host_len + 1);
+    ctx->port = port;
+    _tcp_race_init(&ctx->race, 0);
+
+    if (_dns_cache_get(ctx->host, ctx->race.addrs, &ret)) {
+        _tcp_addr_set_port(ctx->race.addrs, ret, port);
+        ctx->race.addr_cnt = ret;
+        return ctx;
+    }
+
+#ifdef TCP_ASYNC_RESOLVE
+    ctx->hints.ai_family   = AF_UNSPEC;
+    ctx->hints.ai_socktype = SOCK_STREAM;
+    ctx->hints.ai_protocol = IPPROTO_TCP;
+
+    list[0]                 = &ctx->request;
+    ctx->request.ar_name    = ctx->host;
+    ctx->request.ar_request = &ctx->hints;
+
+    ret = getaddrinfo_a(GAI_NOWAIT, list, 1, NULL);
+    if (ret) {
+        Log_e("getaddrinfo_a(%s:%u) error: %s", ctx->host, port, gai_strerror(ret));
+        HAL_Free(ctx);
+        return NULL;
+    }
+    ctx->resolving = true;
+#else
+    ret = _tcp_resolve(ctx->host, port, ctx->race.addrs);
+    if (ret < 0) {
+        HAL_Free(ctx);
+        return NULL;
+    }
+    ctx->race.addr_cnt = ret;
+#endif
+
+    return ctx;
+}
+
+/* one step of connect: DNS result, then the attempts racing across the addresses */
+static int _tcp_connect_step(TCPConnectCtx *ctx)
+{
+    int ret;
+
+#ifdef TCP_ASYNC_RESOLVE
+    if (ctx->resolving) {
+        ret = gai_error(&ctx->request);
+        if (EAI_INPROGRESS == ret) {
+            return QCLOUD_ERR_TCP_CONNECTING;
+        }
+
+        ctx->resolving = false;
+        if (ret) {
+            Log_e("getaddrinfo_a(%s:%u) error: %s", ctx->host, ctx->port, gai_strerror(ret));
+            return QCLOUD_ERR_TCP_UNKNOWN_HOST;
+        }
+
+        ret = _tcp_addr_from_list(ctx->request.ar_result, ctx->race.addrs);
+        freeaddrinfo(ctx->request.ar_result);
+        ctx->request.ar_result = NULL;
+
+        _dns_cache_put(ctx->host, ctx->race.addrs, ret);
+        _tcp_addr_set_port(ctx->race.addrs, ret, ctx->port);
+        ctx->race.addr_cnt = ret;
+    }
+#endif
+
+    ret = _tcp_race_step(&ctx->race, 0);
+    if (QCLOUD_ERR_TCP_CONNECT == ret) {
+        Log_e("fail to connect with TCP server: %s:%u", ctx->host, ctx->port);
+        _dns_cache_drop(ctx->host);
+    }
+
+    return ret;
+}
+
+int HAL_TCP_ConnectPoll(void *handle, uintptr_t *fd)
+{
+    TCPConnectCtx *ctx = (TCPConnectCtx *)handle;
+    int            ret;
+
+    ret = _tcp_connect_step(ctx);
+    if (ret < 0) {
+        return ret;
+    }
+
+    *fd = (uintptr_t)_tcp_race_take(&ctx->race, ret);
+    _tcp_log_connected(ctx->host, ctx->port);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+void HAL_TCP_ConnectStop(void *handle)
+{
+    TCPConnectCtx *ctx = (TCPConnectCtx *)handle;
+
+    if (NULL == ctx) {
+        return;
+    }
+
+    _tcp_race_close(&ctx->race);
+
+#ifdef TCP_ASYNC_RESOLVE
+    _tcp_orphans_reap();
+    if (ctx->resolving && EAI_NOTCANCELED == gai_cancel(&ctx->request)) {
+        /* the resolver is still using the request, do not wait for it here */
+        pthread_mutex_lock(&sg_tcp_orphan_lock);
+        ctx->next      = sg_tcp_orphans;
+        sg_tcp_orphans = ctx;
+        pthread_mutex_unlock(&sg_tcp_orphan_lock);
+        return;
+    }
+    if (ctx->resolving && NULL != ctx->request.ar_result) {
+        freeaddrinfo(ctx->request.ar_result);
+    }
+#endif
+
+    HAL_Free(ctx);
+}
+
 int HAL_TCP_Disconnect(uintptr_t fd)
 {
     int rc;
@@ -136,144 +690,232 @@ int HAL_TCP_Disconnect(uintptr_t fd)
     return 0;
 }
 
+/**
+ * @brief Wait for the socket to get ready for events, until t_end
+ *
+ * poll() rather than select(), which can't take descriptors beyond FD_SETSIZE
+ *
+ * @return  >0 when ready (or broken), 0 for timeout, <0 for failure
+ */
+static int _tcp_wait(int fd, short events, uint64_t t_end)
+{
+    struct pollfd pfd;
+    uint64_t      t_left;
+    int           ret;
+
+    do {
+        t_left = _linux_time_left(t_end, _linux_get_time_ms());
+        if (0 == t_left) {
+            return 0;
+        }
+
+        pfd.fd      = fd;
+        pfd.events  = events;
+        pfd.revents = 0;
+        ret         = poll(&pfd, 1, t_left > INT_MAX ? INT_MAX : (int)t_left);
+    } while (ret < 0 && EINTR == errno);
+
+    if (ret < 0) {
+        Log_e("poll error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+    }
+
+    return ret;
+}
+
+/*
+ * The sockets stay in blocking mode as HAL_TCP_Connect gives them to user, so
+ * each send/recv asks not to block with MSG_DONTWAIT. Data already buffered
+ * is moved right away and poll is only called when the socket runs dry (full).
+ */
 int HAL_TCP_Write(uintptr_t fd, const unsigned char *buf, uint32_t len, uint32_t timeout_ms, size_t *written_len)
 {
     int      ret;
     uint32_t len_sent;
-    uint64_t t_end, t_left;
-    fd_set   sets;
+    uint64_t t_end;
 
     t_end    = _linux_get_time_ms() + timeout_ms;
     len_sent = 0;
+    ret      = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
 
     /* send one time if timeout_ms is value 0 */
-    do {
-        t_left = _linux_time_left(t_end, _linux_get_time_ms());
-
-        if (0 != t_left) {
-            struct timeval timeout;
-
-            FD_ZERO(&sets);
-            FD_SET(fd, &sets);
+    while (len_sent < len) {
+        ret = send(fd, buf + len_sent, len - len_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret > 0) {
+            len_sent += ret;
+            continue;
+        }
 
-            timeout.tv_sec  = t_left / 1000;
-            timeout.tv_usec = (t_left % 1000) * 1000;
+        if (ret < 0 && EINTR == errno) {
+            continue;
+        }
 
-            ret = select(fd + 1, NULL, &sets, NULL, &timeout);
+        if (ret < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+            ret = _tcp_wait((int)fd, POLLOUT, t_end);
             if (ret > 0) {
-                if (0 == FD_ISSET(fd, &sets)) {
-                    Log_e("Should NOT arrive");
-                    /* If timeout in next loop, it will not sent any data */
-                    ret = 0;
-                    continue;
-                }
-            } else if (0 == ret) {
+                continue;
+            }
+
+            if (0 == ret) {
                 ret = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
-                Log_e("select-write timeout %d", (int)fd);
-                break;
+                Log_e("poll-write timeout %d", (int)fd);
             } else {
-                if (EINTR == errno) {
-                    Log_e("EINTR be caught");
-                    continue;
-                }
-
                 ret = QCLOUD_ERR_TCP_WRITE_FAIL;
-                Log_e("select-write fail: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
-                break;
             }
-        } else {
-            ret = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
+            break;
         }
 
-        if (ret > 0) {
-            ret = send(fd, buf + len_sent, len - len_sent, 0);
-            if (ret > 0) {
-                len_sent += ret;
-            } else if (0 == ret) {
-                Log_e("No data be sent. Should NOT arrive");
-            } else {
-                if (EINTR == errno) {
-                    Log_e("EINTR be caught");
+        ret = QCLOUD_ERR_TCP_WRITE_FAIL;
+        Log_e("send fail: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+        break;
+    }
+
+    *written_len = (size_t)len_sent;
+
+    return len_sent > 0 ? QCLOUD_RET_SUCCESS : ret;
+}
+
+/* segments handed to kernel in one sendmsg call */
+#define HAL_TCP_IOV_MAX 8
+
+int HAL_TCP_Writev(uintptr_t fd, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len)
+{
+    int           ret, i, cnt, idx;
+    size_t        len, len_sent, off;
+    uint64_t      t_end;
+    struct iovec  vec[HAL_TCP_IOV_MAX];
+    struct msghdr msg;
+
+    t_end    = _linux_get_time_ms() + timeout_ms;
+    len_sent = 0;
+    len      = 0;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].len;
+    }
+
+    /* idx/off: first segment and offset inside it not sent yet */
+    idx = 0;
+    off = 0;
+    ret = QCLOUD_RET_SUCCESS;
+
+    while (len_sent < len) {
+        for (cnt = 0, i = idx; i < iovcnt && cnt < HAL_TCP_IOV_MAX; i++) {
+            if (0 == iov[i].len - (i == idx ? off : 0)) {
+                continue;
+            }
+            vec[cnt].iov_base = (void *)(iov[i].data + (i == idx ? off : 0));
+            vec[cnt].iov_len  = iov[i].len - (i == idx ? off : 0);
+            cnt++;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = vec;
+        msg.msg_iovlen = cnt;
+
+        ret = sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                ret = _tcp_wait((int)fd, POLLOUT, t_end);
+                if (ret > 0) {
                     continue;
                 }
 
-                ret = QCLOUD_ERR_TCP_WRITE_FAIL;
-                Log_e("send fail: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+                if (0 == ret) {
+                    ret = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
+                    Log_e("poll-write timeout %d", (int)fd);
+                } else {
+                    ret = QCLOUD_ERR_TCP_WRITE_FAIL;
+                }
                 break;
             }
+
+            ret = QCLOUD_ERR_TCP_WRITE_FAIL;
+            Log_e("sendmsg fail: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+            break;
         }
-    } while ((len_sent < len) && (_linux_time_left(t_end, _linux_get_time_ms()) > 0));
 
-    *written_len = (size_t)len_sent;
+        len_sent += ret;
+        off += ret;
+        while (idx < iovcnt && off >= iov[idx].len) {
+            off -= iov[idx].len;
+            idx++;
+        }
+    }
+
+    *written_len = len_sent;
 
     return len_sent > 0 ? QCLOUD_RET_SUCCESS : ret;
 }
 
+static void _tcp_log_peer_shutdown(uintptr_t fd)
+{
+    struct sockaddr_storage peer;
+    socklen_t               sLen = sizeof(peer);
+    char                    host[NI_MAXHOST];
+    char                    port[NI_MAXSERV];
+
+    if (getpeername(fd, (struct sockaddr *)&peer, &sLen) != 0 ||
+        getnameinfo((struct sockaddr *)&peer, sLen, host, sizeof(host), port, sizeof(port),
+                    NI_NUMERICHOST | NI_NUMERICSERV) != 0) {
+        strcpy(host, "unknown");
+        strcpy(port, "0");
+    }
+
+    /* reduce log print due to frequent log server connect/disconnect */
+    if (atoi(port) == LOG_UPLOAD_SERVER_PORT)
+        UPLOAD_DBG("connection is closed by server: %s:%s", host, port);
+    else
+        Log_e("connection is closed by server: %s:%s", host, port);
+}
+
 int HAL_TCP_Read(uintptr_t fd, unsigned char *buf, uint32_t len, uint32_t timeout_ms, size_t *read_len)
 {
-    int            ret, err_code;
-    uint32_t       len_recv;
-    uint64_t       t_end, t_left;
-    fd_set         sets;
-    struct timeval timeout;
+    int      ret, err_code;
+    uint32_t len_recv;
+    uint64_t t_end;
 
+    /* zero timeout: take whatever is already in the socket buffer without waiting */
     t_end    = _linux_get_time_ms() + timeout_ms;
     len_recv = 0;
     err_code = 0;
 
-    do {
-        t_left = _linux_time_left(t_end, _linux_get_time_ms());
-        if (0 == t_left) {
-            err_code = QCLOUD_ERR_TCP_READ_TIMEOUT;
-            break;
+    while (len_recv < len) {
+        ret = recv(fd, buf + len_recv, len - len_recv, MSG_DONTWAIT);
+        if (ret > 0) {
+            len_recv += ret;
+            continue;
         }
 
-        FD_ZERO(&sets);
-        FD_SET(fd, &sets);
+        if (0 == ret) {
+            /* zero timeout callers only peek at the socket, keep them quiet */
+            if (0 != timeout_ms) {
+                _tcp_log_peer_shutdown(fd);
+            }
+            err_code = QCLOUD_ERR_TCP_PEER_SHUTDOWN;
+            break;
+        }
 
-        timeout.tv_sec  = t_left / 1000;
-        timeout.tv_usec = (t_left % 1000) * 1000;
+        if (EINTR == errno) {
+            continue;
+        }
 
-        ret = select(fd + 1, &sets, NULL, NULL, &timeout);
-        if (ret > 0) {
-            ret = recv(fd, buf + len_recv, len - len_recv, 0);
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            ret = _tcp_wait((int)fd, POLLIN, t_end);
             if (ret > 0) {
-                len_recv += ret;
-            } else if (0 == ret) {
-                struct sockaddr_in peer;
-                socklen_t          sLen      = sizeof(peer);
-                int                peer_port = 0;
-                getpeername(fd, (struct sockaddr *)&peer, &sLen);
-                peer_port = ntohs(peer.sin_port);
-
-                /* reduce log print due to frequent log server connect/disconnect */
-                if (peer_port == LOG_UPLOAD_SERVER_PORT)
-                    UPLOAD_DBG("connection is closed by server: %s:%d",
-                               STRING_PTR_PRINT_SANITY_CHECK(inet_ntoa(peer.sin_addr)), peer_port);
-                else
-                    Log_e("connection is closed by server: %s:%d",
-                          STRING_PTR_PRINT_SANITY_CHECK(inet_ntoa(peer.sin_addr)), peer_port);
-
-                err_code = QCLOUD_ERR_TCP_PEER_SHUTDOWN;
-                break;
-            } else {
-                if (EINTR == errno) {
-                    Log_e("EINTR be caught");
-                    continue;
-                }
-                Log_e("recv error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
-                err_code = QCLOUD_ERR_TCP_READ_FAIL;
-                break;
+                continue;
             }
-        } else if (0 == ret) {
-            err_code = QCLOUD_ERR_TCP_READ_TIMEOUT;
-            break;
-        } else {
-            Log_e("select-recv error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
-            err_code = QCLOUD_ERR_TCP_READ_FAIL;
+
+            err_code = (0 == ret) ? QCLOUD_ERR_TCP_READ_TIMEOUT : QCLOUD_ERR_TCP_READ_FAIL;
             break;
         }
-    } while ((len_recv < len));
+
+        Log_e("recv error: %s", STRING_PTR_PRINT_SANITY_CHECK(strerror(errno)));
+        err_code = QCLOUD_ERR_TCP_READ_FAIL;
+        break;
+    }
 
     *read_len = (size_t)len_recv;
 
@@ -282,3 +924,14 @@ int HAL_TCP_Read(uintptr_t fd, unsigned char *buf, uint32_t len, uint32_t timeou
 
     return (len == len_recv) ? QCLOUD_RET_SUCCESS : err_code;
 }
+
+int HAL_TCP_ReadableBytes(uintptr_t fd)
+{
+    int len = 0;
+
+    if (ioctl((int)fd, FIONREAD, &len) < 0) {
+        return QCLOUD_ERR_TCP_READ_FAIL;
+    }
+
+    return len;
+}
@@ -70,11 +70,15 @@ char *HAL_Timer_current(char *time_str)
     if (time_str == NULL)
         return " ";
 
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    time_t now_time = tv.tv_sec;
+    return HAL_Timer_format(HAL_Timer_current_sec(), time_str);
+}
+
+char *HAL_Timer_format(long time_sec, char *time_str)
+{
+    time_t    now_time = time_sec;
+    struct tm tm_tmp;
 
-    struct tm tm_tmp = *localtime(&now_time);
+    localtime_r(&now_time, &tm_tmp);
     strftime(time_str, TIME_FORMAT_STR_LEN, "%F %T", &tm_tmp);
 
     return time_str;
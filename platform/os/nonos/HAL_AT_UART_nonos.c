@@ -78,3 +78,16 @@ int HAL_AT_Uart_Deinit(void)
 {
     return QCLOUD_RET_SUCCESS;
 }
+
+/**
+ * @brief mask the rx interrupt so bytes stay in the uart, with RTS flow
+ * control configured the module is then held off by hardware
+ */
+void HAL_AT_Uart_SetRxFlow(bool enable)
+{
+    if (enable) {
+        __HAL_UART_ENABLE_IT(pAtUart, UART_IT_RXNE);
+    } else {
+        __HAL_UART_DISABLE_IT(pAtUart, UART_IT_RXNE);
+    }
+}
@@ -303,6 +303,16 @@ error:
     return 0;
 }
 
+/* every connection sets up its own contexts on this platform */
+void *HAL_TLS_CacheCreate(TLSConnectParams *pConnectParams)
+{
+    return NULL;
+}
+
+void HAL_TLS_CacheDestroy(void *cache)
+{
+}
+
 void HAL_TLS_Disconnect(uintptr_t handle)
 {
     if ((uintptr_t)NULL == handle) {
@@ -379,6 +389,22 @@ int HAL_TLS_Read(uintptr_t handle, unsigned char *msg, size_t totalLen, uint32_t
 
     TLSDataParams *pParams = (TLSDataParams *)handle;
 
+    /* zero timeout: only hand out the plaintext already decrypted in mbedtls, no socket access */
+    if (0 == timeout_ms) {
+        size_t avail = mbedtls_ssl_get_bytes_avail(&(pParams->ssl));
+        if (0 == avail) {
+            return QCLOUD_ERR_SSL_NOTHING_TO_READ;
+        }
+
+        int read_rc = mbedtls_ssl_read(&(pParams->ssl), msg, avail < totalLen ? avail : totalLen);
+        if (read_rc <= 0) {
+            return QCLOUD_ERR_SSL_NOTHING_TO_READ;
+        }
+        *read_len = read_rc;
+
+        return (totalLen == *read_len) ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_SSL_READ_TIMEOUT;
+    }
+
     do {
         int read_rc = 0;
         read_rc     = mbedtls_ssl_read(&(pParams->ssl), msg + *read_len, totalLen - *read_len);
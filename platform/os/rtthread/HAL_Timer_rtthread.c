@@ -61,6 +61,14 @@ char *HAL_Timer_current(void)
     return now_time_str;
 }
 
+char *HAL_Timer_format(long time_sec, char *time_str)
+{
+    memset(time_str, 0, TIME_FORMAT_STR_LEN);
+    snprintf(time_str, TIME_FORMAT_STR_LEN, "%ld", time_sec);
+
+    return time_str;
+}
+
 bool HAL_Timer_expired(Timer *timer)
 {
     uint32_t now_ts;
@@ -59,4 +59,8 @@ int HAL_AT_Uart_Deinit(void)
     return QCLOUD_RET_SUCCESS;
 }
 
+void HAL_AT_Uart_SetRxFlow(bool enable)
+{
+}
+
 #endif
@@ -93,3 +93,12 @@ int HAL_FileFlush(void *fp)
 {
     return fflush((FILE *)fp);
 }
+
+const void *HAL_FileMap(void *fp, long offset, size_t len)
+{
+    return NULL;
+}
+
+void HAL_FileUnmap(const void *addr, size_t len)
+{
+}
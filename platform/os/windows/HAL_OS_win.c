@@ -175,6 +175,22 @@ unsigned long HAL_QueueItemPush(void *queue_handle, void *const item_buffer, uin
 
     return QCLOUD_RET_SUCCESS;
 }
+
+unsigned long HAL_QueueItemPopBatch(void *queue_handle, void *const item_buffer, unsigned long max_items,
+                                    uint32_t wait_timeout)
+{
+    QCLOUD_MESSAGE_QUEUE_T *queue = (QCLOUD_MESSAGE_QUEUE_T *)queue_handle;
+    unsigned long           num   = 0;
+
+    /* only the first item waits, the rest are drained without blocking */
+    while (num < max_items && QCLOUD_RET_SUCCESS == HAL_QueueItemPop(queue_handle,
+                                                                     (char *)item_buffer + num * queue->queue_item_size,
+                                                                     num ? 0 : wait_timeout)) {
+        num++;
+    }
+
+    return num;
+}
 #endif  // WIFI_CONFIG_ENABLED
 
 void *HAL_MutexCreate(void)
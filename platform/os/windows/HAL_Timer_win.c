@@ -65,10 +65,14 @@ void HAL_Timer_init(Timer *timer)
 
 char *HAL_Timer_current(char *time_str)
 {
-    time_t    now;
+    return HAL_Timer_format((long)time(NULL), time_str);
+}
+
+char *HAL_Timer_format(long time_sec, char *time_str)
+{
+    time_t    now = time_sec;
     struct tm tm_val;
 
-    time(&now);
     localtime_s(&tm_val, &now);
 
     snprintf(time_str, TIME_FORMAT_STR_LEN, "%04d/%02d/%02d %02d:%02d:%02d", tm_val.tm_year + 1900, tm_val.tm_mon + 1,
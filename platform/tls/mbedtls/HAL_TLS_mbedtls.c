@@ -41,40 +41,45 @@ extern "C" {
 #include "utils_param_check.h"
 #include "utils_timer.h"
 
+#if defined(__linux__)
+#include <poll.h>
+
+#include "qcloud_iot_import_linux.h"
+#endif
+
 #ifndef AUTH_MODE_CERT
 static const int ciphersuites[] = {MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA, MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA, 0};
 #endif
 
 /**
- * @brief data structure for mbedtls SSL connection
+ * @brief mbedtls contexts kept across connections of one client
+ *
+ * random generator, parsed CA chain and client cert/key, and the last session
+ * for an abbreviated handshake on reconnect
  */
 typedef struct {
-    mbedtls_net_context      socket_fd;
     mbedtls_entropy_context  entropy;
     mbedtls_ctr_drbg_context ctr_drbg;
-    mbedtls_ssl_context      ssl;
-    mbedtls_ssl_config       ssl_conf;
     mbedtls_x509_crt         ca_cert;
     mbedtls_x509_crt         client_cert;
     mbedtls_pk_context       private_key;
-} TLSDataParams;
+    mbedtls_ssl_session      session;      // session to resume
+    bool                     has_session;  // session is valid
+} TLSCache;
 
 /**
- * @brief free memory/resources allocated by mbedtls
+ * @brief data structure for mbedtls SSL connection
  */
-static void _free_mebedtls(TLSDataParams *pParams)
-{
-    mbedtls_net_free(&(pParams->socket_fd));
-    mbedtls_x509_crt_free(&(pParams->client_cert));
-    mbedtls_x509_crt_free(&(pParams->ca_cert));
-    mbedtls_pk_free(&(pParams->private_key));
-    mbedtls_ssl_free(&(pParams->ssl));
-    mbedtls_ssl_config_free(&(pParams->ssl_conf));
-    mbedtls_ctr_drbg_free(&(pParams->ctr_drbg));
-    mbedtls_entropy_free(&(pParams->entropy));
-
-    HAL_Free(pParams);
-}
+typedef struct {
+    mbedtls_net_context socket_fd;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config  ssl_conf;
+    TLSCache *          cache;      // cache of connect params, or own_cache if none
+    TLSCache            own_cache;  // contexts for this connection only
+#if defined(__linux__)
+    void *tcp_connect;  // TCP connect in progress by HAL_TLS_ConnectStart
+#endif
+} TLSDataParams;
 
 #if defined(MBEDTLS_DEBUG_C)
 #define DEBUG_LEVEL 0
@@ -85,46 +90,80 @@ static void _ssl_debug(void *ctx, int level, const char *file, int line, const c
 
 #endif
 
+#if defined(__linux__)
+/* same as mbedtls_net_recv_timeout but waits with poll(), select() can't take descriptors beyond FD_SETSIZE */
+static int _tls_net_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+    struct pollfd pfd;
+    int           ret;
+
+    pfd.fd      = ((mbedtls_net_context *)ctx)->fd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    if (pfd.fd < 0) {
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+    }
+
+    ret = poll(&pfd, 1, timeout == 0 ? -1 : (int)timeout);
+    if (ret == 0) {
+        return MBEDTLS_ERR_SSL_TIMEOUT;
+    }
+    if (ret < 0) {
+        return EINTR == errno ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    return mbedtls_net_recv(ctx, buf, len);
+}
+#define TLS_NET_RECV_TIMEOUT _tls_net_recv_timeout
+#else
+#define TLS_NET_RECV_TIMEOUT mbedtls_net_recv_timeout
+#endif
+
 /**
- * @brief mbedtls SSL client init
+ * @brief free contexts of TLS cache
+ */
+static void _tls_cache_free(TLSCache *pCache)
+{
+    mbedtls_ssl_session_free(&(pCache->session));
+    mbedtls_x509_crt_free(&(pCache->client_cert));
+    mbedtls_x509_crt_free(&(pCache->ca_cert));
+    mbedtls_pk_free(&(pCache->private_key));
+    mbedtls_ctr_drbg_free(&(pCache->ctr_drbg));
+    mbedtls_entropy_free(&(pCache->entropy));
+}
+
+/**
+ * @brief TLS cache init
  *
- * 1. call a series of mbedtls init functions
- * 2. init and set seed for random functions
- * 3. load CA file, cert files or PSK
+ * 1. init and set seed for random functions
+ * 2. load CA file and cert files
  *
- * @param pDataParams       mbedtls TLS parmaters
+ * @param pCache            TLS cache
  * @param pConnectParams    device info for TLS connection
  * @return                  QCLOUD_RET_SUCCESS when success, or err code for
  * failure
  */
-static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pConnectParams)
+static int _tls_cache_init(TLSCache *pCache, TLSConnectParams *pConnectParams)
 {
     int ret = QCLOUD_RET_SUCCESS;
 
-    mbedtls_net_init(&(pDataParams->socket_fd));
-    mbedtls_ssl_init(&(pDataParams->ssl));
-    mbedtls_ssl_config_init(&(pDataParams->ssl_conf));
-    mbedtls_ctr_drbg_init(&(pDataParams->ctr_drbg));
-    mbedtls_x509_crt_init(&(pDataParams->ca_cert));
-    mbedtls_x509_crt_init(&(pDataParams->client_cert));
-    mbedtls_pk_init(&(pDataParams->private_key));
-
-    mbedtls_entropy_init(&(pDataParams->entropy));
+    mbedtls_ctr_drbg_init(&(pCache->ctr_drbg));
+    mbedtls_x509_crt_init(&(pCache->ca_cert));
+    mbedtls_x509_crt_init(&(pCache->client_cert));
+    mbedtls_pk_init(&(pCache->private_key));
+    mbedtls_ssl_session_init(&(pCache->session));
+    pCache->has_session = false;
 
-#if defined(MBEDTLS_DEBUG_C)
-    mbedtls_debug_set_threshold(DEBUG_LEVEL);
-    mbedtls_ssl_conf_dbg(&pDataParams->ssl_conf, _ssl_debug, NULL);
-#endif
+    mbedtls_entropy_init(&(pCache->entropy));
 
     // custom parameter is NULL for now
-    if ((ret = mbedtls_ctr_drbg_seed(&(pDataParams->ctr_drbg), mbedtls_entropy_func, &(pDataParams->entropy), NULL,
-                                     0)) != 0) {
+    if ((ret = mbedtls_ctr_drbg_seed(&(pCache->ctr_drbg), mbedtls_entropy_func, &(pCache->entropy), NULL, 0)) != 0) {
         Log_e("mbedtls_ctr_drbg_seed failed returned 0x%04x", ret < 0 ? -ret : ret);
         return QCLOUD_ERR_SSL_INIT;
     }
 
     if (pConnectParams->ca_crt != NULL) {
-        if ((ret = mbedtls_x509_crt_parse(&(pDataParams->ca_cert), (const unsigned char *)pConnectParams->ca_crt,
+        if ((ret = mbedtls_x509_crt_parse(&(pCache->ca_cert), (const unsigned char *)pConnectParams->ca_crt,
                                           (pConnectParams->ca_crt_len + 1)))) {
             Log_e("parse ca crt failed returned 0x%04x", ret < 0 ? -ret : ret);
             return QCLOUD_ERR_SSL_CERT;
@@ -133,12 +172,12 @@ static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pC
 
 #ifdef AUTH_MODE_CERT
     if (pConnectParams->cert_file != NULL && pConnectParams->key_file != NULL) {
-        if ((ret = mbedtls_x509_crt_parse_file(&(pDataParams->client_cert), pConnectParams->cert_file)) != 0) {
+        if ((ret = mbedtls_x509_crt_parse_file(&(pCache->client_cert), pConnectParams->cert_file)) != 0) {
             Log_e("load client cert file failed returned 0x%x", ret < 0 ? -ret : ret);
             return QCLOUD_ERR_SSL_CERT;
         }
 
-        if ((ret = mbedtls_pk_parse_keyfile(&(pDataParams->private_key), pConnectParams->key_file, "")) != 0) {
+        if ((ret = mbedtls_pk_parse_keyfile(&(pCache->private_key), pConnectParams->key_file, "")) != 0) {
             Log_e("load client key file failed returned 0x%x", ret < 0 ? -ret : ret);
             return QCLOUD_ERR_SSL_CERT;
         }
@@ -147,7 +186,64 @@ static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pC
               STRING_PTR_PRINT_SANITY_CHECK(pConnectParams->cert_file),
               STRING_PTR_PRINT_SANITY_CHECK(pConnectParams->key_file));
     }
-#else
+#endif
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief free memory/resources allocated by mbedtls
+ */
+static void _free_mebedtls(TLSDataParams *pParams)
+{
+#if defined(__linux__)
+    HAL_TCP_ConnectStop(pParams->tcp_connect);
+#endif
+    mbedtls_net_free(&(pParams->socket_fd));
+    mbedtls_ssl_free(&(pParams->ssl));
+    mbedtls_ssl_config_free(&(pParams->ssl_conf));
+    if (&(pParams->own_cache) == pParams->cache) {
+        _tls_cache_free(pParams->cache);
+    }
+
+    HAL_Free(pParams);
+}
+
+/**
+ * @brief mbedtls SSL client init
+ *
+ * 1. call a series of mbedtls init functions
+ * 2. take the TLS cache of connect params, or init one for this connection
+ * 3. load PSK
+ *
+ * @param pDataParams       mbedtls TLS parmaters
+ * @param pConnectParams    device info for TLS connection
+ * @return                  QCLOUD_RET_SUCCESS when success, or err code for
+ * failure
+ */
+static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pConnectParams)
+{
+    int ret = QCLOUD_RET_SUCCESS;
+
+    mbedtls_net_init(&(pDataParams->socket_fd));
+    mbedtls_ssl_init(&(pDataParams->ssl));
+    mbedtls_ssl_config_init(&(pDataParams->ssl_conf));
+
+#if defined(MBEDTLS_DEBUG_C)
+    mbedtls_debug_set_threshold(DEBUG_LEVEL);
+    mbedtls_ssl_conf_dbg(&pDataParams->ssl_conf, _ssl_debug, NULL);
+#endif
+
+    if (NULL != pConnectParams->cache) {
+        pDataParams->cache = (TLSCache *)pConnectParams->cache;
+    } else {
+        pDataParams->cache = &(pDataParams->own_cache);
+        if ((ret = _tls_cache_init(pDataParams->cache, pConnectParams)) != QCLOUD_RET_SUCCESS) {
+            return ret;
+        }
+    }
+
+#ifndef AUTH_MODE_CERT
     if (pConnectParams->psk != NULL && pConnectParams->psk_id != NULL) {
         const char *psk_id = pConnectParams->psk_id;
         ret                = mbedtls_ssl_conf_psk(&(pDataParams->ssl_conf), (unsigned char *)pConnectParams->psk,
@@ -165,6 +261,33 @@ static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pC
     return QCLOUD_RET_SUCCESS;
 }
 
+void *HAL_TLS_CacheCreate(TLSConnectParams *pConnectParams)
+{
+    TLSCache *pCache = (TLSCache *)HAL_Malloc(sizeof(TLSCache));
+    if (NULL == pCache) {
+        Log_e("memory not enough to malloc TLS cache");
+        return NULL;
+    }
+
+    if (_tls_cache_init(pCache, pConnectParams) != QCLOUD_RET_SUCCESS) {
+        _tls_cache_free(pCache);
+        HAL_Free(pCache);
+        return NULL;
+    }
+
+    return pCache;
+}
+
+void HAL_TLS_CacheDestroy(void *cache)
+{
+    if (NULL == cache) {
+        return;
+    }
+
+    _tls_cache_free((TLSCache *)cache);
+    HAL_Free(cache);
+}
+
 /**
  * @brief Setup TCP connection
  *
@@ -175,6 +298,16 @@ static int _mbedtls_client_init(TLSDataParams *pDataParams, TLSConnectParams *pC
  */
 int _mbedtls_tcp_connect(mbedtls_net_context *socket_fd, const char *host, int port)
 {
+#if defined(__linux__)
+    /* share the DNS cache and the racing connect of TCP HAL */
+    uintptr_t fd = HAL_TCP_Connect(host, (uint16_t)port);
+    if (0 == fd) {
+        return QCLOUD_ERR_TCP_CONNECT;
+    }
+    socket_fd->fd = (int)fd;
+
+    return QCLOUD_RET_SUCCESS;
+#else
     int  ret = 0;
     char port_str[6];
     HAL_Snprintf(port_str, 6, "%d", port);
@@ -197,6 +330,7 @@ int _mbedtls_tcp_connect(mbedtls_net_context *socket_fd, const char *host, int p
     }
 
     return QCLOUD_RET_SUCCESS;
+#endif
 }
 
 /**
@@ -211,40 +345,46 @@ int _qcloud_server_certificate_verify(void *hostname, mbedtls_x509_crt *crt, int
     return *flags;
 }
 
-uintptr_t HAL_TLS_Connect(TLSConnectParams *pConnectParams, const char *host, int port)
+/**
+ * @brief Setup SSL/TLS structure of client, before TCP connection
+ *
+ * @param pDataParams       mbedtls TLS parmaters
+ * @param pConnectParams    device info for TLS connection
+ * @param host              server address
+ * @return                  QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+static int _mbedtls_client_setup(TLSDataParams *pDataParams, TLSConnectParams *pConnectParams, const char *host)
 {
     int ret = 0;
 
-    TLSDataParams *pDataParams = (TLSDataParams *)HAL_Malloc(sizeof(TLSDataParams));
-
     if ((ret = _mbedtls_client_init(pDataParams, pConnectParams)) != QCLOUD_RET_SUCCESS) {
-        goto error;
+        return ret;
     }
 
     Log_d("Setting up the SSL/TLS structure...");
     if ((ret = mbedtls_ssl_config_defaults(&(pDataParams->ssl_conf), MBEDTLS_SSL_IS_CLIENT,
                                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
         Log_e("mbedtls_ssl_config_defaults failed returned 0x%04x", ret < 0 ? -ret : ret);
-        goto error;
+        return ret;
     }
 
     mbedtls_ssl_conf_verify(&(pDataParams->ssl_conf), _qcloud_server_certificate_verify, (void *)host);
 
     mbedtls_ssl_conf_authmode(&(pDataParams->ssl_conf), MBEDTLS_SSL_VERIFY_REQUIRED);
 
-    mbedtls_ssl_conf_rng(&(pDataParams->ssl_conf), mbedtls_ctr_drbg_random, &(pDataParams->ctr_drbg));
+    mbedtls_ssl_conf_rng(&(pDataParams->ssl_conf), mbedtls_ctr_drbg_random, &(pDataParams->cache->ctr_drbg));
 
-    mbedtls_ssl_conf_ca_chain(&(pDataParams->ssl_conf), &(pDataParams->ca_cert), NULL);
-    if ((ret = mbedtls_ssl_conf_own_cert(&(pDataParams->ssl_conf), &(pDataParams->client_cert),
-                                         &(pDataParams->private_key))) != 0) {
+    mbedtls_ssl_conf_ca_chain(&(pDataParams->ssl_conf), &(pDataParams->cache->ca_cert), NULL);
+    if ((ret = mbedtls_ssl_conf_own_cert(&(pDataParams->ssl_conf), &(pDataParams->cache->client_cert),
+                                         &(pDataParams->cache->private_key))) != 0) {
         Log_e("mbedtls_ssl_conf_own_cert failed returned 0x%04x", ret < 0 ? -ret : ret);
-        goto error;
+        return ret;
     }
 
     mbedtls_ssl_conf_read_timeout(&(pDataParams->ssl_conf), pConnectParams->timeout_ms);
     if ((ret = mbedtls_ssl_setup(&(pDataParams->ssl), &(pDataParams->ssl_conf))) != 0) {
         Log_e("mbedtls_ssl_setup failed returned 0x%04x", ret < 0 ? -ret : ret);
-        goto error;
+        return ret;
     }
 
 #ifndef AUTH_MODE_CERT
@@ -257,11 +397,75 @@ uintptr_t HAL_TLS_Connect(TLSConnectParams *pConnectParams, const char *host, in
     // Set the hostname to check against the received server certificate and sni
     if ((ret = mbedtls_ssl_set_hostname(&(pDataParams->ssl), host)) != 0) {
         Log_e("mbedtls_ssl_set_hostname failed returned 0x%04x", ret < 0 ? -ret : ret);
-        goto error;
+        return ret;
     }
 
     mbedtls_ssl_set_bio(&(pDataParams->ssl), &(pDataParams->socket_fd), mbedtls_net_send, mbedtls_net_recv,
-                        mbedtls_net_recv_timeout);
+                        TLS_NET_RECV_TIMEOUT);
+
+    // offer the last session for an abbreviated handshake, server falls back to a full one if it is gone
+    if (pDataParams->cache->has_session) {
+        if ((ret = mbedtls_ssl_set_session(&(pDataParams->ssl), &(pDataParams->cache->session))) != 0) {
+            Log_w("mbedtls_ssl_set_session failed returned 0x%04x", ret < 0 ? -ret : ret);
+        }
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Check result of the handshake done
+ *
+ * @param pDataParams       mbedtls TLS parmaters
+ * @return                  QCLOUD_RET_SUCCESS when success, or err code for failure
+ */
+static int _mbedtls_handshake_done(TLSDataParams *pDataParams)
+{
+    int ret = 0;
+
+    if ((ret = mbedtls_ssl_get_verify_result(&(pDataParams->ssl))) != 0) {
+        Log_e("mbedtls_ssl_get_verify_result failed returned 0x%04x", ret < 0 ? -ret : ret);
+        return QCLOUD_ERR_SSL_CONNECT;
+    }
+
+    mbedtls_ssl_conf_read_timeout(&(pDataParams->ssl_conf), 100);
+
+    // keep the session to resume on reconnect, no use for a cache of this connection only
+    if (&(pDataParams->own_cache) != pDataParams->cache) {
+        ret                             = mbedtls_ssl_get_session(&(pDataParams->ssl), &(pDataParams->cache->session));
+        pDataParams->cache->has_session = (0 == ret);
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static void _mbedtls_handshake_error(TLSDataParams *pDataParams, int ret)
+{
+    // the session may be what the server rejects
+    pDataParams->cache->has_session = false;
+
+    Log_e("mbedtls_ssl_handshake failed returned 0x%04x", ret < 0 ? -ret : ret);
+    if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+        Log_e("Unable to verify the server's certificate");
+    }
+}
+
+uintptr_t HAL_TLS_Connect(TLSConnectParams *pConnectParams, const char *host, int port)
+{
+    int ret = 0;
+
+    TLSDataParams *pDataParams = (TLSDataParams *)HAL_Malloc(sizeof(TLSDataParams));
+    if (NULL == pDataParams) {
+        Log_e("memory not enough to malloc TLS connection");
+        return 0;
+    }
+#if defined(__linux__)
+    pDataParams->tcp_connect = NULL;
+#endif
+
+    if ((ret = _mbedtls_client_setup(pDataParams, pConnectParams, host)) != QCLOUD_RET_SUCCESS) {
+        goto error;
+    }
 
     Log_d("Performing the SSL/TLS handshake...");
     Log_d("Connecting to /%s/%d...", STRING_PTR_PRINT_SANITY_CHECK(host), port);
@@ -271,21 +475,15 @@ uintptr_t HAL_TLS_Connect(TLSConnectParams *pConnectParams, const char *host, in
 
     while ((ret = mbedtls_ssl_handshake(&(pDataParams->ssl))) != 0) {
         if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-            Log_e("mbedtls_ssl_handshake failed returned 0x%04x", ret < 0 ? -ret : ret);
-            if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
-                Log_e("Unable to verify the server's certificate");
-            }
+            _mbedtls_handshake_error(pDataParams, ret);
             goto error;
         }
     }
 
-    if ((ret = mbedtls_ssl_get_verify_result(&(pDataParams->ssl))) != 0) {
-        Log_e("mbedtls_ssl_get_verify_result failed returned 0x%04x", ret < 0 ? -ret : ret);
+    if (_mbedtls_handshake_done(pDataParams) != QCLOUD_RET_SUCCESS) {
         goto error;
     }
 
-    mbedtls_ssl_conf_read_timeout(&(pDataParams->ssl_conf), 100);
-
     Log_d("connected with /%s/%d...", STRING_PTR_PRINT_SANITY_CHECK(host), port);
 
     return (uintptr_t)pDataParams;
@@ -295,6 +493,78 @@ error:
     return 0;
 }
 
+#if defined(__linux__)
+uintptr_t HAL_TLS_ConnectStart(TLSConnectParams *pConnectParams, const char *host, int port)
+{
+    TLSDataParams *pDataParams = (TLSDataParams *)HAL_Malloc(sizeof(TLSDataParams));
+    if (NULL == pDataParams) {
+        Log_e("memory not enough to malloc TLS connection");
+        return 0;
+    }
+    pDataParams->tcp_connect = NULL;
+
+    if (_mbedtls_client_setup(pDataParams, pConnectParams, host) != QCLOUD_RET_SUCCESS) {
+        goto error;
+    }
+
+    // no read timeout during handshake, the socket is not blocking
+    mbedtls_ssl_set_bio(&(pDataParams->ssl), &(pDataParams->socket_fd), mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    Log_d("Connecting to /%s/%d...", STRING_PTR_PRINT_SANITY_CHECK(host), port);
+    pDataParams->tcp_connect = HAL_TCP_ConnectStart(host, (uint16_t)port);
+    if (NULL == pDataParams->tcp_connect) {
+        goto error;
+    }
+
+    return (uintptr_t)pDataParams;
+
+error:
+    _free_mebedtls(pDataParams);
+    return 0;
+}
+
+int HAL_TLS_ConnectPoll(uintptr_t handle)
+{
+    TLSDataParams *pDataParams = (TLSDataParams *)handle;
+    uintptr_t      fd          = 0;
+    int            ret         = 0;
+
+    if (NULL != pDataParams->tcp_connect) {
+        ret = HAL_TCP_ConnectPoll(pDataParams->tcp_connect, &fd);
+        if (QCLOUD_RET_SUCCESS != ret) {
+            return ret;
+        }
+
+        HAL_TCP_ConnectStop(pDataParams->tcp_connect);
+        pDataParams->tcp_connect  = NULL;
+        pDataParams->socket_fd.fd = (int)fd;
+        if (mbedtls_net_set_nonblock(&(pDataParams->socket_fd)) != 0) {
+            Log_e("set nonblock failed");
+            return QCLOUD_ERR_TCP_CONNECT;
+        }
+        Log_d("Performing the SSL/TLS handshake...");
+    }
+
+    ret = mbedtls_ssl_handshake(&(pDataParams->ssl));
+    if (MBEDTLS_ERR_SSL_WANT_READ == ret || MBEDTLS_ERR_SSL_WANT_WRITE == ret) {
+        return QCLOUD_ERR_SSL_CONNECTING;
+    }
+    if (0 != ret) {
+        _mbedtls_handshake_error(pDataParams, ret);
+        return QCLOUD_ERR_SSL_CONNECT;
+    }
+
+    if (mbedtls_net_set_block(&(pDataParams->socket_fd)) != 0) {
+        Log_e("set block failed");
+        return QCLOUD_ERR_SSL_CONNECT;
+    }
+    mbedtls_ssl_set_bio(&(pDataParams->ssl), &(pDataParams->socket_fd), mbedtls_net_send, mbedtls_net_recv,
+                        TLS_NET_RECV_TIMEOUT);
+
+    return _mbedtls_handshake_done(pDataParams);
+}
+#endif
+
 void HAL_TLS_Disconnect(uintptr_t handle)
 {
     if ((uintptr_t)NULL == handle) {
@@ -303,22 +573,45 @@ void HAL_TLS_Disconnect(uintptr_t handle)
     }
     TLSDataParams *pParams = (TLSDataParams *)handle;
     int            ret     = 0;
-    do {
-        ret = mbedtls_ssl_close_notify(&(pParams->ssl));
-    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
-    mbedtls_net_free(&(pParams->socket_fd));
-    mbedtls_x509_crt_free(&(pParams->client_cert));
-    mbedtls_x509_crt_free(&(pParams->ca_cert));
-    mbedtls_pk_free(&(pParams->private_key));
-    mbedtls_ssl_free(&(pParams->ssl));
-    mbedtls_ssl_config_free(&(pParams->ssl_conf));
-    mbedtls_ctr_drbg_free(&(pParams->ctr_drbg));
-    mbedtls_entropy_free(&(pParams->entropy));
+    // nothing to notify if the handshake started by HAL_TLS_ConnectStart is not over
+    if (MBEDTLS_SSL_HANDSHAKE_OVER == pParams->ssl.state) {
+        do {
+            ret = mbedtls_ssl_close_notify(&(pParams->ssl));
+        } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    }
 
-    HAL_Free((void *)handle);
+    _free_mebedtls(pParams);
 }
 
+#if defined(__linux__)
+int HAL_TLS_GetFd(uintptr_t handle)
+{
+    if ((uintptr_t)NULL == handle) {
+        return -1;
+    }
+
+    return ((TLSDataParams *)handle)->socket_fd.fd;
+}
+
+int HAL_TLS_ReadableBytes(uintptr_t handle)
+{
+    TLSDataParams *pParams = (TLSDataParams *)handle;
+    int            len;
+
+    if ((uintptr_t)NULL == handle) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    len = HAL_TCP_ReadableBytes(pParams->socket_fd.fd);
+    if (len < 0) {
+        return len;
+    }
+
+    return len + (int)mbedtls_ssl_get_bytes_avail(&(pParams->ssl));
+}
+#endif
+
 int HAL_TLS_Write(uintptr_t handle, unsigned char *msg, size_t totalLen, uint32_t timeout_ms, size_t *written_len)
 {
     Timer timer;
@@ -368,6 +661,22 @@ int HAL_TLS_Read(uintptr_t handle, unsigned char *msg, size_t totalLen, uint32_t
 
     TLSDataParams *pParams = (TLSDataParams *)handle;
 
+    /* zero timeout: only hand out the plaintext already decrypted in mbedtls, no socket access */
+    if (0 == timeout_ms) {
+        size_t avail = mbedtls_ssl_get_bytes_avail(&(pParams->ssl));
+        if (0 == avail) {
+            return QCLOUD_ERR_SSL_NOTHING_TO_READ;
+        }
+
+        int read_rc = mbedtls_ssl_read(&(pParams->ssl), msg, avail < totalLen ? avail : totalLen);
+        if (read_rc <= 0) {
+            return QCLOUD_ERR_SSL_NOTHING_TO_READ;
+        }
+        *read_len = read_rc;
+
+        return (totalLen == *read_len) ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_SSL_READ_TIMEOUT;
+    }
+
     do {
         int read_rc = 0;
         read_rc     = mbedtls_ssl_read(&(pParams->ssl), msg + *read_len, totalLen - *read_len);
@@ -22,35 +22,28 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "lite-utils.h"
 #include "qcloud_iot_export.h"
 #include "qcloud_iot_import.h"
 #include "utils_getopt.h"
 
 #define FW_RUNNING_VERSION "1.0.0"
 
-#define KEY_VER  "version"
-#define KEY_SIZE "downloaded_size"
-
 #define FW_VERSION_MAX_LEN    32
 #define FW_FILE_PATH_MAX_LEN  128
 #define OTA_BUF_LEN           5000
-#define FW_INFO_FILE_DATA_LEN 128
 
 typedef struct OTAContextData {
     void *ota_handle;
     void *mqtt_client;
     char  fw_file_path[FW_FILE_PATH_MAX_LEN];
-    char  fw_info_file_path[FW_FILE_PATH_MAX_LEN];
+    char  fw_ckpt_file_path[FW_FILE_PATH_MAX_LEN];
 
     // remote_version means version for the FW in the cloud and to be downloaded
     char     remote_version[FW_VERSION_MAX_LEN];
     uint32_t fw_file_size;
 
     // for resuming download
-    /* local_version means downloading but not running */
-    char local_version[FW_VERSION_MAX_LEN];
-    int  downloaded_size;
+    uint32_t downloaded_size;
 
     // to make sure report is acked
     bool report_pub_ack;
@@ -174,193 +167,49 @@ static void _wait_for_pub_ack(OTAContextData *ota_ctx, int packet_id)
  * these are platform-dependant functions
  * POSIX FILE is used in this sample code
  **********************************************************************************/
-// calculate left MD5 for resuming download from break point
-static int _cal_exist_fw_md5(OTAContextData *ota_ctx)
+static int _save_fw_data_to_file(char *file_name, uint32_t offset, char *buf, int len)
 {
-    char   buff[OTA_BUF_LEN];
-    size_t rlen, total_read = 0;
-    int    ret = QCLOUD_RET_SUCCESS;
+    void *fp = NULL;
 
-    ret = IOT_OTA_ResetClientMD5(ota_ctx->ota_handle);
-    if (ret) {
-        Log_e("reset MD5 failed: %d", ret);
-        return QCLOUD_ERR_FAILURE;
+    /* not "ab+": appending ignores the seek, and the file may hold data past
+     * the checkpoint offset that has to be overwritten on resume */
+    if (offset > 0) {
+        fp = HAL_FileOpen(file_name, "rb+");
     }
-
-    void *fp = HAL_FileOpen(ota_ctx->fw_file_path, "ab+");
-    if (NULL == fp) {
-        Log_e("open file %s failed", ota_ctx->fw_file_path);
+    if (NULL == fp && NULL == (fp = HAL_FileOpen(file_name, "wb+"))) {
+        Log_e("open file failed");
         return QCLOUD_ERR_FAILURE;
     }
 
-    // rewind(fp);
-    size_t size = ota_ctx->downloaded_size;
-
-    while ((size > 0) && (!HAL_FileEof(fp))) {
-        rlen = (size > OTA_BUF_LEN) ? OTA_BUF_LEN : size;
-        if (rlen != HAL_FileRead(buff, 1, rlen, fp)) {
-            Log_e("read data len not expected");
-            ret = QCLOUD_ERR_FAILURE;
-            break;
-        }
-        IOT_OTA_UpdateClientMd5(ota_ctx->ota_handle, buff, rlen);
-        size -= rlen;
-        total_read += rlen;
-    }
-
-    HAL_FileClose(fp);
-    Log_d("total read: %d", total_read);
-    return ret;
-}
-
-/* update local firmware info for resuming download from break point */
-static int _update_local_fw_info(OTAContextData *ota_ctx)
-{
-    void *fp;
-    int   wlen;
-    int   ret = QCLOUD_RET_SUCCESS;
-    char  data_buf[FW_INFO_FILE_DATA_LEN];
-
-    memset(data_buf, 0, sizeof(data_buf));
-    HAL_Snprintf(data_buf, sizeof(data_buf), "{\"%s\":\"%s\", \"%s\":%d}", KEY_VER, ota_ctx->remote_version, KEY_SIZE,
-                 ota_ctx->downloaded_size);
-
-    fp = HAL_FileOpen(ota_ctx->fw_info_file_path, "w");
-    if (NULL == fp) {
-        Log_e("open file %s failed", ota_ctx->fw_info_file_path);
-        ret = QCLOUD_ERR_FAILURE;
-        goto exit;
-    }
-
-    wlen = HAL_FileWrite(data_buf, 1, strlen(data_buf), fp);
-    if (wlen != strlen(data_buf)) {
-        Log_e("save version to file err");
-        ret = QCLOUD_ERR_FAILURE;
-    }
-
-exit:
-
-    if (NULL != fp) {
+    if (0 != HAL_FileSeek(fp, offset, SEEK_SET)) {
+        Log_e("seek file to %u failed", offset);
         HAL_FileClose(fp);
+        return QCLOUD_ERR_FAILURE;
     }
 
-    return ret;
-}
-
-static int _get_local_fw_info(char *file_name, char *local_version)
-{
-    int  len;
-    int  rlen;
-    char json_doc[FW_INFO_FILE_DATA_LEN] = {0};
-
-    void *fp = HAL_FileOpen(file_name, "r");
-    if (NULL == fp) {
-        Log_e("open file %s failed", file_name);
-        return 0;
-    }
-
-    HAL_FileSeek(fp, 0L, SEEK_END);
-    len = ftell(fp);
-    if (len > FW_INFO_FILE_DATA_LEN) {
-        Log_e("%s is too big, pls check", file_name);
-        HAL_FileClose(fp);
-        return 0;
-    }
-
-    rewind(fp);
-    rlen = HAL_FileRead(json_doc, 1, len, fp);
-    if (len != rlen) {
-        Log_e("read data len (%d) less than needed (%d), %s", rlen, len, json_doc);
-        HAL_FileClose(fp);
-        return 0;
-    }
-
-    char *version = LITE_json_value_of(KEY_VER, json_doc);
-    char *size    = LITE_json_value_of(KEY_SIZE, json_doc);
-
-    if ((NULL == version) || (NULL == size)) {
-        if (version)
-            HAL_Free(version);
-        if (size)
-            HAL_Free(size);
+    if (1 != HAL_FileWrite(buf, len, 1, fp)) {
+        Log_e("write data to file failed");
         HAL_FileClose(fp);
-        return 0;
-    }
-
-    int local_size = atoi(size);
-    HAL_Free(size);
-
-    if (local_size <= 0) {
-        Log_w("local info offset invalid: %d", local_size);
-        HAL_Free(version);
-        local_size = 0;
+        return QCLOUD_ERR_FAILURE;
     }
-
-    strncpy(local_version, version, FW_VERSION_MAX_LEN);
-    HAL_Free(version);
+    HAL_FileFlush(fp);
     HAL_FileClose(fp);
-    return local_size;
-}
-
-/* get local firmware offset for resuming download from break point */
-static int _update_fw_downloaded_size(OTAContextData *ota_ctx)
-{
-    int local_size = _get_local_fw_info(ota_ctx->fw_info_file_path, ota_ctx->local_version);
-    if (local_size == 0) {
-        ota_ctx->downloaded_size = 0;
-        return 0;
-    }
-
-    if ((0 != strcmp(ota_ctx->local_version, ota_ctx->remote_version)) ||
-        (ota_ctx->downloaded_size > ota_ctx->fw_file_size)) {
-        ota_ctx->downloaded_size = 0;
-        return 0;
-    }
-
-    ota_ctx->downloaded_size = local_size;
-    Log_i("calc MD5 for resuming download from offset: %d", ota_ctx->downloaded_size);
-    int ret = _cal_exist_fw_md5(ota_ctx);
-    if (ret) {
-        Log_e("regen OTA MD5 error: %d", ret);
-        HAL_FileRemove(ota_ctx->fw_info_file_path);
-        ota_ctx->downloaded_size = 0;
-        return 0;
-    }
-    Log_d("local MD5 update done!");
-    return local_size;
-}
 
-static int _delete_fw_info_file(char *file_name)
-{
-    return HAL_FileRemove(file_name);
+    return 0;
 }
 
-static int _save_fw_data_to_file(char *file_name, uint32_t offset, char *buf, int len)
+static long _get_fw_file_size(char *file_name)
 {
-    void *fp;
-    if (offset > 0) {
-        if (NULL == (fp = HAL_FileOpen(file_name, "ab+"))) {
-            Log_e("open file failed");
-            return QCLOUD_ERR_FAILURE;
-        }
-    } else {
-        if (NULL == (fp = HAL_FileOpen(file_name, "wb+"))) {
-            Log_e("open file failed");
-            return QCLOUD_ERR_FAILURE;
-        }
-    }
+    long  size;
+    void *fp = HAL_FileOpen(file_name, "rb");
 
-    HAL_FileSeek(fp, offset, SEEK_SET);
-
-    if (1 != HAL_FileWrite(buf, len, 1, fp)) {
-        Log_e("write data to file failed");
-        HAL_FileClose(fp);
-        return QCLOUD_ERR_FAILURE;
+    if (NULL == fp) {
+        return 0;
     }
-    HAL_FileFlush(fp);
+    size = HAL_FileSize(fp);
     HAL_FileClose(fp);
 
-    return 0;
+    return size;
 }
 
 static char *_get_local_fw_running_version()
@@ -400,12 +249,22 @@ bool process_ota(OTAContextData *ota_ctx)
             IOT_OTA_Ioctl(h_ota, IOT_OTAG_VERSION, ota_ctx->remote_version, FW_VERSION_MAX_LEN);
 
             HAL_Snprintf(ota_ctx->fw_file_path, FW_FILE_PATH_MAX_LEN, "./FW_%s.bin", ota_ctx->remote_version);
-            HAL_Snprintf(ota_ctx->fw_info_file_path, FW_FILE_PATH_MAX_LEN, "./FW_%s.json", ota_ctx->remote_version);
+            HAL_Snprintf(ota_ctx->fw_ckpt_file_path, FW_FILE_PATH_MAX_LEN, "./FW_%s.ckpt", ota_ctx->remote_version);
 
             /* check if pre-downloading finished or not */
-            /* if local FW downloaded size (ota_ctx->downloaded_size) is not zero, it
-             * will do resuming download */
-            _update_fw_downloaded_size(ota_ctx);
+            /* if the checkpoint gives downloaded size (ota_ctx->downloaded_size) not zero, it
+             * will do resuming download, with the MD5 state restored from the checkpoint */
+            rc = IOT_OTA_ResumeFromCheckpoint(h_ota, ota_ctx->fw_ckpt_file_path, &ota_ctx->downloaded_size);
+            if (QCLOUD_RET_SUCCESS != rc) {
+                Log_e("OTA resume from checkpoint err,rc:%d", rc);
+                ota_ctx->downloaded_size = 0;
+            }
+            if (ota_ctx->downloaded_size > 0 &&
+                _get_fw_file_size(ota_ctx->fw_file_path) < (long)ota_ctx->downloaded_size) {
+                Log_w("firmware file shorter than checkpoint, download from start");
+                ota_ctx->downloaded_size = 0;
+                IOT_OTA_ResetClientMD5(h_ota);
+            }
 
             /*set offset and start http connect*/
             rc = IOT_OTA_StartDownload(h_ota, ota_ctx->downloaded_size, ota_ctx->fw_file_size);
@@ -431,11 +290,11 @@ bool process_ota(OTAContextData *ota_ctx)
                     break;
                 }
 
-                /* get OTA information and update local info */
+                /* get OTA information and checkpoint the data saved */
                 IOT_OTA_Ioctl(h_ota, IOT_OTAG_FETCHED_SIZE, &ota_ctx->downloaded_size, 4);
-                rc = _update_local_fw_info(ota_ctx);
+                rc = IOT_OTA_SaveCheckpoint(h_ota, false);
                 if (QCLOUD_RET_SUCCESS != rc) {
-                    Log_e("update local fw info err,rc:%d", rc);
+                    Log_e("save OTA checkpoint err,rc:%d", rc);
                 }
 
                 // quit ota process as something wrong with mqtt
@@ -449,8 +308,8 @@ bool process_ota(OTAContextData *ota_ctx)
 
             /* Must check MD5 match or not */
             if (upgrade_fetch_success) {
-                // download is finished, delete the fw info file
-                _delete_fw_info_file(ota_ctx->fw_info_file_path);
+                // download is finished, delete the checkpoint file
+                IOT_OTA_ClearCheckpoint(h_ota);
 
                 uint32_t firmware_valid;
                 IOT_OTA_Ioctl(h_ota, IOT_OTAG_CHECK_FIRMWARE, &firmware_valid, 4);
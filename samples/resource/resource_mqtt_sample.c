@@ -26,6 +26,7 @@
 #define RESOURCE_NAME_MAX_LEN       32
 #define RESOURCE_PATH_MAX_LEN       128
 #define RESOURCE_BUF_LEN            5000
+#define RESOURCE_UPLOAD_YIELD_LEN   (64 * 1024)
 #define RESOURCE_INFO_FILE_DATA_LEN 128
 
 typedef struct ResourceContextData {
@@ -580,29 +581,17 @@ bool process_resource_upload(void *ctx)
                 break;
             }
 
-            // upload and read the resource
-            readlen = RESOURCE_BUF_LEN > (resource_size - offset) ? (resource_size - offset) : RESOURCE_BUF_LEN;
-            rc      = _read_local_resource_data(upload_resource_name, offset, buf_upload, readlen);
-            if (rc) {
-                Log_e("read data from file failed");
+            // upload the resource, the sdk reads it from file
+            FILE *fp = fopen(upload_resource_name, "rb");
+            if (NULL == fp) {
+                Log_e("open file %s failed", upload_resource_name);
                 upload_resource_success = false;
                 break;
             }
             do {
                 /* send resource data */
-                int len = IOT_Resource_UploadYield(resource_handle, buf_upload, readlen, 5);
-                if (len > 0) {
-                    offset += len;
-                    readlen = RESOURCE_BUF_LEN > (resource_size - offset) ? (resource_size - offset) : RESOURCE_BUF_LEN;
-                    if (readlen != 0) {
-                        rc = _read_local_resource_data(upload_resource_name, offset, buf_upload, readlen);
-                        if (rc) {
-                            Log_e("read data from file failed");
-                            upload_resource_success = false;
-                            break;
-                        }
-                    }
-                } else if (len < 0) {
+                int len = IOT_Resource_UploadFileYield(resource_handle, fp, RESOURCE_UPLOAD_YIELD_LEN, 5);
+                if (len < 0) {
                     Log_e("upload fail rc=%d", len);
                     upload_resource_success = false;
                     break;
@@ -617,6 +606,7 @@ bool process_resource_upload(void *ctx)
                 }
 
             } while (!IOT_Resource_IsUploadFinish(resource_handle));
+            fclose(fp);
 
             /* Must check MD5 match or not */
             if (upload_resource_success) {
@@ -36,7 +36,16 @@ extern "C" {
 #define AT_END_MARK_LEN 4
 
 #define CLINET_BUFF_LEN          (1024)
-#define RING_BUFF_LEN            CLINET_BUFF_LEN  // uart ring buffer len
+/* uart ring buffer len, must be a power of two. Holds about 22ms of data at
+ * 921600 baud while the parser is busy */
+#ifndef RING_BUFF_LEN
+#define RING_BUFF_LEN (2048)
+#endif
+/* uart rx is paused once less than this is left in the ring buffer and
+ * resumed when it is half empty again */
+#ifndef AT_UART_RX_HOLD_ROOM
+#define AT_UART_RX_HOLD_ROOM (128)
+#endif
 #define GET_CHAR_TIMEOUT_MS      (5000)
 #define CMD_RESPONSE_INTERVAL_MS (100)
 
@@ -89,7 +98,7 @@ typedef struct _at_client_ {
     at_status status;
     char      end_sign;
 
-    ring_buff_t pRingBuff;
+    spsc_ring_buff_t pRingBuff;
 
     char *   recv_buffer;
     uint32_t recv_bufsz;
@@ -22,7 +22,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
-#include "utils_list.h"
+#include "utils_ringbuff.h"
 
 #define UNUSED_SOCKET             (-1)
 #define MAX_AT_SOCKET_NUM         (5)
@@ -30,18 +30,15 @@
 #define AT_SOCKET_RECV_TIMEOUT_MS (1000)
 #define IPV4_STR_MAX_LEN          (16)
 
+/* per socket receive ring, must be a power of two */
+#ifndef AT_SOCKET_RECV_RING_LEN
+#define AT_SOCKET_RECV_RING_LEN (2048)
+#endif
+
 typedef enum { eNET_TCP = 6, eNET_UDP = 17, eNET_DEFAULT = 0xff } eNetProto;
 
 typedef enum { eSOCKET_ALLOCED = 0, eSOCKET_CONNECTED, eSOCKET_CLOSED } eSocketState;
 
-/* AT receive package list structure */
-typedef struct at_recv_pkt {
-    List   list;
-    size_t bfsz_totle;
-    size_t bfsz_index;
-    char * buff;
-} at_recv_pkt;
-
 typedef enum {
     AT_SOCKET_EVT_RECV = 0,
     AT_SOCKET_EVT_CLOSED,
@@ -66,7 +63,7 @@ typedef struct {
 /*at socket context*/
 typedef struct {
     int             fd; /** socket fd */
-    List *          recvpkt_list;
+    sSpscRingbuff   recv_ring; /* filled by the URC parser, drained by at_socket_recv */
     char            remote_ip[IPV4_STR_MAX_LEN];
     uint16_t        remote_port;
     uint32_t        send_timeout_ms;
@@ -87,4 +84,8 @@ int at_socket_connect(const char *host, uint16_t port, eNetProto eProto);
 int at_socket_close(int fd);
 int at_socket_send(int fd, const void *buf, size_t len);
 int at_socket_recv(int fd, void *buf, size_t len);
+
+/* for at device drivers: read len bytes of socket data from the AT client
+ * straight into the receive ring of the device socket dev_fd */
+int at_socket_recv_fill(int dev_fd, size_t len, uint32_t timeout);
 #endif
@@ -40,6 +40,9 @@ extern "C" {
 
 #define MAX_CLEAE_DOC_LEN 256
 
+/* buckets of registered property keys, must be a power of 2 */
+#define TEMPLATE_PROPERTY_HASH_SIZE 64
+
 typedef struct _TemplateInnerData {
     uint32_t token_num;
     int32_t  sync_status;
@@ -50,6 +53,8 @@ typedef struct _TemplateInnerData {
     List *   property_handle_list;
     char *   upstream_topic;    // upstream topic
     char *   downstream_topic;  // downstream topic
+
+    PropertyHandler *property_hash[TEMPLATE_PROPERTY_HASH_SIZE];  // registered properties by key
 } TemplateInnerData;
 
 typedef struct _Template {
@@ -57,6 +57,16 @@ int template_common_remove_property(Qcloud_IoT_Template *ptemplate, DeviceProper
  */
 int template_common_check_property_existence(Qcloud_IoT_Template *ptemplate, DeviceProperty *pProperty);
 
+/**
+ * @brief find a registered property by key, caller should hold the template mutex
+ *
+ * @param pTemplate handle to data_template client
+ * @param key       key token, not necessarily NUL-terminated
+ * @param key_len   length of key token
+ * @return          property handler, or NULL if no property is registered with this key
+ */
+PropertyHandler *template_common_find_property(Qcloud_IoT_Template *pTemplate, const char *key, int key_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -99,11 +99,13 @@ typedef struct {
 /**
  * @brief for property and it's callback
  */
-typedef struct {
+typedef struct _PropertyHandler {
     void *property;
 
     OnPropRegCallback callback;
 
+    struct _PropertyHandler *hash_next;  // next handler in the same key bucket
+
 } PropertyHandler;
 
 /**
@@ -128,36 +130,107 @@ typedef struct {
 int check_snprintf_return(int32_t returnCode, size_t maxSizeOfWrite);
 
 /**
- * @brief insert source string to the dest string with specified position
+ * @brief JSON writer appending to a caller buffer at a tracked position
+ *
+ * Errors are sticky: once the buffer runs out every later write is dropped
+ * and json_writer_finish() reports the error.
+ */
+typedef struct {
+    char * buf;
+    size_t size;
+    size_t len;
+    int    err;
+} JsonWriter;
+
+/**
+ * @brief append a string literal without strlen
+ */
+#define json_writer_literal(writer, str) json_writer_raw(writer, str, sizeof(str) - 1)
+
+/**
+ * @brief init JSON writer on a buffer
+ *
+ * @param writer       JSON writer
+ * @param buf          JSON string buffer
+ * @param size         size of buffer
+ */
+void json_writer_init(JsonWriter *writer, char *buf, size_t size);
+
+/**
+ * @brief append raw bytes
+ *
+ * @param writer       JSON writer
+ * @param str          bytes to append
+ * @param len          number of bytes
+ */
+void json_writer_raw(JsonWriter *writer, const char *str, size_t len);
+
+/**
+ * @brief append a NUL-terminated string as is
+ */
+void json_writer_str(JsonWriter *writer, const char *str);
+
+/**
+ * @brief append a quoted string, the content is not escaped
+ */
+void json_writer_string(JsonWriter *writer, const char *str);
+
+/**
+ * @brief append "key":
+ */
+void json_writer_key(JsonWriter *writer, const char *key);
+
+/**
+ * @brief append a signed integer
+ */
+void json_writer_int(JsonWriter *writer, int32_t value);
+
+/**
+ * @brief append an unsigned integer
+ */
+void json_writer_uint(JsonWriter *writer, uint32_t value);
+
+/**
+ * @brief append a number with 6 fractional digits, same as "%f"
+ */
+void json_writer_double(JsonWriter *writer, double value);
+
+/**
+ * @brief close an object or array, replacing the trailing comma if there is one
  *
- * @param pSourceStr   source string
- * @param pDestStr     dest string
- * @param pos          dest string positon
+ * @param writer       JSON writer
+ * @param end          '}' or ']'
  */
-void insert_str(char *pDestStr, char *pSourceStr, int pos);
+void json_writer_close(JsonWriter *writer, char end);
 
 /**
- * add a JSON node to JSON string
+ * @brief terminate the JSON string
  *
- * @param jsonBuffer   	JSON string buffer
- * @param sizeOfBuffer  size of buffer
+ * @param writer       JSON writer
+ * @return             QCLOUD_RET_SUCCESS for success, or err code if the buffer was too small
+ */
+int json_writer_finish(JsonWriter *writer);
+
+/**
+ * add a JSON node followed by a comma
+ *
+ * @param writer        JSON writer
  * @param pJsonNode     JSON node
  * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
  */
-int put_json_node(char *jsonBuffer, size_t sizeOfBuffer, DeviceProperty *pJsonNode);
+int put_json_node(JsonWriter *writer, DeviceProperty *pJsonNode);
 
 /**
- * add a JSON node to JSON string, data_template's bool type not the same to
+ * add a JSON node followed by a comma, data_template's bool type not the same to
  * put_json_node
  *
- * @param jsonBuffer   	JSON string buffer
- * @param sizeOfBuffer  size of buffer
+ * @param writer        JSON writer
  * @param pKey          key of JSON node
  * @param pData         value of JSON node
  * @param type          value type of JSON node
  * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
  */
-int template_put_json_node(char *jsonBuffer, size_t sizeOfBuffer, const char *pKey, void *pData, JsonDataType type);
+int template_put_json_node(JsonWriter *writer, const char *pKey, void *pData, JsonDataType type);
 
 /**
  * @brief generate an empty JSON with only clientToken
@@ -231,6 +304,30 @@ bool parse_code_return(char *pJsonDoc, int32_t *pCode);
  */
 bool update_value_if_key_match(char *pJsonDoc, DeviceProperty *pProperty);
 
+/**
+ * @brief update property value from a value token already located in a JSON document
+ *
+ * The value is converted in place: the byte after the token is borrowed as a
+ * terminator and restored before return, so no copy of the value is made.
+ *
+ * @param pProperty      device property
+ * @param value          start of the value token (inside the quotes for strings)
+ * @param value_len      length of the value token
+ * @param value_type     token type from json_get_next_object
+ * @return               true if the value was applied, false for null or missing value
+ */
+bool update_value_from_json_token(DeviceProperty *pProperty, char *value, int value_len, int value_type);
+
+/**
+ * @brief check if a property key equals a key token which is not NUL-terminated
+ *
+ * @param key            NUL-terminated property key
+ * @param name           key token
+ * @param name_len       length of key token
+ * @return               true if equal
+ */
+bool template_key_match(const char *key, const char *name, int name_len);
+
 /**
  * @brief parse field of method from JSON string
  *
@@ -23,6 +23,7 @@
 #define IOT_GATEWAY_COMMON_H_
 
 #include "qcloud_iot_export.h"
+#include "utils_timer.h"
 
 #define GATEWAY_PAYLOAD_BUFFER_LEN        1024
 #define GATEWAY_RECEIVE_BUFFER_LEN        1024
@@ -37,6 +38,26 @@
 #define GATEWAY_SEARCH_OP_STR             "search_devices"
 #define GATEWAY_DESCRIBE_SUBDEVIES_OP_STR "describe_sub_devices"
 
+/* Max sub-devices packed in one batch online/offline request, fewer when their reply would not
+ * fit in the MQTT read buffer */
+#ifndef GATEWAY_BATCH_MAX_DEVICES
+#define GATEWAY_BATCH_MAX_DEVICES 50
+#endif
+
+/* Sub-device sessions preallocated on construct when there is no limit, doubled when used up */
+#ifndef GATEWAY_INIT_SUBDEV_SESSIONS
+#define GATEWAY_INIT_SUBDEV_SESSIONS 64
+#endif
+
+/* Worst case reply entry of one sub-device without its ids, a batch is cut so the whole reply
+ * fits in the MQTT read buffer after GATEWAY_BATCH_REPLY_RESERVE for header, topic and wrapper */
+#define GATEWAY_BATCH_REPLY_ENTRY "{\"product_id\":\"\",\"device_name\":\"\",\"result\":-2147483648},"
+#define GATEWAY_BATCH_REPLY_RESERVE \
+    (MAX_SIZE_OF_CLOUD_TOPIC + 16 + sizeof(GATEWAY_PAYLOAD_STATUS_BATCH_PREFIX_FMT) + sizeof(GATEWAY_OFFLIN_OP_STR))
+
+/* Time to wait for the result of a batch request, same as the sync request */
+#define GATEWAY_BATCH_TIMEOUT_MS (GATEWAY_LOOP_MAX_COUNT * 200)
+
 /* The format of operation of gateway topic */
 #define GATEWAY_TOPIC_OPERATION_FMT "$gateway/operation/%s/%s"
 
@@ -51,6 +72,11 @@
     "{\"type\":\"%s\",\"payload\":{\"devices\":[{\"product_id\":\"%s\"," \
     "\"device_name\":\"%s\"}]}}"
 
+/* The format of status cmd payload with many devices */
+#define GATEWAY_PAYLOAD_STATUS_BATCH_PREFIX_FMT "{\"type\":\"%s\",\"payload\":{\"devices\":["
+#define GATEWAY_PAYLOAD_STATUS_BATCH_ENTRY_FMT  "{\"product_id\":\"%s\",\"device_name\":\"%s\"},"
+#define GATEWAY_PAYLOAD_STATUS_BATCH_SUFFIX     "]}}"
+
 /* The format of bind cmd payload */
 #define GATEWAY_PAYLOAD_OP_FMT                                                    \
     "{\"type\":\"%s\",\"payload\":{\"devices\":[{\"product_id\":\"%s\","          \
@@ -72,14 +98,50 @@ typedef enum _SubdevSessionStatus {
     SUBDEV_SEESION_STATUS_MAX
 } SubdevSessionStatus;
 
+struct _SubdevSession;
+
+/* The structure of batch online/offline request waiting for results */
+typedef struct _SubdevBatch {
+    SubdevSessionStatus         target_status;  // session status on success
+    int                         pending;        // devices still waiting for result
+    bool                        failing;        // devices are failed by timeout or send error, replies ignored
+    Timer                       timer;          // timeout of the whole batch
+    GatewaySubdevResultCallback callback;
+    void *                      user_data;
+    struct _SubdevSession *     members[GATEWAY_BATCH_MAX_DEVICES];  // NULL once the device has its result
+    int                         member_cnt;
+    struct _SubdevBatch *       next;
+} SubdevBatch;
+
 /* The structure of subdevice session */
 typedef struct _SubdevSession {
     char                   product_id[MAX_SIZE_OF_PRODUCT_ID + 1];
     char                   device_name[MAX_SIZE_OF_DEVICE_NAME + 1];
     SubdevSessionStatus    session_status;
-    struct _SubdevSession *next;
+    SubdevBatch *          batch;      // batch request waiting for the result of this device
+    int                    batch_pos;  // index in members of batch
+    uint32_t               hash;    // hash of product_id and device_name
+    bool                   in_use;  // false if the record is in the free list
+    struct _SubdevSession *next;    // next free record
 } SubdevSession;
 
+/* A chunk of session records, records never move so sessions can be pointed to */
+typedef struct _SubdevSessionChunk {
+    struct _SubdevSessionChunk *next;
+    SubdevSession               records[];
+} SubdevSessionChunk;
+
+/* The table of subdevice sessions, slab records indexed by an open addressing hash */
+typedef struct _SubdevSessionTable {
+    SubdevSessionChunk *chunks;     // session records, a new chunk is added when used up
+    SubdevSession *     free_list;  // records not in use
+    SubdevSession **    index;      // hash slots, NULL for empty
+    uint32_t            capacity;   // number of records
+    uint32_t            limit;      // max number of records, 0 for no limit
+    uint32_t            mask;       // number of slots - 1, slots are at least twice the records
+    uint32_t            count;      // records in use
+} SubdevSessionTable;
+
 /* The structure of common reply data */
 typedef struct _ReplyData {
     int32_t result;
@@ -98,19 +160,37 @@ typedef struct _GatewayData {
 
 /* The structure of gateway context */
 typedef struct _Gateway {
-    void *           mqtt;
-    SubdevSession *  session_list;
-    SubdevBindList   bind_list;
-    GatewayData      gateway_data;
-    MQTTEventHandler event_handle;
-    int              is_construct;
-    char             recv_buf[GATEWAY_RECEIVE_BUFFER_LEN];
+    void *             mqtt;
+    void *             lock;  // protect sessions and batches against the yield thread
+    SubdevSessionTable sessions;
+    SubdevBatch *      batch_list;
+    SubdevBindList     bind_list;
+    GatewayData        gateway_data;
+    MQTTEventHandler   event_handle;
+    int                is_construct;
+    char               recv_buf[GATEWAY_RECEIVE_BUFFER_LEN];
 #ifdef MULTITHREAD_ENABLED
     bool yield_thread_running;
     int  yield_thread_exit_code;
 #endif
 } Gateway;
 
+/**
+ * @brief allocate the session records and hash index
+ *
+ * @param gateway   gateway client
+ * @param limit     max number of sessions, all preallocated, or 0 for no limit
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int subdev_session_table_init(Gateway *gateway, uint32_t limit);
+
+/**
+ * @brief free the session records and hash index
+ *
+ * @param gateway   gateway client
+ */
+void subdev_session_table_deinit(Gateway *gateway);
+
 SubdevSession *subdev_add_session(Gateway *gateway, char *product_id, char *device_name);
 
 SubdevSession *subdev_find_session(Gateway *gateway, char *product_id, char *device_name);
@@ -124,6 +204,44 @@ int gateway_subscribe_unsubscribe_default(Gateway *gateway, GatewayParam *param)
 
 int gateway_publish_sync(Gateway *gateway, char *topic, PublishParams *params, int32_t *result);
 
+/**
+ * @brief publish status of many sub-devices in batches without waiting for the results
+ *
+ * @param gateway   gateway client
+ * @param param     gateway and sub-device parameters
+ * @param count     number of sub-devices
+ * @param online    true for online, false for offline
+ * @param callback  called once for each sub-device with its result
+ * @param user_data user data passed to callback
+ * @return          QCLOUD_RET_SUCCESS if all batches are sent, or err code of the first failure
+ */
+int gateway_subdev_status_batch(Gateway *gateway, GatewayParam param[], int count, bool online,
+                                GatewaySubdevResultCallback callback, void *user_data);
+
+/**
+ * @brief apply the per-device results of a status reply to pending batches
+ *
+ * @param gateway   gateway client
+ * @param devices   devices array of the reply
+ * @param online    true for online reply, false for offline reply
+ */
+void gateway_subdev_batch_reply(Gateway *gateway, char *devices, bool online);
+
+/**
+ * @brief fail the devices of timed out batches
+ *
+ * @param gateway   gateway client
+ * @return          number of devices still waiting for result
+ */
+int gateway_subdev_batch_expire(Gateway *gateway);
+
+/**
+ * @brief drop all batches without calling back, used on destroy
+ *
+ * @param gateway   gateway client
+ */
+void gateway_subdev_batch_clear(Gateway *gateway);
+
 int subdev_bind_hmac_sha1_cal(DeviceInfo *pDevInfo, char *signout, int max_signlen, int nonce, long timestamp);
 
 #endif /* IOT_GATEWAY_COMMON_H_ */
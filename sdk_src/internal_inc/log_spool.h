@@ -0,0 +1,110 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef QCLOUD_IOT_LOG_SPOOL_H_
+#define QCLOUD_IOT_LOG_SPOOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "qcloud_iot_export_variables.h"
+
+#define LOG_SPOOL_PATH_LEN (128)
+
+/**
+ * On-disk log spool: records are appended to segment files "<path>.<seq>",
+ * "<path>.idx" keeps the byte size of each live segment and the replay
+ * position in the oldest one. Each record is a header (magic, length, CRC32)
+ * followed by the log text.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t head_seq;    // oldest segment with unsent records
+    uint32_t head_offset; // replay position in head segment
+    uint32_t tail_seq;    // segment being appended
+    uint32_t seg_size[LOG_SPOOL_MAX_SEGMENTS];
+    uint32_t crc;
+} LogSpoolIndex;
+
+typedef struct {
+    char          path[LOG_SPOOL_PATH_LEN];
+    uint32_t      max_segments;
+    LogSpoolIndex index;
+    uint32_t      peek_seq;    // position after the last log_spool_peek
+    uint32_t      peek_offset;
+} LogSpool;
+
+/**
+ * @brief open the spool at path, load the index or start an empty spool
+ *
+ * @param spool     spool handle
+ * @param path      path prefix of spool files
+ * @param max_size  total size cap, oldest segment is evicted beyond it
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int log_spool_init(LogSpool *spool, const char *path, size_t max_size);
+
+/**
+ * @brief append one record of log text
+ *
+ * @param spool     spool handle
+ * @param data      log text
+ * @param len       length of data, no larger than LOG_SPOOL_SEGMENT_SIZE minus record header
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int log_spool_append(LogSpool *spool, const char *data, size_t len);
+
+/**
+ * @brief read the oldest records which fit in buf, without removing them.
+ *        Records failing the CRC check are skipped.
+ *
+ * @param spool     spool handle
+ * @param buf       destination buffer
+ * @param buf_len   length of buf
+ * @param data_len  length of log text read into buf, 0 if spool is empty
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int log_spool_peek(LogSpool *spool, char *buf, size_t buf_len, size_t *data_len);
+
+/**
+ * @brief remove the records returned by the last log_spool_peek
+ *
+ * @param spool     spool handle
+ * @return          QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int log_spool_commit(LogSpool *spool);
+
+/**
+ * @brief get the size of unsent records (including record headers)
+ *
+ * @param spool     spool handle
+ * @return          size in bytes
+ */
+size_t log_spool_size(LogSpool *spool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // QCLOUD_IOT_LOG_SPOOL_H_
@@ -44,12 +44,24 @@ extern "C" {
 /* Max size of conn Id  */
 #define MAX_CONN_ID_LEN (6)
 
-/* Max number of topic subscribed */
-#define MAX_MESSAGE_HANDLERS (10)
+/* Max value of remaining length field, 4 bytes encoded */
+#define MAX_PACKET_REM_LEN (268435455)
 
-/* Max number in repub list */
+/* Max number of topic subscription waiting for SUBACK */
+#define MAX_SUB_WAIT_ACK_NUM (10)
+
+/* Default number of publish waiting for puback */
 #define MAX_REPUB_NUM (20)
 
+/* Upper limit of publish waiting for puback */
+#define MAX_PUB_WINDOW_SIZE (1024)
+
+/* Minimal size of MQTT Tx/Rx buffer, enough for CONNECT packet and topic of PUBLISH */
+#define MIN_MQTT_BUF_LEN (512)
+
+/* Wait for the rest of a packet when driven by reactor, unit: ms */
+#define MQTT_REACTOR_READ_WAIT_MS (1)
+
 /* Minimal wait interval when reconnect */
 #define MIN_RECONNECT_WAIT_INTERVAL (1000)
 
@@ -169,13 +181,92 @@ typedef struct {
  * @brief data structure for topic subscription handle
  */
 typedef struct SubTopicHandle {
-    const char *      topic_filter;       // topic name, wildcard filter is supported
-    OnMessageHandler  message_handler;    // callback when msg of this subscription arrives
-    OnSubEventHandler sub_event_handler;  // callback when event of this subscription happens
-    void *            handler_user_data;  // user context for callback
-    QoS               qos;                // QoS
+    const char *          topic_filter;           // topic name, wildcard filter is supported
+    OnMessageHandler      message_handler;        // callback when msg of this subscription arrives
+    OnSubEventHandler     sub_event_handler;      // callback when event of this subscription happens
+    void *                handler_user_data;      // user context for callback
+    QoS                   qos;                    // QoS
+    OnMessageChunkHandler message_chunk_handler;  // callback when msg arrives in chunks, NULL if not streamed
 } SubTopicHandle;
 
+/**
+ * @brief node of topic subscription trie, one node for one topic level
+ *
+ * literal levels are kept sorted for binary search, wildcard levels separately,
+ * so one inbound topic is dispatched by walking its levels once
+ */
+typedef struct SubTopicNode SubTopicNode;
+struct SubTopicNode {
+    SubTopicHandle handle;     // subscription ending at this level, topic_filter is NULL if none
+    SubTopicNode * parent;     // upper level, NULL for root
+    SubTopicNode **children;   // literal lower levels sorted by name
+    uint16_t       child_cnt;  // count of literal lower levels
+    uint16_t       child_cap;  // capacity of children array
+    SubTopicNode * plus;       // '+' lower level
+    SubTopicNode * hash;       // '#' lower level
+    char *         level;      // level name, not null-terminated
+    uint16_t       level_len;  // length of level name
+};
+
+/**
+ * @brief callback for visiting subscriptions in trie
+ *
+ * @return 0 to continue, or non-zero to stop visiting
+ */
+typedef int (*SubTopicVisitor)(SubTopicHandle *handle, void *ctx);
+
+/* topic publish info, one slot of the puback waiting window */
+typedef struct REPUBLISH_INFO {
+    uint32_t            deadline;      /* HAL_GetTimeMs() value when puback waiting times out */
+    uint16_t            msg_id;        /* packet id, 0 for a free slot */
+    uint16_t            heap_pos;      /* position in the deadline heap */
+    OnPublishAckHandler ack_handler;   /* callback when puback arrives or times out */
+    void *              ack_user_data; /* user context for callback */
+} QcloudIotPubInfo;
+
+/**
+ * @brief window of QoS1 publish waiting for puback
+ *
+ * heap keeps the busy slot index as a min-heap ordered by deadline in its first
+ * count entries and the free slot index after them, so a slot is taken or freed
+ * without regard to packet id and the next timeout is at heap[0]. puback finds the
+ * slot of a packet id through index, a linear probing table at most half full
+ */
+typedef struct {
+    QcloudIotPubInfo *slots;       // slot array, size entries
+    uint16_t *        heap;        // busy slot index min-heap by deadline, then free slot index
+    uint16_t *        index;       // packet id hash table of busy slot index + 1, 0 if empty
+    uint16_t          index_mask;  // index entries - 1, a power of two at least 2 * size
+    uint16_t          size;        // max publish in flight
+    uint16_t          count;       // publish in flight now
+} QcloudIotPubWindow;
+
+/**
+ * @brief frame larger than read buffer being read through, its head handled already
+ *
+ * the rest is read into read buffer piece by piece, as it arrives if driven by reactor,
+ * and handed to chunk handler, or discarded without one
+ */
+typedef struct {
+    size_t                remain;             // bytes of the frame still to read, 0 if none
+    size_t                offset;             // payload bytes read so far
+    size_t                total_len;          // payload length
+    bool                  deliver;            // false if payload is read through without delivery
+    OnMessageChunkHandler chunk_handler;      // NULL to discard the rest of the frame
+    void *                handler_user_data;  // user context for chunk handler
+    MQTTMessage           msg;                // PUBLISH being streamed
+    char                  topic[MAX_SIZE_OF_CLOUD_TOPIC];
+} MQTTFrameStream;
+
+/**
+ * @brief step of the connect with MQTT server advanced without blocking
+ */
+typedef enum {
+    MQTT_CONNECT_IDLE = 0,  // no connect in progress
+    MQTT_CONNECT_NETWORK,   // DNS, TCP connect and TLS handshake in progress
+    MQTT_CONNECT_CONNACK,   // CONNECT sent, waiting for CONNACK
+} MQTTConnectStep;
+
 /**
  * @brief MQTT QCloud IoT Client structure
  */
@@ -191,19 +282,22 @@ typedef struct Client {
     uint32_t current_reconnect_wait_interval;  // unit:ms
     uint32_t counter_network_disconnected;     // number of disconnection
 
-    size_t        write_buf_size;                         // size of MQTT write buffer
-    size_t        read_buf_size;                          // size of MQTT read buffer
-    unsigned char write_buf[QCLOUD_IOT_MQTT_TX_BUF_LEN];  // MQTT write buffer
-    unsigned char read_buf[QCLOUD_IOT_MQTT_RX_BUF_LEN];   // MQTT read buffer
+    size_t         write_buf_size;  // size of MQTT write buffer
+    size_t         read_buf_size;   // size of MQTT read buffer
+    unsigned char *write_buf;       // MQTT write buffer, allocated in init
+    unsigned char *read_buf;        // MQTT read buffer, allocated in init
+    size_t         read_buf_used;   // bytes staged in read buffer, current frame included
+    size_t         read_frame_len;  // length of the frame at the head of read buffer, may exceed read_buf_size
+    MQTTFrameStream frame_stream;   // frame larger than read buffer not fully read yet
 
     void *lock_generic;    // mutex/lock for this client struture
     void *lock_write_buf;  // mutex/lock for write buffer
 
-    void *lock_list_pub;  // mutex/lock for puback waiting list
+    void *lock_list_pub;  // mutex/lock for puback waiting window
     void *lock_list_sub;  // mutex/lock for suback waiting list
 
-    List *list_pub_wait_ack;  // puback waiting list
-    List *list_sub_wait_ack;  // suback waiting list
+    QcloudIotPubWindow pub_wait_ack;       // puback waiting window
+    List *             list_sub_wait_ack;  // suback waiting list
 
     MQTTEventHandler event_handle;  // callback for MQTT event
 
@@ -214,8 +308,11 @@ typedef struct Client {
     Timer ping_timer;             // MQTT ping timer
     Timer reconnect_delay_timer;  // MQTT reconnect delay timer
 
-    DeviceInfo     device_info;
-    SubTopicHandle sub_handles[MAX_MESSAGE_HANDLERS];  // subscription handle array
+    MQTTConnectStep connect_step;   // step of the connect without blocking
+    Timer           connect_timer;  // timeout timer of the current connect step
+
+    DeviceInfo   device_info;
+    SubTopicNode sub_trie;  // root of subscription trie
 
     char host_addr[HOST_STR_LENGTH];
 
@@ -237,6 +334,8 @@ typedef struct Client {
     int  yield_thread_exit_code;
 #endif
 
+    void *reactor_slot;  // slot of the reactor driving this client, NULL if driven by yield
+
 } Qcloud_IoT_Client;
 
 /**
@@ -249,15 +348,6 @@ typedef enum MQTT_NODE_STATE {
     MQTT_NODE_STATE_INVALID,
 } MQTTNodeState;
 
-/* topic publish info */
-typedef struct REPUBLISH_INFO {
-    Timer          pub_start_time; /* timer for puback waiting */
-    MQTTNodeState  node_state;     /* node state in wait list */
-    uint16_t       msg_id;         /* packet id */
-    uint32_t       len;            /* msg length */
-    unsigned char *buf;            /* msg buffer */
-} QcloudIotPubInfo;
-
 /* topic subscribe/unsubscribe info */
 typedef struct SUBSCRIBE_INFO {
     enum msgTypes  type;           /* type: sub or unsub */
@@ -307,6 +397,19 @@ int qcloud_iot_mqtt_connect(Qcloud_IoT_Client *pClient, MQTTConnectParams *pPara
  */
 int qcloud_iot_mqtt_attempt_reconnect(Qcloud_IoT_Client *pClient);
 
+/**
+ * @brief Advance the connect with MQTT server without blocking, by network connect_async op
+ *
+ * Steps: DNS, TCP connect, TLS handshake, CONNECT sent and CONNACK received. Each call
+ * moves on as far as possible without waiting, so it is called again until it is done.
+ *
+ * @param pClient    handle to MQTT client
+ *
+ * @return QCLOUD_RET_SUCCESS when connected, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when in progress,
+ *         or err code for failure
+ */
+int qcloud_iot_mqtt_connect_step(Qcloud_IoT_Client *pClient);
+
 /**
  * @brief Disconnect with MQTT server
  *
@@ -327,6 +430,20 @@ int qcloud_iot_mqtt_disconnect(Qcloud_IoT_Client *pClient);
  */
 int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams);
 
+/**
+ * @brief Publish MQTT message and get notified by callback when QoS1 publish is acked or timeout
+ *
+ * @param pClient       handle to MQTT client
+ * @param topicName     MQTT topic name
+ * @param pParams       publish parameters
+ * @param ack_handler   callback for QoS1 publish result, could be NULL
+ * @param user_data     user context for callback
+ *
+ * @return packet id (>=0) when success, or err code (<0) for failure
+ */
+int qcloud_iot_mqtt_publish_async(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams,
+                                  OnPublishAckHandler ack_handler, void *user_data);
+
 /**
  * @brief Subscribe MQTT topic
  *
@@ -339,11 +456,14 @@ int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, Publish
 int qcloud_iot_mqtt_subscribe(Qcloud_IoT_Client *pClient, char *topicFilter, SubscribeParams *pParams);
 
 /**
- * @brief Re-subscribe MQTT topics
+ * @brief Re-subscribe MQTT topics, called in the packet reading context after reconnect
+ *
+ * SUBSCRIBE is sent MAX_SUB_WAIT_ACK_NUM at a time with SUBACK read in between. A
+ * topic failed is told to its sub_event_handler and the others go on
  *
  * @param pClient       handle to MQTT client
  *
- * @return QCLOUD_RET_SUCCESS for success, or err code for failure
+ * @return QCLOUD_RET_SUCCESS for success, or err code when reading SUBACK fails
  */
 int qcloud_iot_mqtt_resubscribe(Qcloud_IoT_Client *pClient);
 
@@ -380,6 +500,28 @@ bool qcloud_iot_mqtt_is_sub_ready(Qcloud_IoT_Client *pClient, char *topicFilter)
  */
 int qcloud_iot_mqtt_yield(Qcloud_IoT_Client *pClient, uint32_t timeout_ms);
 
+/**
+ * @brief Run the yield state machine once: reconnect when due, read and handle the
+ * packets arrived, check puback/suback timeout and keep alive
+ *
+ * @param pClient       handle to MQTT client
+ * @param timer         timer for reading/sending of this round
+ * @param read_packet   false to only check the timers, without reading
+ * @param packet_type   type of the last packet read, unchanged if none
+ * @return QCLOUD_RET_SUCCESS, QCLOUD_RET_MQTT_RECONNECTED or QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT
+ * to go on, or err code to stop
+ */
+int qcloud_iot_mqtt_yield_once(Qcloud_IoT_Client *pClient, Timer *timer, bool read_packet, uint8_t *packet_type);
+
+#if defined(__linux__)
+/**
+ * @brief Remove client from the reactor driving it, if any
+ *
+ * @param pClient       handle to MQTT client
+ */
+void qcloud_iot_mqtt_reactor_detach(Qcloud_IoT_Client *pClient);
+#endif
+
 /**
  * @brief Check if auto reconnect is enabled or not
  *
@@ -441,7 +583,17 @@ void get_next_conn_id(char *conn_id);
 int mqtt_init_packet_header(unsigned char *header, MessageTypes message_type, QoS qos, uint8_t dup, uint8_t retained);
 
 /**
- * @brief Read and handle one MQTT msg/ack from server
+ * @brief Drop the bytes staged in read buffer, called when network is (re)connected
+ *
+ * @param pClient
+ */
+void reset_read_buffer(Qcloud_IoT_Client *pClient);
+
+/**
+ * @brief Read and handle MQTT msg/ack from server
+ *
+ * one network read may stage several packets in read buffer, the packets staged
+ * completely are all handled in one call, until a CONNACK is met
  *
  * @param pClient
  * @param timer
@@ -461,6 +613,17 @@ int cycle_for_read(Qcloud_IoT_Client *pClient, Timer *timer, uint8_t *packet_typ
  */
 int send_mqtt_packet(Qcloud_IoT_Client *pClient, size_t length, Timer *timer);
 
+/**
+ * @brief Send the packet made of several data segments, without joining them in write buffer
+ *
+ * @param pClient
+ * @param iov       packet segments in order, consumed in place while sending
+ * @param iovcnt    count of segments
+ * @param timer
+ * @return
+ */
+int send_mqtt_packet_iov(Qcloud_IoT_Client *pClient, NetIovec *iov, int iovcnt, Timer *timer);
+
 /**
  * @brief wait for a specific packet with timeout
  *
@@ -491,7 +654,7 @@ void set_client_conn_state(Qcloud_IoT_Client *pClient, uint8_t connected);
 uint8_t get_client_conn_state(Qcloud_IoT_Client *pClient);
 
 /**
- * @brief Check Publish ACK waiting list, remove the node if PUBACK received or
+ * @brief Check Publish ACK waiting window, remove the publish whose PUBACK waiting is
  * timeout
  *
  * @param pClient MQTT client
@@ -499,6 +662,120 @@ uint8_t get_client_conn_state(Qcloud_IoT_Client *pClient);
  */
 int qcloud_iot_mqtt_pub_info_proc(Qcloud_IoT_Client *pClient);
 
+/**
+ * @brief Add subscription into trie, caller should hold lock_generic
+ *
+ * @param root      root of trie
+ * @param handle    subscription, its topic_filter is owned by trie on success
+ * @return the stored subscription, which is an existing one if the topic filter was
+ * subscribed already, or NULL if memory is not enough
+ */
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_add(SubTopicNode *root, SubTopicHandle *handle);
+
+/**
+ * @brief Find subscription of the exact topic filter, caller should hold lock_generic
+ *
+ * @param root          root of trie
+ * @param topic_filter  topic filter
+ * @return the subscription, or NULL if not subscribed
+ */
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_find(SubTopicNode *root, const char *topic_filter);
+
+/**
+ * @brief Find subscription with message or chunk handler matching the topic name, caller
+ * should hold lock_generic
+ *
+ * exact level is preferred over '+', and '+' over '#', when several filters match
+ *
+ * @param root          root of trie
+ * @param topic_name    topic name, no wildcard
+ * @param topic_len     length of topic name
+ * @return the subscription, or NULL if not matched
+ */
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_match(SubTopicNode *root, const char *topic_name, size_t topic_len);
+
+/**
+ * @brief Remove subscription of the exact topic filter, caller should hold lock_generic
+ *
+ * @param root          root of trie
+ * @param topic_filter  topic filter
+ * @param removed       copy of the subscription removed, its topic_filter should be freed by caller
+ * @return true if the subscription is removed, false if not subscribed
+ */
+bool qcloud_iot_mqtt_sub_trie_remove(SubTopicNode *root, const char *topic_filter, SubTopicHandle *removed);
+
+/**
+ * @brief Visit every subscription in trie
+ *
+ * @param root      root of trie
+ * @param visitor   callback for each subscription
+ * @param ctx       context for callback
+ * @return 0 when all visited, or non-zero value returned by visitor
+ */
+int qcloud_iot_mqtt_sub_trie_foreach(SubTopicNode *root, SubTopicVisitor visitor, void *ctx);
+
+/**
+ * @brief Remove all subscriptions and free trie nodes, root itself is kept
+ *
+ * @param root      root of trie
+ */
+void qcloud_iot_mqtt_sub_trie_clear(SubTopicNode *root);
+
+/**
+ * @brief Allocate slots of Publish ACK waiting window
+ *
+ * @param window    the window
+ * @param size      max publish in flight, 0 for MAX_REPUB_NUM
+ * @return QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int qcloud_iot_mqtt_pub_window_init(QcloudIotPubWindow *window, uint16_t size);
+
+/**
+ * @brief Release slots of Publish ACK waiting window
+ *
+ * @param window    the window
+ */
+void qcloud_iot_mqtt_pub_window_deinit(QcloudIotPubWindow *window);
+
+/**
+ * @brief Put publish into waiting window, caller should hold lock_list_pub
+ *
+ * @param window    the window
+ * @param msg_id    packet id of publish
+ * @param timeout_ms    PUBACK waiting time
+ * @return the slot, or NULL if window is full or the packet id is already waiting
+ */
+QcloudIotPubInfo *qcloud_iot_mqtt_pub_window_push(QcloudIotPubWindow *window, uint16_t msg_id, uint32_t timeout_ms);
+
+/**
+ * @brief Take publish out of waiting window, caller should hold lock_list_pub
+ *
+ * @param window    the window
+ * @param msg_id    packet id of publish
+ * @param info      copy of the slot taken out, could be NULL
+ * @return true if the publish was waiting in window, false otherwise
+ */
+bool qcloud_iot_mqtt_pub_window_remove(QcloudIotPubWindow *window, uint16_t msg_id, QcloudIotPubInfo *info);
+
+/**
+ * @brief Take the publish with earliest expired deadline out of waiting window, caller
+ * should hold lock_list_pub
+ *
+ * @param window    the window
+ * @param info      copy of the slot taken out
+ * @return true if an expired publish is taken out, false otherwise
+ */
+bool qcloud_iot_mqtt_pub_window_pop_expired(QcloudIotPubWindow *window, QcloudIotPubInfo *info);
+
+/**
+ * @brief Get the earliest deadline in waiting window, caller should hold lock_list_pub
+ *
+ * @param window    the window
+ * @param deadline  HAL_GetTimeMs() value when the earliest puback waiting times out
+ * @return true if some publish is waiting, false otherwise
+ */
+bool qcloud_iot_mqtt_pub_window_next_deadline(QcloudIotPubWindow *window, uint32_t *deadline);
+
 /**
  * @brief Check Subscribe ACK waiting list, remove the node if SUBACK received
  * or timeout
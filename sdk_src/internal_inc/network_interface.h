@@ -30,6 +30,10 @@ extern "C" {
 
 #include "qcloud_iot_import.h"
 
+#if defined(__linux__)
+#include "qcloud_iot_import_linux.h"
+#endif
+
 /*
  * Type of network interface
  */
@@ -51,10 +55,23 @@ struct Network {
 
     int (*connect)(Network *);
 
+    // optional connect without blocking, called again while it returns QCLOUD_ERR_TCP_CONNECTING or
+    // QCLOUD_ERR_SSL_CONNECTING, NULL if the stack can only connect in one blocking call
+    int (*connect_async)(Network *);
+
     int (*read)(Network *, unsigned char *, size_t, uint32_t, size_t *);
 
     int (*write)(Network *, unsigned char *, size_t, uint32_t, size_t *);
 
+    // optional vectored write, NULL if the stack can only write one buffer at a time
+    int (*writev)(Network *, const NetIovec *, int, uint32_t, size_t *);
+
+    // optional OS socket of the connection for readiness polling, NULL if the stack has none
+    int (*get_fd)(Network *);
+
+    // optional hint of bytes readable without blocking, NULL if the stack can't tell
+    int (*readable)(Network *);
+
     void (*disconnect)(Network *);
 
     int (*is_connected)(Network *);
@@ -64,6 +81,9 @@ struct Network {
     // for AT: 0 = valid connection, MAX_UNSINGED_INT = invalid
     uintptr_t handle;
 
+    // TCP connect in progress by connect_async
+    void *connect_ctx;
+
 #ifndef AUTH_WITH_NOTLS
     SSLConnectParams ssl_connect_params;
 #endif
@@ -81,6 +101,26 @@ int qcloud_iot_network_init(Network *pNetwork);
 /* return the handle */
 int is_network_connected(Network *pNetwork);
 
+/*
+ * Write data segments in order, by writev op if available or one write per segment otherwise
+ */
+int network_writev(Network *pNetwork, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len);
+
+/*
+ * Get OS socket of the connection by get_fd op, -1 if not connected or not available
+ */
+int network_get_fd(Network *pNetwork);
+
+/*
+ * Get bytes readable without blocking by readable op, -1 if not connected or not available
+ */
+int network_readable(Network *pNetwork);
+
+/*
+ * Whether the return code of connect_async op means the connect is still in progress
+ */
+bool network_is_connecting(int rc);
+
 /* network stack API */
 #ifdef AT_TCP_ENABLED
 
@@ -99,6 +139,12 @@ int network_tcp_write(Network *pNetwork, unsigned char *data, size_t datalen, ui
 void network_tcp_disconnect(Network *pNetwork);
 int  network_tcp_connect(Network *pNetwork);
 int  network_tcp_init(Network *pNetwork);
+#if defined(__linux__)
+int network_tcp_writev(Network *pNetwork, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len);
+int network_tcp_get_fd(Network *pNetwork);
+int network_tcp_readable(Network *pNetwork);
+int network_tcp_connect_async(Network *pNetwork);
+#endif
 #endif
 
 #ifndef AUTH_WITH_NOTLS
@@ -107,6 +153,11 @@ int network_tls_write(Network *pNetwork, unsigned char *data, size_t datalen, ui
 void network_tls_disconnect(Network *pNetwork);
 int  network_tls_connect(Network *pNetwork);
 int  network_tls_init(Network *pNetwork);
+#if defined(__linux__)
+int network_tls_get_fd(Network *pNetwork);
+int network_tls_readable(Network *pNetwork);
+int network_tls_connect_async(Network *pNetwork);
+#endif
 #endif
 
 #ifdef COAP_COMM_ENABLED
@@ -25,16 +25,21 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void *ofc_Init(const char *url, uint32_t offset, uint32_t size);
 
+int qcloud_ofc_set_decode(void *handle, bool decode);
+
 int32_t qcloud_ofc_connect(void *handle);
 
 int32_t qcloud_ofc_fetch(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s);
 
 int qcloud_ofc_deinit(void *handle);
 
+int qcloud_ofc_response_code(void *handle);
+
 #ifdef __cplusplus
 }
 #endif
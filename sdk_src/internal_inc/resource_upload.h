@@ -22,12 +22,17 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "utils_md5.h"
+
 void *qcloud_resource_upload_http_init(const char *url, char *md5sum, int upload_len);
 
 int32_t qcloud_resource_upload_http_connect(void *handle);
 
 int32_t qcloud_resource_upload_http_send_body(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s);
 
+int32_t qcloud_resource_upload_http_send_file(void *handle, void *fp, uint32_t len, iot_md5_context *md5,
+                                              uint32_t timeout_s);
+
 int32_t qcloud_resource_upload_http_recv(void *handle, char *buf, uint32_t bufLen, uint32_t timeout_s);
 
 int qcloud_resource_upload_http_deinit(void *handle);
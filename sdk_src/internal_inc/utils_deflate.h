@@ -0,0 +1,105 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef QCLOUD_IOT_UTILS_DEFLATE_H_
+#define QCLOUD_IOT_UTILS_DEFLATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* hash table size (2^bits entries of int32) used for LZ77 match finding */
+#define DEFLATE_HASH_BITS (10)
+
+/**
+ * @brief callback to consume compressed output
+ *
+ * @param user_data     user data passed to utils_deflate
+ * @param data          compressed bytes
+ * @param len           length of data
+ * @return              QCLOUD_RET_SUCCESS to continue, or err code to abort
+ */
+typedef int (*DeflateOutputCb)(void *user_data, const uint8_t *data, size_t len);
+
+/**
+ * @brief compress src into a zlib stream (RFC1950 wrapped RFC1951, fixed huffman),
+ *        output is handed to out_cb each time out_buf fills up
+ *
+ * @param src           data to compress
+ * @param src_len       length of src
+ * @param out_buf       work buffer for compressed output
+ * @param out_buf_len   length of out_buf
+ * @param out_cb        output callback
+ * @param user_data     user data for out_cb
+ * @return              compressed length for success, or err code for failure
+ */
+int utils_deflate(const uint8_t *src, size_t src_len, uint8_t *out_buf, size_t out_buf_len, DeflateOutputCb out_cb,
+                  void *user_data);
+
+/**
+ * @brief update an adler32 checksum (RFC1950), start with adler = 1
+ *
+ * @param adler         checksum of the preceding data
+ * @param data          data to add
+ * @param len           length of data
+ * @return              updated checksum
+ */
+uint32_t utils_adler32(uint32_t adler, const uint8_t *data, size_t len);
+
+/* utils_inflate return code when the end of the compressed stream is reached */
+#define INFLATE_STREAM_END (1)
+
+/**
+ * @brief create an incremental decompressor, the format (gzip, zlib or raw deflate)
+ *        is detected from the first bytes of the stream
+ *
+ * @param max_window    max LZ77 window size, power of 2 up to 32768, streams
+ *                      referring further back are rejected
+ * @return              handle for success, NULL for failure
+ */
+void *utils_inflate_init(size_t max_window);
+
+/**
+ * @brief decompress as much of in as fits in out. Input which can not be decoded
+ *        completely yet is left unused, pass it again with more data appended.
+ *
+ * @param handle        handle of utils_inflate_init
+ * @param in            compressed data
+ * @param in_len        length of in
+ * @param in_used       length of in consumed
+ * @param out           output buffer
+ * @param out_len       length of out
+ * @param out_produced  length of decompressed data written to out
+ * @return              QCLOUD_RET_SUCCESS if more input or output space is needed,
+ *                      INFLATE_STREAM_END after the trailer is verified, or err code for failure
+ */
+int utils_inflate(void *handle, const uint8_t *in, size_t in_len, size_t *in_used, uint8_t *out, size_t out_len,
+                  size_t *out_produced);
+
+void utils_inflate_deinit(void *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QCLOUD_IOT_UTILS_DEFLATE_H_ */
@@ -37,28 +37,45 @@ extern "C" {
 typedef enum { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE, HTTP_HEAD } HttpMethod;
 
 typedef struct {
-    int     remote_port;
-    int     response_code;
-    char *  header;
-    char *  auth_user;
-    char *  auth_password;
-    Network network_stack;
+    int         remote_port;
+    int         response_code;
+    char *      header;
+    char *      auth_user;
+    char *      auth_password;
+    Network     network_stack;
+    bool        keep_alive;   // keep the connection in the pool on close for the next request to the same server
+    int         conn_state;   // state of request/response on the connection, for keep-alive
+    void *      pool_entry;   // pool entry of the server, NULL if keep_alive is not used
+    bool        conn_reused;  // connection was taken from the pool, the server may have closed it meanwhile
+    /* request sent on a reused connection, sent again once on a new connection if the reused one
+     * is found closed before the status line. retry_url is NULL when there is nothing to retry */
+    const char *retry_url;
+    const char *retry_ca_crt;
+    int         retry_port;
+    int         retry_method;
 } HTTPClient;
 
 typedef struct {
     bool  is_more;               // if more data to check
     bool  is_chunked;            // if response in chunked data
+    bool  is_post_chunked;       // if post data is sent by qcloud_http_send_chunk
     int   retrieve_len;          // length of retrieve
     int   response_content_len;  // length of resposne content
     int   post_buf_len;          // post data length
     int   response_buf_len;      // length of response data buffer
     char *post_content_type;     // type of post content
+    char *post_content_encoding; // encoding of post content, NULL for identity
     char *post_buf;              // post data buffer
     char *response_buf;          // response data buffer
+    bool  decode_content;        // accept gzip/deflate response content and decode it into response_buf
+    int   decoded_len;           // length of decoded content put in response_buf by qcloud_http_recv_data
+    void *decoder;               // state of content decoding, free by qcloud_http_decode_deinit
 } HTTPClientData;
 
 /**
- * @brief do one http request
+ * @brief do one http request. If the request fails on a connection reused from the pool, it is
+ *        sent once more on a new connection, also when the response ends before its status line.
+ *        url and ca_crt must stay valid until qcloud_http_recv_data got the response header.
  *
  * @param client        http client
  * @param url           server url
@@ -73,12 +90,53 @@ int qcloud_http_client_common(HTTPClient *client, const char *url, int port, con
 
 int qcloud_http_recv_data(HTTPClient *client, uint32_t timeout_ms, HTTPClientData *client_data);
 
+/**
+ * @brief free the content decoding state of client_data used with decode_content
+ *
+ * @param client_data   http data
+ */
+void qcloud_http_decode_deinit(HTTPClientData *client_data);
+
 int qcloud_http_send_data(HTTPClient *client, HttpMethod method, uint32_t timeout_ms, HTTPClientData *client_data);
 
+/**
+ * @brief send one chunk of a chunked post body, header must be sent with is_post_chunked
+ *
+ * @param client        http client
+ * @param data          chunk data
+ * @param len           chunk length, 0 to send the last chunk
+ * @param timeout_ms    timeout
+ * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int qcloud_http_send_chunk(HTTPClient *client, const char *data, int len, uint32_t timeout_ms);
+
+/**
+ * @brief connect to the server of url. With keep_alive, an idle connection kept in the pool
+ *        for the same scheme, host and port is taken instead if there is one, and a new TLS
+ *        connection resumes the session of the last one to the server.
+ *
+ * @param client        http client
+ * @param url           server url
+ * @param port          server port
+ * @param ca_crt        ca of server for https, NULL for http
+ * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
 int qcloud_http_client_connect(HTTPClient *client, const char *url, int port, const char *ca_crt);
 
+/**
+ * @brief close the connection. With keep_alive, a connection whose response is read completely,
+ *        or not read at all after the whole request is sent, is kept in the pool instead
+ *        and closed after HTTP_CONN_POOL_IDLE_MS.
+ *
+ * @param client        http client
+ */
 void qcloud_http_client_close(HTTPClient *client);
 
+/**
+ * @brief close all idle connections in the pool and release the TLS sessions of servers not in use
+ */
+void qcloud_http_client_pool_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
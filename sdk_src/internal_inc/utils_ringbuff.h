@@ -44,4 +44,46 @@ int ring_buff_init(sRingbuff *ring_buff, char *buff, uint32_t size);
 int ring_buff_flush(sRingbuff *ring_buff);
 int ring_buff_push_data(sRingbuff *ring_buff, uint8_t *pData, int len);
 int ring_buff_pop_data(sRingbuff *ring_buff, uint8_t *pData, int len);
+
+/*
+ * Single-producer/single-consumer ring. One context pushes (e.g. the UART
+ * ISR or reader thread) while another pops, without any lock. head and tail
+ * are free-running byte counters, so size must be a power of two.
+ */
+typedef struct _spsc_ring_buff_ {
+    uint32_t          size;
+    uint32_t          mask;
+    volatile uint32_t head; /* bytes written, only the producer stores it */
+    volatile uint32_t tail; /* bytes read, only the consumer stores it */
+    uint8_t *         buffer;
+} sSpscRingbuff;
+
+typedef sSpscRingbuff *spsc_ring_buff_t;
+
+int spsc_ring_buff_init(sSpscRingbuff *ring_buff, void *buff, uint32_t size);
+
+/* consumer side: discard everything pushed so far */
+void spsc_ring_buff_flush(sSpscRingbuff *ring_buff);
+
+uint32_t spsc_ring_buff_used(sSpscRingbuff *ring_buff);
+uint32_t spsc_ring_buff_free(sSpscRingbuff *ring_buff);
+
+/* producer side: copy up to len bytes in, return the number accepted */
+uint32_t spsc_ring_buff_push(sSpscRingbuff *ring_buff, const void *pData, uint32_t len);
+
+/* consumer side: copy up to len bytes out, return the number read */
+uint32_t spsc_ring_buff_pop(sSpscRingbuff *ring_buff, void *pData, uint32_t len);
+
+/* producer side: point *ppData at the next contiguous writable span and
+ * return its length, commit makes len bytes of it visible to the consumer */
+uint32_t spsc_ring_buff_reserve(sSpscRingbuff *ring_buff, uint8_t **ppData);
+void     spsc_ring_buff_commit(sSpscRingbuff *ring_buff, uint32_t len);
+
+/* consumer side: point *ppData at the next contiguous readable span and
+ * return its length, without consuming it */
+uint32_t spsc_ring_buff_peek(sSpscRingbuff *ring_buff, const uint8_t **ppData);
+
+/* consumer side: release len bytes previously returned by peek */
+void spsc_ring_buff_consume(sSpscRingbuff *ring_buff, uint32_t len);
+
 #endif  // __ringbuff_h__
@@ -25,16 +25,23 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void *qcloud_url_download_init(const char *url, uint32_t offset, uint32_t size);
 
+/* accept gzip/deflate content and fetch it decoded, only for download from offset 0, call before connect */
+int qcloud_url_download_set_decode(void *handle, bool decode);
+
 int32_t qcloud_url_download_connect(void *handle, int https_enabled);
 
 int32_t qcloud_url_download_fetch(void *handle, char *buf, uint32_t bufLen, uint32_t timeout_s);
 
 int qcloud_url_download_deinit(void *handle);
 
+/* HTTP status code of the response, 0 before it is received */
+int qcloud_url_download_response_code(void *handle);
+
 #ifdef __cplusplus
 }
 #endif
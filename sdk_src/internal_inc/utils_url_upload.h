@@ -27,12 +27,27 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "utils_md5.h"
+
 void *qcloud_url_upload_init(const char *url, uint32_t content_len, char *custom_header);
 
 int32_t qcloud_url_upload_connect(void *handle, int method);
 
 int32_t qcloud_url_upload_body(void *handle, char *data_buf, uint32_t data_Len, uint32_t timeout_ms);
 
+/**
+ * @brief send len bytes of file from its current position as the request body. The file is mapped
+ *        where supported so disk reads overlap with sending, MD5 is updated as the data is sent.
+ *
+ * @param handle        upload handle
+ * @param fp            file opened by HAL_FileOpen, positioned after the data sent on success
+ * @param len           length of data to send
+ * @param md5           MD5 context to update with the data, NULL if not needed
+ * @param timeout_ms    timeout of sending each HTTP_UPLOAD_FILE_SLICE_SIZE of data
+ * @return              QCLOUD_RET_SUCCESS for success, or err code for failure
+ */
+int32_t qcloud_url_upload_file(void *handle, void *fp, uint32_t len, iot_md5_context *md5, uint32_t timeout_ms);
+
 int32_t qcloud_url_upload_recv_response(void *handle, char *response_buf, uint32_t bufLen, uint32_t timeout_ms);
 
 int qcloud_url_upload_deinit(void *handle);
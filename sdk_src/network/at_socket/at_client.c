@@ -37,17 +37,53 @@
 #define AT_RESP_END_FAIL  "FAIL"
 #define AT_END_CR_LF      "\r\n"
 
-sRingbuff        g_ring_buff;
+sSpscRingbuff    g_ring_buff;
 static at_client sg_at_client = {0};
 static uint32_t  sg_flags     = 0;
 
+#ifdef AT_UART_RECV_IRQ
+static volatile bool     sg_rx_held    = false;
+static volatile uint32_t sg_rx_dropped = 0;
+#endif
+
 /*this function can be called only by at_uart_isr, just push the data to the
- * at_client ringbuffer.*/
+ * at_client ringbuffer. It is the only producer of g_ring_buff, so no lock is
+ * taken here. The uart is held off before the ring fills up, anything still
+ * lost is counted and reported by the reader.*/
 void at_client_uart_rx_isr_cb(uint8_t *pdata, uint8_t len)
 {
-    (void)ring_buff_push_data(&g_ring_buff, pdata, len);
+#ifdef AT_UART_RECV_IRQ
+    sg_rx_dropped += len - spsc_ring_buff_push(&g_ring_buff, pdata, len);
+
+    if (!sg_rx_held && spsc_ring_buff_free(&g_ring_buff) < AT_UART_RX_HOLD_ROOM) {
+        sg_rx_held = true;
+        HAL_AT_Uart_SetRxFlow(false);
+    }
+#else
+    (void)spsc_ring_buff_push(&g_ring_buff, pdata, len);
+#endif
 }
 
+#ifdef AT_UART_RECV_IRQ
+/* reader side of the rx hold, called after data is taken out of the ring */
+static void _at_client_rx_release(at_client_t client)
+{
+    static uint32_t reported = 0;
+    uint32_t        dropped  = sg_rx_dropped;
+
+    if (sg_rx_held && spsc_ring_buff_free(client->pRingBuff) >= RING_BUFF_LEN / 2) {
+        sg_rx_held = false;
+        HAL_AT_Uart_SetRxFlow(true);
+    }
+
+    /* only the isr writes sg_rx_dropped */
+    if (dropped != reported) {
+        Log_w("at uart ring full, %u bytes dropped", dropped - reported);
+        reported = dropped;
+    }
+}
+#endif
+
 /**
  * Create response object.
  *
@@ -386,12 +422,15 @@ static int at_client_getchar(at_client_t client, char *pch, uint32_t timeout)
             continue;
         }
 #else
-        if (0 == ring_buff_pop_data(client->pRingBuff, (uint8_t *)pch,
+        if (0 == spsc_ring_buff_pop(client->pRingBuff, pch,
                                     1)) {  // push data to ringbuff @ AT_UART_IRQHandler
             continue;
         }
 #endif
         else {
+#ifdef AT_UART_RECV_IRQ
+            _at_client_rx_release(client);
+#endif
             break;
         }
     } while (!expired(&timer));
@@ -418,9 +457,14 @@ static int at_client_getchar(at_client_t client, char *pch, uint32_t timeout)
  */
 int at_client_obj_recv(char *buf, int size, int timeout)
 {
-    int  read_idx = 0;
-    int  result   = QCLOUD_RET_SUCCESS;
+    int read_idx = 0;
+#ifdef AT_UART_RECV_IRQ
+    Timer    timer;
+    uint32_t len;
+#else
+    int  result = QCLOUD_RET_SUCCESS;
     char ch;
+#endif
 
     POINTER_SANITY_CHECK(buf, 0);
     at_client_t client = at_client_get();
@@ -432,6 +476,22 @@ int at_client_obj_recv(char *buf, int size, int timeout)
         return 0;
     }
 
+#ifdef AT_UART_RECV_IRQ
+    /* copy whatever is already buffered in one go, the timeout restarts
+     * whenever new data arrives as it does per char below */
+    countdown_ms(&timer, timeout);
+    while (read_idx < size) {
+        len = spsc_ring_buff_pop(client->pRingBuff, buf + read_idx, size - read_idx);
+        if (len) {
+            _at_client_rx_release(client);
+            read_idx += len;
+            countdown_ms(&timer, timeout);
+        } else if (expired(&timer)) {
+            Log_e("AT Client receive failed, uart device get data timeout");
+            return 0;
+        }
+    }
+#else
     while (1) {
         if (read_idx < size) {
             result = at_client_getchar(client, &ch, timeout);
@@ -445,6 +505,7 @@ int at_client_obj_recv(char *buf, int size, int timeout)
             break;
         }
     }
+#endif
 
 #ifdef AT_DEBUG
     at_print_raw_cmd("urc_recv", buf, size);
@@ -565,7 +626,10 @@ static int at_recv_readline(at_client_t client)
                 Log_e("read line failed. The line data length is out of buffer size(%d)!", client->recv_bufsz);
                 memset(client->recv_buffer, 0x00, client->recv_bufsz);
                 client->cur_recv_len = 0;
-                ring_buff_flush(client->pRingBuff);
+                spsc_ring_buff_flush(client->pRingBuff);
+#ifdef AT_UART_RECV_IRQ
+                _at_client_rx_release(client);
+#endif
                 return -1;
             }
             break;
@@ -791,7 +855,10 @@ int at_client_para_init(at_client_t client)
         Log_e("malloc ringbuff err");
         goto err_exit;
     }
-    ring_buff_init(&g_ring_buff, ringBuff, RING_BUFF_LEN);
+    if (RINGBUFF_OK != spsc_ring_buff_init(&g_ring_buff, ringBuff, RING_BUFF_LEN)) {
+        Log_e("ringbuff len %d is not a power of two", RING_BUFF_LEN);
+        goto err_exit;
+    }
 
     recvBuff = HAL_Malloc(CLINET_BUFF_LEN);
     if (NULL == recvBuff) {
@@ -25,9 +25,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "at_client.h"
 #include "qcloud_iot_export.h"
 #include "qcloud_iot_import.h"
 #include "utils_param_check.h"
+#include "utils_timer.h"
 
 /** The global array of available at */
 static at_socket_ctx_t at_socket_ctxs[MAX_AT_SOCKET_NUM];
@@ -38,8 +40,6 @@ static void *sg_at_socket_mutex;
 /**at device driver ops*/
 static at_device_op_t *sg_at_device_ops = NULL;
 
-#define MAX_RECV_PKT_PER_CHAIN (10)
-
 static at_device_op_t *_at_device_op_get(void)
 {
     return sg_at_device_ops;
@@ -52,9 +52,9 @@ static int _at_socket_ctx_free(at_socket_ctx_t *pCtx)
     pCtx->fd       = UNUSED_SOCKET;
     pCtx->net_type = eNET_DEFAULT;
 
-    if (pCtx->recvpkt_list) {
-        list_destroy(pCtx->recvpkt_list);
-        pCtx->recvpkt_list = NULL;
+    if (pCtx->recv_ring.buffer) {
+        HAL_Free(pCtx->recv_ring.buffer);
+        memset(&pCtx->recv_ring, 0, sizeof(pCtx->recv_ring));
     }
 
     if (pCtx->recv_lock) {
@@ -67,7 +67,8 @@ static int _at_socket_ctx_free(at_socket_ctx_t *pCtx)
 
 static at_socket_ctx_t *_at_socket_ctx_alloc(void)
 {
-    int i;
+    int   i;
+    void *ring_mem;
 
     for (i = 0; i < MAX_AT_SOCKET_NUM; i++) {
         if (at_socket_ctxs[i].state == eSOCKET_CLOSED) {
@@ -81,11 +82,14 @@ static at_socket_ctx_t *_at_socket_ctx_alloc(void)
                 Log_e("create recv lock fail");
                 goto exit;
             }
-            at_socket_ctxs[i].recvpkt_list = list_new();
-            if (NULL != at_socket_ctxs[i].recvpkt_list) {
-                at_socket_ctxs[i].recvpkt_list->free = HAL_Free;
-            } else {
-                Log_e("no memory to allocate recvpkt_list");
+            ring_mem = HAL_Malloc(AT_SOCKET_RECV_RING_LEN);
+            if (NULL == ring_mem) {
+                Log_e("no memory to allocate recv ring");
+                goto exit;
+            }
+            if (RINGBUFF_OK != spsc_ring_buff_init(&at_socket_ctxs[i].recv_ring, ring_mem, AT_SOCKET_RECV_RING_LEN)) {
+                Log_e("recv ring len %d is not a power of two", AT_SOCKET_RECV_RING_LEN);
+                HAL_Free(ring_mem);
                 goto exit;
             }
 
@@ -103,7 +107,8 @@ exit:
     return NULL;
 }
 
-static at_socket_ctx_t *_at_socket_find(int fd)
+/* caller holds sg_at_socket_mutex */
+static at_socket_ctx_t *_at_socket_find_locked(int fd)
 {
     int i;
 
@@ -116,90 +121,31 @@ static at_socket_ctx_t *_at_socket_find(int fd)
     return NULL;
 }
 
-/* get a block to the AT socket receive list*/
-static int _at_recvpkt_put(List *rlist, const char *ptr, size_t length)
+static at_socket_ctx_t *_at_socket_find(int fd)
 {
-    at_recv_pkt *pkt = NULL;
-
-    if (rlist->len > MAX_RECV_PKT_PER_CHAIN) {
-        Log_e("Too many recv packets wait for read");
-        HAL_Free(pkt);
-        return QCLOUD_ERR_FAILURE;
-    }
-
-    pkt = (at_recv_pkt *)HAL_Malloc(sizeof(struct at_recv_pkt));
-    if (pkt == NULL) {
-        Log_e("No memory for receive packet table!");
-        return QCLOUD_ERR_FAILURE;
-    }
-
-    pkt->bfsz_totle = length;
-    pkt->bfsz_index = 0;
-    pkt->buff       = (char *)ptr;
-
-    ListNode *node = list_node_new(pkt);
-    if (NULL == node) {
-        Log_e("run list_node_new is error!");
-        HAL_Free(pkt);
-        return QCLOUD_ERR_FAILURE;
-    }
+    at_socket_ctx_t *pAtSocket;
 
-    list_rpush(rlist, node);
+    HAL_MutexLock(sg_at_socket_mutex);
+    pAtSocket = _at_socket_find_locked(fd);
+    HAL_MutexUnlock(sg_at_socket_mutex);
 
-    return length;
+    return pAtSocket;
 }
 
-/* get a block from AT socket receive list */
-static int _at_recvpkt_get(List *pkt_list, char *buff, size_t len)
+/* read and drop socket data that has no place to go, so the next URC is
+ * parsed from the right position */
+static void _at_recv_discard(size_t len, uint32_t timeout)
 {
-    ListIterator *iter;
-    ListNode *    node = NULL;
-    at_recv_pkt * pkt;
-    size_t        readlen = 0, page_len = 0;
-    POINTER_SANITY_CHECK(buff, QCLOUD_ERR_INVAL);
-
-    if (pkt_list->len) {
-        iter = list_iterator_new(pkt_list, LIST_HEAD);
-        if (NULL == iter) {
-            Log_e("new listiterator fail");
-            return QCLOUD_ERR_TCP_READ_FAIL;
-        }
+    char   temp[16];
+    size_t n;
 
-        /*traverse recv pktlist*/
-        do {
-            node = list_iterator_next(iter);
-            if (!node) {
-                break;
-            }
-
-            /*get recv packet*/
-            pkt = (at_recv_pkt *)(node->val);
-            if (!pkt) {
-                Log_e("pkt is invalid!");
-                list_remove(pkt_list, node);
-                continue;
-            }
-
-            page_len = pkt->bfsz_totle - pkt->bfsz_index;
-            if (page_len >= (len - readlen)) {
-                memcpy(buff + readlen, pkt->buff + pkt->bfsz_index, (len - readlen));
-                pkt->bfsz_index += len - readlen;
-                readlen = len;
-                break;
-            } else {
-                memcpy(buff + readlen, pkt->buff + pkt->bfsz_index, page_len);
-                readlen += page_len;
-
-                /*delete pkt after read*/
-                HAL_Free(pkt->buff);
-                list_remove(pkt_list, node);
-            }
-        } while (1);
-
-        list_iterator_destroy(iter);
+    while (len) {
+        n = len > sizeof(temp) ? sizeof(temp) : len;
+        if (at_client_recv(temp, n, timeout) != n) {
+            break;
+        }
+        len -= n;
     }
-
-    return readlen;
 }
 
 static void _at_socket_recv_cb(int fd, at_socket_evt_t event, char *buff, size_t bfsz)
@@ -207,28 +153,34 @@ static void _at_socket_recv_cb(int fd, at_socket_evt_t event, char *buff, size_t
     POINTER_SANITY_CHECK_RTN(buff);
     at_socket_ctx_t *pAtSocket;
 
+    /* drivers that hand over a malloced buffer instead of calling
+     * at_socket_recv_fill(), copy it into the ring and release it */
     if (event == AT_SOCKET_EVT_RECV) {
         HAL_MutexLock(sg_at_socket_mutex);
-        pAtSocket = _at_socket_find(fd + MAX_AT_SOCKET_NUM);
-        if (_at_recvpkt_put(pAtSocket->recvpkt_list, buff, bfsz) < 0) {
-            Log_e("put recv package to list fail");
-            HAL_Free(buff);
+        pAtSocket = _at_socket_find_locked(fd + MAX_AT_SOCKET_NUM);
+        if (NULL == pAtSocket || spsc_ring_buff_push(&pAtSocket->recv_ring, buff, bfsz) != bfsz) {
+            Log_e("put recv data to ring fail");
         }
         HAL_MutexUnlock(sg_at_socket_mutex);
+        HAL_Free(buff);
     }
 }
 
 static void _at_socket_closed_cb(int fd, at_socket_evt_t event, char *buff, size_t bfsz)
 {
     at_socket_ctx_t *pAtSocket;
-    pAtSocket = _at_socket_find(fd + MAX_AT_SOCKET_NUM);
 
-    if (pAtSocket != NULL && event == AT_SOCKET_EVT_CLOSED) {
-        HAL_MutexLock(sg_at_socket_mutex);
+    if (event != AT_SOCKET_EVT_CLOSED) {
+        return;
+    }
+
+    HAL_MutexLock(sg_at_socket_mutex);
+    pAtSocket = _at_socket_find_locked(fd + MAX_AT_SOCKET_NUM);
+    if (pAtSocket != NULL) {
         pAtSocket->state = eSOCKET_CLOSED;
         _at_socket_ctx_free(pAtSocket);
-        HAL_MutexUnlock(sg_at_socket_mutex);
     }
+    HAL_MutexUnlock(sg_at_socket_mutex);
 }
 
 int at_device_op_register(at_device_op_t *device_op)
@@ -255,7 +207,7 @@ int at_socket_init(void)
         at_socket_ctxs[i].fd           = UNUSED_SOCKET;
         at_socket_ctxs[i].state        = eSOCKET_CLOSED;
         at_socket_ctxs[i].dev_op       = NULL;
-        at_socket_ctxs[i].recvpkt_list = NULL;
+        memset(&at_socket_ctxs[i].recv_ring, 0, sizeof(at_socket_ctxs[i].recv_ring));
     }
 
     sg_at_socket_mutex = HAL_MutexCreate();
@@ -385,21 +337,74 @@ int at_socket_recv(int fd, void *buf, size_t len)
         HAL_MutexLock(pAtSocket->recv_lock);
 
         // call at device recv driver for os and nonos
-        if (pAtSocket->recvpkt_list->len == 0) {
+        if (0 == spsc_ring_buff_used(&pAtSocket->recv_ring)) {
             if (pAtSocket->dev_op->recv_timeout(fd - MAX_AT_SOCKET_NUM, buf, len, pAtSocket->recv_timeout_ms) !=
                 QCLOUD_RET_SUCCESS) {
                 Log_e("at device recv err");  // do not return yet
             }
         }
 
-        /* receive packet list last transmission of remaining data */
-        recv_len = _at_recvpkt_get(pAtSocket->recvpkt_list, (char *)buf, len);
+        recv_len = spsc_ring_buff_pop(&pAtSocket->recv_ring, buf, len);
         HAL_MutexUnlock(pAtSocket->recv_lock);
     }
 
     return recv_len;
 }
 
+int at_socket_recv_fill(int dev_fd, size_t len, uint32_t timeout)
+{
+    at_socket_ctx_t *pAtSocket;
+    size_t           filled = 0;
+    uint32_t         span;
+    uint8_t *        ptr;
+    Timer            timer;
+
+    countdown_ms(&timer, timeout);
+    while (filled < len) {
+        /* the ring is only used under the mutex, as close frees it */
+        HAL_MutexLock(sg_at_socket_mutex);
+        pAtSocket = _at_socket_find_locked(dev_fd + MAX_AT_SOCKET_NUM);
+        if (NULL == pAtSocket || NULL == pAtSocket->recv_ring.buffer) {
+            HAL_MutexUnlock(sg_at_socket_mutex);
+            Log_e("socket %d not found, discard %u bytes", dev_fd, len - filled);
+            _at_recv_discard(len - filled, timeout);
+            return 0 == filled ? QCLOUD_ERR_FAILURE : (int)filled;
+        }
+
+        span = spsc_ring_buff_reserve(&pAtSocket->recv_ring, &ptr);
+        if (0 == span) {
+            HAL_MutexUnlock(sg_at_socket_mutex);
+#ifdef AT_OS_USED
+            /* the uart ring is not drained while waiting here, so the uart
+             * rx is paused and the module held off until the reader makes
+             * room. Only a reader stalled for a whole timeout loses data */
+            if (!expired(&timer)) {
+                at_delayms(1);
+                continue;
+            }
+#endif
+            Log_e("socket %d recv ring full, discard %u bytes", dev_fd, len - filled);
+            _at_recv_discard(len - filled, timeout);
+            break;
+        }
+
+        if (span > len - filled) {
+            span = len - filled;
+        }
+        if (at_client_recv((char *)ptr, span, timeout) != span) {
+            HAL_MutexUnlock(sg_at_socket_mutex);
+            Log_e("receive size(%u) data failed!", span);
+            break;
+        }
+        spsc_ring_buff_commit(&pAtSocket->recv_ring, span);
+        HAL_MutexUnlock(sg_at_socket_mutex);
+        filled += span;
+        countdown_ms(&timer, timeout);
+    }
+
+    return filled;
+}
+
 int at_socket_recv_timeout(int fd, void *buf, size_t len, uint32_t timeout)
 {
     at_socket_ctx_t *pAtSocket;
@@ -32,6 +32,63 @@ int is_network_connected(Network *pNetwork)
     return pNetwork->handle;
 }
 
+int network_writev(Network *pNetwork, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len)
+{
+    POINTER_SANITY_CHECK(pNetwork, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(written_len, QCLOUD_ERR_INVAL);
+
+    int    i, rc = QCLOUD_RET_SUCCESS;
+    size_t len;
+
+    if (NULL != pNetwork->writev) {
+        return pNetwork->writev(pNetwork, iov, iovcnt, timeout_ms, written_len);
+    }
+
+    *written_len = 0;
+    for (i = 0; i < iovcnt; i++) {
+        if (0 == iov[i].len) {
+            continue;
+        }
+
+        len = 0;
+        rc  = pNetwork->write(pNetwork, (unsigned char *)iov[i].data, iov[i].len, timeout_ms, &len);
+        *written_len += len;
+        /* partial write, let caller decide to retry from where it stops */
+        if (QCLOUD_RET_SUCCESS != rc || len < iov[i].len) {
+            break;
+        }
+    }
+
+    return rc;
+}
+
+int network_get_fd(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    if (NULL == pNetwork->get_fd || 0 == pNetwork->is_connected(pNetwork)) {
+        return -1;
+    }
+
+    return pNetwork->get_fd(pNetwork);
+}
+
+int network_readable(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    if (NULL == pNetwork->readable || 0 == pNetwork->is_connected(pNetwork)) {
+        return -1;
+    }
+
+    return pNetwork->readable(pNetwork);
+}
+
+bool network_is_connecting(int rc)
+{
+    return QCLOUD_ERR_TCP_CONNECTING == rc || QCLOUD_ERR_SSL_CONNECTING == rc;
+}
+
 #ifdef AT_TCP_ENABLED
 int is_network_at_connected(Network *pNetwork)
 {
@@ -51,18 +108,33 @@ int qcloud_iot_network_init(Network *pNetwork)
     switch (pNetwork->type) {
         case NETWORK_TCP:
 #ifdef AT_TCP_ENABLED
-            pNetwork->init         = network_at_tcp_init;
-            pNetwork->connect      = network_at_tcp_connect;
-            pNetwork->read         = network_at_tcp_read;
-            pNetwork->write        = network_at_tcp_write;
-            pNetwork->disconnect   = network_at_tcp_disconnect;
-            pNetwork->is_connected = is_network_at_connected;
-            pNetwork->handle       = AT_NO_CONNECTED_FD;
+            pNetwork->init          = network_at_tcp_init;
+            pNetwork->connect       = network_at_tcp_connect;
+            pNetwork->connect_async = NULL;
+            pNetwork->read          = network_at_tcp_read;
+            pNetwork->write         = network_at_tcp_write;
+            pNetwork->writev        = NULL;
+            pNetwork->get_fd        = NULL;
+            pNetwork->readable      = NULL;
+            pNetwork->disconnect    = network_at_tcp_disconnect;
+            pNetwork->is_connected  = is_network_at_connected;
+            pNetwork->handle        = AT_NO_CONNECTED_FD;
 #else
             pNetwork->init         = network_tcp_init;
             pNetwork->connect      = network_tcp_connect;
             pNetwork->read         = network_tcp_read;
             pNetwork->write        = network_tcp_write;
+#if defined(__linux__)
+            pNetwork->connect_async = network_tcp_connect_async;
+            pNetwork->writev        = network_tcp_writev;
+            pNetwork->get_fd        = network_tcp_get_fd;
+            pNetwork->readable      = network_tcp_readable;
+#else
+            pNetwork->connect_async = NULL;
+            pNetwork->writev        = NULL;
+            pNetwork->get_fd        = NULL;
+            pNetwork->readable      = NULL;
+#endif
             pNetwork->disconnect   = network_tcp_disconnect;
             pNetwork->is_connected = is_network_connected;
             pNetwork->handle       = 0;
@@ -75,6 +147,16 @@ int qcloud_iot_network_init(Network *pNetwork)
             pNetwork->connect      = network_tls_connect;
             pNetwork->read         = network_tls_read;
             pNetwork->write        = network_tls_write;
+            pNetwork->writev       = NULL;
+#if defined(__linux__)
+            pNetwork->connect_async = network_tls_connect_async;
+            pNetwork->get_fd        = network_tls_get_fd;
+            pNetwork->readable      = network_tls_readable;
+#else
+            pNetwork->connect_async = NULL;
+            pNetwork->get_fd        = NULL;
+            pNetwork->readable      = NULL;
+#endif
             pNetwork->disconnect   = network_tls_disconnect;
             pNetwork->is_connected = is_network_connected;
             pNetwork->handle       = 0;
@@ -84,23 +166,31 @@ int qcloud_iot_network_init(Network *pNetwork)
 #ifdef COAP_COMM_ENABLED
 #ifdef AUTH_WITH_NOTLS
         case NETWORK_UDP:
-            pNetwork->init         = network_udp_init;
-            pNetwork->connect      = network_udp_connect;
-            pNetwork->read         = network_udp_read;
-            pNetwork->write        = network_udp_write;
-            pNetwork->disconnect   = network_udp_disconnect;
-            pNetwork->is_connected = is_network_connected;
-            pNetwork->handle       = 0;
+            pNetwork->init          = network_udp_init;
+            pNetwork->connect       = network_udp_connect;
+            pNetwork->connect_async = NULL;
+            pNetwork->read          = network_udp_read;
+            pNetwork->write         = network_udp_write;
+            pNetwork->writev        = NULL;
+            pNetwork->get_fd        = NULL;
+            pNetwork->readable      = NULL;
+            pNetwork->disconnect    = network_udp_disconnect;
+            pNetwork->is_connected  = is_network_connected;
+            pNetwork->handle        = 0;
             break;
 #else
         case NETWORK_DTLS:
-            pNetwork->init         = network_dtls_init;
-            pNetwork->connect      = network_dtls_connect;
-            pNetwork->read         = network_dtls_read;
-            pNetwork->write        = network_dtls_write;
-            pNetwork->disconnect   = network_dtls_disconnect;
-            pNetwork->is_connected = is_network_connected;
-            pNetwork->handle       = 0;
+            pNetwork->init          = network_dtls_init;
+            pNetwork->connect       = network_dtls_connect;
+            pNetwork->connect_async = NULL;
+            pNetwork->read          = network_dtls_read;
+            pNetwork->write         = network_dtls_write;
+            pNetwork->writev        = NULL;
+            pNetwork->get_fd        = NULL;
+            pNetwork->readable      = NULL;
+            pNetwork->disconnect    = network_dtls_disconnect;
+            pNetwork->is_connected  = is_network_connected;
+            pNetwork->handle        = 0;
             break;
 #endif
 #endif
@@ -108,6 +198,8 @@ int qcloud_iot_network_init(Network *pNetwork)
             Log_e("unknown network type: %d", pNetwork->type);
             return QCLOUD_ERR_INVAL;
     }
+    pNetwork->connect_ctx = NULL;
+
     return pNetwork->init(pNetwork);
 }
 
@@ -66,10 +66,62 @@ int network_tcp_write(Network *pNetwork, unsigned char *data, size_t datalen, ui
     return rc;
 }
 
+#if defined(__linux__)
+int network_tcp_writev(Network *pNetwork, const NetIovec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len)
+{
+    POINTER_SANITY_CHECK(pNetwork, QCLOUD_ERR_INVAL);
+
+    return HAL_TCP_Writev(pNetwork->handle, iov, iovcnt, timeout_ms, written_len);
+}
+
+int network_tcp_get_fd(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    return 0 == pNetwork->handle ? -1 : (int)pNetwork->handle;
+}
+
+int network_tcp_readable(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    return HAL_TCP_ReadableBytes(pNetwork->handle);
+}
+
+int network_tcp_connect_async(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, QCLOUD_ERR_INVAL);
+
+    int rc;
+
+    if (NULL == pNetwork->connect_ctx) {
+        pNetwork->connect_ctx = HAL_TCP_ConnectStart(pNetwork->host, pNetwork->port);
+        if (NULL == pNetwork->connect_ctx) {
+            return QCLOUD_ERR_TCP_CONNECT;
+        }
+    }
+
+    rc = HAL_TCP_ConnectPoll(pNetwork->connect_ctx, &pNetwork->handle);
+    if (QCLOUD_ERR_TCP_CONNECTING == rc) {
+        return rc;
+    }
+
+    HAL_TCP_ConnectStop(pNetwork->connect_ctx);
+    pNetwork->connect_ctx = NULL;
+
+    return rc;
+}
+#endif
+
 void network_tcp_disconnect(Network *pNetwork)
 {
     POINTER_SANITY_CHECK_RTN(pNetwork);
 
+#if defined(__linux__)
+    HAL_TCP_ConnectStop(pNetwork->connect_ctx);
+    pNetwork->connect_ctx = NULL;
+#endif
+
     if (0 == pNetwork->handle) {
         return;
     }
@@ -65,6 +65,44 @@ int network_tls_write(Network *pNetwork, unsigned char *data, size_t datalen, ui
     return rc;
 }
 
+#if defined(__linux__)
+int network_tls_get_fd(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    return HAL_TLS_GetFd(pNetwork->handle);
+}
+
+int network_tls_readable(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, -1);
+
+    return HAL_TLS_ReadableBytes(pNetwork->handle);
+}
+
+int network_tls_connect_async(Network *pNetwork)
+{
+    POINTER_SANITY_CHECK(pNetwork, QCLOUD_ERR_INVAL);
+
+    int rc;
+
+    if (0 == pNetwork->handle) {
+        pNetwork->handle = HAL_TLS_ConnectStart(&(pNetwork->ssl_connect_params), pNetwork->host, pNetwork->port);
+        if (0 == pNetwork->handle) {
+            return QCLOUD_ERR_SSL_CONNECT;
+        }
+    }
+
+    rc = HAL_TLS_ConnectPoll(pNetwork->handle);
+    if (QCLOUD_RET_SUCCESS != rc && !network_is_connecting(rc)) {
+        HAL_TLS_Disconnect(pNetwork->handle);
+        pNetwork->handle = 0;
+    }
+
+    return rc;
+}
+#endif
+
 void network_tls_disconnect(Network *pNetwork)
 {
     POINTER_SANITY_CHECK_RTN(pNetwork);
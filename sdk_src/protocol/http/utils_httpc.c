@@ -31,6 +31,7 @@ extern "C" {
 #include "qcloud_iot_common.h"
 #include "qcloud_iot_export.h"
 #include "qcloud_iot_import.h"
+#include "utils_deflate.h"
 #include "utils_timer.h"
 
 #define HTTP_CLIENT_MIN(x, y) (((x) < (y)) ? (x) : (y))
@@ -46,6 +47,46 @@ extern "C" {
 
 #define HTTP_RETRIEVE_MORE_DATA (1)
 
+/* staging of encoded content, a receive needs HTTP_CLIENT_CHUNK_SIZE free space as it may return that much */
+#define HTTP_CLIENT_DECODE_BUF_SIZE (2 * HTTP_CLIENT_CHUNK_SIZE)
+
+typedef struct {
+    void *inflate;    // NULL for identity content
+    bool  body_done;  // all encoded content is received
+    bool  stream_end; // all decoded content is output
+    int   len;        // length of encoded content staged in buf
+    char  buf[HTTP_CLIENT_DECODE_BUF_SIZE + 1];
+} HTTPContentDecoder;
+
+/* request/response state of a connection, a keep-alive connection is pooled only when IDLE or SENT */
+typedef enum {
+    HTTP_CONN_IDLE = 0,   // no request in progress
+    HTTP_CONN_SENDING,    // request header or body being sent
+    HTTP_CONN_SENT,       // request sent completely, response not read yet
+    HTTP_CONN_RECEIVING,  // response header parsed, body being read
+    HTTP_CONN_CLOSE,      // server closes the connection after the response
+} HTTPConnState;
+
+/* time (unit: ms) to read the response left unread on a pooled connection before reusing it */
+#define HTTP_CLIENT_DRAIN_TIMEOUT_MS 1000
+
+typedef struct {
+    char     host[HTTP_CLIENT_MAX_HOST_LEN];  // empty if the entry is free
+    int      port;
+    bool     tls;
+    int      users;          // clients connected to the server through the pool
+    uint32_t last_use;       // stamp for least recently used eviction
+    Network  network;        // idle connection, handle is 0 if none
+    bool     drain;          // response of the idle connection is not read yet
+    Timer    idle_timer;     // idle connection is closed when it expires
+    void *   tls_cache;      // TLS contexts and last session of the server
+    bool     cache_in_use;   // a connection, active or idle, uses tls_cache
+} HTTPPoolEntry;
+
+static HTTPPoolEntry sg_http_pool[HTTP_CONN_POOL_SIZE];
+static void *        sg_http_pool_lock = NULL;
+static uint32_t      sg_http_pool_stamp = 0;
+
 #if defined(MBEDTLS_DEBUG_C)
 #define DEBUG_LEVEL 2
 #endif
@@ -271,14 +312,27 @@ static int _http_client_send_header(HTTPClient *client, const char *url, HttpMet
         _http_client_get_info(client, send_buf, &len, (char *)client->header, strlen(client->header));
     }
 
-    if (client_data->post_buf != NULL) {
-        HAL_Snprintf(buf, sizeof(buf), "Content-Length: %d\r\n", client_data->post_buf_len);
-        _http_client_get_info(client, send_buf, &len, buf, strlen(buf));
+    if (client_data->post_buf != NULL || client_data->is_post_chunked) {
+        if (client_data->is_post_chunked) {
+            _http_client_get_info(client, send_buf, &len, "Transfer-Encoding: chunked\r\n", 0);
+        } else {
+            HAL_Snprintf(buf, sizeof(buf), "Content-Length: %d\r\n", client_data->post_buf_len);
+            _http_client_get_info(client, send_buf, &len, buf, strlen(buf));
+        }
 
         if (client_data->post_content_type != NULL) {
             HAL_Snprintf(buf, sizeof(buf), "Content-Type: %s\r\n", client_data->post_content_type);
             _http_client_get_info(client, send_buf, &len, buf, strlen(buf));
         }
+
+        if (client_data->post_content_encoding != NULL) {
+            HAL_Snprintf(buf, sizeof(buf), "Content-Encoding: %s\r\n", client_data->post_content_encoding);
+            _http_client_get_info(client, send_buf, &len, buf, strlen(buf));
+        }
+    }
+
+    if (client_data->decode_content) {
+        _http_client_get_info(client, send_buf, &len, "Accept-Encoding: gzip, deflate\r\n", 0);
     }
 
     _http_client_get_info(client, send_buf, &len, "\r\n", 0);
@@ -323,6 +377,21 @@ static int _http_client_send_userdata(HTTPClient *client, HTTPClientData *client
     return QCLOUD_RET_SUCCESS;
 }
 
+static int _http_client_write(HTTPClient *client, const char *data, size_t len, uint32_t timeout_ms)
+{
+    size_t written_len = 0;
+    int    rc = client->network_stack.write(&client->network_stack, (unsigned char *)data, len, timeout_ms, &written_len);
+    if (written_len == 0) {
+        Log_e("written_len == 0,Connection was closed by server");
+        return QCLOUD_ERR_HTTP_CLOSED;
+    } else if (rc != QCLOUD_RET_SUCCESS) {
+        Log_e("Connection error (send returned %d)", rc);
+        return QCLOUD_ERR_HTTP_CONN;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
 static int _http_client_recv(HTTPClient *client, char *buf, int min_len, int max_len, int *p_read_len,
                              uint32_t timeout_ms, HTTPClientData *client_data)
 {
@@ -415,8 +484,9 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
         uint32_t readLen = 0;
         if (client_data->is_chunked && client_data->retrieve_len <= 0) {
             /* Read chunk header */
-            bool foundCrlf;
-            int  n;
+            bool  foundCrlf;
+            int   n;
+            char *chunk_end;
             do {
                 foundCrlf = IOT_FALSE;
                 crlf_pos  = 0;
@@ -429,12 +499,22 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
                         }
                     }
                 }
+                if (foundCrlf && crlf_pos == 0) {
+                    /* CRLF ending the data of a chunk, left when response_buf filled up */
+                    memmove(data, &data[2], len - 2);
+                    len -= 2;
+                    foundCrlf = IOT_FALSE;
+                    continue;
+                }
                 if (!foundCrlf) {
                     /* Try to read more */
                     if (len < HTTP_CLIENT_CHUNK_SIZE) {
                         int new_trf_len, rc;
-                        rc = _http_client_recv(client, data + len, 0, HTTP_CLIENT_CHUNK_SIZE - len - 1, &new_trf_len,
-                                               left_ms(&timer), client_data);
+                        /* no more than response_buf can take, bytes after a full response_buf would be lost */
+                        int max_len = HTTP_CLIENT_MIN(HTTP_CLIENT_CHUNK_SIZE - len - 1,
+                                                      client_data->response_buf_len - 1 - count);
+                        rc = _http_client_recv(client, data + len, 0, max_len, &new_trf_len, left_ms(&timer),
+                                               client_data);
                         len += new_trf_len;
                         if (rc != QCLOUD_RET_SUCCESS) {
                             IOT_FUNC_EXIT_RC(rc);
@@ -449,14 +529,10 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
             data[crlf_pos] = '\0';
 
             // n = sscanf(data, "%x", &readLen);/* chunk length */
-            readLen                   = strtoul(data, NULL, 16);
-            n                         = (0 == readLen) ? 0 : 1;
+            readLen                   = strtoul(data, &chunk_end, 16);
+            n                         = (chunk_end == data) ? 0 : 1;
             client_data->retrieve_len = readLen;
             client_data->response_content_len += client_data->retrieve_len;
-            if (readLen == 0) {
-                client_data->is_more = IOT_FALSE;
-                Log_d("no more (last chunk)");
-            }
 
             if (n != 1) {
                 Log_e("Could not read chunk length");
@@ -466,6 +542,24 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
             memmove(data, &data[crlf_pos + 2], len - (crlf_pos + 2));
             len -= (crlf_pos + 2);
 
+            if (readLen == 0) {
+                client_data->is_more = IOT_FALSE;
+                Log_d("no more (last chunk)");
+                /* empty line ending the body, read it to leave the connection clean for the next request */
+                if (len < 2) {
+                    int new_trf_len = 0;
+                    if (_http_client_recv(client, data + len, 2 - len, 2 - len, &new_trf_len, left_ms(&timer),
+                                          client_data) == QCLOUD_RET_SUCCESS) {
+                        len += new_trf_len;
+                    }
+                }
+                /* trailer fields are not parsed, such a connection is not reused */
+                if (len != 2 || data[0] != '\r' || data[1] != '\n') {
+                    client->conn_state = HTTP_CONN_CLOSE;
+                }
+                IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+            }
+
         } else {
             readLen = client_data->retrieve_len;
         }
@@ -492,6 +586,7 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
                 client_data->retrieve_len = 0;
             } else {
                 readLen -= len;
+                len = 0;
             }
 
             if (readLen) {
@@ -513,8 +608,8 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
             if (len < 2) {
                 int new_trf_len, rc;
                 /* Read missing chars to find end of chunk */
-                rc = _http_client_recv(client, data + len, 2 - len, HTTP_CLIENT_CHUNK_SIZE - len - 1, &new_trf_len,
-                                       left_ms(&timer), client_data);
+                rc = _http_client_recv(client, data + len, 2 - len, 2 - len, &new_trf_len, left_ms(&timer),
+                                       client_data);
                 if ((rc != QCLOUD_RET_SUCCESS) || (0 == left_ms(&timer))) {
                     IOT_FUNC_EXIT_RC(rc);
                 }
@@ -537,6 +632,36 @@ static int _http_client_retrieve_content(HTTPClient *client, char *data, int len
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+static int _http_client_content_decoder(HTTPClientData *client_data, const char *header)
+{
+    HTTPContentDecoder *decoder = client_data->decoder;
+    const char *        value   = strstr(header, "Content-Encoding: ");
+
+    if (value == NULL) {
+        value = strstr(header, "content-encoding: ");
+    }
+    if (value == NULL) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    value += strlen("Content-Encoding: ");
+    if (!strncmp(value, "identity", strlen("identity"))) {
+        return QCLOUD_RET_SUCCESS;
+    }
+    if (strncmp(value, "gzip", strlen("gzip")) && strncmp(value, "deflate", strlen("deflate"))) {
+        Log_e("unsupported content encoding: %.16s", value);
+        return QCLOUD_ERR_HTTP_PRTCL;
+    }
+
+    /* gzip or zlib wrapped deflate, the wrapper is detected by the inflater */
+    decoder->inflate = utils_inflate_init(HTTP_INFLATE_WINDOW_SIZE);
+    if (decoder->inflate == NULL) {
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
 static int _http_client_response_parse(HTTPClient *client, char *data, int len, uint32_t timeout_ms,
                                        HTTPClientData *client_data)
 {
@@ -586,6 +711,7 @@ static int _http_client_response_parse(HTTPClient *client, char *data, int len,
     len -= (crlf_pos + 2);
 
     client_data->is_chunked = IOT_FALSE;
+    client->conn_state      = HTTP_CONN_RECEIVING;
 
     if (NULL == (ptr_body_end = strstr(data, "\r\n\r\n"))) {
         int new_trf_len, rc;
@@ -607,7 +733,7 @@ static int _http_client_response_parse(HTTPClient *client, char *data, int len,
         client_data->retrieve_len         = client_data->response_content_len;
     } else if (NULL != (tmp_ptr = strstr(data, "Transfer-Encoding"))) {
         int   len_chunk   = strlen("Chunked");
-        char *chunk_value = data + strlen("Transfer-Encoding: ");
+        char *chunk_value = tmp_ptr + strlen("Transfer-Encoding: ");
 
         if ((!memcmp(chunk_value, "Chunked", len_chunk)) || (!memcmp(chunk_value, "chunked", len_chunk))) {
             client_data->is_chunked           = IOT_TRUE;
@@ -619,6 +745,18 @@ static int _http_client_response_parse(HTTPClient *client, char *data, int len,
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_HTTP);
     }
 
+    *ptr_body_end = '\0';
+    if (strstr(data, "Connection: close") || strstr(data, "connection: close")) {
+        client->conn_state = HTTP_CONN_CLOSE;
+    }
+    if (client_data->decode_content) {
+        int rc = _http_client_content_decoder(client_data, data);
+        if (rc != QCLOUD_RET_SUCCESS) {
+            IOT_FUNC_EXIT_RC(rc);
+        }
+    }
+    *ptr_body_end = '\r';
+
     len = len - (ptr_body_end + 4 - data);
     memmove(data, ptr_body_end + 4, len + 1);
     int rc = _http_client_retrieve_content(client, data, len, left_ms(&timer), client_data);
@@ -634,12 +772,25 @@ static int _http_client_connect(HTTPClient *client)
     return QCLOUD_RET_SUCCESS;
 }
 
+static void _http_client_decoder_reset(HTTPContentDecoder *decoder)
+{
+    if (decoder->inflate) {
+        utils_inflate_deinit(decoder->inflate);
+    }
+    memset(decoder, 0, sizeof(HTTPContentDecoder));
+}
+
 static int _http_client_send_request(HTTPClient *client, const char *url, HttpMethod method,
                                      HTTPClientData *client_data)
 {
     int rc;
 
-    rc = _http_client_send_header(client, url, method, client_data);
+    if (client_data->decoder) {
+        _http_client_decoder_reset(client_data->decoder);
+    }
+
+    client->conn_state = HTTP_CONN_SENDING;
+    rc                 = _http_client_send_header(client, url, method, client_data);
     if (rc != 0) {
         Log_e("httpclient_send_header is error, rc = %d", rc);
         return rc;
@@ -647,11 +798,21 @@ static int _http_client_send_request(HTTPClient *client, const char *url, HttpMe
 
     if (method == HTTP_POST || method == HTTP_PUT) {
         rc = _http_client_send_userdata(client, client_data, 5000);
+        /* body is sent later by qcloud_http_send_data or qcloud_http_send_chunk */
+        if (client_data->post_buf == NULL || client_data->is_post_chunked) {
+            return rc;
+        }
+    }
+    if (rc == QCLOUD_RET_SUCCESS) {
+        client->conn_state = HTTP_CONN_SENT;
     }
 
     return rc;
 }
 
+static int _http_client_resend(HTTPClient *client, const char *url, int port, const char *ca_crt, HttpMethod method,
+                              HTTPClientData *client_data);
+
 static int _http_client_recv_response(HTTPClient *client, uint32_t timeout_ms, HTTPClientData *client_data)
 {
     IOT_FUNC_ENTRY;
@@ -675,6 +836,20 @@ static int _http_client_recv_response(HTTPClient *client, uint32_t timeout_ms, H
         client_data->is_more = IOT_TRUE;
         rc = _http_client_recv(client, buf, 1, HTTP_CLIENT_CHUNK_SIZE - 1, &reclen, left_ms(&timer), client_data);
 
+        if (rc != QCLOUD_RET_SUCCESS && reclen == 0 && client->retry_url != NULL) {
+            /* the reused connection was closed by the server before it answered */
+            Log_d("pooled connection closed before response, rc = %d, retry on a new connection", rc);
+            client_data->is_more = IOT_FALSE;
+            rc = _http_client_resend(client, client->retry_url, client->retry_port, client->retry_ca_crt,
+                                     (HttpMethod)client->retry_method, client_data);
+            if (rc == QCLOUD_RET_SUCCESS) {
+                IOT_FUNC_EXIT_RC(_http_client_recv_response(client, left_ms(&timer), client_data));
+            }
+        }
+        if (reclen > 0) {
+            client->retry_url = NULL;
+        }
+
         if (rc != QCLOUD_RET_SUCCESS) {
             IOT_FUNC_EXIT_RC(rc);
         }
@@ -690,6 +865,90 @@ static int _http_client_recv_response(HTTPClient *client, uint32_t timeout_ms, H
         }
     }
 
+    if (rc >= 0 && !client_data->is_more && client->conn_state == HTTP_CONN_RECEIVING) {
+        client->conn_state = HTTP_CONN_IDLE;
+    }
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/* receive encoded content into the staging buffer of the decoder and decode it into response_buf */
+static int _http_client_recv_decoded(HTTPClient *client, uint32_t timeout_ms, HTTPClientData *client_data)
+{
+    IOT_FUNC_ENTRY;
+
+    HTTPContentDecoder *decoder  = client_data->decoder;
+    char *              out      = client_data->response_buf;
+    int                 out_len  = client_data->response_buf_len;
+    int                 rc       = QCLOUD_RET_SUCCESS;
+    int                 received = 0;
+    size_t              used, produced;
+    Timer               timer;
+
+    InitTimer(&timer);
+    countdown_ms(&timer, timeout_ms);
+
+
+    client_data->decoded_len = 0;
+    while (1) {
+        if (decoder->inflate) {
+            rc = utils_inflate(decoder->inflate, (uint8_t *)decoder->buf, decoder->len, &used,
+                               (uint8_t *)out + client_data->decoded_len, out_len - client_data->decoded_len,
+                               &produced);
+            if (rc < 0) {
+                Log_e("decode content failed: %d", rc);
+                break;
+            }
+            decoder->stream_end = (rc == INFLATE_STREAM_END);
+            rc                  = QCLOUD_RET_SUCCESS;
+        } else {
+            used = produced = HTTP_CLIENT_MIN(decoder->len, out_len - client_data->decoded_len);
+            memcpy(out + client_data->decoded_len, decoder->buf, produced);
+        }
+        memmove(decoder->buf, decoder->buf + used, decoder->len - used);
+        decoder->len -= used;
+        client_data->decoded_len += produced;
+
+        if (client_data->decoded_len == out_len || decoder->stream_end) {
+            break;
+        }
+        if (decoder->body_done) {
+            if (decoder->inflate) {
+                Log_e("encoded content truncated");
+                rc = QCLOUD_ERR_HTTP_PRTCL;
+            }
+            break;
+        }
+        if (client_data->decoded_len && expired(&timer)) {
+            break;
+        }
+        if (HTTP_CLIENT_DECODE_BUF_SIZE - decoder->len < HTTP_CLIENT_CHUNK_SIZE) {
+            Log_e("encoded content step larger than %d", HTTP_CLIENT_DECODE_BUF_SIZE - HTTP_CLIENT_CHUNK_SIZE);
+            rc = QCLOUD_ERR_HTTP_PRTCL;
+            break;
+        }
+
+        if (!client_data->is_more) {
+            /* content length counters are set by the response header */
+            client_data->response_content_len = 0;
+            client_data->retrieve_len         = 0;
+        }
+        received = client_data->response_content_len - client_data->retrieve_len;
+
+        client_data->response_buf     = decoder->buf + decoder->len;
+        client_data->response_buf_len = HTTP_CLIENT_DECODE_BUF_SIZE - decoder->len + 1;
+        rc                            = _http_client_recv_response(client, left_ms(&timer), client_data);
+        client_data->response_buf     = out;
+        client_data->response_buf_len = out_len;
+        if (rc < 0) {
+            break;
+        }
+
+        decoder->len += client_data->response_content_len - client_data->retrieve_len - received;
+        decoder->body_done = !client_data->is_more;
+        rc                 = QCLOUD_RET_SUCCESS;
+    }
+
     IOT_FUNC_EXIT_RC(rc);
 }
 
@@ -705,6 +964,7 @@ static int _http_network_init(Network *pNetwork, const char *host, int port, con
         pNetwork->ssl_connect_params.ca_crt     = ca_crt_dir;
         pNetwork->ssl_connect_params.ca_crt_len = strlen(pNetwork->ssl_connect_params.ca_crt);
         pNetwork->ssl_connect_params.timeout_ms = 10000;
+        pNetwork->ssl_connect_params.cache      = NULL;
         pNetwork->type                          = NETWORK_TLS;
     }
 #endif
@@ -716,7 +976,175 @@ static int _http_network_init(Network *pNetwork, const char *host, int port, con
     return rc;
 }
 
-int qcloud_http_client_connect(HTTPClient *client, const char *url, int port, const char *ca_crt)
+/* close a connection of the pool entry if still open and release its use of the TLS cache,
+ * called with the pool locked */
+static void _http_pool_disconnect(HTTPPoolEntry *entry, Network *network)
+{
+#ifndef AUTH_WITH_NOTLS
+    if (entry->tls_cache && network->ssl_connect_params.cache == entry->tls_cache) {
+        entry->cache_in_use = false;
+    }
+    network->ssl_connect_params.cache = NULL;
+#endif
+    if (network->handle != 0) {
+        network->disconnect(network);
+        network->handle = 0;
+    }
+}
+
+/* free an entry no client uses, called with the pool locked */
+static void _http_pool_release(HTTPPoolEntry *entry)
+{
+    _http_pool_disconnect(entry, &entry->network);
+#ifndef AUTH_WITH_NOTLS
+    HAL_TLS_CacheDestroy(entry->tls_cache);
+#endif
+    memset(entry, 0, sizeof(HTTPPoolEntry));
+}
+
+/* find the entry of the server, or take a free or the least recently used one no client uses,
+ * closing expired idle connections on the way. Called with the pool locked, NULL if all are in use */
+static HTTPPoolEntry *_http_pool_find(const char *host, int port, bool tls)
+{
+    HTTPPoolEntry *entry = NULL, *victim = NULL;
+    int            i;
+
+    for (i = 0; i < HTTP_CONN_POOL_SIZE; i++) {
+        HTTPPoolEntry *e = &sg_http_pool[i];
+
+        if (e->network.handle != 0 && expired(&e->idle_timer)) {
+            _http_pool_disconnect(e, &e->network);
+        }
+        if (e->host[0] != '\0' && e->port == port && e->tls == tls && !strcmp(e->host, host)) {
+            entry = e;
+        } else if (e->users == 0 && (victim == NULL || (victim->host[0] != '\0' &&
+                                                        (e->host[0] == '\0' || e->last_use < victim->last_use)))) {
+            victim = e;
+        }
+    }
+
+    if (entry == NULL && victim != NULL) {
+        _http_pool_release(victim);
+        strncpy(victim->host, host, sizeof(victim->host) - 1);
+        victim->port = port;
+        victim->tls  = tls;
+        entry        = victim;
+    }
+    if (entry != NULL) {
+        entry->last_use = ++sg_http_pool_stamp;
+    }
+
+    return entry;
+}
+
+/* read and drop the response left unread on a pooled connection */
+static void _http_client_drain(HTTPClient *client)
+{
+    HTTPClientData client_data;
+    char           buf[HTTP_CLIENT_CHUNK_SIZE];  // no smaller than a header read, content after it would be lost
+    Timer          timer;
+    int            rc;
+
+    memset(&client_data, 0, sizeof(HTTPClientData));
+    client_data.response_buf     = buf;
+    client_data.response_buf_len = sizeof(buf);
+
+    InitTimer(&timer);
+    countdown_ms(&timer, HTTP_CLIENT_DRAIN_TIMEOUT_MS);
+    do {
+        rc = _http_client_recv_response(client, left_ms(&timer), &client_data);
+    } while (rc >= 0 && client->network_stack.handle != 0 && client->conn_state != HTTP_CONN_IDLE &&
+             client->conn_state != HTTP_CONN_CLOSE && !expired(&timer));
+}
+
+/* an idle connection has nothing to read, unless the server sent an alert or closed it */
+static bool _http_client_is_alive(Network *network)
+{
+    if (network_readable(network) > 0) {
+        return false;
+    }
+#if defined(__linux__)
+    if (network->type == NETWORK_TCP) {
+        unsigned char byte;
+        size_t        read_len = 0;
+
+        return network->read(network, &byte, 1, 0, &read_len) == QCLOUD_ERR_TCP_NOTHING_TO_READ;
+    }
+#endif
+
+    return true;
+}
+
+/* create the pool lock on first use, only one of the threads racing here gets it installed */
+static void *_http_pool_lock_get(void)
+{
+#if defined(MULTITHREAD_ENABLED) && (defined(__GNUC__) || defined(__clang__))
+    void *lock = __atomic_load_n(&sg_http_pool_lock, __ATOMIC_ACQUIRE);
+    void *none = NULL;
+
+    if (lock == NULL && (lock = HAL_MutexCreate()) != NULL &&
+        !__atomic_compare_exchange_n(&sg_http_pool_lock, &none, lock, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        HAL_MutexDestroy(lock);
+        lock = none;
+    }
+
+    return lock;
+#else
+    if (sg_http_pool_lock == NULL) {
+        sg_http_pool_lock = HAL_MutexCreate();
+    }
+
+    return sg_http_pool_lock;
+#endif
+}
+
+/* join the pool entry of the server and, if reuse, take its idle connection if it is still usable */
+static int _http_pool_take(HTTPClient *client, const char *host, int port, bool tls, bool reuse)
+{
+    HTTPPoolEntry *entry;
+    Network        network;
+    bool           drain = false;
+
+    if (_http_pool_lock_get() == NULL) {
+        return QCLOUD_ERR_HTTP_CONN;
+    }
+
+    network.handle = 0;
+    HAL_MutexLock(sg_http_pool_lock);
+    entry = _http_pool_find(host, port, tls);
+    if (entry != NULL) {
+        entry->users++;
+        if (reuse && entry->network.handle != 0) {
+            network = entry->network;
+            drain   = entry->drain;
+            memset(&entry->network, 0, sizeof(Network));
+        }
+    }
+    HAL_MutexUnlock(sg_http_pool_lock);
+
+    client->pool_entry = entry;
+    if (network.handle == 0) {
+        return QCLOUD_ERR_HTTP_CONN;
+    }
+
+    client->network_stack = network;
+    client->conn_state    = drain ? HTTP_CONN_SENT : HTTP_CONN_IDLE;
+    if (drain) {
+        _http_client_drain(client);
+    }
+    if (client->network_stack.handle == 0 || client->conn_state != HTTP_CONN_IDLE ||
+        !_http_client_is_alive(&client->network_stack)) {
+        HAL_MutexLock(sg_http_pool_lock);
+        _http_pool_disconnect(entry, &client->network_stack);
+        HAL_MutexUnlock(sg_http_pool_lock);
+        return QCLOUD_ERR_HTTP_CONN;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/* connect to the server of url, taking an idle pooled connection only if reuse */
+static int _http_client_open(HTTPClient *client, const char *url, int port, const char *ca_crt, bool reuse)
 {
     if (client->network_stack.handle != 0) {
         Log_e("http client has connected to host!");
@@ -729,9 +1157,37 @@ int qcloud_http_client_connect(HTTPClient *client, const char *url, int port, co
     if (rc != QCLOUD_RET_SUCCESS)
         return rc;
 
+    client->conn_state  = HTTP_CONN_IDLE;
+    client->conn_reused = false;
+    client->retry_url   = NULL;
+    if (client->keep_alive && client->pool_entry == NULL &&
+        _http_pool_take(client, host, port, ca_crt != NULL, reuse) == QCLOUD_RET_SUCCESS) {
+        client->conn_reused = true;
+        return QCLOUD_RET_SUCCESS;
+    }
+
     rc = _http_network_init(&client->network_stack, host, port, ca_crt);
-    if (rc != QCLOUD_RET_SUCCESS)
+    if (rc != QCLOUD_RET_SUCCESS) {
+        qcloud_http_client_close(client);
         return rc;
+    }
+
+#ifndef AUTH_WITH_NOTLS
+    /* TLS contexts and session are shared by one connection at a time, the others set up their own */
+    if (client->pool_entry != NULL && ca_crt != NULL) {
+        HTTPPoolEntry *entry = client->pool_entry;
+
+        HAL_MutexLock(sg_http_pool_lock);
+        if (entry->tls_cache == NULL) {
+            entry->tls_cache = HAL_TLS_CacheCreate(&client->network_stack.ssl_connect_params);
+        }
+        if (entry->tls_cache != NULL && !entry->cache_in_use) {
+            client->network_stack.ssl_connect_params.cache = entry->tls_cache;
+            entry->cache_in_use                            = true;
+        }
+        HAL_MutexUnlock(sg_http_pool_lock);
+    }
+#endif
 
     rc = _http_client_connect(client);
     if (rc != QCLOUD_RET_SUCCESS) {
@@ -747,11 +1203,77 @@ int qcloud_http_client_connect(HTTPClient *client, const char *url, int port, co
     return rc;
 }
 
+int qcloud_http_client_connect(HTTPClient *client, const char *url, int port, const char *ca_crt)
+{
+    return _http_client_open(client, url, port, ca_crt, true);
+}
+
+/* drop the reused connection the request failed on and send the request on a new one */
+static int _http_client_resend(HTTPClient *client, const char *url, int port, const char *ca_crt, HttpMethod method,
+                              HTTPClientData *client_data)
+{
+    int rc;
+
+    client->conn_state = HTTP_CONN_CLOSE;  // not to be pooled again
+    qcloud_http_client_close(client);
+
+    rc = _http_client_open(client, url, port, ca_crt, false);
+    if (rc != QCLOUD_RET_SUCCESS) {
+        return rc;
+    }
+
+    return _http_client_send_request(client, url, method, client_data);
+}
+
 void qcloud_http_client_close(HTTPClient *client)
 {
+    HTTPPoolEntry *entry = client->pool_entry;
+
+    if (entry != NULL) {
+        HAL_MutexLock(sg_http_pool_lock);
+        if (client->network_stack.handle != 0 &&
+            (client->conn_state == HTTP_CONN_IDLE || client->conn_state == HTTP_CONN_SENT)) {
+            /* keep the newest connection, the server is more likely to close an older one */
+            if (entry->network.handle != 0) {
+                _http_pool_disconnect(entry, &entry->network);
+            }
+            entry->network = client->network_stack;
+            entry->drain   = (client->conn_state == HTTP_CONN_SENT);
+            InitTimer(&entry->idle_timer);
+            countdown_ms(&entry->idle_timer, HTTP_CONN_POOL_IDLE_MS);
+            client->network_stack.handle = 0;
+        } else {
+            _http_pool_disconnect(entry, &client->network_stack);
+        }
+        entry->users--;
+        client->pool_entry = NULL;
+        HAL_MutexUnlock(sg_http_pool_lock);
+    }
+
     if (client->network_stack.handle != 0) {
         client->network_stack.disconnect(&client->network_stack);
     }
+    client->conn_state = HTTP_CONN_IDLE;
+    client->retry_url  = NULL;
+}
+
+void qcloud_http_client_pool_clear(void)
+{
+    int i;
+
+    if (_http_pool_lock_get() == NULL) {
+        return;
+    }
+
+    HAL_MutexLock(sg_http_pool_lock);
+    for (i = 0; i < HTTP_CONN_POOL_SIZE; i++) {
+        if (sg_http_pool[i].users == 0) {
+            _http_pool_release(&sg_http_pool[i]);
+        } else {
+            _http_pool_disconnect(&sg_http_pool[i], &sg_http_pool[i].network);
+        }
+    }
+    HAL_MutexUnlock(sg_http_pool_lock);
 }
 
 int qcloud_http_client_common(HTTPClient *client, const char *url, int port, const char *ca_crt, HttpMethod method,
@@ -766,12 +1288,25 @@ int qcloud_http_client_common(HTTPClient *client, const char *url, int port, con
     }
 
     rc = _http_client_send_request(client, url, method, client_data);
+    if (rc != QCLOUD_RET_SUCCESS && client->conn_reused) {
+        /* the server may have closed the pooled connection while it was idle */
+        Log_d("send on pooled connection failed, rc = %d, retry on a new connection", rc);
+        rc = _http_client_resend(client, url, port, ca_crt, method, client_data);
+    }
     if (rc != QCLOUD_RET_SUCCESS) {
         Log_e("http_client_send_request is error,rc = %d", rc);
         qcloud_http_client_close(client);
         return rc;
     }
 
+    /* a whole request on a reused connection can still meet EOF instead of the response */
+    if (client->conn_reused && client->conn_state == HTTP_CONN_SENT) {
+        client->retry_url    = url;
+        client->retry_ca_crt = ca_crt;
+        client->retry_port   = port;
+        client->retry_method = method;
+    }
+
     return QCLOUD_RET_SUCCESS;
 }
 
@@ -786,7 +1321,19 @@ int qcloud_http_recv_data(HTTPClient *client, uint32_t timeout_ms, HTTPClientDat
     countdown_ms(&timer, (unsigned int)timeout_ms);
 
     if ((NULL != client_data->response_buf) && (0 != client_data->response_buf_len)) {
-        rc = _http_client_recv_response(client, left_ms(&timer), client_data);
+        if (client_data->decode_content) {
+            if (NULL == client_data->decoder) {
+                client_data->decoder = HAL_Malloc(sizeof(HTTPContentDecoder));
+                if (NULL == client_data->decoder) {
+                    Log_e("malloc content decoder failed");
+                    IOT_FUNC_EXIT_RC(QCLOUD_ERR_MALLOC);
+                }
+                memset(client_data->decoder, 0, sizeof(HTTPContentDecoder));
+            }
+            rc = _http_client_recv_decoded(client, left_ms(&timer), client_data);
+        } else {
+            rc = _http_client_recv_response(client, left_ms(&timer), client_data);
+        }
         if (rc < 0) {
             Log_e("http_client_recv_response is error,rc = %d", rc);
             qcloud_http_client_close(client);
@@ -796,6 +1343,17 @@ int qcloud_http_recv_data(HTTPClient *client, uint32_t timeout_ms, HTTPClientDat
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+void qcloud_http_decode_deinit(HTTPClientData *client_data)
+{
+    HTTPContentDecoder *decoder = client_data->decoder;
+
+    if (decoder) {
+        _http_client_decoder_reset(decoder);
+        HAL_Free(decoder);
+        client_data->decoder = NULL;
+    }
+}
+
 int qcloud_http_send_data(HTTPClient *client, HttpMethod method, uint32_t timeout_ms, HTTPClientData *client_data)
 {
     int rc = QCLOUD_ERR_INVAL;
@@ -806,6 +1364,44 @@ int qcloud_http_send_data(HTTPClient *client, HttpMethod method, uint32_t timeou
     return rc;
 }
 
+int qcloud_http_send_chunk(HTTPClient *client, const char *data, int len, uint32_t timeout_ms)
+{
+    char buf[HTTP_CLIENT_SEND_BUF_SIZE];
+    int  head_len, rc;
+
+    if (len < 0 || (len > 0 && data == NULL)) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    /* last chunk carries no data and terminates the body with an empty line */
+    if (len == 0) {
+        rc = _http_client_write(client, "0\r\n\r\n", 5, timeout_ms);
+        if (rc == QCLOUD_RET_SUCCESS) {
+            client->conn_state = HTTP_CONN_SENT;
+        }
+        return rc;
+    }
+
+    head_len = HAL_Snprintf(buf, sizeof(buf), "%x\r\n", (unsigned int)len);
+
+    /* frame small chunks in one write to save a TLS record per chunk */
+    if ((size_t)(head_len + len + 2) <= sizeof(buf)) {
+        memcpy(buf + head_len, data, len);
+        memcpy(buf + head_len + len, "\r\n", 2);
+        return _http_client_write(client, buf, head_len + len + 2, timeout_ms);
+    }
+
+    rc = _http_client_write(client, buf, head_len, timeout_ms);
+    if (rc == QCLOUD_RET_SUCCESS) {
+        rc = _http_client_write(client, data, len, timeout_ms);
+    }
+    if (rc == QCLOUD_RET_SUCCESS) {
+        rc = _http_client_write(client, "\r\n", 2, timeout_ms);
+    }
+
+    return rc;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,8 @@ extern "C" {
 
 typedef struct {
     const char *   url;
+    uint32_t       offset;
+    uint32_t       size;
     HTTPClient     http;      /* http client */
     HTTPClientData http_data; /* http client data */
 } HTTPUrlDownloadHandle;
@@ -62,18 +64,26 @@ void *qcloud_url_download_init(const char *url, uint32_t offset, uint32_t size)
     }
     memset(handle->http.header, 0, HTTP_HEAD_CONTENT_LEN);
 
-    HAL_Snprintf(handle->http.header, HTTP_HEAD_CONTENT_LEN,
-                 "Accept: "
-                 "text/html,application/xhtml+xml,application/xml;q=0.9,*/"
-                 "*;q=0.8\r\n"
-                 "Accept-Encoding: gzip, deflate\r\n"
-                 "Range: bytes=%d-%d\r\n",
-                 offset, size);
+    handle->url    = url;
+    handle->offset = offset;
+    handle->size   = size;
+    return handle;
+}
 
-    Log_d("head_content:%s", handle->http.header);
+int qcloud_url_download_set_decode(void *handle, bool decode)
+{
+    POINTER_SANITY_CHECK(handle, QCLOUD_ERR_INVAL);
 
-    handle->url = url;
-    return handle;
+    HTTPUrlDownloadHandle *pHandle = (HTTPUrlDownloadHandle *)handle;
+
+    /* a byte range of encoded content can not be decoded on its own */
+    if (decode && pHandle->offset) {
+        Log_w("download from offset %u is not decoded", pHandle->offset);
+        return QCLOUD_ERR_INVAL;
+    }
+    pHandle->http_data.decode_content = decode;
+
+    return QCLOUD_RET_SUCCESS;
 }
 
 int32_t qcloud_url_download_connect(void *handle, int https_enabled)
@@ -89,6 +99,23 @@ int32_t qcloud_url_download_connect(void *handle, int https_enabled)
     int         port   = 80;
     const char *ca_crt = NULL;
 
+    /* the whole content is requested when it is decoded, as ranges refer to the encoded bytes */
+    if (pHandle->http_data.decode_content) {
+        HAL_Snprintf(pHandle->http.header, HTTP_HEAD_CONTENT_LEN,
+                     "Accept: "
+                     "text/html,application/xhtml+xml,application/xml;q=0.9,*/"
+                     "*;q=0.8\r\n");
+    } else {
+        HAL_Snprintf(pHandle->http.header, HTTP_HEAD_CONTENT_LEN,
+                     "Accept: "
+                     "text/html,application/xhtml+xml,application/xml;q=0.9,*/"
+                     "*;q=0.8\r\n"
+                     "Accept-Encoding: identity\r\n"
+                     "Range: bytes=%u-%u\r\n",
+                     pHandle->offset, pHandle->size);
+    }
+    Log_d("head_content:%s", pHandle->http.header);
+
     if (strstr(pHandle->url, "https") && https_enabled) {
         port   = 443;
         ca_crt = iot_https_ca_get();
@@ -117,6 +144,10 @@ int32_t qcloud_url_download_fetch(void *handle, char *buf, uint32_t bufLen, uint
         IOT_FUNC_EXIT_RC(rc);
     }
 
+    if (pHandle->http_data.decode_content) {
+        IOT_FUNC_EXIT_RC(pHandle->http_data.decoded_len);
+    }
+
     IOT_FUNC_EXIT_RC(pHandle->http_data.response_content_len - pHandle->http_data.retrieve_len - diff);
 }
 
@@ -132,12 +163,20 @@ int qcloud_url_download_deinit(void *handle)
     if (pHandle->http.network_stack.is_connected(&pHandle->http.network_stack)) {
         pHandle->http.network_stack.disconnect(&pHandle->http.network_stack);
     }
+    qcloud_http_decode_deinit(&pHandle->http_data);
     HAL_Free(pHandle->http.header);
     HAL_Free(pHandle);
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+int qcloud_url_download_response_code(void *handle)
+{
+    POINTER_SANITY_CHECK(handle, 0);
+
+    return ((HTTPUrlDownloadHandle *)handle)->http.response_code;
+}
+
 #ifdef __cplusplus
 }
 #endif
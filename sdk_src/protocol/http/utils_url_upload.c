@@ -72,7 +72,8 @@ void *qcloud_url_upload_init(const char *url, uint32_t content_len, char *custom
 
     // Log_d("head_content:%s", handle->http.header);
 
-    handle->url = url;
+    handle->url             = url;
+    handle->http.keep_alive = true;
     return handle;
 }
 
@@ -119,6 +120,73 @@ int32_t qcloud_url_upload_body(void *handle, char *data_buf, uint32_t data_Len,
     IOT_FUNC_EXIT_RC(rc);
 }
 
+int32_t qcloud_url_upload_file(void *handle, void *fp, uint32_t len, iot_md5_context *md5, uint32_t timeout_ms)
+{
+    IOT_FUNC_ENTRY;
+
+    if (!handle || !fp) {
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+    }
+
+    HTTPUrlUploadHandle *pHandle = (HTTPUrlUploadHandle *)handle;
+    char *               buf     = NULL;
+    long                 offset  = HAL_FileTell(fp);
+    long                 pos     = offset;  // position of fp
+    int                  rc      = QCLOUD_RET_SUCCESS;
+
+    if (offset < 0) {
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+    }
+
+    while (len > 0 && rc == QCLOUD_RET_SUCCESS) {
+        uint32_t    part = len < HTTP_UPLOAD_FILE_MAP_SIZE ? len : HTTP_UPLOAD_FILE_MAP_SIZE;
+        const char *data = HAL_FileMap(fp, offset, part);
+        uint32_t    sent, slice;
+
+        if (data == NULL) {
+            /* read one slice into buffer instead */
+            part = len < HTTP_UPLOAD_FILE_SLICE_SIZE ? len : HTTP_UPLOAD_FILE_SLICE_SIZE;
+            if (buf == NULL && (buf = HAL_Malloc(HTTP_UPLOAD_FILE_SLICE_SIZE)) == NULL) {
+                Log_e("allocate for upload buffer failed!");
+                rc = QCLOUD_ERR_MALLOC;
+                break;
+            }
+            if ((pos != offset && HAL_FileSeek(fp, offset, SEEK_SET) != 0) || HAL_FileRead(buf, 1, part, fp) != part) {
+                Log_e("read file failed at %ld", offset);
+                rc = QCLOUD_ERR_FAILURE;
+                break;
+            }
+            pos = offset + part;
+        }
+
+        for (sent = 0; sent < part && rc == QCLOUD_RET_SUCCESS; sent += slice) {
+            const char *p = data ? data + sent : buf;
+
+            slice = part - sent < HTTP_UPLOAD_FILE_SLICE_SIZE ? part - sent : HTTP_UPLOAD_FILE_SLICE_SIZE;
+            /* hash the slice just before it is copied out, while it is in cache */
+            if (md5) {
+                utils_md5_update(md5, (const unsigned char *)p, slice);
+            }
+            pHandle->http_data.post_buf     = (char *)p;
+            pHandle->http_data.post_buf_len = slice;
+            rc = qcloud_http_send_data(&pHandle->http, HTTP_PUT, timeout_ms, &pHandle->http_data);
+        }
+
+        if (data) {
+            HAL_FileUnmap(data, part);
+        }
+        offset += part;
+        len -= part;
+    }
+    HAL_Free(buf);
+
+    if (rc == QCLOUD_RET_SUCCESS && pos != offset && HAL_FileSeek(fp, offset, SEEK_SET) != 0) {
+        rc = QCLOUD_ERR_FAILURE;
+    }
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
 int32_t qcloud_url_upload_recv_response(void *handle, char *response_buf, uint32_t bufLen, uint32_t timeout_ms)
 {
     IOT_FUNC_ENTRY;
@@ -144,9 +212,7 @@ int qcloud_url_upload_deinit(void *handle)
     }
 
     HTTPUrlUploadHandle *pHandle = (HTTPUrlUploadHandle *)handle;
-    if (pHandle->http.network_stack.is_connected(&pHandle->http.network_stack)) {
-        pHandle->http.network_stack.disconnect(&pHandle->http.network_stack);
-    }
+    qcloud_http_client_close(&pHandle->http);
     HAL_Free(pHandle->http.header);
     HAL_Free(pHandle);
 
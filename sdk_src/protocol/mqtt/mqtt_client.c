@@ -47,6 +47,30 @@ static uint16_t _get_random_start_packet_id(void)
     return rand() % 65536 + 1;
 }
 
+/* 0 for default size, and not less than MIN_MQTT_BUF_LEN */
+static size_t _get_buf_size(uint32_t size, size_t default_size)
+{
+    if (0 == size) {
+        return default_size;
+    }
+
+    if (size < MIN_MQTT_BUF_LEN) {
+        Log_w("MQTT buffer size %u too small, use %u", (unsigned)size, MIN_MQTT_BUF_LEN);
+        return MIN_MQTT_BUF_LEN;
+    }
+
+    return size;
+}
+
+static int _notify_client_destroy(SubTopicHandle *handle, void *ctx)
+{
+    if (NULL != handle->sub_event_handler) {
+        handle->sub_event_handler(ctx, MQTT_EVENT_CLIENT_DESTROY, handle->handler_user_data);
+    }
+
+    return 0;
+}
+
 DeviceInfo *IOT_MQTT_GetDeviceInfo(void *pClient)
 {
     POINTER_SANITY_CHECK(pClient, NULL);
@@ -86,6 +110,7 @@ void *IOT_MQTT_Construct(MQTTInitParams *pParams)
     client_id                        = HAL_Malloc(MAX_SIZE_OF_CLIENT_ID + 1);
     if (client_id == NULL) {
         Log_e("malloc client_id failed");
+        qcloud_iot_mqtt_fini(mqtt_client);
         HAL_Free(mqtt_client);
         return NULL;
     }
@@ -154,6 +179,10 @@ int IOT_MQTT_Destroy(void **pClient)
 
     Qcloud_IoT_Client *mqtt_client = (Qcloud_IoT_Client *)(*pClient);
 
+#if defined(__linux__)
+    qcloud_iot_mqtt_reactor_detach(mqtt_client);
+#endif
+
     int rc = qcloud_iot_mqtt_disconnect(mqtt_client);
     // disconnect network stack by force
     if (rc != QCLOUD_RET_SUCCESS) {
@@ -161,18 +190,9 @@ int IOT_MQTT_Destroy(void **pClient)
         set_client_conn_state(mqtt_client, NOTCONNECTED);
     }
 
-    int i = 0;
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        /* notify this event to topic subscriber */
-        if (NULL != mqtt_client->sub_handles[i].topic_filter && NULL != mqtt_client->sub_handles[i].sub_event_handler)
-            mqtt_client->sub_handles[i].sub_event_handler(mqtt_client, MQTT_EVENT_CLIENT_DESTROY,
-                                                          mqtt_client->sub_handles[i].handler_user_data);
-
-        if (NULL != mqtt_client->sub_handles[i].topic_filter) {
-            HAL_Free((void *)mqtt_client->sub_handles[i].topic_filter);
-            mqtt_client->sub_handles[i].topic_filter = NULL;
-        }
-    }
+    /* notify this event to topic subscriber */
+    qcloud_iot_mqtt_sub_trie_foreach(&mqtt_client->sub_trie, _notify_client_destroy, mqtt_client);
+    qcloud_iot_mqtt_sub_trie_clear(&mqtt_client->sub_trie);
 
 #ifdef MQTT_RMDUP_MSG_ENABLED
     reset_repeat_packet_id_buffer(mqtt_client);
@@ -184,9 +204,14 @@ int IOT_MQTT_Destroy(void **pClient)
     HAL_MutexDestroy(mqtt_client->lock_list_sub);
     HAL_MutexDestroy(mqtt_client->lock_list_pub);
 
-    list_destroy(mqtt_client->list_pub_wait_ack);
+    qcloud_iot_mqtt_pub_window_deinit(&mqtt_client->pub_wait_ack);
     list_destroy(mqtt_client->list_sub_wait_ack);
+    HAL_Free(mqtt_client->write_buf);
+    HAL_Free(mqtt_client->read_buf);
     HAL_Free(mqtt_client->options.client_id);
+#ifndef AUTH_WITH_NOTLS
+    HAL_TLS_CacheDestroy(mqtt_client->network_stack.ssl_connect_params.cache);
+#endif
 
     HAL_Free(*pClient);
     *pClient = NULL;
@@ -210,6 +235,12 @@ int IOT_MQTT_Yield(void *pClient, uint32_t timeout_ms)
     }
 #endif
 
+    /* driven by reactor already */
+    if (NULL != mqtt_client->reactor_slot) {
+        HAL_SleepMs(timeout_ms);
+        return QCLOUD_RET_SUCCESS;
+    }
+
     int rc = qcloud_iot_mqtt_yield(mqtt_client, timeout_ms);
 
 #ifdef LOG_UPLOAD
@@ -230,6 +261,14 @@ int IOT_MQTT_Publish(void *pClient, char *topicName, PublishParams *pParams)
     return qcloud_iot_mqtt_publish(mqtt_client, topicName, pParams);
 }
 
+int IOT_MQTT_PublishAsync(void *pClient, char *topicName, PublishParams *pParams, OnPublishAckHandler ack_handler,
+                          void *user_data)
+{
+    Qcloud_IoT_Client *mqtt_client = (Qcloud_IoT_Client *)pClient;
+
+    return qcloud_iot_mqtt_publish_async(mqtt_client, topicName, pParams, ack_handler, user_data);
+}
+
 int IOT_MQTT_Subscribe(void *pClient, char *topicFilter, SubscribeParams *pParams)
 {
     Qcloud_IoT_Client *mqtt_client = (Qcloud_IoT_Client *)pClient;
@@ -309,6 +348,12 @@ int IOT_MQTT_StartLoop(void *pClient)
 
     Qcloud_IoT_Client * mqtt_client   = (Qcloud_IoT_Client *)pClient;
     static ThreadParams thread_params = {0};
+
+    if (NULL != mqtt_client->reactor_slot) {
+        Log_e("client is driven by reactor, no yield thread needed");
+        return QCLOUD_ERR_FAILURE;
+    }
+
     thread_params.thread_func         = _mqtt_yield_thread;
     thread_params.thread_name         = "mqtt_yield_thread";
     thread_params.user_arg            = pClient;
@@ -366,14 +411,7 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
     }
 
-    int i = 0;
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        pClient->sub_handles[i].topic_filter      = NULL;
-        pClient->sub_handles[i].message_handler   = NULL;
-        pClient->sub_handles[i].sub_event_handler = NULL;
-        pClient->sub_handles[i].qos               = QOS0;
-        pClient->sub_handles[i].handler_user_data = NULL;
-    }
+    memset(&pClient->sub_trie, 0, sizeof(SubTopicNode));
 
     if (pParams->command_timeout < MIN_COMMAND_TIMEOUT)
         pParams->command_timeout = MIN_COMMAND_TIMEOUT;
@@ -383,8 +421,8 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
 
     // packet id, random from [1 - 65536]
     pClient->next_packet_id               = _get_random_start_packet_id();
-    pClient->write_buf_size               = QCLOUD_IOT_MQTT_TX_BUF_LEN;
-    pClient->read_buf_size                = QCLOUD_IOT_MQTT_RX_BUF_LEN;
+    pClient->write_buf_size               = _get_buf_size(pParams->tx_buf_size, QCLOUD_IOT_MQTT_TX_BUF_LEN);
+    pClient->read_buf_size                = _get_buf_size(pParams->rx_buf_size, QCLOUD_IOT_MQTT_RX_BUF_LEN);
     pClient->is_ping_outstanding          = 0;
     pClient->was_manually_disconnected    = 0;
     pClient->counter_network_disconnected = 0;
@@ -392,6 +430,7 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
     pClient->yield_thread_running = false;
 #endif
     pClient->event_handle = pParams->event_handle;
+    memset(&pClient->pub_wait_ack, 0, sizeof(QcloudIotPubWindow));
 
     pClient->lock_generic = HAL_MutexCreate();
     if (NULL == pClient->lock_generic) {
@@ -404,6 +443,14 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
         Log_e("create write buf lock failed.");
         goto error;
     }
+    if ((pClient->write_buf = (unsigned char *)HAL_Malloc(pClient->write_buf_size)) == NULL) {
+        Log_e("malloc write buf failed, size: %u", (unsigned)pClient->write_buf_size);
+        goto error;
+    }
+    if ((pClient->read_buf = (unsigned char *)HAL_Malloc(pClient->read_buf_size)) == NULL) {
+        Log_e("malloc read buf failed, size: %u", (unsigned)pClient->read_buf_size);
+        goto error;
+    }
     if ((pClient->lock_list_sub = HAL_MutexCreate()) == NULL) {
         Log_e("create sub list lock failed.");
         goto error;
@@ -413,11 +460,10 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
         goto error;
     }
 
-    if ((pClient->list_pub_wait_ack = list_new()) == NULL) {
-        Log_e("create pub wait list failed.");
+    if (qcloud_iot_mqtt_pub_window_init(&pClient->pub_wait_ack, pParams->pub_window_size) != QCLOUD_RET_SUCCESS) {
+        Log_e("create pub wait window failed.");
         goto error;
     }
-    pClient->list_pub_wait_ack->free = HAL_Free;
 
     if ((pClient->list_sub_wait_ack = list_new()) == NULL) {
         Log_e("create sub wait list failed.");
@@ -464,6 +510,9 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
     pClient->network_stack.ssl_connect_params.timeout_ms =
         (pClient->command_timeout_ms > QCLOUD_IOT_TLS_HANDSHAKE_TIMEOUT) ? pClient->command_timeout_ms
                                                                          : QCLOUD_IOT_TLS_HANDSHAKE_TIMEOUT;
+
+    // parse certificates once and resume TLS session on reconnect, every connect sets up all without it
+    pClient->network_stack.ssl_connect_params.cache = HAL_TLS_CacheCreate(&(pClient->network_stack.ssl_connect_params));
 #else
     pClient->network_stack.host = pClient->host_addr;
     pClient->network_stack.port = MQTT_SERVER_PORT_NOTLS;
@@ -479,10 +528,7 @@ int qcloud_iot_mqtt_init(Qcloud_IoT_Client *pClient, MQTTInitParams *pParams)
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 
 error:
-    if (pClient->list_pub_wait_ack) {
-        pClient->list_pub_wait_ack->free(pClient->list_pub_wait_ack);
-        pClient->list_pub_wait_ack = NULL;
-    }
+    qcloud_iot_mqtt_pub_window_deinit(&pClient->pub_wait_ack);
     if (pClient->list_sub_wait_ack) {
         pClient->list_sub_wait_ack->free(pClient->list_sub_wait_ack);
         pClient->list_sub_wait_ack = NULL;
@@ -503,6 +549,14 @@ error:
         HAL_MutexDestroy(pClient->lock_write_buf);
         pClient->lock_write_buf = NULL;
     }
+    if (pClient->write_buf) {
+        HAL_Free(pClient->write_buf);
+        pClient->write_buf = NULL;
+    }
+    if (pClient->read_buf) {
+        HAL_Free(pClient->read_buf);
+        pClient->read_buf = NULL;
+    }
 
     IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE)
 }
@@ -519,8 +573,13 @@ int qcloud_iot_mqtt_fini(Qcloud_IoT_Client *mqtt_client)
     HAL_MutexDestroy(mqtt_client->lock_list_sub);
     HAL_MutexDestroy(mqtt_client->lock_list_pub);
 
-    list_destroy(mqtt_client->list_pub_wait_ack);
+    qcloud_iot_mqtt_pub_window_deinit(&mqtt_client->pub_wait_ack);
     list_destroy(mqtt_client->list_sub_wait_ack);
+    HAL_Free(mqtt_client->write_buf);
+    HAL_Free(mqtt_client->read_buf);
+#ifndef AUTH_WITH_NOTLS
+    HAL_TLS_CacheDestroy(mqtt_client->network_stack.ssl_connect_params.cache);
+#endif
 
     Log_i("release mqtt client resources");
 
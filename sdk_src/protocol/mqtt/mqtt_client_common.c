@@ -56,6 +56,10 @@ static int _check_handle_is_identical(SubTopicHandle *sub_handle1, SubTopicHandl
         return 1;
     }
 
+    if (sub_handle1->message_chunk_handler != sub_handle2->message_chunk_handler) {
+        return 1;
+    }
+
     return 0;
 }
 
@@ -516,221 +520,358 @@ int send_mqtt_packet(Qcloud_IoT_Client *pClient, size_t length, Timer *timer)
     IOT_FUNC_EXIT_RC(rc);
 }
 
-static int _decode_packet_rem_len_with_net_read(Qcloud_IoT_Client *pClient, uint32_t *value, uint32_t timeout)
+int send_mqtt_packet_iov(Qcloud_IoT_Client *pClient, NetIovec *iov, int iovcnt, Timer *timer)
 {
     IOT_FUNC_ENTRY;
 
     POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
-    POINTER_SANITY_CHECK(value, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(iov, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(timer, QCLOUD_ERR_INVAL);
 
-    unsigned char i;
-    uint32_t      multiplier = 1;
-    uint32_t      len        = 0;
-    size_t        read_len   = 0;
+    int    i, rc = QCLOUD_ERR_FAILURE;
+    size_t sentLen = 0, left = 0;
 
-    *value = 0;
+    for (i = 0; i < iovcnt; i++) {
+        left += iov[i].len;
+    }
 
-    do {
-        if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
-            /* bad data */
-            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_PACKET_READ)
+    while (left > 0 && !expired(timer)) {
+        rc = network_writev(&(pClient->network_stack), iov, iovcnt, left_ms(timer), &sentLen);
+        if (rc != QCLOUD_RET_SUCCESS) {
+            /* there was an error writing the data */
+            break;
         }
-
-        if ((pClient->network_stack.read(&(pClient->network_stack), &i, 1, timeout, &read_len)) != QCLOUD_RET_SUCCESS) {
-            /* The value argument is the important value. len is just used temporarily
-             * and never used by the calling function for anything else */
-            IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+        left -= sentLen;
+
+        /* consume the written part so the next round starts where this one stopped */
+        while (sentLen > 0 && iovcnt > 0) {
+            if (sentLen >= iov->len) {
+                sentLen -= iov->len;
+                iov++;
+                iovcnt--;
+            } else {
+                iov->data += sentLen;
+                iov->len -= sentLen;
+                sentLen = 0;
+            }
         }
+    }
 
-        *value += ((i & 127) * multiplier);
-        multiplier *= 128;
-    } while ((i & 128) != 0);
+    if (0 == left) {
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
 
-    /* The value argument is the important value. len is just used temporarily
-     * and never used by the calling function for anything else */
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS == rc ? QCLOUD_ERR_MQTT_REQUEST_TIMEOUT : rc);
+}
+
+void reset_read_buffer(Qcloud_IoT_Client *pClient)
+{
+    pClient->read_buf_used       = 0;
+    pClient->read_frame_len      = 0;
+    pClient->frame_stream.remain = 0;
 }
 
 /**
- * @brief Read MQTT packet from network stack
+ * @brief Stage network data into read buffer until at least @need bytes are there
  *
- * 1. read 1st byte in fixed header and check if valid
- * 2. read the remaining length
- * 3. read payload according to remaining length
+ * The missing bytes are waited for with timeout, then whatever the network stack
+ * already holds is taken in without blocking (zero timeout read), so a burst of
+ * packets is staged by one or two network reads instead of several per packet.
  *
- * @param pClient        MQTT Client
- * @param timer          timeout timer
- * @param packet_type    MQTT packet type
+ * @param pClient       MQTT Client
+ * @param need          number of bytes required in read buffer
+ * @param timeout_ms    timeout for the missing bytes
  * @return QCLOUD_RET_SUCCESS for success, or err code for failure
  */
-static int _read_mqtt_packet(Qcloud_IoT_Client *pClient, Timer *timer, uint8_t *packet_type)
+static int _fill_read_buf(Qcloud_IoT_Client *pClient, size_t need, uint32_t timeout_ms)
 {
-    IOT_FUNC_ENTRY;
-
-    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
-    POINTER_SANITY_CHECK(timer, QCLOUD_ERR_INVAL);
+    size_t read_len = 0;
+    int    rc;
 
-    uint32_t len      = 0;
-    uint32_t rem_len  = 0;
-    size_t   read_len = 0;
-    int      rc;
-    int      timer_left_ms = left_ms(timer);
-
-    if (timer_left_ms <= 0) {
-        timer_left_ms = 1;
+    if (pClient->read_buf_used >= need) {
+        return QCLOUD_RET_SUCCESS;
     }
 
-    // 1. read 1st byte in fixed header and check if valid
-    rc = pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf, 1, timer_left_ms, &read_len);
-    if (rc == QCLOUD_ERR_SSL_NOTHING_TO_READ || rc == QCLOUD_ERR_TCP_NOTHING_TO_READ) {
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NOTHING_TO_READ);
-    }
+    rc = pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf + pClient->read_buf_used,
+                                     need - pClient->read_buf_used, timeout_ms, &read_len);
+    pClient->read_buf_used += read_len;
     if (rc != QCLOUD_RET_SUCCESS) {
-        IOT_FUNC_EXIT_RC(rc);
+        return rc;
     }
 
-    len = 1;
-
-    // 2. read the remaining length
-    timer_left_ms = left_ms(timer);
-    if (timer_left_ms <= 0) {
-        timer_left_ms = 1;
+    // opportunistic read, the result does not matter as the required bytes are there
+    if (pClient->read_buf_used < pClient->read_buf_size) {
+        read_len = 0;
+        pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf + pClient->read_buf_used,
+                                    pClient->read_buf_size - pClient->read_buf_used, 0, &read_len);
+        pClient->read_buf_used += read_len;
     }
-    timer_left_ms += QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
 
-    rc = _decode_packet_rem_len_with_net_read(pClient, &rem_len, timer_left_ms);
-    if (QCLOUD_RET_SUCCESS != rc) {
-        IOT_FUNC_EXIT_RC(rc);
-    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Decode the remaining length of the packet staged at @buf
+ *
+ * @param buf           packet start (fixed header)
+ * @param avail         bytes available from @buf
+ * @param rem_len       remaining length decoded
+ * @param header_len    length of fixed header, 0 if more bytes are needed to decode
+ * @return QCLOUD_RET_SUCCESS for success, or QCLOUD_ERR_MQTT_PACKET_READ for bad data
+ */
+static int _decode_staged_rem_len(unsigned char *buf, size_t avail, uint32_t *rem_len, size_t *header_len)
+{
+    uint32_t multiplier = 1;
+    size_t   i;
 
-    // if read buffer is not enough to read the remaining length, discard the
-    // packet
-    if (rem_len >= pClient->read_buf_size) {
-        size_t  total_bytes_read = 0;
-        size_t  bytes_to_be_read;
-        int32_t ret_val = 0;
+    *rem_len    = 0;
+    *header_len = 0;
 
-        timer_left_ms = left_ms(timer);
-        if (timer_left_ms <= 0) {
-            timer_left_ms = 1;
+    for (i = 1; i < avail; i++) {
+        if (i > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
+            /* bad data */
+            return QCLOUD_ERR_MQTT_PACKET_READ;
         }
-        timer_left_ms += QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
 
-        bytes_to_be_read = pClient->read_buf_size;
-        do {
-            ret_val = pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf, bytes_to_be_read,
-                                                  timer_left_ms, &read_len);
-            if (ret_val != QCLOUD_RET_SUCCESS) {
-                break;
-            }
-            total_bytes_read += read_len;
-            if ((rem_len - total_bytes_read) >= pClient->read_buf_size) {
-                bytes_to_be_read = pClient->read_buf_size;
-            } else {
-                bytes_to_be_read = rem_len - total_bytes_read;
-            }
-        } while (total_bytes_read < rem_len);
+        *rem_len += ((buf[i] & 127) * multiplier);
+        multiplier *= 128;
 
-        Log_e("MQTT Recv buffer not enough: %d < %d", pClient->read_buf_size, rem_len);
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_BUF_TOO_SHORT);
+        if ((buf[i] & 128) == 0) {
+            *header_len = i + 1;
+            break;
+        }
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Check if one more complete packet is staged behind the current one
+ *
+ * @param pClient        MQTT Client
+ * @return true if the next packet can be handled without network read
+ */
+static bool _is_next_packet_staged(Qcloud_IoT_Client *pClient)
+{
+    uint32_t rem_len    = 0;
+    size_t   header_len = 0;
+    size_t   avail      = pClient->read_buf_used - pClient->read_frame_len;
+
+    if (QCLOUD_RET_SUCCESS !=
+            _decode_staged_rem_len(pClient->read_buf + pClient->read_frame_len, avail, &rem_len, &header_len) ||
+        0 == header_len) {
+        return false;
     }
 
-    len += mqtt_write_packet_rem_len(pClient->read_buf + 1, rem_len);
+    return (header_len + rem_len) <= avail;
+}
 
-    // 3. read payload according to remaining length
-    if (rem_len > 0 && ((len + rem_len) > pClient->read_buf_size)) {
-        timer_left_ms = left_ms(timer);
-        if (timer_left_ms <= 0) {
-            timer_left_ms = 1;
-        }
-        timer_left_ms += QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
+static uint32_t _remain_wait_ms(Timer *timer)
+{
+    int timer_left_ms = left_ms(timer);
 
-        pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf, rem_len, timer_left_ms, &read_len);
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_BUF_TOO_SHORT);
+    if (timer_left_ms <= 0) {
+        timer_left_ms = 1;
     }
-    if (rem_len > 0) {
-        timer_left_ms = left_ms(timer);
-        if (timer_left_ms <= 0) {
-            timer_left_ms = 1;
-        }
-        timer_left_ms += QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
-        rc = pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf + len, rem_len, timer_left_ms,
+
+    return timer_left_ms + QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
+}
+
+/* wait for the rest of a packet, no more than a glance when driven by reactor */
+static uint32_t _rest_wait_ms(Qcloud_IoT_Client *pClient, Timer *timer)
+{
+    return NULL != pClient->reactor_slot ? MQTT_REACTOR_READ_WAIT_MS : _remain_wait_ms(timer);
+}
+
+/* driven by reactor, a packet not fully arrived stays staged until its socket is readable again */
+static bool _is_packet_pending(Qcloud_IoT_Client *pClient, int rc)
+{
+    if (NULL == pClient->reactor_slot) {
+        return false;
+    }
+
+    return QCLOUD_ERR_TCP_READ_TIMEOUT == rc || QCLOUD_ERR_TCP_NOTHING_TO_READ == rc ||
+           QCLOUD_ERR_SSL_READ_TIMEOUT == rc || QCLOUD_ERR_SSL_NOTHING_TO_READ == rc;
+}
+
+/**
+ * @brief Read through the rest of the frame larger than read buffer
+ *
+ * Driven by reactor, the read stops as soon as the socket runs dry and goes on in
+ * the next cycle, so one slow sender does not hold the other clients.
+ *
+ * @param pClient        MQTT Client
+ * @param timer          timeout timer
+ * @return QCLOUD_RET_SUCCESS when the frame is done, QCLOUD_ERR_MQTT_NOTHING_TO_READ
+ *         if the rest is still on the way, or err code for failure
+ */
+static int _read_frame_stream(Qcloud_IoT_Client *pClient, Timer *timer)
+{
+    MQTTFrameStream *stream = &pClient->frame_stream;
+    size_t           read_len;
+    int              rc = QCLOUD_RET_SUCCESS;
+
+    while (stream->remain > 0) {
+        read_len = 0;
+        rc       = pClient->network_stack.read(&(pClient->network_stack), pClient->read_buf,
+                                         Min(stream->remain, pClient->read_buf_size), _rest_wait_ms(pClient, timer),
                                          &read_len);
+        if (stream->deliver && NULL != stream->chunk_handler && read_len > 0) {
+            stream->msg.payload     = pClient->read_buf;
+            stream->msg.payload_len = read_len;
+            stream->chunk_handler(pClient, &stream->msg, stream->offset, stream->total_len,
+                                  stream->handler_user_data);
+        }
+        stream->remain -= read_len;
+        stream->offset += read_len;
         if (rc != QCLOUD_RET_SUCCESS) {
-            IOT_FUNC_EXIT_RC(rc);
+            break;
         }
     }
 
-    *packet_type = (pClient->read_buf[0] & MQTT_HEADER_TYPE_MASK) >> MQTT_HEADER_TYPE_SHIFT;
+    if (rc != QCLOUD_RET_SUCCESS) {
+        if (_is_packet_pending(pClient, rc)) {
+            return QCLOUD_ERR_MQTT_NOTHING_TO_READ;
+        }
+        stream->remain = 0;
+        Log_e("read large frame failed: %d, %u bytes read", rc, (unsigned)stream->offset);
+    }
 
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    return rc;
 }
 
 /**
- * @brief Check if two topic equals
+ * @brief Discard the frame larger than read buffer, whose head is staged
  *
- * @param topic_filter
- * @param topicName
- * @return
+ * @param pClient        MQTT Client
+ * @param timer          timeout timer
+ * @return QCLOUD_ERR_BUF_TOO_SHORT, or err code of network read
  */
-static uint8_t _is_topic_equals(char *topic_filter, char *topicName)
+static int _discard_staged_frame(Qcloud_IoT_Client *pClient, Timer *timer)
 {
-    return (uint8_t)(strlen(topic_filter) == strlen(topicName) && !strcmp(topic_filter, topicName));
+    size_t discard_len = pClient->read_frame_len - pClient->read_buf_used;
+    int    rc;
+
+    Log_e("MQTT Recv buffer not enough: %u < %u", (unsigned)pClient->read_buf_size,
+          (unsigned)pClient->read_frame_len);
+    reset_read_buffer(pClient);
+
+    pClient->frame_stream.remain        = discard_len;
+    pClient->frame_stream.offset        = 0;
+    pClient->frame_stream.chunk_handler = NULL;
+
+    rc = _read_frame_stream(pClient, timer);
+    if (QCLOUD_RET_SUCCESS == rc || QCLOUD_ERR_MQTT_NOTHING_TO_READ == rc) {
+        rc = QCLOUD_ERR_BUF_TOO_SHORT;
+    }
+
+    return rc;
 }
 
 /**
- * @brief Check if topic match
+ * @brief Read MQTT packet from network stack
  *
- * assume topic filter and name is in correct format
- * # can only be at end
- * + and # can only be next to separator
+ * Packets are staged in read buffer, the packet handled last time is dropped first.
+ * A PUBLISH larger than read buffer is returned with only its head staged, that is
+ * read_frame_len > read_buf_size, and its handler has to consume the rest.
  *
- * @param topic_filter  topic name filter, wildcard is supported
- * @param topicName     topic name, no wildcard
- * @param topicNameLen  length of topic name
- * @return
+ * 1. get 1st byte in fixed header
+ * 2. get and decode the remaining length
+ * 3. get payload according to remaining length
+ *
+ * Network read happens only when the bytes are not staged yet, and the packet
+ * read is always moved to the head of read buffer.
+ *
+ * @param pClient        MQTT Client
+ * @param timer          timeout timer
+ * @param packet_type    MQTT packet type
+ * @return QCLOUD_RET_SUCCESS for success, or err code for failure
  */
-static uint8_t _is_topic_matched(char *topic_filter, char *topicName, uint16_t topicNameLen)
+static int _read_mqtt_packet(Qcloud_IoT_Client *pClient, Timer *timer, uint8_t *packet_type)
 {
-    char *curf;
-    char *curn;
-    char *curn_end;
-
-    curf     = topic_filter;
-    curn     = topicName;
-    curn_end = curn + topicNameLen;
-
-    while (*curf && (curn < curn_end)) {
-        if (*curf == '+' && *curn == '/') {
-            curf++;
-            continue;
+    IOT_FUNC_ENTRY;
+
+    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(timer, QCLOUD_ERR_INVAL);
+
+    uint32_t rem_len    = 0;
+    size_t   header_len = 0;
+    size_t   total_len  = 0;
+    int      rc;
+    int      timer_left_ms = left_ms(timer);
+
+    // drop the packet handled last time
+    if (pClient->read_frame_len > 0) {
+        pClient->read_buf_used -= pClient->read_frame_len;
+        if (pClient->read_buf_used > 0) {
+            memmove(pClient->read_buf, pClient->read_buf + pClient->read_frame_len, pClient->read_buf_used);
         }
+        pClient->read_frame_len = 0;
+    }
+
+    // reactor polls the socket with expired timer, without waiting
+    if (timer_left_ms <= 0) {
+        timer_left_ms = NULL != pClient->reactor_slot ? 0 : 1;
+    }
+
+    // 1. get 1st byte in fixed header
+    rc = _fill_read_buf(pClient, 1, timer_left_ms);
+    if (rc == QCLOUD_ERR_SSL_NOTHING_TO_READ || rc == QCLOUD_ERR_TCP_NOTHING_TO_READ) {
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NOTHING_TO_READ);
+    }
+    if (rc != QCLOUD_RET_SUCCESS) {
+        IOT_FUNC_EXIT_RC(rc);
+    }
 
-        if (*curn == '/' && *curf != '/') {
+    // 2. get and decode the remaining length
+    do {
+        rc = _decode_staged_rem_len(pClient->read_buf, pClient->read_buf_used, &rem_len, &header_len);
+        if (QCLOUD_RET_SUCCESS != rc) {
+            reset_read_buffer(pClient);
+            IOT_FUNC_EXIT_RC(rc);
+        }
+        if (header_len > 0) {
             break;
         }
 
-        if (*curf != '+' && *curf != '#' && *curf != *curn) {
-            break;
+        rc = _fill_read_buf(pClient, pClient->read_buf_used + 1, _rest_wait_ms(pClient, timer));
+        if (QCLOUD_RET_SUCCESS != rc) {
+            IOT_FUNC_EXIT_RC(_is_packet_pending(pClient, rc) ? QCLOUD_ERR_MQTT_NOTHING_TO_READ : QCLOUD_ERR_FAILURE);
         }
+    } while (1);
+
+    total_len               = header_len + rem_len;
+    pClient->read_frame_len = total_len;
+    *packet_type            = (pClient->read_buf[0] & MQTT_HEADER_TYPE_MASK) >> MQTT_HEADER_TYPE_SHIFT;
 
-        if (*curf == '+') {
-            /* skip until we meet the next separator, or end of string */
-            char *nextpos = curn + 1;
-            while (nextpos < curn_end && *nextpos != '/') nextpos = ++curn + 1;
-        } else if (*curf == '#') {
-            /* skip until end of string */
-            curn = curn_end - 1;
+    // if read buffer is not enough to hold the packet, stage the head of PUBLISH
+    // for streaming, and discard the others
+    if (total_len > pClient->read_buf_size) {
+        if (PUBLISH != *packet_type) {
+            IOT_FUNC_EXIT_RC(_discard_staged_frame(pClient, timer));
         }
 
-        curf++;
-        curn++;
+        rc = _fill_read_buf(pClient, pClient->read_buf_size, _rest_wait_ms(pClient, timer));
+        if (_is_packet_pending(pClient, rc)) {
+            pClient->read_frame_len = 0;
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NOTHING_TO_READ);
+        }
+        if (rc != QCLOUD_RET_SUCCESS) {
+            reset_read_buffer(pClient);
+        }
+        IOT_FUNC_EXIT_RC(rc);
     }
 
-    if (*curf == '\0') {
-        return (uint8_t)(curn == curn_end);
+    // 3. get payload according to remaining length
+    rc = _fill_read_buf(pClient, total_len, _rest_wait_ms(pClient, timer));
+    if (rc != QCLOUD_RET_SUCCESS) {
+        pClient->read_frame_len = 0;
+        if (_is_packet_pending(pClient, rc)) {
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NOTHING_TO_READ);
+        }
     }
-    return (uint8_t)((*curf == '#') || *(curf + 1) == '#' || (*curf == '+' && *(curn - 1) == '/'));
+
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 /**
@@ -752,24 +893,33 @@ static int _deliver_message(Qcloud_IoT_Client *pClient, char *topicName, uint16_
     message->ptopic    = topicName;
     message->topic_len = (size_t)topicNameLen;
 
-    uint32_t i;
+    SubTopicHandle *      handle;
+    OnMessageHandler      message_handler       = NULL;
+    OnMessageChunkHandler message_chunk_handler = NULL;
+    void *                handler_user_data     = NULL;
+
     HAL_MutexLock(pClient->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((pClient->sub_handles[i].topic_filter != NULL) &&
-            (_is_topic_equals(topicName, (char *)pClient->sub_handles[i].topic_filter) ||
-             _is_topic_matched((char *)pClient->sub_handles[i].topic_filter, topicName, topicNameLen))) {
-            HAL_MutexUnlock(pClient->lock_generic);
-            if (pClient->sub_handles[i].message_handler != NULL) {
-                pClient->sub_handles[i].message_handler(pClient, message, pClient->sub_handles[i].handler_user_data);
-                IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
-            }
-            HAL_MutexLock(pClient->lock_generic);
-        }
+    handle = qcloud_iot_mqtt_sub_trie_match(&pClient->sub_trie, topicName, topicNameLen);
+    if (NULL != handle) {
+        message_handler       = handle->message_handler;
+        message_chunk_handler = handle->message_chunk_handler;
+        handler_user_data     = handle->handler_user_data;
+    }
+    HAL_MutexUnlock(pClient->lock_generic);
+
+    if (NULL != message_handler) {
+        message_handler(pClient, message, handler_user_data);
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
+
+    /* streaming subscriber gets the whole message as one chunk */
+    if (NULL != message_chunk_handler) {
+        message_chunk_handler(pClient, message, 0, message->payload_len, handler_user_data);
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
     }
 
     /* Message handler not found for topic */
     /* May be we do not care  change FAILURE  use SUCCESS*/
-    HAL_MutexUnlock(pClient->lock_generic);
 
     Log_d("no matching any topic, call default handle function");
 
@@ -783,55 +933,6 @@ static int _deliver_message(Qcloud_IoT_Client *pClient, char *topicName, uint16_
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
-/**
- * @brief remove node signed with msgId from publish ACK wait list
- *
- * @return 0, success; NOT 0, fail;
- */
-static int _mask_pubInfo_from(Qcloud_IoT_Client *c, uint16_t msgId)
-{
-    IOT_FUNC_ENTRY;
-
-    if (!c) {
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
-    }
-
-    HAL_MutexLock(c->lock_list_pub);
-    if (c->list_pub_wait_ack->len) {
-        ListIterator *    iter;
-        ListNode *        node      = NULL;
-        QcloudIotPubInfo *repubInfo = NULL;
-
-        if (NULL == (iter = list_iterator_new(c->list_pub_wait_ack, LIST_TAIL))) {
-            HAL_MutexUnlock(c->lock_list_pub);
-            return QCLOUD_RET_SUCCESS;
-        }
-
-        for (;;) {
-            node = list_iterator_next(iter);
-
-            if (NULL == node) {
-                break;
-            }
-
-            repubInfo = (QcloudIotPubInfo *)node->val;
-            if (NULL == repubInfo) {
-                Log_e("node's value is invalid!");
-                continue;
-            }
-
-            if (repubInfo->msg_id == msgId) {
-                repubInfo->node_state = MQTT_NODE_STATE_INVALID; /* set as invalid node */
-            }
-        }
-
-        list_iterator_destroy(iter);
-    }
-    HAL_MutexUnlock(c->lock_list_pub);
-
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
-}
-
 /**
  * @brief remove node signed with msgId from subscribe ACK wait list, and return
  * the msg handler
@@ -888,16 +989,20 @@ static int _handle_puback_packet(Qcloud_IoT_Client *pClient, Timer *timer)
     POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(timer, QCLOUD_ERR_INVAL);
 
-    uint16_t packet_id;
-    uint8_t  dup, type;
-    int      rc;
+    uint16_t         packet_id;
+    uint8_t          dup, type;
+    int              rc;
+    bool             acked;
+    QcloudIotPubInfo pub_info;
 
     rc = deserialize_ack_packet(&type, &dup, &packet_id, pClient->read_buf, pClient->read_buf_size);
     if (QCLOUD_RET_SUCCESS != rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    (void)_mask_pubInfo_from(pClient, packet_id);
+    HAL_MutexLock(pClient->lock_list_pub);
+    acked = qcloud_iot_mqtt_pub_window_remove(&pClient->pub_wait_ack, packet_id, &pub_info);
+    HAL_MutexUnlock(pClient->lock_list_pub);
 
     /* notify this event to user callback */
     if (NULL != pClient->event_handle.h_fp) {
@@ -907,6 +1012,10 @@ static int _handle_puback_packet(Qcloud_IoT_Client *pClient, Timer *timer)
         pClient->event_handle.h_fp(pClient, pClient->event_handle.context, &msg);
     }
 
+    if (acked && NULL != pub_info.ack_handler) {
+        pub_info.ack_handler(pClient, packet_id, MQTT_EVENT_PUBLISH_SUCCESS, pub_info.ack_user_data);
+    }
+
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
@@ -928,7 +1037,6 @@ static int _handle_suback_packet(Qcloud_IoT_Client *pClient, Timer *timer, QoS q
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    int flag_dup = 0, i_free = -1;
     // check return code in SUBACK packet: 0x00(QOS0, SUCCESS),0x01(QOS1,
     // SUCCESS),0x02(QOS2, SUCCESS),0x80(Failure)
     if (grantedQoS[0] == 0x80) {
@@ -965,40 +1073,31 @@ static int _handle_suback_packet(Qcloud_IoT_Client *pClient, Timer *timer, QoS q
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_SUB);
     }
 
-    int i;
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((NULL != pClient->sub_handles[i].topic_filter)) {
-            if (0 == _check_handle_is_identical(&pClient->sub_handles[i], &sub_handle)) {
-                flag_dup = 1;
-                Log_w("Identical topic found: %s", sub_handle.topic_filter);
-                if (pClient->sub_handles[i].handler_user_data != sub_handle.handler_user_data) {
-                    Log_w("Update handler_user_data %p -> %p!", pClient->sub_handles[i].handler_user_data,
-                          sub_handle.handler_user_data);
-                    pClient->sub_handles[i].handler_user_data = sub_handle.handler_user_data;
-                }
-                HAL_Free((void *)sub_handle.topic_filter);
-                sub_handle.topic_filter = NULL;
-                break;
-            }
-        } else {
-            if (-1 == i_free) {
-                i_free = i; /* record available element */
-            }
-        }
+    SubTopicHandle *stored = qcloud_iot_mqtt_sub_trie_add(&pClient->sub_trie, &sub_handle);
+    if (NULL == stored) {
+        Log_e("add subscription %s failed!", sub_handle.topic_filter);
+        HAL_MutexUnlock(pClient->lock_generic);
+        HAL_Free((void *)sub_handle.topic_filter);
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
     }
 
-    if (0 == flag_dup) {
-        if (-1 == i_free) {
-            Log_e("NO more @sub_handles space!");
-            HAL_MutexUnlock(pClient->lock_generic);
-            IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+    if (stored->topic_filter != sub_handle.topic_filter) {
+        /* topic subscribed again, e.g. resubscribe after reconnect, keep one subscription */
+        if (0 != _check_handle_is_identical(stored, &sub_handle)) {
+            Log_w("Update handlers of topic: %s", sub_handle.topic_filter);
+            stored->message_handler       = sub_handle.message_handler;
+            stored->sub_event_handler     = sub_handle.sub_event_handler;
+            stored->message_chunk_handler = sub_handle.message_chunk_handler;
         } else {
-            pClient->sub_handles[i_free].topic_filter      = sub_handle.topic_filter;
-            pClient->sub_handles[i_free].message_handler   = sub_handle.message_handler;
-            pClient->sub_handles[i_free].sub_event_handler = sub_handle.sub_event_handler;
-            pClient->sub_handles[i_free].qos               = sub_handle.qos;
-            pClient->sub_handles[i_free].handler_user_data = sub_handle.handler_user_data;
+            Log_w("Identical topic found: %s", sub_handle.topic_filter);
+        }
+        if (stored->handler_user_data != sub_handle.handler_user_data) {
+            Log_w("Update handler_user_data %p -> %p!", stored->handler_user_data, sub_handle.handler_user_data);
+            stored->handler_user_data = sub_handle.handler_user_data;
         }
+        stored->qos = sub_handle.qos;
+        HAL_Free((void *)sub_handle.topic_filter);
+        sub_handle.topic_filter = stored->topic_filter;
     }
 
     HAL_MutexUnlock(pClient->lock_generic);
@@ -1093,6 +1192,40 @@ void reset_repeat_packet_id_buffer(Qcloud_IoT_Client *pClient)
 
 #endif
 
+static int _send_publish_ack(Qcloud_IoT_Client *pClient, QoS qos, uint16_t msg_id, Timer *timer)
+{
+    IOT_FUNC_ENTRY;
+    int      rc;
+    uint32_t len = 0;
+
+    HAL_MutexLock(pClient->lock_write_buf);
+    if (QOS1 == qos) {
+        rc = serialize_pub_ack_packet(pClient->write_buf, pClient->write_buf_size, PUBACK, 0, msg_id, &len);
+    } else { /* Message is not QOS0 or QOS1 means only option left is QOS2 */
+        rc = serialize_pub_ack_packet(pClient->write_buf, pClient->write_buf_size, PUBREC, 0, msg_id, &len);
+    }
+
+    if (QCLOUD_RET_SUCCESS != rc) {
+        HAL_MutexUnlock(pClient->lock_write_buf);
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    if (expired(timer)) {
+        /* send timeout */
+        //Log_w("puback timer expired! left:%d, increase a bit", left_ms(timer));
+        countdown_ms(timer, 100);
+    }
+
+    rc = send_mqtt_packet(pClient, len, timer);
+    if (QCLOUD_RET_SUCCESS != rc) {
+        HAL_MutexUnlock(pClient->lock_write_buf);
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    HAL_MutexUnlock(pClient->lock_write_buf);
+    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+}
+
 static int _handle_publish_packet(Qcloud_IoT_Client *pClient, Timer *timer)
 {
     IOT_FUNC_ENTRY;
@@ -1100,7 +1233,6 @@ static int _handle_publish_packet(Qcloud_IoT_Client *pClient, Timer *timer)
     uint16_t    topic_len;
     MQTTMessage msg;
     int         rc;
-    uint32_t    len = 0;
 
     rc = deserialize_publish_packet(&msg.dup, &msg.qos, &msg.retained, &msg.id, &topic_name, &topic_len,
                                     (unsigned char **)&msg.payload, &msg.payload_len, pClient->read_buf,
@@ -1143,32 +1275,118 @@ static int _handle_publish_packet(Qcloud_IoT_Client *pClient, Timer *timer)
 #endif
     }
 
-    HAL_MutexLock(pClient->lock_write_buf);
-    if (QOS1 == msg.qos) {
-        rc = serialize_pub_ack_packet(pClient->write_buf, pClient->write_buf_size, PUBACK, 0, msg.id, &len);
-    } else { /* Message is not QOS0 or QOS1 means only option left is QOS2 */
-        rc = serialize_pub_ack_packet(pClient->write_buf, pClient->write_buf_size, PUBREC, 0, msg.id, &len);
-    }
+    IOT_FUNC_EXIT_RC(_send_publish_ack(pClient, msg.qos, msg.id, timer));
+}
 
-    if (QCLOUD_RET_SUCCESS != rc) {
-        HAL_MutexUnlock(pClient->lock_write_buf);
+/**
+ * @brief Go on reading the frame larger than read buffer, then ack the PUBLISH delivered
+ */
+static int _resume_frame_stream(Qcloud_IoT_Client *pClient, Timer *timer)
+{
+    IOT_FUNC_ENTRY;
+    MQTTFrameStream *stream = &pClient->frame_stream;
+    int              rc;
+
+    rc = _read_frame_stream(pClient, timer);
+    if (QCLOUD_RET_SUCCESS != rc || NULL == stream->chunk_handler || QOS0 == stream->msg.qos) {
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    if (expired(timer)) {
-        /* send timeout */
-        //Log_w("puback timer expired! left:%d, increase a bit", left_ms(timer));
-        countdown_ms(timer, 100);
+#ifdef MQTT_RMDUP_MSG_ENABLED
+    _add_packet_id_to_repeat_buf(pClient, stream->msg.id);
+#endif
+
+    IOT_FUNC_EXIT_RC(_send_publish_ack(pClient, stream->msg.qos, stream->msg.id, timer));
+}
+
+/**
+ * @brief Handle PUBLISH larger than read buffer, of which only the head is staged
+ *
+ * The payload is handed to the chunk handler of matched subscription piece by piece,
+ * each piece read into read buffer as it arrives, so the whole message is never held.
+ * Without chunk handler, the packet is discarded.
+ */
+static int _handle_publish_stream(Qcloud_IoT_Client *pClient, Timer *timer)
+{
+    IOT_FUNC_ENTRY;
+    MQTTFrameStream *stream = &pClient->frame_stream;
+    char *           topic_name;
+    uint16_t         topic_len;
+    MQTTMessage      msg;
+    uint32_t         rem_len    = 0;
+    size_t           header_len = 0;
+    size_t           var_len;
+    size_t           chunk_len;
+    SubTopicHandle * handle;
+    int              rc;
+
+    // topic name and packet id have to be staged
+    _decode_staged_rem_len(pClient->read_buf, pClient->read_buf_used, &rem_len, &header_len);
+    var_len = header_len + 2;
+    if (var_len <= pClient->read_buf_used) {
+        var_len += (pClient->read_buf[header_len] << 8) + pClient->read_buf[header_len + 1];
+        var_len += (pClient->read_buf[0] & MQTT_HEADER_QOS_MASK) ? 2 : 0;
+    }
+    if (var_len > pClient->read_buf_used) {
+        IOT_FUNC_EXIT_RC(_discard_staged_frame(pClient, timer));
     }
 
-    rc = send_mqtt_packet(pClient, len, timer);
+    rc = deserialize_publish_packet(&msg.dup, &msg.qos, &msg.retained, &msg.id, &topic_name, &topic_len,
+                                    (unsigned char **)&msg.payload, &msg.payload_len, pClient->read_buf,
+                                    pClient->read_buf_used);
     if (QCLOUD_RET_SUCCESS != rc) {
-        HAL_MutexUnlock(pClient->lock_write_buf);
+        _discard_staged_frame(pClient, timer);
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    HAL_MutexUnlock(pClient->lock_write_buf);
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    // topic is copied out as read buffer is reused for the payload
+    if (topic_len >= MAX_SIZE_OF_CLOUD_TOPIC) {
+        topic_len = MAX_SIZE_OF_CLOUD_TOPIC - 1;
+        Log_e("topic len exceed buffer len");
+    }
+    memcpy(stream->topic, topic_name, topic_len);
+    stream->topic[topic_len] = '\0';
+
+    stream->chunk_handler     = NULL;
+    stream->handler_user_data = NULL;
+    HAL_MutexLock(pClient->lock_generic);
+    handle = qcloud_iot_mqtt_sub_trie_match(&pClient->sub_trie, stream->topic, topic_len);
+    if (NULL != handle) {
+        stream->chunk_handler     = handle->message_chunk_handler;
+        stream->handler_user_data = handle->handler_user_data;
+    }
+    HAL_MutexUnlock(pClient->lock_generic);
+
+    if (NULL == stream->chunk_handler) {
+        Log_e("no chunk handler for large message of topic %s", stream->topic);
+        IOT_FUNC_EXIT_RC(_discard_staged_frame(pClient, timer));
+    }
+
+    stream->deliver = true;
+#ifdef MQTT_RMDUP_MSG_ENABLED
+    // repeated message is still read through to keep the stream in sync
+    if (QOS0 != msg.qos && _get_packet_id_in_repeat_buf(pClient, msg.id) >= 0) {
+        stream->deliver = false;
+    }
+#endif
+
+    stream->msg           = msg;
+    stream->msg.ptopic    = stream->topic;
+    stream->msg.topic_len = topic_len;
+    stream->total_len     = msg.payload_len;
+
+    chunk_len = pClient->read_buf_used - var_len;
+    if (stream->deliver && chunk_len > 0) {
+        stream->msg.payload_len = chunk_len;
+        stream->chunk_handler(pClient, &stream->msg, 0, stream->total_len, stream->handler_user_data);
+    }
+
+    // the rest of the payload is read into read buffer from its head
+    reset_read_buffer(pClient);
+    stream->offset = chunk_len;
+    stream->remain = stream->total_len - chunk_len;
+
+    IOT_FUNC_EXIT_RC(_resume_frame_stream(pClient, timer));
 }
 
 static int _handle_pubrec_packet(Qcloud_IoT_Client *pClient, Timer *timer)
@@ -1229,72 +1447,95 @@ int cycle_for_read(Qcloud_IoT_Client *pClient, Timer *timer, uint8_t *packet_typ
     POINTER_SANITY_CHECK(timer, QCLOUD_ERR_INVAL);
 
     int rc;
-    /* read the socket, see what work is due */
-    rc = _read_mqtt_packet(pClient, timer, packet_type);
-    if (QCLOUD_ERR_MQTT_NOTHING_TO_READ == rc) {
-        /* Nothing to read, not a cycle failure */
-        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
-    }
-
-    if (QCLOUD_RET_SUCCESS != rc) {
-        IOT_FUNC_EXIT_RC(rc);
-    }
 
-    switch (*packet_type) {
-        case CONNACK:
-            break;
-        case PUBACK:
-            rc = _handle_puback_packet(pClient, timer);
-            break;
-        case SUBACK:
-            rc = _handle_suback_packet(pClient, timer, qos);
-            break;
-        case UNSUBACK:
-            rc = _handle_unsuback_packet(pClient, timer);
-            break;
-        case PUBLISH: {
-            rc = _handle_publish_packet(pClient, timer);
-            break;
+    /* the large frame left by last cycle comes before any other packet */
+    if (pClient->frame_stream.remain > 0) {
+        rc = _resume_frame_stream(pClient, timer);
+        if (QCLOUD_ERR_MQTT_NOTHING_TO_READ == rc) {
+            IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
         }
-        case PUBREC: {
-            rc = _handle_pubrec_packet(pClient, timer);
-            break;
+        if (QCLOUD_RET_SUCCESS != rc) {
+            IOT_FUNC_EXIT_RC(rc);
         }
-        case PUBREL: {
-            Log_e("Packet type PUBREL is currently NOT handled!");
-            break;
+    }
+
+    do {
+        /* read the socket, see what work is due */
+        rc = _read_mqtt_packet(pClient, timer, packet_type);
+        if (QCLOUD_ERR_MQTT_NOTHING_TO_READ == rc) {
+            /* Nothing to read, not a cycle failure */
+            IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
         }
-        case PUBCOMP:
-            break;
-        case PINGRESP:
-            break;
-        default: {
-            /* Either unknown packet type or Failure occurred
-             * Should not happen */
 
-            IOT_FUNC_EXIT_RC(QCLOUD_ERR_RX_MESSAGE_INVAL);
-            break;
+        if (QCLOUD_RET_SUCCESS != rc) {
+            IOT_FUNC_EXIT_RC(rc);
         }
-    }
 
-    switch (*packet_type) {
-        /* Recv below msgs are all considered as PING OK */
-        case PUBACK:
-        case SUBACK:
-        case UNSUBACK:
-        case PINGRESP: {
-            _handle_pingresp_packet(pClient);
-            break;
+        switch (*packet_type) {
+            case CONNACK:
+                break;
+            case PUBACK:
+                rc = _handle_puback_packet(pClient, timer);
+                break;
+            case SUBACK:
+                rc = _handle_suback_packet(pClient, timer, qos);
+                break;
+            case UNSUBACK:
+                rc = _handle_unsuback_packet(pClient, timer);
+                break;
+            case PUBLISH: {
+                if (pClient->read_frame_len > pClient->read_buf_size) {
+                    rc = _handle_publish_stream(pClient, timer);
+                    if (QCLOUD_ERR_MQTT_NOTHING_TO_READ == rc) {
+                        rc = QCLOUD_RET_SUCCESS;
+                    }
+                } else {
+                    rc = _handle_publish_packet(pClient, timer);
+                }
+                break;
+            }
+            case PUBREC: {
+                rc = _handle_pubrec_packet(pClient, timer);
+                break;
+            }
+            case PUBREL: {
+                Log_e("Packet type PUBREL is currently NOT handled!");
+                break;
+            }
+            case PUBCOMP:
+                break;
+            case PINGRESP:
+                break;
+            default: {
+                /* Either unknown packet type or Failure occurred
+                 * Should not happen */
+
+                IOT_FUNC_EXIT_RC(QCLOUD_ERR_RX_MESSAGE_INVAL);
+                break;
+            }
         }
-        /* Recv downlink pub means link is OK but we still need to send PING request
-         */
-        case PUBLISH: {
-            HAL_MutexLock(pClient->lock_generic);
-            pClient->is_ping_outstanding = 0;
-            HAL_MutexUnlock(pClient->lock_generic);
-            break;
+
+        switch (*packet_type) {
+            /* Recv below msgs are all considered as PING OK */
+            case PUBACK:
+            case SUBACK:
+            case UNSUBACK:
+            case PINGRESP: {
+                _handle_pingresp_packet(pClient);
+                break;
+            }
+            /* Recv downlink pub means link is OK but we still need to send PING request
+             */
+            case PUBLISH: {
+                HAL_MutexLock(pClient->lock_generic);
+                pClient->is_ping_outstanding = 0;
+                HAL_MutexUnlock(pClient->lock_generic);
+                break;
+            }
         }
-    }
+
+        /* CONNACK is waited by caller, so stop there */
+    } while (QCLOUD_RET_SUCCESS == rc && CONNACK != *packet_type && _is_next_packet_staged(pClient));
 
     IOT_FUNC_EXIT_RC(rc);
 }
@@ -1351,7 +1592,7 @@ int push_sub_info_to(Qcloud_IoT_Client *c, int len, unsigned short msgId, Messag
 
     HAL_MutexLock(c->lock_list_sub);
 
-    if (c->list_sub_wait_ack->len >= MAX_MESSAGE_HANDLERS) {
+    if (c->list_sub_wait_ack->len >= MAX_SUB_WAIT_ACK_NUM) {
         HAL_MutexUnlock(c->lock_list_sub);
         Log_e("number of sub_info more than max! size = %d", c->list_sub_wait_ack->len);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_MAX_SUBSCRIPTIONS);
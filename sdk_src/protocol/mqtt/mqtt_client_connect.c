@@ -308,6 +308,68 @@ static int _deserialize_connack_packet(uint8_t *sessionPresent, int *connack_rc,
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+/**
+ * @brief Serialize and send CONNECT packet, network is connected
+ *
+ * @param pClient
+ * @param timer     timeout timer
+ * @return
+ */
+static int _send_connect_packet(Qcloud_IoT_Client *pClient, Timer *timer)
+{
+    IOT_FUNC_ENTRY;
+
+    int      rc;
+    uint32_t len = 0;
+
+    HAL_MutexLock(pClient->lock_write_buf);
+    // serialize CONNECT packet
+    rc = _serialize_connect_packet(pClient->write_buf, pClient->write_buf_size, &(pClient->options), &len);
+    if (QCLOUD_RET_SUCCESS != rc || 0 == len) {
+        HAL_MutexUnlock(pClient->lock_write_buf);
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    // send CONNECT packet
+    rc = send_mqtt_packet(pClient, len, timer);
+    HAL_MutexUnlock(pClient->lock_write_buf);
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Check CONNACK at the head of read buffer, and enter connected state if accepted
+ *
+ * @param pClient
+ * @return
+ */
+static int _handle_connack_packet(Qcloud_IoT_Client *pClient)
+{
+    IOT_FUNC_ENTRY;
+
+    int     connack_rc = QCLOUD_ERR_FAILURE, rc = QCLOUD_ERR_FAILURE;
+    uint8_t sessionPresent = 0;
+
+    // deserialize CONNACK and check reture code
+    rc = _deserialize_connack_packet(&sessionPresent, &connack_rc, pClient->read_buf, pClient->read_buf_size);
+    if (QCLOUD_RET_SUCCESS != rc) {
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    if (QCLOUD_RET_MQTT_CONNACK_CONNECTION_ACCEPTED != connack_rc) {
+        IOT_FUNC_EXIT_RC(connack_rc);
+    }
+
+    set_client_conn_state(pClient, CONNECTED);
+    HAL_MutexLock(pClient->lock_generic);
+    pClient->was_manually_disconnected = 0;
+    pClient->is_ping_outstanding       = 0;
+    countdown(&pClient->ping_timer, pClient->options.keep_alive_interval);
+    HAL_MutexUnlock(pClient->lock_generic);
+
+    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+}
+
 /**
  * @brief Setup connection with MQTT server
  *
@@ -319,10 +381,8 @@ static int _mqtt_connect(Qcloud_IoT_Client *pClient, MQTTConnectParams *options)
 {
     IOT_FUNC_ENTRY;
 
-    Timer    connect_timer;
-    int      connack_rc = QCLOUD_ERR_FAILURE, rc = QCLOUD_ERR_FAILURE;
-    uint8_t  sessionPresent = 0;
-    uint32_t len            = 0;
+    Timer connect_timer;
+    int   rc = QCLOUD_ERR_FAILURE;
 
     InitTimer(&connect_timer);
     countdown_ms(&connect_timer, pClient->command_timeout_ms);
@@ -331,23 +391,16 @@ static int _mqtt_connect(Qcloud_IoT_Client *pClient, MQTTConnectParams *options)
         _copy_connect_params(&(pClient->options), options);
     }
 
+    // bytes staged from the previous connection are useless
+    reset_read_buffer(pClient);
+
     // TCP or TLS network connect
     rc = pClient->network_stack.connect(&(pClient->network_stack));
     if (QCLOUD_RET_SUCCESS != rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    HAL_MutexLock(pClient->lock_write_buf);
-    // serialize CONNECT packet
-    rc = _serialize_connect_packet(pClient->write_buf, pClient->write_buf_size, &(pClient->options), &len);
-    if (QCLOUD_RET_SUCCESS != rc || 0 == len) {
-        HAL_MutexUnlock(pClient->lock_write_buf);
-        IOT_FUNC_EXIT_RC(rc);
-    }
-
-    // send CONNECT packet
-    rc = send_mqtt_packet(pClient, len, &connect_timer);
-    HAL_MutexUnlock(pClient->lock_write_buf);
+    rc = _send_connect_packet(pClient, &connect_timer);
     if (QCLOUD_RET_SUCCESS != rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
@@ -358,24 +411,89 @@ static int _mqtt_connect(Qcloud_IoT_Client *pClient, MQTTConnectParams *options)
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    // deserialize CONNACK and check reture code
-    rc = _deserialize_connack_packet(&sessionPresent, &connack_rc, pClient->read_buf, pClient->read_buf_size);
-    if (QCLOUD_RET_SUCCESS != rc) {
-        IOT_FUNC_EXIT_RC(rc);
+    rc = _handle_connack_packet(pClient);
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/* timeout of DNS, TCP connect and TLS handshake together */
+static uint32_t _network_connect_timeout_ms(Qcloud_IoT_Client *pClient)
+{
+#ifndef AUTH_WITH_NOTLS
+    return pClient->network_stack.ssl_connect_params.timeout_ms;
+#else
+    return pClient->command_timeout_ms;
+#endif
+}
+
+/* the step in progress is still in time, or it times out */
+static int _connect_step_pending(Qcloud_IoT_Client *pClient)
+{
+    if (expired(&pClient->connect_timer)) {
+        Log_e("connect step %d timeout", pClient->connect_step);
+        return QCLOUD_ERR_MQTT_REQUEST_TIMEOUT;
     }
 
-    if (QCLOUD_RET_MQTT_CONNACK_CONNECTION_ACCEPTED != connack_rc) {
-        IOT_FUNC_EXIT_RC(connack_rc);
+    return QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT;
+}
+
+int qcloud_iot_mqtt_connect_step(Qcloud_IoT_Client *pClient)
+{
+    IOT_FUNC_ENTRY;
+
+    int     rc;
+    Timer   timer;
+    uint8_t packet_type = 0;
+
+    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(pClient->network_stack.connect_async, QCLOUD_ERR_INVAL);
+
+    if (get_client_conn_state(pClient)) {
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_MQTT_ALREADY_CONNECTED);
     }
 
-    set_client_conn_state(pClient, CONNECTED);
-    HAL_MutexLock(pClient->lock_generic);
-    pClient->was_manually_disconnected = 0;
-    pClient->is_ping_outstanding       = 0;
-    countdown(&pClient->ping_timer, pClient->options.keep_alive_interval);
-    HAL_MutexUnlock(pClient->lock_generic);
+    if (MQTT_CONNECT_IDLE == pClient->connect_step) {
+        // bytes staged from the previous connection are useless
+        reset_read_buffer(pClient);
+        countdown_ms(&pClient->connect_timer, _network_connect_timeout_ms(pClient));
+        pClient->connect_step = MQTT_CONNECT_NETWORK;
+    }
 
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    // 1. DNS, TCP connect and TLS handshake, then send CONNECT
+    if (MQTT_CONNECT_NETWORK == pClient->connect_step) {
+        rc = pClient->network_stack.connect_async(&(pClient->network_stack));
+        if (network_is_connecting(rc)) {
+            rc = _connect_step_pending(pClient);
+            goto exit;
+        }
+        if (QCLOUD_RET_SUCCESS != rc) {
+            goto exit;
+        }
+
+        countdown_ms(&pClient->connect_timer, pClient->command_timeout_ms);
+        rc = _send_connect_packet(pClient, &pClient->connect_timer);
+        if (QCLOUD_RET_SUCCESS != rc) {
+            goto exit;
+        }
+        pClient->connect_step = MQTT_CONNECT_CONNACK;
+    }
+
+    // 2. take CONNACK if it has arrived
+    InitTimer(&timer);
+    rc = cycle_for_read(pClient, &timer, &packet_type, QOS0);
+    if (QCLOUD_RET_SUCCESS == rc) {
+        rc = (CONNACK == packet_type) ? _handle_connack_packet(pClient) : _connect_step_pending(pClient);
+    }
+
+exit:
+    if (QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT != rc) {
+        pClient->connect_step = MQTT_CONNECT_IDLE;
+        if (QCLOUD_RET_SUCCESS != rc) {
+            pClient->network_stack.disconnect(&(pClient->network_stack));
+        }
+    }
+
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 int qcloud_iot_mqtt_connect(Qcloud_IoT_Client *pClient, MQTTConnectParams *pParams)
@@ -407,13 +525,23 @@ int qcloud_iot_mqtt_attempt_reconnect(Qcloud_IoT_Client *pClient)
     int rc;
     POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
 
-    Log_i("attempt to reconnect...");
-
     if (get_client_conn_state(pClient)) {
         IOT_FUNC_EXIT_RC(QCLOUD_RET_MQTT_ALREADY_CONNECTED);
     }
 
-    rc = qcloud_iot_mqtt_connect(pClient, &pClient->options);
+    if (MQTT_CONNECT_IDLE == pClient->connect_step) {
+        Log_i("attempt to reconnect...");
+    }
+
+    // connect step by step if the network can, so reconnect does not block the caller
+    if (NULL != pClient->network_stack.connect_async) {
+        rc = qcloud_iot_mqtt_connect_step(pClient);
+        if (QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT == rc) {
+            IOT_FUNC_EXIT_RC(rc);
+        }
+    } else {
+        rc = qcloud_iot_mqtt_connect(pClient, &pClient->options);
+    }
 
     if (!get_client_conn_state(pClient)) {
         IOT_FUNC_EXIT_RC(rc);
@@ -438,6 +566,11 @@ int qcloud_iot_mqtt_disconnect(Qcloud_IoT_Client *pClient)
     uint32_t serialized_len = 0;
 
     if (get_client_conn_state(pClient) == 0) {
+        // drop the connect in progress
+        if (MQTT_CONNECT_IDLE != pClient->connect_step) {
+            pClient->network_stack.disconnect(&(pClient->network_stack));
+            pClient->connect_step = MQTT_CONNECT_IDLE;
+        }
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NO_CONN);
     }
 
@@ -0,0 +1,269 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2018-2020 THL A29 Limited, a Tencent company. All rights
+ reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "mqtt_client.h"
+
+/* wrap around safe compare of HAL_GetTimeMs() values */
+#define DEADLINE_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+static bool _heap_less(QcloudIotPubWindow *window, uint16_t i, uint16_t j)
+{
+    return DEADLINE_BEFORE(window->slots[window->heap[i]].deadline, window->slots[window->heap[j]].deadline);
+}
+
+static void _heap_swap(QcloudIotPubWindow *window, uint16_t i, uint16_t j)
+{
+    uint16_t tmp    = window->heap[i];
+    window->heap[i] = window->heap[j];
+    window->heap[j] = tmp;
+
+    window->slots[window->heap[i]].heap_pos = i;
+    window->slots[window->heap[j]].heap_pos = j;
+}
+
+static void _heap_sift_up(QcloudIotPubWindow *window, uint16_t pos)
+{
+    while (pos > 0 && _heap_less(window, pos, (pos - 1) / 2)) {
+        _heap_swap(window, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void _heap_sift_down(QcloudIotPubWindow *window, uint16_t pos)
+{
+    uint16_t child;
+
+    while ((child = 2 * pos + 1) < window->count) {
+        if (child + 1 < window->count && _heap_less(window, child + 1, child)) {
+            child++;
+        }
+        if (!_heap_less(window, child, pos)) {
+            break;
+        }
+        _heap_swap(window, pos, child);
+        pos = child;
+    }
+}
+
+/* sequential packet ids fall in distinct buckets */
+#define INDEX_HOME(window, msg_id) ((msg_id) & (window)->index_mask)
+
+/* position of msg_id in index, or -1 */
+static int _index_find(QcloudIotPubWindow *window, uint16_t msg_id)
+{
+    uint16_t pos;
+
+    for (pos = INDEX_HOME(window, msg_id); window->index[pos]; pos = (pos + 1) & window->index_mask) {
+        if (window->slots[window->index[pos] - 1].msg_id == msg_id) {
+            return pos;
+        }
+    }
+
+    return -1;
+}
+
+static void _index_insert(QcloudIotPubWindow *window, uint16_t msg_id, uint16_t slot_idx)
+{
+    uint16_t pos = INDEX_HOME(window, msg_id);
+
+    while (window->index[pos]) {
+        pos = (pos + 1) & window->index_mask;
+    }
+    window->index[pos] = slot_idx + 1;
+}
+
+/* backward shift deletion, no tombstones are left behind */
+static void _index_erase(QcloudIotPubWindow *window, uint16_t pos)
+{
+    uint16_t next = (pos + 1) & window->index_mask;
+    uint16_t home;
+
+    while (window->index[next]) {
+        home = INDEX_HOME(window, window->slots[window->index[next] - 1].msg_id);
+        /* the entry at next may move to pos if pos is on its probe path */
+        if (((next - home) & window->index_mask) >= ((next - pos) & window->index_mask)) {
+            window->index[pos] = window->index[next];
+            pos                = next;
+        }
+        next = (next + 1) & window->index_mask;
+    }
+    window->index[pos] = 0;
+}
+
+/* take slot out of heap and index and mark it free, its index is left at heap[count] as a free entry */
+static void _slot_release(QcloudIotPubWindow *window, QcloudIotPubInfo *slot, QcloudIotPubInfo *info)
+{
+    uint16_t pos = slot->heap_pos;
+
+    if (NULL != info) {
+        *info = *slot;
+    }
+
+    _index_erase(window, _index_find(window, slot->msg_id));
+
+    window->count--;
+    if (pos != window->count) {
+        _heap_swap(window, pos, window->count);
+        _heap_sift_down(window, pos);
+        _heap_sift_up(window, pos);
+    }
+
+    memset(slot, 0, sizeof(QcloudIotPubInfo));
+}
+
+int qcloud_iot_mqtt_pub_window_init(QcloudIotPubWindow *window, uint16_t size)
+{
+    uint16_t i;
+    uint32_t index_len = 1;
+
+    POINTER_SANITY_CHECK(window, QCLOUD_ERR_INVAL);
+
+    if (0 == size) {
+        size = MAX_REPUB_NUM;
+    } else if (size > MAX_PUB_WINDOW_SIZE) {
+        Log_w("publish window size %u exceeds, use %u", size, MAX_PUB_WINDOW_SIZE);
+        size = MAX_PUB_WINDOW_SIZE;
+    }
+
+    while (index_len < 2 * (uint32_t)size) {
+        index_len <<= 1;
+    }
+
+    window->slots = (QcloudIotPubInfo *)HAL_Malloc(sizeof(QcloudIotPubInfo) * size);
+    window->heap  = (uint16_t *)HAL_Malloc(sizeof(uint16_t) * size);
+    window->index = (uint16_t *)HAL_Malloc(sizeof(uint16_t) * index_len);
+    if (NULL == window->slots || NULL == window->heap || NULL == window->index) {
+        Log_e("memory malloc failed!");
+        qcloud_iot_mqtt_pub_window_deinit(window);
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    memset(window->slots, 0, sizeof(QcloudIotPubInfo) * size);
+    memset(window->index, 0, sizeof(uint16_t) * index_len);
+    window->index_mask = index_len - 1;
+    /* heap[0, count) is the deadline heap, heap[count, size) holds the free slots */
+    for (i = 0; i < size; i++) {
+        window->heap[i] = i;
+    }
+    window->size  = size;
+    window->count = 0;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+void qcloud_iot_mqtt_pub_window_deinit(QcloudIotPubWindow *window)
+{
+    POINTER_SANITY_CHECK_RTN(window);
+
+    HAL_Free(window->slots);
+    HAL_Free(window->heap);
+    HAL_Free(window->index);
+    window->slots      = NULL;
+    window->heap       = NULL;
+    window->index      = NULL;
+    window->index_mask = 0;
+    window->size       = 0;
+    window->count      = 0;
+}
+
+static QcloudIotPubInfo *_slot_find(QcloudIotPubWindow *window, uint16_t msg_id)
+{
+    int pos = _index_find(window, msg_id);
+
+    return (pos < 0) ? NULL : &window->slots[window->index[pos] - 1];
+}
+
+QcloudIotPubInfo *qcloud_iot_mqtt_pub_window_push(QcloudIotPubWindow *window, uint16_t msg_id, uint32_t timeout_ms)
+{
+    QcloudIotPubInfo *slot;
+
+    if (window->count >= window->size) {
+        Log_e("publish window full, %u publish waiting for puback", window->count);
+        return NULL;
+    }
+
+    /* packet id wrapped around onto a publish still waiting */
+    if (0 == msg_id || NULL != _slot_find(window, msg_id)) {
+        Log_e("packet id %u is already waiting for puback", msg_id);
+        return NULL;
+    }
+
+    slot           = &window->slots[window->heap[window->count]];
+    slot->msg_id   = msg_id;
+    slot->deadline = HAL_GetTimeMs() + timeout_ms;
+    slot->heap_pos = window->count++;
+    _index_insert(window, msg_id, slot - window->slots);
+    _heap_sift_up(window, slot->heap_pos);
+
+    return slot;
+}
+
+bool qcloud_iot_mqtt_pub_window_remove(QcloudIotPubWindow *window, uint16_t msg_id, QcloudIotPubInfo *info)
+{
+    QcloudIotPubInfo *slot;
+
+    if (0 == msg_id || NULL == (slot = _slot_find(window, msg_id))) {
+        return false;
+    }
+
+    _slot_release(window, slot, info);
+
+    return true;
+}
+
+bool qcloud_iot_mqtt_pub_window_pop_expired(QcloudIotPubWindow *window, QcloudIotPubInfo *info)
+{
+    QcloudIotPubInfo *slot;
+
+    if (0 == window->count) {
+        return false;
+    }
+
+    slot = &window->slots[window->heap[0]];
+    if (DEADLINE_BEFORE(HAL_GetTimeMs(), slot->deadline)) {
+        return false;
+    }
+
+    _slot_release(window, slot, info);
+
+    return true;
+}
+
+bool qcloud_iot_mqtt_pub_window_next_deadline(QcloudIotPubWindow *window, uint32_t *deadline)
+{
+    if (0 == window->count) {
+        return false;
+    }
+
+    *deadline = window->slots[window->heap[0]].deadline;
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,7 +22,6 @@ extern "C" {
 #include <string.h>
 
 #include "mqtt_client.h"
-#include "utils_list.h"
 
 /**
  * @param mqttstring the MQTTString structure into which the data is to be read
@@ -75,54 +74,27 @@ static uint32_t _get_publish_packet_len(uint8_t qos, char *topicName, size_t pay
     return (uint32_t)len;
 }
 
-static int _mask_push_pubInfo_to(Qcloud_IoT_Client *c, int len, unsigned short msgId, ListNode **node)
+static int _mask_push_pubInfo_to(Qcloud_IoT_Client *c, unsigned short msgId, OnPublishAckHandler ack_handler,
+                                 void *user_data)
 {
     IOT_FUNC_ENTRY;
 
-    if (!c || !node) {
+    if (!c) {
         Log_e("invalid parameters!");
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_PUSH_TO_LIST_FAILED);
     }
 
-    if ((len < 0) || (len > c->write_buf_size)) {
-        Log_e("the param of len is error!");
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
-    }
-
     HAL_MutexLock(c->lock_list_pub);
 
-    if (c->list_pub_wait_ack->len >= MAX_REPUB_NUM) {
-        HAL_MutexUnlock(c->lock_list_pub);
-        Log_e("more than %u elements in republish list. List overflow!", c->list_pub_wait_ack->len);
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
-    }
-
-    QcloudIotPubInfo *repubInfo = (QcloudIotPubInfo *)HAL_Malloc(sizeof(QcloudIotPubInfo) + len);
+    QcloudIotPubInfo *repubInfo = qcloud_iot_mqtt_pub_window_push(&c->pub_wait_ack, msgId, c->command_timeout_ms);
     if (NULL == repubInfo) {
         HAL_MutexUnlock(c->lock_list_pub);
-        Log_e("memory malloc failed!");
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
-    }
-
-    repubInfo->node_state = MQTT_NODE_STATE_NORMANL;
-    repubInfo->msg_id     = msgId;
-    repubInfo->len        = len;
-    InitTimer(&repubInfo->pub_start_time);
-    countdown_ms(&repubInfo->pub_start_time, c->command_timeout_ms);
-
-    repubInfo->buf = (unsigned char *)repubInfo + sizeof(QcloudIotPubInfo);
-
-    memcpy(repubInfo->buf, c->write_buf, len);
-
-    *node = list_node_new(repubInfo);
-    if (NULL == *node) {
-        HAL_MutexUnlock(c->lock_list_pub);
-        HAL_Free(repubInfo);
-        Log_e("list_node_new failed!");
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_PUSH_TO_LIST_FAILED);
     }
 
-    list_rpush(c->list_pub_wait_ack, *node);
+    /* only the puback is waited here, the packet is not resent so neither kept */
+    repubInfo->ack_handler   = ack_handler;
+    repubInfo->ack_user_data = user_data;
 
     HAL_MutexUnlock(c->lock_list_pub);
 
@@ -245,27 +217,24 @@ int serialize_pub_ack_packet(unsigned char *buf, size_t buf_len, MessageTypes pa
 }
 
 /**
- * Serializes the supplied publish data into the supplied buffer, ready for
- * sending
- * @param buf the buffer into which the packet will be serialized
+ * Serializes the fixed header and variable header of publish packet into the
+ * supplied buffer, the payload is sent from caller buffer directly
+ * @param buf the buffer into which the header will be serialized
  * @param buf_len the length in bytes of the supplied buffer
  * @param dup integer - the MQTT dup flag
  * @param qos integer - the MQTT QoS value
  * @param retained integer - the MQTT retained flag
  * @param packet_id integer - the MQTT packet identifier
  * @param topicName MQTTString - the MQTT topic in the publish
- * @param payload byte buffer - the MQTT publish payload
  * @param payload_len integer - the length of the MQTT payload
- * @return the length of the serialized data.  <= 0 indicates error
+ * @return the length of the serialized header.  <= 0 indicates error
  */
-static int _serialize_publish_packet(unsigned char *buf, size_t buf_len, uint8_t dup, QoS qos, uint8_t retained,
-                                     uint16_t packet_id, char *topicName, unsigned char *payload, size_t payload_len,
-                                     uint32_t *serialized_len)
+static int _serialize_publish_header(unsigned char *buf, size_t buf_len, uint8_t dup, QoS qos, uint8_t retained,
+                                     uint16_t packet_id, char *topicName, size_t payload_len, uint32_t *serialized_len)
 {
     IOT_FUNC_ENTRY;
     POINTER_SANITY_CHECK(buf, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(serialized_len, QCLOUD_ERR_INVAL);
-    POINTER_SANITY_CHECK(payload, QCLOUD_ERR_INVAL);
 
     unsigned char *ptr     = buf;
     unsigned char  header  = 0;
@@ -273,7 +242,7 @@ static int _serialize_publish_packet(unsigned char *buf, size_t buf_len, uint8_t
     int            rc;
 
     rem_len = _get_publish_packet_len(qos, topicName, payload_len);
-    if (get_mqtt_packet_len(rem_len) > buf_len) {
+    if (rem_len > MAX_PACKET_REM_LEN || get_mqtt_packet_len(rem_len) - payload_len > buf_len) {
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_BUF_TOO_SHORT);
     }
 
@@ -285,23 +254,20 @@ static int _serialize_publish_packet(unsigned char *buf, size_t buf_len, uint8_t
     mqtt_write_char(&ptr, header); /* write header */
 
     ptr += mqtt_write_packet_rem_len(ptr, rem_len); /* write remaining length */
-    ;
 
     mqtt_write_utf8_string(&ptr, topicName); /* Variable Header: Topic Name */
 
     if (qos > 0) {
-        mqtt_write_uint_16(&ptr, packet_id); /* Variable Header: Topic Name */
+        mqtt_write_uint_16(&ptr, packet_id); /* Variable Header: Packet Identifier */
     }
 
-    memcpy(ptr, payload, payload_len);
-    ptr += payload_len;
-
     *serialized_len = (uint32_t)(ptr - buf);
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
-int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams)
+static int _mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams,
+                         OnPublishAckHandler ack_handler, void *user_data)
 {
     IOT_FUNC_ENTRY;
 
@@ -312,8 +278,7 @@ int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, Publish
     Timer    timer;
     uint32_t len = 0;
     int      rc;
-
-    ListNode *node = NULL;
+    NetIovec iov[2];
 
     size_t topicLen = strlen(topicName);
     if (topicLen > MAX_SIZE_OF_CLOUD_TOPIC) {
@@ -350,16 +315,16 @@ int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, Publish
         }
     }
 
-    rc = _serialize_publish_packet(pClient->write_buf, pClient->write_buf_size, 0, pParams->qos, pParams->retained,
-                                   pParams->id, topicName, (unsigned char *)pParams->payload, pParams->payload_len,
-                                   &len);
+    /* write buffer holds the headers only, payload goes out from caller buffer */
+    rc = _serialize_publish_header(pClient->write_buf, pClient->write_buf_size, 0, pParams->qos, pParams->retained,
+                                   pParams->id, topicName, pParams->payload_len, &len);
     if (QCLOUD_RET_SUCCESS != rc) {
         HAL_MutexUnlock(pClient->lock_write_buf);
         IOT_FUNC_EXIT_RC(rc);
     }
 
     if (pParams->qos > QOS0) {
-        rc = _mask_push_pubInfo_to(pClient, len, pParams->id, &node);
+        rc = _mask_push_pubInfo_to(pClient, pParams->id, ack_handler, user_data);
         if (QCLOUD_RET_SUCCESS != rc) {
             Log_e("push publish into to pubInfolist failed!");
             HAL_MutexUnlock(pClient->lock_write_buf);
@@ -368,11 +333,15 @@ int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, Publish
     }
 
     /* send the publish packet */
-    rc = send_mqtt_packet(pClient, len, &timer);
+    iov[0].data = pClient->write_buf;
+    iov[0].len  = len;
+    iov[1].data = (const unsigned char *)pParams->payload;
+    iov[1].len  = pParams->payload_len;
+    rc          = send_mqtt_packet_iov(pClient, iov, 2, &timer);
     if (QCLOUD_RET_SUCCESS != rc) {
         if (pParams->qos > QOS0) {
             HAL_MutexLock(pClient->lock_list_pub);
-            list_remove(pClient->list_pub_wait_ack, node);
+            qcloud_iot_mqtt_pub_window_remove(&pClient->pub_wait_ack, pParams->id, NULL);
             HAL_MutexUnlock(pClient->lock_list_pub);
         }
 
@@ -385,6 +354,17 @@ int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, Publish
     IOT_FUNC_EXIT_RC(pParams->id);
 }
 
+int qcloud_iot_mqtt_publish(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams)
+{
+    return _mqtt_publish(pClient, topicName, pParams, NULL, NULL);
+}
+
+int qcloud_iot_mqtt_publish_async(Qcloud_IoT_Client *pClient, char *topicName, PublishParams *pParams,
+                                  OnPublishAckHandler ack_handler, void *user_data)
+{
+    return _mqtt_publish(pClient, topicName, pParams, ack_handler, user_data);
+}
+
 #ifdef __cplusplus
 }
 #endif
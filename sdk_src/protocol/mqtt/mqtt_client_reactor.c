@@ -0,0 +1,518 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2018-2020 THL A29 Limited, a Tencent company. All rights
+ reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "mqtt_client.h"
+
+#if defined(__linux__)
+
+/* max clients read in one round */
+#define MQTT_REACTOR_MAX_READY (64)
+
+/* interval to check timers of a client in connecting, unit: ms */
+#define MQTT_REACTOR_TICK_MS (100)
+
+/* max interval to check timers of a client, for the acks waited since last check, unit: ms */
+#define MQTT_REACTOR_MAX_CHECK_MS (1000)
+
+/* wrap around safe compare of HAL_GetTimeMs() values */
+#define DEADLINE_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+/* max packets read from one client in a row, the rest is left to next round */
+#define MQTT_REACTOR_MAX_PASSES (8)
+
+typedef struct MQTTReactor MQTTReactor;
+
+typedef struct {
+    MQTTReactor *      owner;        // reactor of this slot
+    Qcloud_IoT_Client *client;       // client driven, NULL for a free slot
+    int                fd;           // socket added to poller, -1 if none
+    bool               pending;      // stopped reading by MQTT_REACTOR_MAX_PASSES last round
+    uint32_t           pending_pos;  // position in pending list
+    uint32_t           due;          // HAL_GetTimeMs() value to check timers of client
+    uint32_t           heap_pos;     // position in timer heap
+} MQTTReactorSlot;
+
+struct MQTTReactor {
+    void *           lock;           // held by a round of run, and by add/remove
+    MQTTReactorSlot *driving;        // slot whose client is driven now, NULL if none
+    void *           poller;         // poller of client sockets
+    MQTTReactorSlot *slots;          // slot array, size entries
+    uint32_t *       free_slots;     // stack of free slot index
+    uint32_t         free_cnt;       // count of free slots
+    uint32_t         size;           // max clients
+    uint32_t *       pending_slots;  // slot index of pending clients, pending_cnt entries
+    uint32_t         pending_cnt;    // count of pending slots
+    uint32_t *       timer_heap;     // slot index min-heap by due, one entry per client
+    uint32_t         timer_cnt;      // count of clients in timer heap
+};
+
+/* reactor running a round on this thread, whose lock is held for the callbacks of its clients */
+static __thread MQTTReactor *sg_round_reactor = NULL;
+
+static void _reactor_lock(MQTTReactor *r)
+{
+    if (sg_round_reactor != r) {
+        HAL_MutexLock(r->lock);
+    }
+}
+
+static void _reactor_unlock(MQTTReactor *r)
+{
+    if (sg_round_reactor != r) {
+        HAL_MutexUnlock(r->lock);
+    }
+}
+
+/* follow the socket of client, which changes when reconnected */
+static void _reactor_sync_fd(MQTTReactor *r, MQTTReactorSlot *slot)
+{
+    int fd = network_get_fd(&slot->client->network_stack);
+
+    if (fd == slot->fd) {
+        return;
+    }
+
+    /* the old socket is closed when disconnected, so removed from poller by kernel already */
+    slot->fd = -1;
+    if (fd >= 0 && QCLOUD_RET_SUCCESS == HAL_PollerAdd(r->poller, fd, slot)) {
+        slot->fd = fd;
+    }
+}
+
+static void _reactor_set_pending(MQTTReactor *r, MQTTReactorSlot *slot, bool pending)
+{
+    uint32_t last;
+
+    if (slot->pending == pending) {
+        return;
+    }
+
+    slot->pending = pending;
+    if (pending) {
+        slot->pending_pos                 = r->pending_cnt;
+        r->pending_slots[r->pending_cnt++] = (uint32_t)(slot - r->slots);
+        return;
+    }
+
+    /* fill the hole with the last one */
+    last                                 = r->pending_slots[--r->pending_cnt];
+    r->pending_slots[slot->pending_pos]  = last;
+    r->slots[last].pending_pos           = slot->pending_pos;
+}
+
+static bool _timer_less(MQTTReactor *r, uint32_t i, uint32_t j)
+{
+    return DEADLINE_BEFORE(r->slots[r->timer_heap[i]].due, r->slots[r->timer_heap[j]].due);
+}
+
+static void _timer_swap(MQTTReactor *r, uint32_t i, uint32_t j)
+{
+    uint32_t tmp     = r->timer_heap[i];
+    r->timer_heap[i] = r->timer_heap[j];
+    r->timer_heap[j] = tmp;
+
+    r->slots[r->timer_heap[i]].heap_pos = i;
+    r->slots[r->timer_heap[j]].heap_pos = j;
+}
+
+static void _timer_sift(MQTTReactor *r, uint32_t pos)
+{
+    uint32_t child;
+
+    while (pos > 0 && _timer_less(r, pos, (pos - 1) / 2)) {
+        _timer_swap(r, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+
+    while ((child = 2 * pos + 1) < r->timer_cnt) {
+        if (child + 1 < r->timer_cnt && _timer_less(r, child + 1, child)) {
+            child++;
+        }
+        if (!_timer_less(r, child, pos)) {
+            break;
+        }
+        _timer_swap(r, pos, child);
+        pos = child;
+    }
+}
+
+static void _timer_add(MQTTReactor *r, MQTTReactorSlot *slot)
+{
+    slot->due                       = HAL_GetTimeMs();
+    slot->heap_pos                  = r->timer_cnt;
+    r->timer_heap[r->timer_cnt++]   = (uint32_t)(slot - r->slots);
+    _timer_sift(r, slot->heap_pos);
+}
+
+static void _timer_del(MQTTReactor *r, MQTTReactorSlot *slot)
+{
+    uint32_t pos = slot->heap_pos;
+
+    if (pos != --r->timer_cnt) {
+        _timer_swap(r, pos, r->timer_cnt);
+        _timer_sift(r, pos);
+    }
+}
+
+/* ms until the timers of client are due: keep alive, puback waiting or reconnect delay */
+static uint32_t _reactor_check_after(Qcloud_IoT_Client *pClient)
+{
+    uint32_t wait = MQTT_REACTOR_MAX_CHECK_MS;
+    uint32_t deadline;
+    bool     waiting;
+
+    if (!get_client_conn_state(pClient)) {
+        if (MQTT_CONNECT_IDLE != pClient->connect_step) {
+            return MQTT_REACTOR_TICK_MS;
+        }
+        return Min(wait, (uint32_t)Max(left_ms(&pClient->reconnect_delay_timer), 0));
+    }
+
+    if (0 != pClient->options.keep_alive_interval) {
+        wait = Min(wait, (uint32_t)Max(left_ms(&pClient->ping_timer), 0));
+    }
+
+    HAL_MutexLock(pClient->lock_list_pub);
+    waiting = qcloud_iot_mqtt_pub_window_next_deadline(&pClient->pub_wait_ack, &deadline);
+    HAL_MutexUnlock(pClient->lock_list_pub);
+    if (waiting) {
+        wait = DEADLINE_BEFORE(deadline, HAL_GetTimeMs()) ? 0 : Min(wait, deadline - HAL_GetTimeMs());
+    }
+
+    return wait;
+}
+
+/* put client back into timer heap at its next due, no sooner than this round */
+static void _reactor_reschedule(MQTTReactor *r, MQTTReactorSlot *slot)
+{
+    slot->due = HAL_GetTimeMs() + Max(_reactor_check_after(slot->client), 1);
+    _timer_sift(r, slot->heap_pos);
+}
+
+/* bytes staged behind the packet handled, or waiting in the socket (unknown counts as more) */
+static bool _reactor_has_more(Qcloud_IoT_Client *pClient)
+{
+    return pClient->read_buf_used > pClient->read_frame_len || 0 != network_readable(&pClient->network_stack);
+}
+
+/**
+ * @brief Run yield state machine of one client
+ *
+ * @param r         reactor
+ * @param slot      slot of the client
+ * @param readable  true to read the client, false to check its timers only
+ */
+static void _reactor_drive(MQTTReactor *r, MQTTReactorSlot *slot, bool readable)
+{
+    Qcloud_IoT_Client *pClient = slot->client;
+    Timer              timer;
+    uint8_t            packet_type;
+    int                pass = 0;
+    bool               more;
+    int                rc;
+
+    if (readable) {
+        _reactor_set_pending(r, slot, false);
+    }
+
+    /* same as yield, nothing to do when disconnected for good */
+    if (!get_client_conn_state(pClient) &&
+        (1 == pClient->was_manually_disconnected || 0 == pClient->options.auto_connect_enable ||
+         pClient->current_reconnect_wait_interval > MAX_RECONNECT_WAIT_INTERVAL)) {
+        _reactor_sync_fd(r, slot);
+        slot->due = HAL_GetTimeMs() + MQTT_REACTOR_MAX_CHECK_MS;
+        _timer_sift(r, slot->heap_pos);
+        return;
+    }
+
+    InitTimer(&timer);
+    countdown_ms(&timer, readable ? MQTT_REACTOR_READ_WAIT_MS : 0);
+    r->driving = slot;
+    do {
+        packet_type = 0;
+        rc          = qcloud_iot_mqtt_yield_once(pClient, &timer, readable, &packet_type);
+        /* later passes take only what has arrived, without waiting */
+        countdown_ms(&timer, 0);
+        more = readable && QCLOUD_RET_SUCCESS == rc && 0 != packet_type && _reactor_has_more(pClient);
+    } while (more && ++pass < MQTT_REACTOR_MAX_PASSES && NULL != slot->client);
+    r->driving = NULL;
+
+    /* removed by its own callback, the slot is freed only now that it is not used */
+    if (NULL == slot->client) {
+        r->free_slots[r->free_cnt++] = (uint32_t)(slot - r->slots);
+        return;
+    }
+
+    if (more) {
+        _reactor_set_pending(r, slot, true);
+    }
+
+    if (QCLOUD_RET_SUCCESS != rc && QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT != rc && QCLOUD_RET_MQTT_RECONNECTED != rc) {
+        Log_w("client %s yield failed: %d", pClient->device_info.device_name, rc);
+    }
+
+    _reactor_sync_fd(r, slot);
+    _reactor_reschedule(r, slot);
+}
+
+static void _reactor_free(MQTTReactor *r)
+{
+    if (NULL != r->poller) {
+        HAL_PollerDestroy(r->poller);
+    }
+    if (NULL != r->lock) {
+        HAL_MutexDestroy(r->lock);
+    }
+    HAL_Free(r->slots);
+    HAL_Free(r->free_slots);
+    HAL_Free(r->pending_slots);
+    HAL_Free(r->timer_heap);
+    HAL_Free(r);
+}
+
+void *IOT_MQTT_ReactorCreate(uint32_t max_clients)
+{
+    MQTTReactor *r;
+    uint32_t     i;
+
+    NUMBERIC_SANITY_CHECK(max_clients, NULL);
+
+    r = (MQTTReactor *)HAL_Malloc(sizeof(MQTTReactor));
+    if (NULL == r) {
+        Log_e("malloc reactor failed");
+        return NULL;
+    }
+    memset(r, 0, sizeof(MQTTReactor));
+
+    r->slots      = (MQTTReactorSlot *)HAL_Malloc(max_clients * sizeof(MQTTReactorSlot));
+    r->free_slots    = (uint32_t *)HAL_Malloc(max_clients * sizeof(uint32_t));
+    r->pending_slots = (uint32_t *)HAL_Malloc(max_clients * sizeof(uint32_t));
+    r->timer_heap    = (uint32_t *)HAL_Malloc(max_clients * sizeof(uint32_t));
+    if (NULL == r->slots || NULL == r->free_slots || NULL == r->pending_slots || NULL == r->timer_heap) {
+        Log_e("malloc reactor slots failed, max clients: %u", max_clients);
+        goto error;
+    }
+
+    if ((r->lock = HAL_MutexCreate()) == NULL) {
+        Log_e("create reactor lock failed");
+        goto error;
+    }
+
+    if ((r->poller = HAL_PollerCreate()) == NULL) {
+        Log_e("create reactor poller failed");
+        goto error;
+    }
+
+    /* free stack pops slot 0 first */
+    for (i = 0; i < max_clients; i++) {
+        r->slots[i].owner   = r;
+        r->slots[i].client  = NULL;
+        r->slots[i].fd      = -1;
+        r->slots[i].pending = false;
+        r->free_slots[i]    = max_clients - 1 - i;
+    }
+    r->free_cnt = max_clients;
+    r->size     = max_clients;
+
+    return r;
+
+error:
+    _reactor_free(r);
+    return NULL;
+}
+
+void IOT_MQTT_ReactorDestroy(void *reactor)
+{
+    POINTER_SANITY_CHECK_RTN(reactor);
+
+    MQTTReactor *r = (MQTTReactor *)reactor;
+    uint32_t     i;
+
+    HAL_MutexLock(r->lock);
+    for (i = 0; i < r->size; i++) {
+        if (NULL != r->slots[i].client) {
+            r->slots[i].client->reactor_slot = NULL;
+        }
+    }
+    HAL_MutexUnlock(r->lock);
+
+    _reactor_free(r);
+}
+
+int IOT_MQTT_ReactorAdd(void *reactor, void *pClient)
+{
+    POINTER_SANITY_CHECK(reactor, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
+
+    MQTTReactor *      r      = (MQTTReactor *)reactor;
+    Qcloud_IoT_Client *client = (Qcloud_IoT_Client *)pClient;
+    MQTTReactorSlot *  slot;
+
+    if (NULL != client->reactor_slot) {
+        Log_e("client is driven by reactor already");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+#ifdef MULTITHREAD_ENABLED
+    if (client->yield_thread_running) {
+        Log_e("client is driven by yield thread");
+        return QCLOUD_ERR_FAILURE;
+    }
+#endif
+
+    if (NULL == client->network_stack.get_fd) {
+        Log_e("network of client can not be polled");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    _reactor_lock(r);
+    if (0 == r->free_cnt) {
+        _reactor_unlock(r);
+        Log_e("reactor is full, max clients: %u", r->size);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    slot                 = &r->slots[r->free_slots[--r->free_cnt]];
+    slot->client         = client;
+    slot->fd             = -1;
+    slot->pending        = false;
+    client->reactor_slot = slot;
+    _reactor_sync_fd(r, slot);
+    _timer_add(r, slot);
+    _reactor_unlock(r);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+void qcloud_iot_mqtt_reactor_detach(Qcloud_IoT_Client *pClient)
+{
+    MQTTReactorSlot *slot = (MQTTReactorSlot *)pClient->reactor_slot;
+    MQTTReactor *    r;
+
+    if (NULL == slot) {
+        return;
+    }
+
+    r = slot->owner;
+    _reactor_lock(r);
+    /* only a socket still open is in poller */
+    if (slot->fd >= 0 && slot->fd == network_get_fd(&pClient->network_stack)) {
+        HAL_PollerDel(r->poller, slot->fd);
+    }
+    _reactor_set_pending(r, slot, false);
+    _timer_del(r, slot);
+    slot->client          = NULL;
+    slot->fd              = -1;
+    pClient->reactor_slot = NULL;
+    /* the slot being driven is freed after its client returns from callback */
+    if (slot != r->driving) {
+        r->free_slots[r->free_cnt++] = (uint32_t)(slot - r->slots);
+    }
+    _reactor_unlock(r);
+}
+
+int IOT_MQTT_ReactorRemove(void *reactor, void *pClient)
+{
+    POINTER_SANITY_CHECK(reactor, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
+
+    Qcloud_IoT_Client *client = (Qcloud_IoT_Client *)pClient;
+
+    if (NULL == client->reactor_slot || ((MQTTReactorSlot *)client->reactor_slot)->owner != reactor) {
+        Log_e("client is not driven by this reactor");
+        return QCLOUD_ERR_INVAL;
+    }
+
+    qcloud_iot_mqtt_reactor_detach(client);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int IOT_MQTT_ReactorRun(void *reactor, uint32_t timeout_ms)
+{
+    POINTER_SANITY_CHECK(reactor, QCLOUD_ERR_INVAL);
+
+    MQTTReactor *    r = (MQTTReactor *)reactor;
+    MQTTReactor *    outer;
+    MQTTReactorSlot *slot;
+    void *           ready[MQTT_REACTOR_MAX_READY];
+    uint32_t         now;
+    uint32_t         j;
+    int              cnt, i;
+
+    // no wait if some client is not drained, or till the earliest timer due
+    HAL_MutexLock(r->lock);
+    now = HAL_GetTimeMs();
+    if (r->pending_cnt > 0) {
+        timeout_ms = 0;
+    } else if (r->timer_cnt > 0) {
+        slot       = &r->slots[r->timer_heap[0]];
+        timeout_ms = DEADLINE_BEFORE(slot->due, now) ? 0 : Min(timeout_ms, slot->due - now);
+    }
+    HAL_MutexUnlock(r->lock);
+
+    cnt = HAL_PollerWait(r->poller, ready, MQTT_REACTOR_MAX_READY, timeout_ms);
+    if (cnt < 0) {
+        return cnt;
+    }
+
+    HAL_MutexLock(r->lock);
+    outer            = sg_round_reactor;
+    sg_round_reactor = r;
+
+    // 1. clients not drained last round, backward as a client left is filled by the last one
+    for (j = r->pending_cnt; j > 0; j--) {
+        if (j <= r->pending_cnt) {
+            _reactor_drive(r, &r->slots[r->pending_slots[j - 1]], true);
+        }
+    }
+
+    // 2. clients readable, slot may be removed or reused after waiting
+    for (i = 0; i < cnt; i++) {
+        slot = (MQTTReactorSlot *)ready[i];
+        if (NULL != slot->client) {
+            _reactor_drive(r, slot, true);
+        }
+    }
+
+    // 3. clients with timers due: ack timeout, keep alive and reconnect, each rescheduled after now
+    now = HAL_GetTimeMs();
+    while (r->timer_cnt > 0 && !DEADLINE_BEFORE(now, r->slots[r->timer_heap[0]].due)) {
+        _reactor_drive(r, &r->slots[r->timer_heap[0]], false);
+    }
+
+    sg_round_reactor = outer;
+    HAL_MutexUnlock(r->lock);
+
+    return cnt;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
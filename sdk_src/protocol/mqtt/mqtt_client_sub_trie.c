@@ -0,0 +1,354 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2018-2020 THL A29 Limited, a Tencent company. All rights
+ reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "mqtt_client.h"
+
+/* initial capacity of children array, doubled when used up */
+#define SUB_TRIE_MIN_CHILDREN 4
+
+static int _level_cmp(const char *a, uint16_t a_len, const char *b, uint16_t b_len)
+{
+    int rc = memcmp(a, b, Min(a_len, b_len));
+
+    return rc ? rc : (int)a_len - (int)b_len;
+}
+
+/* binary search in sorted children, return the index found or where to insert */
+static uint16_t _child_index(SubTopicNode *node, const char *level, uint16_t len, bool *found)
+{
+    uint16_t low = 0, high = node->child_cnt;
+    uint16_t mid;
+    int      rc;
+
+    *found = false;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        rc  = _level_cmp(node->children[mid]->level, node->children[mid]->level_len, level, len);
+        if (0 == rc) {
+            *found = true;
+            return mid;
+        }
+        if (rc < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static SubTopicNode *_node_new(SubTopicNode *parent, const char *level, uint16_t len)
+{
+    SubTopicNode *node = (SubTopicNode *)HAL_Malloc(sizeof(SubTopicNode) + len);
+    if (NULL == node) {
+        Log_e("memory malloc failed!");
+        return NULL;
+    }
+
+    memset(node, 0, sizeof(SubTopicNode));
+    node->parent    = parent;
+    node->level     = (char *)node + sizeof(SubTopicNode);
+    node->level_len = len;
+    memcpy(node->level, level, len);
+
+    return node;
+}
+
+static bool _is_plus(const char *level, uint16_t len)
+{
+    return 1 == len && '+' == level[0];
+}
+
+static bool _is_hash(const char *level, uint16_t len)
+{
+    return 1 == len && '#' == level[0];
+}
+
+static SubTopicNode *_child_get(SubTopicNode *node, const char *level, uint16_t len, bool create)
+{
+    SubTopicNode * child;
+    SubTopicNode **children;
+    uint16_t       idx;
+    bool           found;
+
+    if (_is_plus(level, len) || _is_hash(level, len)) {
+        SubTopicNode **wildcard = _is_plus(level, len) ? &node->plus : &node->hash;
+        if (NULL == *wildcard && create) {
+            *wildcard = _node_new(node, level, len);
+        }
+        return *wildcard;
+    }
+
+    idx = _child_index(node, level, len, &found);
+    if (found) {
+        return node->children[idx];
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    if (node->child_cnt == node->child_cap) {
+        uint16_t cap = node->child_cap ? node->child_cap * 2 : SUB_TRIE_MIN_CHILDREN;
+
+        children = (SubTopicNode **)HAL_Malloc(sizeof(SubTopicNode *) * cap);
+        if (NULL == children) {
+            Log_e("memory malloc failed!");
+            return NULL;
+        }
+        if (node->child_cnt) {
+            memcpy(children, node->children, sizeof(SubTopicNode *) * node->child_cnt);
+        }
+        HAL_Free(node->children);
+        node->children  = children;
+        node->child_cap = cap;
+    }
+
+    child = _node_new(node, level, len);
+    if (NULL == child) {
+        return NULL;
+    }
+
+    memmove(&node->children[idx + 1], &node->children[idx], sizeof(SubTopicNode *) * (node->child_cnt - idx));
+    node->children[idx] = child;
+    node->child_cnt++;
+
+    return child;
+}
+
+
+/* free the nodes left without subscription and lower level, from bottom up */
+static void _node_prune(SubTopicNode *node)
+{
+    SubTopicNode *parent;
+    uint16_t      idx;
+    bool          found;
+
+    while (NULL != (parent = node->parent) && NULL == node->handle.topic_filter && 0 == node->child_cnt &&
+           NULL == node->plus && NULL == node->hash) {
+        if (node == parent->plus) {
+            parent->plus = NULL;
+        } else if (node == parent->hash) {
+            parent->hash = NULL;
+        } else {
+            idx = _child_index(parent, node->level, node->level_len, &found);
+            memmove(&parent->children[idx], &parent->children[idx + 1],
+                    sizeof(SubTopicNode *) * (parent->child_cnt - idx - 1));
+            parent->child_cnt--;
+        }
+
+        HAL_Free(node->children);
+        HAL_Free(node);
+        node = parent;
+    }
+}
+
+/* walk the levels of topic filter, from root. on malloc failure when creating, the levels
+ * created for nothing are freed */
+static SubTopicNode *_node_lookup(SubTopicNode *root, const char *topic_filter, bool create)
+{
+    SubTopicNode *node = root;
+    SubTopicNode *child;
+    const char *  level, *sep;
+
+    level = topic_filter;
+    for (;;) {
+        sep   = strchr(level, '/');
+        child = _child_get(node, level, sep ? (uint16_t)(sep - level) : (uint16_t)strlen(level), create);
+        if (NULL == child) {
+            if (create) {
+                _node_prune(node);
+            }
+            return NULL;
+        }
+        if (NULL == sep) {
+            return child;
+        }
+        node  = child;
+        level = sep + 1;
+    }
+}
+
+static bool _is_deliverable(SubTopicNode *node)
+{
+    return NULL != node && NULL != node->handle.topic_filter &&
+           (NULL != node->handle.message_handler || NULL != node->handle.message_chunk_handler);
+}
+
+/* level is NULL when all levels of topic name are consumed */
+static SubTopicHandle *_node_match(SubTopicNode *node, const char *level, const char *end)
+{
+    SubTopicHandle *handle;
+    SubTopicNode *  child;
+    const char *    sep, *next;
+    uint16_t        len;
+
+    if (NULL == level) {
+        if (_is_deliverable(node)) {
+            return &node->handle;
+        }
+        /* "a/#" matches "a" as well */
+        return _is_deliverable(node->hash) ? &node->hash->handle : NULL;
+    }
+
+    sep  = memchr(level, '/', end - level);
+    len  = (uint16_t)(sep ? sep - level : end - level);
+    next = sep ? sep + 1 : NULL;
+
+    child = _child_get(node, level, len, false);
+    if (NULL != child && NULL != (handle = _node_match(child, next, end))) {
+        return handle;
+    }
+
+    if (NULL != node->plus && NULL != (handle = _node_match(node->plus, next, end))) {
+        return handle;
+    }
+
+    return _is_deliverable(node->hash) ? &node->hash->handle : NULL;
+}
+
+static int _node_foreach(SubTopicNode *node, SubTopicVisitor visitor, void *ctx)
+{
+    uint16_t i;
+    int      rc;
+
+    if (NULL == node) {
+        return 0;
+    }
+
+    if (NULL != node->handle.topic_filter && 0 != (rc = visitor(&node->handle, ctx))) {
+        return rc;
+    }
+
+    for (i = 0; i < node->child_cnt; i++) {
+        if (0 != (rc = _node_foreach(node->children[i], visitor, ctx))) {
+            return rc;
+        }
+    }
+
+    if (0 != (rc = _node_foreach(node->plus, visitor, ctx))) {
+        return rc;
+    }
+
+    return _node_foreach(node->hash, visitor, ctx);
+}
+
+static void _node_free(SubTopicNode *node)
+{
+    uint16_t i;
+
+    if (NULL == node) {
+        return;
+    }
+
+    for (i = 0; i < node->child_cnt; i++) {
+        _node_free(node->children[i]);
+    }
+    _node_free(node->plus);
+    _node_free(node->hash);
+
+    HAL_Free((void *)node->handle.topic_filter);
+    HAL_Free(node->children);
+    if (NULL != node->parent) {
+        HAL_Free(node);
+    }
+}
+
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_add(SubTopicNode *root, SubTopicHandle *handle)
+{
+    POINTER_SANITY_CHECK(root, NULL);
+    POINTER_SANITY_CHECK(handle, NULL);
+    STRING_PTR_SANITY_CHECK(handle->topic_filter, NULL);
+
+    SubTopicNode *node = _node_lookup(root, handle->topic_filter, true);
+    if (NULL == node) {
+        return NULL;
+    }
+
+    if (NULL == node->handle.topic_filter) {
+        node->handle = *handle;
+    }
+
+    return &node->handle;
+}
+
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_find(SubTopicNode *root, const char *topic_filter)
+{
+    POINTER_SANITY_CHECK(root, NULL);
+    STRING_PTR_SANITY_CHECK(topic_filter, NULL);
+
+    SubTopicNode *node = _node_lookup(root, topic_filter, false);
+
+    return (NULL != node && NULL != node->handle.topic_filter) ? &node->handle : NULL;
+}
+
+SubTopicHandle *qcloud_iot_mqtt_sub_trie_match(SubTopicNode *root, const char *topic_name, size_t topic_len)
+{
+    POINTER_SANITY_CHECK(root, NULL);
+    POINTER_SANITY_CHECK(topic_name, NULL);
+
+    return _node_match(root, topic_name, topic_name + topic_len);
+}
+
+bool qcloud_iot_mqtt_sub_trie_remove(SubTopicNode *root, const char *topic_filter, SubTopicHandle *removed)
+{
+    POINTER_SANITY_CHECK(root, false);
+    STRING_PTR_SANITY_CHECK(topic_filter, false);
+
+    SubTopicNode *node = _node_lookup(root, topic_filter, false);
+    if (NULL == node || NULL == node->handle.topic_filter) {
+        return false;
+    }
+
+    if (NULL != removed) {
+        *removed = node->handle;
+    }
+    memset(&node->handle, 0, sizeof(SubTopicHandle));
+    _node_prune(node);
+
+    return true;
+}
+
+int qcloud_iot_mqtt_sub_trie_foreach(SubTopicNode *root, SubTopicVisitor visitor, void *ctx)
+{
+    POINTER_SANITY_CHECK(root, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(visitor, QCLOUD_ERR_INVAL);
+
+    return _node_foreach(root, visitor, ctx);
+}
+
+void qcloud_iot_mqtt_sub_trie_clear(SubTopicNode *root)
+{
+    POINTER_SANITY_CHECK_RTN(root);
+
+    _node_free(root);
+    memset(root, 0, sizeof(SubTopicNode));
+}
+
+#ifdef __cplusplus
+}
+#endif
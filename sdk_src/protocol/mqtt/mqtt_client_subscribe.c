@@ -156,11 +156,12 @@ int qcloud_iot_mqtt_subscribe(Qcloud_IoT_Client *pClient, char *topicFilter, Sub
 
     /* add node into sub ack wait list */
     SubTopicHandle sub_handle;
-    sub_handle.topic_filter      = topic_filter_stored;
-    sub_handle.message_handler   = pParams->on_message_handler;
-    sub_handle.sub_event_handler = pParams->on_sub_event_handler;
-    sub_handle.qos               = pParams->qos;
-    sub_handle.handler_user_data = pParams->user_data;
+    sub_handle.topic_filter          = topic_filter_stored;
+    sub_handle.message_handler       = pParams->on_message_handler;
+    sub_handle.sub_event_handler     = pParams->on_sub_event_handler;
+    sub_handle.qos                   = pParams->qos;
+    sub_handle.handler_user_data     = pParams->user_data;
+    sub_handle.message_chunk_handler = pParams->on_message_chunk_handler;
 
     rc = push_sub_info_to(pClient, len, (unsigned int)packet_id, SUBSCRIBE, &sub_handle, &node);
     if (QCLOUD_RET_SUCCESS != rc) {
@@ -187,43 +188,135 @@ int qcloud_iot_mqtt_subscribe(Qcloud_IoT_Client *pClient, char *topicFilter, Sub
     IOT_FUNC_EXIT_RC(packet_id);
 }
 
-int qcloud_iot_mqtt_resubscribe(Qcloud_IoT_Client *pClient)
+/* subscriptions copied out of trie, so resubscribe runs without lock_generic */
+typedef struct {
+    SubTopicHandle *handles;
+    int             count;
+    int             cap;
+} ResubscribeList;
+
+static int _resubscribe_collect(SubTopicHandle *handle, void *ctx)
 {
-    IOT_FUNC_ENTRY;
-    int rc;
+    ResubscribeList *list = (ResubscribeList *)ctx;
+    SubTopicHandle * handles;
+    char *           topic_filter;
 
-    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
+    if (list->count == list->cap) {
+        int cap = list->cap ? list->cap * 2 : MAX_SUB_WAIT_ACK_NUM;
 
-    uint32_t        itr   = 0;
-    char *          topic = NULL;
+        handles = (SubTopicHandle *)HAL_Malloc(sizeof(SubTopicHandle) * cap);
+        if (NULL == handles) {
+            Log_e("memory malloc failed!");
+            return QCLOUD_ERR_MALLOC;
+        }
+        if (list->count) {
+            memcpy(handles, list->handles, sizeof(SubTopicHandle) * list->count);
+        }
+        HAL_Free(list->handles);
+        list->handles = handles;
+        list->cap     = cap;
+    }
+
+    topic_filter = (char *)HAL_Malloc(strlen(handle->topic_filter) + 1);
+    if (NULL == topic_filter) {
+        Log_e("memory malloc failed!");
+        return QCLOUD_ERR_MALLOC;
+    }
+    strcpy(topic_filter, handle->topic_filter);
+
+    list->handles[list->count]              = *handle;
+    list->handles[list->count].topic_filter = topic_filter;
+    list->count++;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static bool _is_sub_wait_ack_full(Qcloud_IoT_Client *pClient)
+{
+    bool full;
+
+    HAL_MutexLock(pClient->lock_list_sub);
+    full = pClient->list_sub_wait_ack->len >= MAX_SUB_WAIT_ACK_NUM;
+    HAL_MutexUnlock(pClient->lock_list_sub);
+
+    return full;
+}
+
+/* read SUBACK until the ack waiting list has room, the ones not back in time are expired */
+static int _resubscribe_wait_window(Qcloud_IoT_Client *pClient)
+{
+    Timer timer;
+    int   rc = QCLOUD_RET_SUCCESS;
+
+    InitTimer(&timer);
+    countdown_ms(&timer, pClient->command_timeout_ms);
+
+    while (_is_sub_wait_ack_full(pClient) && !expired(&timer)) {
+        rc = wait_for_read(pClient, SUBACK, &timer, QOS0);
+        if (QCLOUD_RET_SUCCESS != rc && QCLOUD_ERR_MQTT_REQUEST_TIMEOUT != rc) {
+            return rc;
+        }
+    }
+
+    if (_is_sub_wait_ack_full(pClient)) {
+        qcloud_iot_mqtt_sub_info_proc(pClient);
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static void _resubscribe_topic(Qcloud_IoT_Client *pClient, SubTopicHandle *handle)
+{
+    int             rc;
     SubscribeParams temp_param;
 
-    if (NULL == pClient) {
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+    temp_param.on_message_handler       = handle->message_handler;
+    temp_param.on_sub_event_handler     = handle->sub_event_handler;
+    temp_param.qos                      = handle->qos;
+    temp_param.user_data                = handle->handler_user_data;
+    temp_param.on_message_chunk_handler = handle->message_chunk_handler;
+
+    rc = qcloud_iot_mqtt_subscribe(pClient, (char *)handle->topic_filter, &temp_param);
+    if (rc < 0) {
+        Log_e("resubscribe failed %d, topic: %s", rc, handle->topic_filter);
+        /* go on with other topics, the subscriber could subscribe again */
+        if (NULL != handle->sub_event_handler) {
+            handle->sub_event_handler(pClient, MQTT_EVENT_SUBCRIBE_NACK, handle->handler_user_data);
+        }
     }
+}
+
+int qcloud_iot_mqtt_resubscribe(Qcloud_IoT_Client *pClient)
+{
+    IOT_FUNC_ENTRY;
+    int             rc;
+    int             i;
+    ResubscribeList list = {NULL, 0, 0};
+
+    POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
 
     if (!get_client_conn_state(pClient)) {
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NO_CONN);
     }
 
-    for (itr = 0; itr < MAX_MESSAGE_HANDLERS; itr++) {
-        topic = (char *)pClient->sub_handles[itr].topic_filter;
-        if (topic == NULL) {
-            continue;
-        }
-        temp_param.on_message_handler   = pClient->sub_handles[itr].message_handler;
-        temp_param.on_sub_event_handler = pClient->sub_handles[itr].sub_event_handler;
-        temp_param.qos                  = pClient->sub_handles[itr].qos;
-        temp_param.user_data            = pClient->sub_handles[itr].handler_user_data;
-
-        rc = qcloud_iot_mqtt_subscribe(pClient, topic, &temp_param);
-        if (rc < 0) {
-            Log_e("resubscribe failed %d, topic: %s", rc, topic);
-            IOT_FUNC_EXIT_RC(rc);
+    HAL_MutexLock(pClient->lock_generic);
+    rc = qcloud_iot_mqtt_sub_trie_foreach(&pClient->sub_trie, _resubscribe_collect, &list);
+    HAL_MutexUnlock(pClient->lock_generic);
+
+    /* SUBSCRIBE is sent in windows of MAX_SUB_WAIT_ACK_NUM, SUBACK drained in between */
+    for (i = 0; QCLOUD_RET_SUCCESS == rc && i < list.count; i++) {
+        rc = _resubscribe_wait_window(pClient);
+        if (QCLOUD_RET_SUCCESS == rc) {
+            _resubscribe_topic(pClient, &list.handles[i]);
         }
     }
 
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    for (i = 0; i < list.count; i++) {
+        HAL_Free((void *)list.handles[i].topic_filter);
+    }
+    HAL_Free(list.handles);
+
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 bool qcloud_iot_mqtt_is_sub_ready(Qcloud_IoT_Client *pClient, char *topicFilter)
@@ -237,18 +330,12 @@ bool qcloud_iot_mqtt_is_sub_ready(Qcloud_IoT_Client *pClient, char *topicFilter)
         return false;
     }
 
-    int i = 0;
+    bool ready;
     HAL_MutexLock(pClient->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((pClient->sub_handles[i].topic_filter != NULL &&
-             !strcmp(pClient->sub_handles[i].topic_filter, topicFilter)) ||
-            strstr(topicFilter, "/#") != NULL || strstr(topicFilter, "/+") != NULL) {
-            HAL_MutexUnlock(pClient->lock_generic);
-            return true;
-        }
-    }
+    ready = NULL != qcloud_iot_mqtt_sub_trie_find(&pClient->sub_trie, topicFilter) ||
+            strstr(topicFilter, "/#") != NULL || strstr(topicFilter, "/+") != NULL;
     HAL_MutexUnlock(pClient->lock_generic);
-    return false;
+    return ready;
 }
 
 #ifdef __cplusplus
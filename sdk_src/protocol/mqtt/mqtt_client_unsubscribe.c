@@ -102,11 +102,11 @@ int qcloud_iot_mqtt_unsubscribe(Qcloud_IoT_Client *pClient, char *topicFilter)
     POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
     STRING_PTR_SANITY_CHECK(topicFilter, QCLOUD_ERR_INVAL);
 
-    int      i = 0;
-    Timer    timer;
-    uint32_t len          = 0;
-    uint16_t packet_id    = 0;
-    bool     suber_exists = false;
+    Timer          timer;
+    uint32_t       len          = 0;
+    uint16_t       packet_id    = 0;
+    bool           suber_exists = false;
+    SubTopicHandle removed;
 
     ListNode *node = NULL;
 
@@ -115,28 +115,20 @@ int qcloud_iot_mqtt_unsubscribe(Qcloud_IoT_Client *pClient, char *topicFilter)
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MAX_TOPIC_LENGTH);
     }
 
-    /* Remove from message handler array */
+    /* Remove from subscription trie */
     HAL_MutexLock(pClient->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((pClient->sub_handles[i].topic_filter != NULL &&
-             !strcmp(pClient->sub_handles[i].topic_filter, topicFilter)) ||
-            strstr(topicFilter, "/#") != NULL || strstr(topicFilter, "/+") != NULL) {
-            /* notify this event to topic subscriber */
-            if (NULL != pClient->sub_handles[i].sub_event_handler)
-                pClient->sub_handles[i].sub_event_handler(pClient, MQTT_EVENT_UNSUBSCRIBE,
-                                                          pClient->sub_handles[i].handler_user_data);
-
-            /* Free the topic filter malloced in qcloud_iot_mqtt_subscribe */
-            HAL_Free((void *)pClient->sub_handles[i].topic_filter);
-            pClient->sub_handles[i].topic_filter = NULL;
-
-            /* We don't want to break here, if the same topic is registered
-             * with 2 callbacks. Unlikely scenario */
-            suber_exists = true;
-        }
-    }
+    suber_exists = qcloud_iot_mqtt_sub_trie_remove(&pClient->sub_trie, topicFilter, &removed);
     HAL_MutexUnlock(pClient->lock_generic);
 
+    if (suber_exists) {
+        /* notify this event to topic subscriber */
+        if (NULL != removed.sub_event_handler)
+            removed.sub_event_handler(pClient, MQTT_EVENT_UNSUBSCRIBE, removed.handler_user_data);
+
+        /* Free the topic filter malloced in qcloud_iot_mqtt_subscribe */
+        HAL_Free((void *)removed.topic_filter);
+    }
+
     if (suber_exists == false) {
         Log_e("subscription does not exists: %s", topicFilter);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_UNSUB_FAIL);
@@ -169,10 +161,8 @@ int qcloud_iot_mqtt_unsubscribe(Qcloud_IoT_Client *pClient, char *topicFilter)
     }
 
     SubTopicHandle sub_handle;
-    sub_handle.topic_filter      = topic_filter_stored;
-    sub_handle.sub_event_handler = NULL;
-    sub_handle.message_handler   = NULL;
-    sub_handle.handler_user_data = NULL;
+    memset(&sub_handle, 0, sizeof(SubTopicHandle));
+    sub_handle.topic_filter = topic_filter_stored;
 
     rc = push_sub_info_to(pClient, len, (unsigned int)packet_id, UNSUBSCRIBE, &sub_handle, &node);
     if (QCLOUD_RET_SUCCESS != rc) {
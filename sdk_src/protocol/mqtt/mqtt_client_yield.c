@@ -95,8 +95,8 @@ static int _handle_reconnect(Qcloud_IoT_Client *pClient)
     int8_t isPhysicalLayerConnected = 1;
     int    rc                       = QCLOUD_RET_MQTT_RECONNECTED;
 
-    // reconnect control by delay timer (increase interval exponentially )
-    if (!expired(&(pClient->reconnect_delay_timer))) {
+    // reconnect control by delay timer (increase interval exponentially ), unless a connect is in progress
+    if (MQTT_CONNECT_IDLE == pClient->connect_step && !expired(&(pClient->reconnect_delay_timer))) {
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT);
     }
 
@@ -107,7 +107,10 @@ static int _handle_reconnect(Qcloud_IoT_Client *pClient)
 
     if (isPhysicalLayerConnected) {
         rc = qcloud_iot_mqtt_attempt_reconnect(pClient);
-        if (rc == QCLOUD_RET_MQTT_RECONNECTED) {
+        if (rc == QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT) {
+            // connect in progress step by step, come back on next yield
+            IOT_FUNC_EXIT_RC(rc);
+        } else if (rc == QCLOUD_RET_MQTT_RECONNECTED) {
             Log_e("attempt to reconnect success.");
             _reconnect_callback(pClient);
 #ifdef LOG_UPLOAD
@@ -202,6 +205,54 @@ static int _mqtt_keep_alive(Qcloud_IoT_Client *pClient)
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+int qcloud_iot_mqtt_yield_once(Qcloud_IoT_Client *pClient, Timer *timer, bool read_packet, uint8_t *packet_type)
+{
+    IOT_FUNC_ENTRY;
+
+    int rc = QCLOUD_RET_SUCCESS;
+
+    if (!get_client_conn_state(pClient)) {
+        if (pClient->current_reconnect_wait_interval > MAX_RECONNECT_WAIT_INTERVAL) {
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_RECONNECT_TIMEOUT);
+        }
+        rc = _handle_reconnect(pClient);
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    if (read_packet) {
+        rc = cycle_for_read(pClient, timer, packet_type, QOS0);
+    }
+
+    if (rc == QCLOUD_RET_SUCCESS) {
+        /* check list of wait publish ACK to remove node that is ACKED or timeout */
+        qcloud_iot_mqtt_pub_info_proc(pClient);
+
+        /* check list of wait subscribe(or unsubscribe) ACK to remove node that is ACKED or timeout */
+        qcloud_iot_mqtt_sub_info_proc(pClient);
+
+        rc = _mqtt_keep_alive(pClient);
+    } else if (rc == QCLOUD_ERR_SSL_READ_TIMEOUT || rc == QCLOUD_ERR_SSL_READ || rc == QCLOUD_ERR_TCP_PEER_SHUTDOWN ||
+               rc == QCLOUD_ERR_TCP_READ_FAIL) {
+        Log_e("network read failed, rc: %d. MQTT Disconnect.", rc);
+        rc = _handle_disconnect(pClient);
+    }
+
+    if (rc == QCLOUD_ERR_MQTT_NO_CONN) {
+        pClient->counter_network_disconnected++;
+
+        if (pClient->options.auto_connect_enable != 1) {
+            IOT_FUNC_EXIT_RC(rc);
+        }
+        pClient->current_reconnect_wait_interval = _get_random_interval();
+        countdown_ms(&(pClient->reconnect_delay_timer), pClient->current_reconnect_wait_interval);
+
+        // reconnect timeout
+        rc = QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT;
+    }
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
 /**
  * @brief Check connection and keep alive state, read/handle MQTT message in synchronized way
  *
@@ -237,44 +288,9 @@ int qcloud_iot_mqtt_yield(Qcloud_IoT_Client *pClient, uint32_t timeout_ms)
 
     // 3. main loop for packet reading/handling and keep alive maintainance
     while (!expired(&timer)) {
-        if (!get_client_conn_state(pClient)) {
-            if (pClient->current_reconnect_wait_interval > MAX_RECONNECT_WAIT_INTERVAL) {
-                rc = QCLOUD_ERR_MQTT_RECONNECT_TIMEOUT;
-                break;
-            }
-            rc = _handle_reconnect(pClient);
-
-            continue;
-        }
-
-        rc = cycle_for_read(pClient, &timer, &packet_type, QOS0);
-
-        if (rc == QCLOUD_RET_SUCCESS) {
-            /* check list of wait publish ACK to remove node that is ACKED or timeout */
-            qcloud_iot_mqtt_pub_info_proc(pClient);
-
-            /* check list of wait subscribe(or unsubscribe) ACK to remove node that is ACKED or timeout */
-            qcloud_iot_mqtt_sub_info_proc(pClient);
-
-            rc = _mqtt_keep_alive(pClient);
-        } else if (rc == QCLOUD_ERR_SSL_READ_TIMEOUT || rc == QCLOUD_ERR_SSL_READ ||
-                   rc == QCLOUD_ERR_TCP_PEER_SHUTDOWN || rc == QCLOUD_ERR_TCP_READ_FAIL) {
-            Log_e("network read failed, rc: %d. MQTT Disconnect.", rc);
-            rc = _handle_disconnect(pClient);
-        }
-
-        if (rc == QCLOUD_ERR_MQTT_NO_CONN) {
-            pClient->counter_network_disconnected++;
-
-            if (pClient->options.auto_connect_enable != 1) {
-                break;
-            }
-            pClient->current_reconnect_wait_interval = _get_random_interval();
-            countdown_ms(&(pClient->reconnect_delay_timer), pClient->current_reconnect_wait_interval);
-
-            // reconnect timeout
-            rc = QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT;
-        } else if (rc != QCLOUD_RET_SUCCESS) {
+        rc = qcloud_iot_mqtt_yield_once(pClient, &timer, true, &packet_type);
+        if (rc != QCLOUD_RET_SUCCESS && rc != QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT &&
+            rc != QCLOUD_RET_MQTT_RECONNECTED) {
             break;
         }
     }
@@ -294,77 +310,31 @@ int qcloud_iot_mqtt_pub_info_proc(Qcloud_IoT_Client *pClient)
 
     POINTER_SANITY_CHECK(pClient, QCLOUD_ERR_INVAL);
 
-    HAL_MutexLock(pClient->lock_list_pub);
-    do {
-        if (0 == pClient->list_pub_wait_ack->len) {
-            break;
-        }
+    QcloudIotPubInfo pub_info;
+    bool             timeout;
 
-        ListIterator *iter;
-        ListNode *    node      = NULL;
-        ListNode *    temp_node = NULL;
+    /* deadline heap gives the expired ones first, so stop at the first one still waiting */
+    while (pClient->is_connected) {
+        HAL_MutexLock(pClient->lock_list_pub);
+        timeout = qcloud_iot_mqtt_pub_window_pop_expired(&pClient->pub_wait_ack, &pub_info);
+        HAL_MutexUnlock(pClient->lock_list_pub);
 
-        if (NULL == (iter = list_iterator_new(pClient->list_pub_wait_ack, LIST_TAIL))) {
-            Log_e("new list failed");
+        if (!timeout) {
             break;
         }
 
-        for (;;) {
-            node = list_iterator_next(iter);
-
-            if (NULL != temp_node) {
-                list_remove(pClient->list_pub_wait_ack, temp_node);
-                temp_node = NULL;
-            }
-
-            if (NULL == node) {
-                break; /* end of list */
-            }
-
-            QcloudIotPubInfo *repubInfo = (QcloudIotPubInfo *)node->val;
-            if (NULL == repubInfo) {
-                Log_e("node's value is invalid!");
-                temp_node = node;
-                continue;
-            }
-
-            /* remove invalid node */
-            if (MQTT_NODE_STATE_INVALID == repubInfo->node_state) {
-                temp_node = node;
-                continue;
-            }
-
-            if (!pClient->is_connected) {
-                continue;
-            }
-
-            /* check the request if timeout or not */
-            if (left_ms(&repubInfo->pub_start_time) > 0) {
-                continue;
-            }
-
-            HAL_MutexUnlock(pClient->lock_list_pub);
-            /* If wait ACK timeout, remove the node from list */
-            /* It is up to user to do republishing or not */
-            temp_node = node;
-
-            countdown_ms(&repubInfo->pub_start_time, pClient->command_timeout_ms);
-            HAL_MutexLock(pClient->lock_list_pub);
-
-            /* notify timeout event */
-            if (NULL != pClient->event_handle.h_fp) {
-                MQTTEventMsg msg;
-                msg.event_type = MQTT_EVENT_PUBLISH_TIMEOUT;
-                msg.msg        = (void *)(uintptr_t)repubInfo->msg_id;
-                pClient->event_handle.h_fp(pClient, pClient->event_handle.context, &msg);
-            }
+        /* It is up to user to do republishing or not */
+        if (NULL != pClient->event_handle.h_fp) {
+            MQTTEventMsg msg;
+            msg.event_type = MQTT_EVENT_PUBLISH_TIMEOUT;
+            msg.msg        = (void *)(uintptr_t)pub_info.msg_id;
+            pClient->event_handle.h_fp(pClient, pClient->event_handle.context, &msg);
         }
 
-        list_iterator_destroy(iter);
-
-    } while (0);
-
-    HAL_MutexUnlock(pClient->lock_list_pub);
+        if (NULL != pub_info.ack_handler) {
+            pub_info.ack_handler(pClient, pub_info.msg_id, MQTT_EVENT_PUBLISH_TIMEOUT, pub_info.ack_user_data);
+        }
+    }
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
@@ -285,24 +285,12 @@ int IOT_Action_Remove(void *pTemplate, DeviceAction *pAction)
 }
 
 // Action post to server
-static int _iot_action_json_init(void *handle, char *jsonBuffer, size_t sizeOfBuffer, const char *pClientToken,
-                                 DeviceAction *pAction)
-{
-    POINTER_SANITY_CHECK(jsonBuffer, QCLOUD_ERR_INVAL);
-    int32_t rc_of_snprintf;
-    memset(jsonBuffer, 0, sizeOfBuffer);
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer, sizeOfBuffer, "{\"method\":\"%s\", \"clientToken\":\"%s\", ",
-                                  REPORT_ACTION, STRING_PTR_PRINT_SANITY_CHECK(pClientToken));
-
-    return check_snprintf_return(rc_of_snprintf, sizeOfBuffer);
-}
-
 static int _iot_construct_action_json(void *handle, char *jsonBuffer, size_t sizeOfBuffer, const char *pClientToken,
                                       DeviceAction *pAction, sReplyPara *replyPara)
 {
-    size_t               remain_size    = 0;
-    int32_t              rc_of_snprintf = 0;
+    JsonWriter           writer;
     uint8_t              i;
+    int                  rc;
     Qcloud_IoT_Template *ptemplate = (Qcloud_IoT_Template *)handle;
 
     POINTER_SANITY_CHECK(ptemplate, QCLOUD_ERR_INVAL);
@@ -310,33 +298,19 @@ static int _iot_construct_action_json(void *handle, char *jsonBuffer, size_t siz
     POINTER_SANITY_CHECK(pClientToken, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(pAction, QCLOUD_ERR_INVAL);
 
-    int rc = _iot_action_json_init(ptemplate, jsonBuffer, sizeOfBuffer, pClientToken, pAction);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        Log_e("event json init failed: %d", rc);
-        return rc;
-    }
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
-    rc_of_snprintf =
-        HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"code\":%d, \"status\":\"%s\", \"response\":{",
-                     replyPara->code, replyPara->status_msg);
-
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
+    json_writer_init(&writer, jsonBuffer, sizeOfBuffer);
+    json_writer_literal(&writer, "{\"method\":\"" REPORT_ACTION "\", \"clientToken\":");
+    json_writer_string(&writer, pClientToken);
+    json_writer_literal(&writer, ", \"code\":");
+    json_writer_int(&writer, replyPara->code);
+    json_writer_literal(&writer, ", \"status\":");
+    json_writer_string(&writer, replyPara->status_msg);
+    json_writer_literal(&writer, ", \"response\":{");
 
     DeviceProperty *pJsonNode = pAction->pOutput;
     for (i = 0; i < pAction->output_num; i++) {
         if (pJsonNode != NULL && pJsonNode->key != NULL) {
-            rc = template_put_json_node(jsonBuffer, remain_size, pJsonNode->key, pJsonNode->data, pJsonNode->type);
+            rc = template_put_json_node(&writer, pJsonNode->key, pJsonNode->data, pJsonNode->type);
 
             if (rc != QCLOUD_RET_SUCCESS) {
                 return rc;
@@ -347,24 +321,12 @@ static int _iot_construct_action_json(void *handle, char *jsonBuffer, size_t siz
         }
         pJsonNode++;
     }
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}");
-
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    json_writer_close(&writer, '}');
 
     // finish json
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) < 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "}");
+    json_writer_literal(&writer, "}");
 
-    return check_snprintf_return(rc_of_snprintf, remain_size);
+    return json_writer_finish(&writer);
 }
 
 static int _publish_action_to_cloud(void *c, char *pJsonDoc)
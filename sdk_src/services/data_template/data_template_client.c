@@ -226,36 +226,34 @@ static int _template_ConstructControlReply(char *jsonBuffer, size_t sizeOfBuffer
 {
     POINTER_SANITY_CHECK(jsonBuffer, QCLOUD_ERR_INVAL);
 
-    int     rc;
-    size_t  remain_size = 0;
-    int32_t rc_of_snprintf;
+    JsonWriter writer;
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer, remain_size, "{\"code\":%d, \"clientToken\":\"%s\",", replyPara->code,
-                                  get_control_clientToken());
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    json_writer_init(&writer, jsonBuffer, sizeOfBuffer);
+    json_writer_literal(&writer, "{\"code\":");
+    json_writer_int(&writer, replyPara->code);
+    json_writer_literal(&writer, ", \"clientToken\":");
+    json_writer_string(&writer, get_control_clientToken());
+    json_writer_literal(&writer, ",");
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
+    if (replyPara->status_msg[0] != '\0') {
+        json_writer_literal(&writer, "\"status\":");
+        json_writer_string(&writer, replyPara->status_msg);
     }
+    json_writer_close(&writer, '}');
 
-    if (strlen(replyPara->status_msg) > 0) {
-        rc_of_snprintf =
-            HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"status\":\"%s\"}", replyPara->status_msg);
-    } else {
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}");
-    }
-
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
+    return json_writer_finish(&writer);
+}
 
-    return rc;
+/**
+ * @brief open a JSON object with a new clientToken
+ */
+static void _put_client_token(JsonWriter *writer, Qcloud_IoT_Template *pTemplate)
+{
+    json_writer_literal(writer, "{\"clientToken\":\"");
+    json_writer_str(writer, pTemplate->device_info.product_id);
+    json_writer_literal(writer, "-");
+    json_writer_uint(writer, pTemplate->inner_data.token_num++);
+    json_writer_literal(writer, "\"");
 }
 
 static void _template_mqtt_event_handler(void *pclient, void *context, MQTTEventMsg *msg)
@@ -312,27 +310,18 @@ int IOT_Template_JSON_ConstructReportArray(void *pClient, char *jsonBuffer, size
     Qcloud_IoT_Template *pTemplate = (Qcloud_IoT_Template *)pClient;
     POINTER_SANITY_CHECK(pTemplate, QCLOUD_ERR_INVAL);
 
-    size_t  remain_size    = 0;
-    int32_t rc_of_snprintf = 0;
-    int     rc;
-    int8_t  i;
-
-    build_empty_json(&(pTemplate->inner_data.token_num), jsonBuffer, pTemplate->device_info.product_id);
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
+    JsonWriter writer;
+    int        rc;
+    int8_t     i;
 
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, ", \"params\":{");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    json_writer_init(&writer, jsonBuffer, sizeOfBuffer);
+    _put_client_token(&writer, pTemplate);
+    json_writer_literal(&writer, ", \"params\":{");
 
     for (i = 0; i < count; i++) {
         DeviceProperty *pJsonNode = pDeviceProperties[i];
         if (pJsonNode != NULL && pJsonNode->key != NULL) {
-            rc = put_json_node(jsonBuffer, remain_size, pJsonNode);
+            rc = put_json_node(&writer, pJsonNode);
 
             if (rc != QCLOUD_RET_SUCCESS) {
                 return rc;
@@ -342,11 +331,9 @@ int IOT_Template_JSON_ConstructReportArray(void *pClient, char *jsonBuffer, size
         }
     }
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}}");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
+    json_writer_close(&writer, '}');
+    json_writer_literal(&writer, "}");
+    rc = json_writer_finish(&writer);
 
     if (rc != QCLOUD_RET_SUCCESS) {
         Log_e("construct datatemplate report array failed: %d", rc);
@@ -472,79 +459,45 @@ int IOT_Template_JSON_ConstructSysInfo(void *pClient, char *jsonBuffer, size_t s
     Qcloud_IoT_Template *pTemplate = (Qcloud_IoT_Template *)pClient;
     POINTER_SANITY_CHECK(pTemplate, QCLOUD_ERR_INVAL);
 
-    size_t  remain_size    = 0;
-    int32_t rc_of_snprintf = 0;
-    int     rc;
-
-    build_empty_json(&(pTemplate->inner_data.token_num), jsonBuffer, pTemplate->device_info.product_id);
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
+    JsonWriter writer;
+    int        rc;
 
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, ", \"params\":{");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    json_writer_init(&writer, jsonBuffer, sizeOfBuffer);
+    _put_client_token(&writer, pTemplate);
+    json_writer_literal(&writer, ", \"params\":{");
 
     DeviceProperty *pJsonNode = pPlatInfo;
     while ((NULL != pJsonNode) && (NULL != pJsonNode->key)) {
-        rc = put_json_node(jsonBuffer, remain_size, pJsonNode);
+        rc = put_json_node(&writer, pJsonNode);
         if (rc != QCLOUD_RET_SUCCESS) {
             return rc;
         }
         pJsonNode++;
     }
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "},");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
     pJsonNode = pSelfInfo;
     if ((NULL == pJsonNode) || (NULL == pJsonNode->key)) {
         Log_d("No self define info");
         goto end;
     }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 2, remain_size, ", \"device_label\":{");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
 
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    // device_label is placed inside params, after the platform info
+    json_writer_literal(&writer, " \"device_label\":{");
 
     while ((NULL != pJsonNode) && (NULL != pJsonNode->key)) {
-        rc = put_json_node(jsonBuffer, remain_size, pJsonNode);
+        rc = put_json_node(&writer, pJsonNode);
         if (rc != QCLOUD_RET_SUCCESS) {
             return rc;
         }
         pJsonNode++;
     }
-
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}},");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+    json_writer_close(&writer, '}');
 
 end:
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}");
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
+    json_writer_close(&writer, '}');
+    json_writer_literal(&writer, "}");
 
-    return rc;
+    return json_writer_finish(&writer);
 }
 
 int IOT_Template_Report_SysInfo(void *pClient, char *pJsonDoc, size_t sizeOfBuffer, OnReplyCallback callback,
@@ -829,7 +782,7 @@ void *IOT_Template_Construct(TemplateInitParams *pParams, void *pMqttClient)
         return NULL;
     }
 
-    MQTTInitParams mqtt_init_params;
+    MQTTInitParams mqtt_init_params = DEFAULT_MQTTINIT_PARAMS;
     _copy_template_init_params_to_mqtt(&mqtt_init_params, pParams);
 
     mqtt_init_params.event_handle.h_fp    = _template_mqtt_event_handler;
@@ -24,8 +24,37 @@ extern "C" {
 
 #include "data_template_client_common.h"
 
+#include <string.h>
+
 #include "qcloud_iot_import.h"
 
+static uint32_t _property_key_hash(const char *key, int key_len)
+{
+    uint32_t hash = 2166136261u;  // FNV-1a
+    int      i;
+
+    for (i = 0; i < key_len; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619u;
+    }
+
+    return hash & (TEMPLATE_PROPERTY_HASH_SIZE - 1);
+}
+
+PropertyHandler *template_common_find_property(Qcloud_IoT_Template *pTemplate, const char *key, int key_len)
+{
+    PropertyHandler *property_handle = pTemplate->inner_data.property_hash[_property_key_hash(key, key_len)];
+
+    while (NULL != property_handle) {
+        if (template_key_match(((DeviceProperty *)property_handle->property)->key, key, key_len)) {
+            break;
+        }
+        property_handle = property_handle->hash_next;
+    }
+
+    return property_handle;
+}
+
 /**
  * @brief add registered propery's call back to data_template handle list
  */
@@ -46,31 +75,52 @@ static int _add_property_handle_to_template_list(Qcloud_IoT_Template *pTemplate,
     ListNode *node = list_node_new(property_handle);
     if (NULL == node) {
         Log_e("run list_node_new is error!");
+        HAL_Free(property_handle);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
     }
     list_rpush(pTemplate->inner_data.property_handle_list, node);
 
+    PropertyHandler **bucket =
+        &pTemplate->inner_data.property_hash[_property_key_hash(pProperty->key, strlen(pProperty->key))];
+    property_handle->hash_next = *bucket;
+    *bucket                    = property_handle;
+
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
 int template_common_check_property_existence(Qcloud_IoT_Template *ptemplate, DeviceProperty *pProperty)
 {
-    ListNode *node;
+    PropertyHandler *property_handle;
+
+    if (NULL == pProperty || NULL == pProperty->key) {
+        return 0;
+    }
 
     HAL_MutexLock(ptemplate->mutex);
-    node = list_find(ptemplate->inner_data.property_handle_list, pProperty);
+    property_handle = template_common_find_property(ptemplate, pProperty->key, strlen(pProperty->key));
     HAL_MutexUnlock(ptemplate->mutex);
 
-    return (NULL != node);
+    return (NULL != property_handle);
 }
 
 int template_common_remove_property(Qcloud_IoT_Template *ptemplate, DeviceProperty *pProperty)
 {
     int rc = QCLOUD_RET_SUCCESS;
 
-    ListNode *node;
+    PropertyHandler **bucket;
+    ListNode *        node = NULL;
+
     HAL_MutexLock(ptemplate->mutex);
-    node = list_find(ptemplate->inner_data.property_handle_list, pProperty);
+    bucket = &ptemplate->inner_data.property_hash[_property_key_hash(pProperty->key, strlen(pProperty->key))];
+    while (NULL != *bucket && strcmp(((DeviceProperty *)(*bucket)->property)->key, pProperty->key)) {
+        bucket = &(*bucket)->hash_next;
+    }
+
+    if (NULL != *bucket) {
+        node    = list_find(ptemplate->inner_data.property_handle_list, *bucket);
+        *bucket = (*bucket)->hash_next;
+    }
+
     if (NULL == node) {
         rc = QCLOUD_ERR_NOT_PROPERTY_EXIST;
         Log_e("Try to remove a non-existent property.");
@@ -30,6 +30,7 @@ extern "C" {
 #include <stdio.h>
 #include <string.h>
 
+#include "json_parser.h"
 #include "lite-utils.h"
 #include "qcloud_iot_device.h"
 #include "qcloud_iot_export_method.h"
@@ -45,24 +46,225 @@ int check_snprintf_return(int32_t returnCode, size_t maxSizeOfWrite)
     return QCLOUD_RET_SUCCESS;
 }
 
-void insert_str(char *pDestStr, char *pSourceStr, int pos)
+void json_writer_init(JsonWriter *writer, char *buf, size_t size)
 {
-    int len  = strlen(pDestStr);
-    int nlen = strlen(pSourceStr);
-    int i;
-    for (i = len - 1; i >= pos; --i) {
-        *(pDestStr + i + nlen) = *(pDestStr + i);
+    writer->buf  = buf;
+    writer->size = size;
+    writer->len  = 0;
+    writer->err  = (size > 1) ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
+    if (size > 0) {
+        buf[0] = '\0';
     }
+}
+
+void json_writer_raw(JsonWriter *writer, const char *str, size_t len)
+{
+    if (writer->err != QCLOUD_RET_SUCCESS) {
+        return;
+    }
+
+    // always keep one byte for the terminator
+    if (len >= writer->size - writer->len) {
+        writer->err = QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+        return;
+    }
+
+    memcpy(writer->buf + writer->len, str, len);
+    writer->len += len;
+}
 
-    int n;
-    for (n = 0; n < nlen; n++) *(pDestStr + pos + n) = *pSourceStr++;
-    *(pDestStr + len + nlen) = 0;
+void json_writer_str(JsonWriter *writer, const char *str)
+{
+    json_writer_raw(writer, str, strlen(str));
+}
+
+void json_writer_string(JsonWriter *writer, const char *str)
+{
+    json_writer_literal(writer, "\"");
+    json_writer_str(writer, str);
+    json_writer_literal(writer, "\"");
+}
+
+void json_writer_key(JsonWriter *writer, const char *key)
+{
+    json_writer_string(writer, key);
+    json_writer_literal(writer, ":");
+}
+
+static void _json_writer_u64(JsonWriter *writer, uint64_t value, int min_digits)
+{
+    char digits[20];
+    int  pos = sizeof(digits);
+
+    do {
+        digits[--pos] = '0' + (value % 10);
+        value /= 10;
+    } while ((value != 0 || (int)sizeof(digits) - pos < min_digits) && pos > 0);
+
+    json_writer_raw(writer, digits + pos, sizeof(digits) - pos);
+}
+
+void json_writer_int(JsonWriter *writer, int32_t value)
+{
+    if (value < 0) {
+        json_writer_literal(writer, "-");
+        _json_writer_u64(writer, (uint64_t)(-(int64_t)value), 1);
+    } else {
+        _json_writer_u64(writer, (uint64_t)value, 1);
+    }
+}
+
+void json_writer_uint(JsonWriter *writer, uint32_t value)
+{
+    _json_writer_u64(writer, value, 1);
+}
+
+/*
+ * fraction / 2^shift in millionths, fraction < 2^shift and fraction < 2^53, rounded half
+ * to even on the exact value like "%f". fraction * 10^6 = fraction * 15625 * 2^6 is kept
+ * as hi * 2^32 + lo so that nothing is lost
+ */
+static uint64_t _json_fraction_to_micro(uint64_t fraction, int shift)
+{
+    uint64_t lo    = (fraction & 0xffffffff) * 15625;
+    uint64_t hi    = (fraction >> 32) * 15625 + (lo >> 32);
+    int      scale = shift - 6;  // the exact millionths are (hi * 2^32 + lo) / 2^scale
+    uint64_t micro, rem, half;
+    bool     above, tie;
+
+    lo &= 0xffffffff;
+    if (scale <= 0) {
+        return ((hi << 32) | lo) << -scale;
+    }
+
+    if (scale <= 32) {
+        micro = (hi << (32 - scale)) | (lo >> scale);
+        rem   = lo & ((1ULL << scale) - 1);
+        half  = 1ULL << (scale - 1);
+        above = rem > half;
+        tie   = rem == half;
+    } else if (scale <= 68) {
+        micro = hi >> (scale - 32);
+        rem   = hi & ((1ULL << (scale - 32)) - 1);
+        half  = 1ULL << (scale - 33);
+        above = rem > half || (rem == half && lo != 0);
+        tie   = rem == half && lo == 0;
+    } else {
+        // hi * 2^32 + lo < 2^67, less than half of 2^scale
+        return 0;
+    }
+
+    if (above || (tie && (micro & 1))) {
+        micro++;
+    }
+
+    return micro;
+}
+
+void json_writer_double(JsonWriter *writer, double value)
+{
+    uint64_t bits, mantissa;
+    uint64_t integer, fraction = 0;
+    int      exponent;
+
+    // IEEE 754 binary64: value = mantissa * 2^exponent
+    memcpy(&bits, &value, sizeof(bits));
+    mantissa = bits & ((1ULL << 52) - 1);
+    exponent = (int)((bits >> 52) & 0x7ff);
+    if (0 == exponent) {
+        exponent = 1 - 1075;
+    } else {
+        mantissa |= 1ULL << 52;
+        exponent -= 1075;
+    }
+
+    // nan, inf and values from 2^63 keep the libc "%f" output
+    if (exponent >= 11) {
+        int32_t rc_of_snprintf;
+
+        if (writer->err != QCLOUD_RET_SUCCESS) {
+            return;
+        }
+        rc_of_snprintf = HAL_Snprintf(writer->buf + writer->len, writer->size - writer->len, "%f", value);
+        writer->err    = check_snprintf_return(rc_of_snprintf, writer->size - writer->len);
+        if (writer->err == QCLOUD_RET_SUCCESS) {
+            writer->len += rc_of_snprintf;
+        }
+        return;
+    }
+
+    // same 6 fractional digits as "%f"
+    if (exponent >= 0) {
+        integer = mantissa << exponent;
+    } else if (-exponent < 64) {
+        integer  = mantissa >> -exponent;
+        fraction = _json_fraction_to_micro(mantissa & ((1ULL << -exponent) - 1), -exponent);
+    } else {
+        integer  = 0;
+        fraction = _json_fraction_to_micro(mantissa, -exponent);
+    }
+    if (fraction >= 1000000) {
+        integer++;
+        fraction -= 1000000;
+    }
+
+    // sign bit, so -0.0 is "-0.000000" as well
+    if (bits >> 63) {
+        json_writer_literal(writer, "-");
+    }
+    _json_writer_u64(writer, integer, 1);
+    json_writer_literal(writer, ".");
+    _json_writer_u64(writer, fraction, 6);
+}
+
+void json_writer_close(JsonWriter *writer, char end)
+{
+    if (writer->err == QCLOUD_RET_SUCCESS && writer->len > 0 && writer->buf[writer->len - 1] == ',') {
+        writer->buf[writer->len - 1] = end;
+    } else {
+        json_writer_raw(writer, &end, 1);
+    }
+}
+
+int json_writer_finish(JsonWriter *writer)
+{
+    if (writer->err == QCLOUD_RET_SUCCESS) {
+        writer->buf[writer->len] = '\0';
+    }
+
+    return writer->err;
+}
+
+bool template_key_match(const char *key, const char *name, int name_len)
+{
+    return (NULL != key) && !strncmp(key, name, name_len) && ('\0' == key[name_len]);
+}
+
+static void _update_struct_value(char *value, DeviceProperty *pProperty)
+{
+    char *   pos = 0, *key = 0, *val = 0;
+    int      klen = 0, vlen = 0, vtype = 0;
+    uint16_t index;
+
+    json_object_for_each_kv(value, pos, key, klen, val, vlen, vtype)
+    {
+        if (!key || !klen || !val) {
+            continue;
+        }
+
+        for (index = 0; index < pProperty->struct_obj_num; index++) {
+            DeviceProperty *pJsonNode = &((((sDataPoint *)(pProperty->data)) + index)->data_property);
+            if (template_key_match(pJsonNode->key, key, klen)) {
+                update_value_from_json_token(pJsonNode, val, vlen, vtype);
+                break;
+            }
+        }
+    }
 }
 
 static int _direct_update_value(char *value, DeviceProperty *pProperty)
 {
     int rc = QCLOUD_RET_SUCCESS;
-    uint16_t index = 0;
 
     if (pProperty->type == JBOOL) {
         rc = LITE_get_boolean(pProperty->data, value);
@@ -85,12 +287,7 @@ static int _direct_update_value(char *value, DeviceProperty *pProperty)
     } else if (pProperty->type == JSTRING) {
         rc = LITE_get_string(pProperty->data, value, pProperty->data_buff_len);
     } else if (pProperty->type == JOBJECT) {
-        for (index = 0; index < pProperty->struct_obj_num; index++) {
-            DeviceProperty *pJsonNode = &((((sDataPoint *)(pProperty->data)) + index)->data_property);
-            if ((pJsonNode != NULL) && (pJsonNode->key != NULL)) {
-                update_value_if_key_match(value, pJsonNode);
-            }
-        }
+        _update_struct_value(value, pProperty);
     } else {
         Log_e("pProperty type unknow,%d", pProperty->type);
     }
@@ -98,145 +295,75 @@ static int _direct_update_value(char *value, DeviceProperty *pProperty)
     return rc;
 }
 
-int put_json_node(char *jsonBuffer, size_t sizeOfBuffer, DeviceProperty *pJsonNode)
+static void _put_json_value(JsonWriter *writer, void *pData, JsonDataType type)
 {
-    int     rc;
-    int32_t rc_of_snprintf = 0;
-    size_t  remain_size    = 0;
-    char *pKey = pJsonNode->key;
-    void *pData = pJsonNode->data;
-    JsonDataType type = pJsonNode->type;
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
+    if (type == JINT32) {
+        json_writer_int(writer, *(int32_t *)(pData));
+    } else if (type == JINT16) {
+        json_writer_int(writer, *(int16_t *)(pData));
+    } else if (type == JINT8) {
+        json_writer_int(writer, *(int8_t *)(pData));
+    } else if (type == JUINT32) {
+        json_writer_uint(writer, *(uint32_t *)(pData));
+    } else if (type == JUINT16) {
+        json_writer_uint(writer, *(uint16_t *)(pData));
+    } else if (type == JUINT8) {
+        json_writer_uint(writer, *(uint8_t *)(pData));
+    } else if (type == JDOUBLE) {
+        json_writer_double(writer, *(double *)(pData));
+    } else if (type == JFLOAT) {
+        json_writer_double(writer, *(float *)(pData));
+    } else if (type == JSTRING) {
+        json_writer_string(writer, (char *)(pData));
     }
+}
 
-    rc_of_snprintf =
-        HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"%s\":", STRING_PTR_PRINT_SANITY_CHECK(pKey));
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
+int put_json_node(JsonWriter *writer, DeviceProperty *pJsonNode)
+{
+    void *       pData = pJsonNode->data;
+    JsonDataType type  = pJsonNode->type;
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
+    json_writer_key(writer, STRING_PTR_PRINT_SANITY_CHECK(pJsonNode->key));
 
     if (pData == NULL) {
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "null,");
-    } else {
-        if (type == JINT32) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi32 ",", *(int32_t *)(pData));
-        } else if (type == JINT16) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi16 ",", *(int16_t *)(pData));
-        } else if (type == JINT8) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi8 ",", *(int8_t *)(pData));
-        } else if (type == JUINT32) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu32 ",", *(uint32_t *)(pData));
-        } else if (type == JUINT16) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu16 ",", *(uint16_t *)(pData));
-        } else if (type == JUINT8) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu8 ",", *(uint8_t *)(pData));
-        } else if (type == JDOUBLE) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%f,", *(double *)(pData));
-        } else if (type == JFLOAT) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%f,", *(float *)(pData));
-        } else if (type == JBOOL) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%s,", *(bool *)(pData) ? "true" : "false");
-        } else if (type == JSTRING) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"%s\",", (char *)(pData));
-        } else if (type == JOBJECT) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "{");
-            rc = check_snprintf_return(rc_of_snprintf, remain_size);
-            if (rc != QCLOUD_RET_SUCCESS) {
-                return rc;
-            }
-            uint16_t index = 0;
-
-            for (index = 0; index < pJsonNode->struct_obj_num; index++) {
-                DeviceProperty *pNode = &((((sDataPoint *)(pJsonNode->data)) + index)->data_property);
-                if ((pNode != NULL) && (pNode->key) != NULL) {
-                    rc = put_json_node(jsonBuffer + strlen(jsonBuffer), remain_size, pNode);
-                    if (rc != QCLOUD_RET_SUCCESS) {
-                        return rc;
-                    }
-                }
+        json_writer_literal(writer, "null");
+    } else if (type == JBOOL) {
+        json_writer_str(writer, *(bool *)(pData) ? "true" : "false");
+    } else if (type == JOBJECT) {
+        uint16_t index;
+
+        json_writer_literal(writer, "{");
+        for (index = 0; index < pJsonNode->struct_obj_num; index++) {
+            DeviceProperty *pNode = &((((sDataPoint *)(pJsonNode->data)) + index)->data_property);
+            if ((pNode != NULL) && (pNode->key) != NULL) {
+                put_json_node(writer, pNode);
             }
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "},");
         }
+        json_writer_close(writer, '}');
+    } else {
+        _put_json_value(writer, pData, type);
     }
+    json_writer_literal(writer, ",");
 
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    return rc;
+    return writer->err;
 }
 
-int template_put_json_node(char *jsonBuffer, size_t sizeOfBuffer, const char *pKey, void *pData, JsonDataType type)
+int template_put_json_node(JsonWriter *writer, const char *pKey, void *pData, JsonDataType type)
 {
-    int     rc;
-    int32_t rc_of_snprintf = 0;
-    size_t  remain_size    = 0;
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
-    rc_of_snprintf =
-        HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"%s\":", STRING_PTR_PRINT_SANITY_CHECK(pKey));
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-    if (rc != QCLOUD_RET_SUCCESS) {
-        return rc;
-    }
-
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
+    json_writer_key(writer, STRING_PTR_PRINT_SANITY_CHECK(pKey));
 
     if (pData == NULL) {
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "null,");
+        json_writer_literal(writer, "null");
+    } else if (type == JBOOL) {
+        json_writer_str(writer, *(bool *)(pData) ? "1" : "0");
+    } else if (type == JOBJECT) {
+        json_writer_str(writer, (char *)(pData));
     } else {
-        if (type == JINT32) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi32 ",", *(int32_t *)(pData));
-        } else if (type == JINT16) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi16 ",", *(int16_t *)(pData));
-        } else if (type == JINT8) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIi8 ",", *(int8_t *)(pData));
-        } else if (type == JUINT32) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu32 ",", *(uint32_t *)(pData));
-        } else if (type == JUINT16) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu16 ",", *(uint16_t *)(pData));
-        } else if (type == JUINT8) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%" PRIu8 ",", *(uint8_t *)(pData));
-        } else if (type == JDOUBLE) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%f,", *(double *)(pData));
-        } else if (type == JFLOAT) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%f,", *(float *)(pData));
-        } else if (type == JBOOL) {
-            rc_of_snprintf =
-                HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%u,", *(bool *)(pData) ? 1 : 0);
-        } else if (type == JSTRING) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"%s\",", (char *)(pData));
-        } else if (type == JOBJECT) {
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "%s,", (char *)(pData));
-        }
+        _put_json_value(writer, pData, type);
     }
+    json_writer_literal(writer, ",");
 
-    rc = check_snprintf_return(rc_of_snprintf, remain_size);
-
-    return rc;
+    return writer->err;
 }
 
 void build_empty_json(uint32_t *tokenNumber, char *pJsonBuffer, char *tokenPrefix)
@@ -307,23 +434,29 @@ bool parse_status_return(char *pJsonDoc, char **pStatus)
     return *pStatus == NULL ? false : true;
 }
 
-bool update_value_if_key_match(char *pJsonDoc, DeviceProperty *pProperty)
+bool update_value_from_json_token(DeviceProperty *pProperty, char *value, int value_len, int value_type)
 {
-    bool ret = false;
+    char last_char = 0;
 
-    char *property_data = LITE_json_value_of(pProperty->key, pJsonDoc);
-    if ((property_data == NULL) || !(strncmp(property_data, "null", 4)) || !(strncmp(property_data, "NULL", 4))) {
-        ret = false;
-    } else {
-        _direct_update_value(property_data, pProperty);
-        ret = true;
+    /* empty string is a value as well */
+    if ((value == NULL) || (value_len < 0) || (value_type == JSNULL)) {
+        return false;
     }
 
-    if (property_data) {
-        HAL_Free(property_data);
-    }
+    backup_json_str_last_char(value, value_len, last_char);
+    _direct_update_value(value, pProperty);
+    restore_json_str_last_char(value, value_len, last_char);
 
-    return ret;
+    return true;
+}
+
+bool update_value_if_key_match(char *pJsonDoc, DeviceProperty *pProperty)
+{
+    int   value_len  = 0;
+    int   value_type = JSNONE;
+    char *value      = json_get_value_by_name(pJsonDoc, strlen(pJsonDoc), pProperty->key, &value_len, &value_type);
+
+    return update_value_from_json_token(pProperty, value, value_len, value_type);
 }
 
 bool parse_template_method_type(char *pJsonDoc, char **pMethod)
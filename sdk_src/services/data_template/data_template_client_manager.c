@@ -28,7 +28,9 @@ extern "C" {
 #include <string.h>
 
 #include "data_template_client.h"
+#include "data_template_client_common.h"
 #include "data_template_client_json.h"
+#include "json_parser.h"
 #include "qcloud_iot_import.h"
 #include "utils_list.h"
 #include "utils_param_check.h"
@@ -177,17 +179,21 @@ static int _set_template_json_type(char *pJsonDoc, size_t sizeOfBuffer, Method m
     if (rc != QCLOUD_RET_SUCCESS)
         IOT_FUNC_EXIT_RC(rc);
 
-    size_t json_len    = strlen(pJsonDoc);
-    size_t remain_size = sizeOfBuffer - json_len;
+    char       json_node_str[64];
+    JsonWriter writer;
+    size_t     json_len = strlen(pJsonDoc);
 
-    char json_node_str[64] = {0};
-    HAL_Snprintf(json_node_str, 64, "\"method\":\"%s\", ", method_str);
+    json_writer_init(&writer, json_node_str, sizeof(json_node_str));
+    json_writer_literal(&writer, "\"method\":");
+    json_writer_string(&writer, method_str);
+    json_writer_literal(&writer, ", ");
 
-    size_t json_node_len = strlen(json_node_str);
-    if (json_node_len >= remain_size - 1) {
+    // the document is built by the caller, shift it once to put method right after the opening brace
+    if (json_writer_finish(&writer) != QCLOUD_RET_SUCCESS || json_len < 1 || json_len + writer.len >= sizeOfBuffer) {
         rc = QCLOUD_ERR_INVAL;
     } else {
-        insert_str(pJsonDoc, json_node_str, 1);
+        memmove(pJsonDoc + 1 + writer.len, pJsonDoc + 1, json_len);
+        memcpy(pJsonDoc + 1, json_node_str, writer.len);
     }
 
     IOT_FUNC_EXIT_RC(rc);
@@ -277,6 +283,7 @@ void qcloud_iot_template_reset(Qcloud_IoT_Template *pTemplate)
         list_destroy(pTemplate->inner_data.property_handle_list);
         pTemplate->inner_data.property_handle_list = NULL;
     }
+    memset(pTemplate->inner_data.property_hash, 0, sizeof(pTemplate->inner_data.property_hash));
 
     if (pTemplate->inner_data.reply_list) {
         list_destroy(pTemplate->inner_data.reply_list);
@@ -304,6 +311,7 @@ int qcloud_iot_template_init(Qcloud_IoT_Template *pTemplate)
     if (pTemplate->mutex == NULL)
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
 
+    memset(pTemplate->inner_data.property_hash, 0, sizeof(pTemplate->inner_data.property_hash));
     pTemplate->inner_data.property_handle_list = list_new();
     if (pTemplate->inner_data.property_handle_list) {
         pTemplate->inner_data.property_handle_list->free = HAL_Free;
@@ -389,40 +397,29 @@ int send_template_request(Qcloud_IoT_Template *pTemplate, RequestParams *pParams
 static void _handle_control(Qcloud_IoT_Template *pTemplate, char *control_str)
 {
     IOT_FUNC_ENTRY;
-    if (pTemplate->inner_data.property_handle_list->len) {
-        ListIterator *   iter;
-        ListNode *       node            = NULL;
-        PropertyHandler *property_handle = NULL;
 
-        if (NULL == (iter = list_iterator_new(pTemplate->inner_data.property_handle_list, LIST_TAIL))) {
-            HAL_MutexUnlock(pTemplate->mutex);
-            IOT_FUNC_EXIT;
-        }
+    char *           pos = 0, *key = 0, *val = 0;
+    int              klen = 0, vlen = 0, vtype = 0;
+    size_t           control_len     = strlen(control_str);
+    PropertyHandler *property_handle = NULL;
 
-        for (;;) {
-            node = list_iterator_next(iter);
-            if (NULL == node) {
-                break;
-            }
+    // walk the control document once and look each key up in the registered properties
+    json_object_for_each_kv(control_str, pos, key, klen, val, vlen, vtype)
+    {
+        if (!key || !klen || !val) {
+            continue;
+        }
 
-            property_handle = (PropertyHandler *)(node->val);
-            if (NULL == property_handle) {
-                Log_e("node's value is invalid!");
-                continue;
-            }
+        property_handle = template_common_find_property(pTemplate, key, klen);
+        if (NULL == property_handle) {
+            continue;
+        }
 
-            if (property_handle->property != NULL) {
-                if (update_value_if_key_match(control_str, property_handle->property)) {
-                    if (property_handle->callback != NULL) {
-                        property_handle->callback(pTemplate, control_str, strlen(control_str),
-                                                  property_handle->property);
-                    }
-                    node = NULL;
-                }
+        if (update_value_from_json_token(property_handle->property, val, vlen, vtype)) {
+            if (property_handle->callback != NULL) {
+                property_handle->callback(pTemplate, control_str, control_len, property_handle->property);
             }
         }
-
-        list_iterator_destroy(iter);
     }
 
     IOT_FUNC_EXIT;
@@ -180,13 +180,10 @@ static sEventReply *_create_event_add_to_list(Qcloud_IoT_Template *pTemplate, On
     IOT_FUNC_EXIT_RC(pReply);
 }
 
-static int _iot_event_json_init(void *handle, char *jsonBuffer, size_t sizeOfBuffer, uint8_t event_count,
-                                OnEventReplyCallback replyCb, uint32_t reply_timeout_ms)
+static int _iot_event_json_init(void *handle, JsonWriter *writer, uint8_t event_count, OnEventReplyCallback replyCb,
+                                uint32_t reply_timeout_ms)
 {
-    POINTER_SANITY_CHECK(jsonBuffer, QCLOUD_ERR_INVAL);
-
     Qcloud_IoT_Template *ptemplate = (Qcloud_IoT_Template *)handle;
-    int32_t              rc_of_snprintf;
     sEventReply *        pReply;
 
     pReply = _create_event_add_to_list(ptemplate, replyCb, reply_timeout_ms);
@@ -195,31 +192,67 @@ static int _iot_event_json_init(void *handle, char *jsonBuffer, size_t sizeOfBuf
         return QCLOUD_ERR_FAILURE;
     }
 
-    memset(jsonBuffer, 0, sizeOfBuffer);
-    if (event_count > SINGLE_EVENT) {
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer, sizeOfBuffer, "{\"method\":\"%s\", \"clientToken\":\"%s\", ",
-                                      POST_EVENTS, pReply->client_token);
-    } else {
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer, sizeOfBuffer, "{\"method\":\"%s\", \"clientToken\":\"%s\", ",
-                                      POST_EVENT, pReply->client_token);
+    json_writer_literal(writer, "{\"method\":");
+    json_writer_string(writer, (event_count > SINGLE_EVENT) ? POST_EVENTS : POST_EVENT);
+    json_writer_literal(writer, ", \"clientToken\":");
+    json_writer_string(writer, pReply->client_token);
+    json_writer_literal(writer, ", ");
+
+    return writer->err;
+}
+
+/**
+ * @brief add eventId, type, timestamp and params of one event
+ */
+static int _iot_put_event(JsonWriter *writer, sEvent *pEvent)
+{
+    uint8_t i;
+
+    json_writer_literal(writer, "\"eventId\":");
+    json_writer_string(writer, STRING_PTR_PRINT_SANITY_CHECK(pEvent->event_name));
+    json_writer_literal(writer, ", \"type\":");
+    json_writer_string(writer, STRING_PTR_PRINT_SANITY_CHECK(pEvent->type));
+    json_writer_literal(writer, ", \"timestamp\":");
+    if (0 == pEvent->timestamp) {  // no accurate UTC time, set 0
+        json_writer_literal(writer, "0");
+    } else {  // accurate UTC time is second,change to ms
+        json_writer_uint(writer, pEvent->timestamp);
+        json_writer_literal(writer, "000");
+    }
+    json_writer_literal(writer, ", \"params\":{");
+
+    DeviceProperty *pJsonNode = pEvent->pEventData;
+    for (i = 0; i < pEvent->eventDataNum; i++) {
+        if (pJsonNode != NULL && pJsonNode->key != NULL) {
+            int rc = template_put_json_node(writer, pJsonNode->key, pJsonNode->data, pJsonNode->type);
+
+            if (rc != QCLOUD_RET_SUCCESS) {
+                return rc;
+            }
+        } else {
+            Log_e("%dth/%d null event property data", i, pEvent->eventDataNum);
+            return QCLOUD_ERR_INVAL;
+        }
+        pJsonNode++;
     }
+    json_writer_close(writer, '}');
 
-    return check_snprintf_return(rc_of_snprintf, sizeOfBuffer);
+    return writer->err;
 }
 
 static int _iot_construct_event_json(void *handle, char *jsonBuffer, size_t sizeOfBuffer, uint8_t event_count,
                                      sEvent *pEventArry[], OnEventReplyCallback replyCb, uint32_t reply_timeout_ms)
 {
-    size_t               remain_size    = 0;
-    int32_t              rc_of_snprintf = 0;
-    uint8_t              i, j;
+    JsonWriter           writer;
+    uint8_t              i;
     Qcloud_IoT_Template *ptemplate = (Qcloud_IoT_Template *)handle;
 
     POINTER_SANITY_CHECK(ptemplate, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(jsonBuffer, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(pEventArry, QCLOUD_ERR_INVAL);
 
-    int rc = _iot_event_json_init(ptemplate, jsonBuffer, sizeOfBuffer, event_count, replyCb, reply_timeout_ms);
+    json_writer_init(&writer, jsonBuffer, sizeOfBuffer);
+    int rc = _iot_event_json_init(ptemplate, &writer, event_count, replyCb, reply_timeout_ms);
 
     if (rc != QCLOUD_RET_SUCCESS) {
         Log_e("event json init failed: %d", rc);
@@ -227,20 +260,8 @@ static int _iot_construct_event_json(void *handle, char *jsonBuffer, size_t size
     }
     // Log_d("event_count:%d, Doc_init:%s",event_count, jsonBuffer);
 
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
     if (event_count > SINGLE_EVENT) {  // mutlti event
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "\"events\":[");
-        rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-        if (rc != QCLOUD_RET_SUCCESS) {
-            return rc;
-        }
-
-        if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-            return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-        }
+        json_writer_literal(&writer, "\"events\":[");
 
         for (i = 0; i < event_count; i++) {
             sEvent *pEvent = pEventArry[i];
@@ -249,124 +270,25 @@ static int _iot_construct_event_json(void *handle, char *jsonBuffer, size_t size
                 return QCLOUD_ERR_INVAL;
             }
 
-            if (0 == pEvent->timestamp) {  // no accurate UTC time, set 0
-                rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size,
-                                              "{\"eventId\":\"%s\", \"type\":\"%s\", "
-                                              "\"timestamp\":0, \"params\":{",
-                                              STRING_PTR_PRINT_SANITY_CHECK(pEvent->event_name),
-                                              STRING_PTR_PRINT_SANITY_CHECK(pEvent->type));
-            } else {  // accurate UTC time is second,change to ms
-                rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size,
-                                              "{\"eventId\":\"%s\", \"type\":\"%s\", "
-                                              "\"timestamp\":%u000, \"params\":{",
-                                              STRING_PTR_PRINT_SANITY_CHECK(pEvent->event_name),
-                                              STRING_PTR_PRINT_SANITY_CHECK(pEvent->type), pEvent->timestamp);
-            }
-
-            rc = check_snprintf_return(rc_of_snprintf, remain_size);
+            json_writer_literal(&writer, "{");
+            rc = _iot_put_event(&writer, pEvent);
             if (rc != QCLOUD_RET_SUCCESS) {
                 return rc;
             }
-
-            if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-                return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-            }
-
-            DeviceProperty *pJsonNode = pEvent->pEventData;
-            for (j = 0; j < pEvent->eventDataNum; j++) {
-                if (pJsonNode != NULL && pJsonNode->key != NULL) {
-                    rc = template_put_json_node(jsonBuffer, remain_size, pJsonNode->key, pJsonNode->data,
-                                                pJsonNode->type);
-
-                    if (rc != QCLOUD_RET_SUCCESS) {
-                        return rc;
-                    }
-                } else {
-                    Log_e("%dth/%d null event property data", i, pEvent->eventDataNum);
-                    return QCLOUD_ERR_INVAL;
-                }
-                pJsonNode++;
-            }
-            if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-                return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-            }
-
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}},");
-
-            rc = check_snprintf_return(rc_of_snprintf, remain_size);
-            if (rc != QCLOUD_RET_SUCCESS) {
-                return rc;
-            }
-
-            pEvent++;
-        }
-
-        if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-            return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
+            json_writer_literal(&writer, "},");
         }
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "]");
-        rc             = check_snprintf_return(rc_of_snprintf, remain_size);
-        if (rc != QCLOUD_RET_SUCCESS) {
-            return rc;
-        }
-
+        json_writer_close(&writer, ']');
     } else {  // single
-        sEvent *pEvent = pEventArry[0];
-        if (0 == pEvent->timestamp) {  // no accurate UTC time, set 0
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size,
-                                          "\"eventId\":\"%s\", \"type\":\"%s\", \"timestamp\":0, \"params\":{",
-                                          STRING_PTR_PRINT_SANITY_CHECK(pEvent->event_name),
-                                          STRING_PTR_PRINT_SANITY_CHECK(pEvent->type));
-        } else {  // accurate UTC time is second,change to ms
-            rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size,
-                                          "\"eventId\":\"%s\", \"type\":\"%s\", "
-                                          "\"timestamp\":%u000, \"params\":{",
-                                          STRING_PTR_PRINT_SANITY_CHECK(pEvent->event_name),
-                                          STRING_PTR_PRINT_SANITY_CHECK(pEvent->type), pEvent->timestamp);
-        }
-
-        rc = check_snprintf_return(rc_of_snprintf, remain_size);
-        if (rc != QCLOUD_RET_SUCCESS) {
-            return rc;
-        }
-
-        if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-            return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-        }
-
-        DeviceProperty *pJsonNode = pEvent->pEventData;
-        for (i = 0; i < pEvent->eventDataNum; i++) {
-            if (pJsonNode != NULL && pJsonNode->key != NULL) {
-                rc = template_put_json_node(jsonBuffer, remain_size, pJsonNode->key, pJsonNode->data, pJsonNode->type);
-
-                if (rc != QCLOUD_RET_SUCCESS) {
-                    return rc;
-                }
-            } else {
-                Log_e("%dth/%d null event property data", i, pEvent->eventDataNum);
-                return QCLOUD_ERR_INVAL;
-            }
-            pJsonNode++;
-        }
-        if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) <= 1) {
-            return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-        }
-
-        rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer) - 1, remain_size, "}");
-
-        rc = check_snprintf_return(rc_of_snprintf, remain_size);
+        rc = _iot_put_event(&writer, pEventArry[0]);
         if (rc != QCLOUD_RET_SUCCESS) {
             return rc;
         }
     }
 
     // finish json
-    if ((remain_size = sizeOfBuffer - strlen(jsonBuffer)) < 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-    rc_of_snprintf = HAL_Snprintf(jsonBuffer + strlen(jsonBuffer), remain_size, "}");
+    json_writer_literal(&writer, "}");
 
-    return check_snprintf_return(rc_of_snprintf, remain_size);
+    return json_writer_finish(&writer);
 }
 
 static int _publish_event_to_cloud(void *c, char *pJsonDoc)
@@ -466,9 +388,8 @@ int IOT_Post_Event(void *pClient, char *pJsonDoc, size_t sizeOfBuffer, uint8_t e
 int IOT_Post_Event_Raw(void *pClient, char *pJsonDoc, size_t sizeOfBuffer, char *pEventMsg,
                        OnEventReplyCallback replyCb)
 {
-    int     rc;
-    size_t  remain_size = 0;
-    int32_t rc_of_snprintf;
+    int        rc;
+    JsonWriter writer;
 
     Qcloud_IoT_Template *ptemplate = (Qcloud_IoT_Template *)pClient;
 
@@ -476,19 +397,17 @@ int IOT_Post_Event_Raw(void *pClient, char *pJsonDoc, size_t sizeOfBuffer, char
     POINTER_SANITY_CHECK(pJsonDoc, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(pEventMsg, QCLOUD_ERR_INVAL);
 
-    rc = _iot_event_json_init(ptemplate, pJsonDoc, sizeOfBuffer, MUTLTI_EVENTS, replyCb,
-                              QCLOUD_IOT_MQTT_COMMAND_TIMEOUT);
+    json_writer_init(&writer, pJsonDoc, sizeOfBuffer);
+    rc = _iot_event_json_init(ptemplate, &writer, MUTLTI_EVENTS, replyCb, QCLOUD_IOT_MQTT_COMMAND_TIMEOUT);
     if (rc != QCLOUD_RET_SUCCESS) {
         Log_e("event json init failed: %d", rc);
         return rc;
     }
 
-    if ((remain_size = sizeOfBuffer - strlen(pJsonDoc)) <= 1) {
-        return QCLOUD_ERR_JSON_BUFFER_TOO_SMALL;
-    }
-
-    rc_of_snprintf = HAL_Snprintf(pJsonDoc + strlen(pJsonDoc), remain_size, "\"events\":[%s]}", pEventMsg);
-    rc             = check_snprintf_return(rc_of_snprintf, remain_size);
+    json_writer_literal(&writer, "\"events\":[");
+    json_writer_str(&writer, pEventMsg);
+    json_writer_literal(&writer, "]}");
+    rc = json_writer_finish(&writer);
     if (rc != QCLOUD_RET_SUCCESS) {
         return rc;
     }
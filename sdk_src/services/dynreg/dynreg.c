@@ -381,7 +381,8 @@ static int _post_reg_request_by_http(char *request_buf, DeviceInfo *pDevInfo)
     memset((char *)&http_client, 0, sizeof(HTTPClient));
     memset((char *)&http_data, 0, sizeof(HTTPClientData));
 
-    http_client.header = "Accept: text/xml,application/json;*/*\r\n";
+    http_client.header     = "Accept: text/xml,application/json;*/*\r\n";
+    http_client.keep_alive = true;
 
     http_data.post_content_type = "application/x-www-form-urlencoded";
     http_data.post_buf          = request_buf;
@@ -557,31 +557,19 @@ static int _post_file_manage_to_cos(const char *file_manage_url, FilePostInfo *i
         goto exit;
     }
 
+    rc = qcloud_url_upload_file(pUploadHandle, fp, file_size, NULL, 5000);
+    if (QCLOUD_RET_SUCCESS != rc) {
+        Log_e("send data failed");
+        goto exit;
+    }
+    Log_d("post file to cos over!");
+
     data_buf = (char *)HAL_Malloc(PER_CHRUNK_READ_SIZE);
-    memset(data_buf, 0, PER_CHRUNK_READ_SIZE);
     if (!data_buf) {
         Log_e("malloc data_buff fail");
+        rc = QCLOUD_ERR_MALLOC;
         goto exit;
     }
-
-    while (!HAL_FileEof(fp) && file_size > 0) {
-        int data_len = (file_size > PER_CHRUNK_READ_SIZE) ? PER_CHRUNK_READ_SIZE : file_size;
-        int read_len = HAL_FileRead(data_buf, 1, data_len, fp);
-        if (data_len != read_len) {
-            Log_e("Read file wrong, read_len %d(%d)", read_len, data_len);
-            rc = QCLOUD_ERR_FAILURE;
-            goto exit;
-        }
-        file_size -= read_len;
-
-        rc = qcloud_url_upload_body(pUploadHandle, data_buf, read_len, 5000);
-        if (QCLOUD_RET_SUCCESS != rc) {
-            Log_e("send data failed");
-            goto exit;
-        }
-    }
-    Log_d("post file to cos over!");
-
     memset(data_buf, 0, PER_CHRUNK_READ_SIZE);
     rc = qcloud_url_upload_recv_response(pUploadHandle, data_buf, PER_CHRUNK_READ_SIZE, COS_REPLY_TIMEOUT_MS);
     if (QCLOUD_RET_SUCCESS != rc) {
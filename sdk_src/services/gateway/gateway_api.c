@@ -138,6 +138,20 @@ void *IOT_Gateway_Construct(GatewayInitParam *init_param)
 
     memset(gateway, 0, sizeof(Gateway));
 
+    gateway->lock = HAL_MutexCreate();
+    if (NULL == gateway->lock) {
+        Log_e("gateway lock create failed");
+        HAL_Free(gateway);
+        IOT_FUNC_EXIT_RC(NULL);
+    }
+
+    rc = subdev_session_table_init(gateway, init_param->max_subdev_sessions);
+    if (QCLOUD_RET_SUCCESS != rc) {
+        HAL_MutexDestroy(gateway->lock);
+        HAL_Free(gateway);
+        IOT_FUNC_EXIT_RC(NULL);
+    }
+
     /* replace user event handle */
     gateway->event_handle.h_fp    = init_param->init_param.event_handle.h_fp;
     gateway->event_handle.context = init_param->init_param.event_handle.context;
@@ -150,6 +164,8 @@ void *IOT_Gateway_Construct(GatewayInitParam *init_param)
     gateway->mqtt = IOT_MQTT_Construct(&init_param->init_param);
     if (NULL == gateway->mqtt) {
         Log_e("construct MQTT failed");
+        subdev_session_table_deinit(gateway);
+        HAL_MutexDestroy(gateway->lock);
         HAL_Free(gateway);
         IOT_FUNC_EXIT_RC(NULL);
     }
@@ -189,6 +205,7 @@ int IOT_Gateway_Subdev_Online(void *client, GatewayParam *param)
     STRING_PTR_SANITY_CHECK(param->subdev_product_id, QCLOUD_ERR_INVAL);
     STRING_PTR_SANITY_CHECK(param->subdev_device_name, QCLOUD_ERR_INVAL);
 
+    HAL_MutexLock(gateway->lock);
     session = subdev_find_session(gateway, param->subdev_product_id, param->subdev_device_name);
     if (NULL == session) {
         Log_d("there is no session, create a new session");
@@ -196,15 +213,23 @@ int IOT_Gateway_Subdev_Online(void *client, GatewayParam *param)
         /* create subdev session */
         session = subdev_add_session(gateway, param->subdev_product_id, param->subdev_device_name);
         if (NULL == session) {
+            HAL_MutexUnlock(gateway->lock);
             Log_e("create session error!");
             IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_CREATE_SESSION_FAIL);
         }
     } else {
+        if (NULL != session->batch) {
+            HAL_MutexUnlock(gateway->lock);
+            Log_i("device is in batch request");
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_SUBDEV_BUSY);
+        }
         if (SUBDEV_SEESION_STATUS_ONLINE == session->session_status) {
+            HAL_MutexUnlock(gateway->lock);
             Log_i("device have online");
             IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_SUBDEV_ONLINE);
         }
     }
+    HAL_MutexUnlock(gateway->lock);
 
     size = HAL_Snprintf(topic, MAX_SIZE_OF_CLOUD_TOPIC + 1, GATEWAY_TOPIC_OPERATION_FMT, param->product_id,
                         param->device_name);
@@ -235,11 +260,19 @@ int IOT_Gateway_Subdev_Online(void *client, GatewayParam *param)
     /* publish packet */
     rc = gateway_publish_sync(gateway, topic, &params, &gateway->gateway_data.online.result);
     if (QCLOUD_RET_SUCCESS != rc) {
+        HAL_MutexLock(gateway->lock);
         subdev_remove_session(gateway, param->subdev_product_id, param->subdev_device_name);
+        HAL_MutexUnlock(gateway->lock);
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    session->session_status = SUBDEV_SEESION_STATUS_ONLINE;
+    /* replies update sessions under the lock from the yield context */
+    HAL_MutexLock(gateway->lock);
+    session = subdev_find_session(gateway, param->subdev_product_id, param->subdev_device_name);
+    if (NULL != session) {
+        session->session_status = SUBDEV_SEESION_STATUS_ONLINE;
+    }
+    HAL_MutexUnlock(gateway->lock);
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
@@ -260,17 +293,26 @@ int IOT_Gateway_Subdev_Offline(void *client, GatewayParam *param)
     STRING_PTR_SANITY_CHECK(param->subdev_product_id, QCLOUD_ERR_INVAL);
     STRING_PTR_SANITY_CHECK(param->subdev_device_name, QCLOUD_ERR_INVAL);
 
+    HAL_MutexLock(gateway->lock);
     session = subdev_find_session(gateway, param->subdev_product_id, param->subdev_device_name);
     if (NULL == session) {
+        HAL_MutexUnlock(gateway->lock);
         Log_d("no session, can not offline");
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_SESSION_NO_EXIST);
     }
+    if (NULL != session->batch) {
+        HAL_MutexUnlock(gateway->lock);
+        Log_i("device is in batch request");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_SUBDEV_BUSY);
+    }
     if (SUBDEV_SEESION_STATUS_OFFLINE == session->session_status) {
         Log_i("device have offline");
         /* free session */
         subdev_remove_session(gateway, param->subdev_product_id, param->subdev_device_name);
+        HAL_MutexUnlock(gateway->lock);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_GATEWAY_SUBDEV_OFFLINE);
     }
+    HAL_MutexUnlock(gateway->lock);
 
     size = HAL_Snprintf(topic, MAX_SIZE_OF_CLOUD_TOPIC + 1, GATEWAY_TOPIC_OPERATION_FMT, param->product_id,
                         param->device_name);
@@ -305,13 +347,35 @@ int IOT_Gateway_Subdev_Offline(void *client, GatewayParam *param)
         IOT_FUNC_EXIT_RC(rc);
     }
 
+    HAL_MutexLock(gateway->lock);
     session->session_status = SUBDEV_SEESION_STATUS_OFFLINE;
     /* free session */
     subdev_remove_session(gateway, param->subdev_product_id, param->subdev_device_name);
+    HAL_MutexUnlock(gateway->lock);
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+int IOT_Gateway_Subdev_Online_Batch(void *client, GatewayParam param[], int count, GatewaySubdevResultCallback callback,
+                                    void *user_data)
+{
+    return gateway_subdev_status_batch((Gateway *)client, param, count, true, callback, user_data);
+}
+
+int IOT_Gateway_Subdev_Offline_Batch(void *client, GatewayParam param[], int count,
+                                     GatewaySubdevResultCallback callback, void *user_data)
+{
+    return gateway_subdev_status_batch((Gateway *)client, param, count, false, callback, user_data);
+}
+
+int IOT_Gateway_Subdev_Batch_Pending(void *client)
+{
+    Gateway *gateway = (Gateway *)client;
+    POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_INVAL);
+
+    return gateway_subdev_batch_expire(gateway);
+}
+
 int IOT_Gateway_Subdev_GetBindList(void *client, GatewayParam *param, SubdevBindList *subdev_bindlist)
 {
     POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
@@ -501,14 +565,11 @@ int IOT_Gateway_Destroy(void *client)
     Gateway *gateway = (Gateway *)client;
     POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_INVAL);
 
-    SubdevSession *cur_session = gateway->session_list;
-    while (cur_session) {
-        SubdevSession *session = cur_session;
-        cur_session            = cur_session->next;
-        HAL_Free(session);
-    }
+    gateway_subdev_batch_clear(gateway);
 
     IOT_MQTT_Destroy(&gateway->mqtt);
+    subdev_session_table_deinit(gateway);
+    HAL_MutexDestroy(gateway->lock);
     HAL_Free(client);
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS)
@@ -519,7 +580,11 @@ int IOT_Gateway_Yield(void *client, uint32_t timeout_ms)
     Gateway *gateway = (Gateway *)client;
     POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_INVAL);
 
-    return IOT_MQTT_Yield(gateway->mqtt, timeout_ms);
+    int rc = IOT_MQTT_Yield(gateway->mqtt, timeout_ms);
+
+    gateway_subdev_batch_expire(gateway);
+
+    return rc;
 }
 
 int IOT_Gateway_Subscribe(void *client, char *topic_filter, SubscribeParams *params)
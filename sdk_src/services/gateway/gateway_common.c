@@ -350,19 +350,27 @@ static void _gateway_message_handler(void *client, MQTTMessage *message, void *u
 
     topic     = (char *)message->ptopic;
     topic_len = message->topic_len;
-    if (NULL == topic || topic_len == 0 || message->payload_len > GATEWAY_RECEIVE_BUFFER_LEN) {
+    if (NULL == topic || topic_len == 0) {
         Log_e("topic %p topic_len %u message->payload_len %u", topic, topic_len, message->payload_len);
         return;
     }
 
-    cloud_rcv_len  = Min(GATEWAY_RECEIVE_BUFFER_LEN - 1, message->payload_len);
+    /* batch replies list every device and may not fit in recv_buf */
+    cloud_rcv_len  = message->payload_len;
     char *json_buf = gateway->recv_buf;
-    memcpy(gateway->recv_buf, message->payload, cloud_rcv_len);
+    if (cloud_rcv_len >= GATEWAY_RECEIVE_BUFFER_LEN) {
+        json_buf = HAL_Malloc(cloud_rcv_len + 1);
+        if (NULL == json_buf) {
+            Log_e("no memory for message of %u bytes", message->payload_len);
+            return;
+        }
+    }
+    memcpy(json_buf, message->payload, cloud_rcv_len);
     json_buf[cloud_rcv_len] = '\0';  // jsmn_parse relies on a string
 
     if (!get_json_type(json_buf, &type)) {
         Log_e("Fail to parse type from msg: %s", json_buf);
-        return;
+        goto exit;
     }
 
     if (!strncmp(type, GATEWAY_SEARCH_OP_STR, sizeof(GATEWAY_SEARCH_OP_STR) - 1)) {
@@ -410,6 +418,12 @@ static void _gateway_message_handler(void *client, MQTTMessage *message, void *u
         goto exit;
     }
 
+    if (!strncmp(type, GATEWAY_ONLINE_OP_STR, sizeof(GATEWAY_ONLINE_OP_STR) - 1) ||
+        !strncmp(type, GATEWAY_OFFLIN_OP_STR, sizeof(GATEWAY_OFFLIN_OP_STR) - 1)) {
+        gateway_subdev_batch_reply(gateway, devices,
+                                   !strncmp(type, GATEWAY_ONLINE_OP_STR, sizeof(GATEWAY_ONLINE_OP_STR) - 1));
+    }
+
     if (!get_json_result(devices_strip, &result) || !get_json_product_id(devices_strip, &product_id) ||
         !get_json_device_name(devices_strip, &device_name)) {
         Log_e("Failed to parse  from msg: %s %p %p %p", json_buf, result, product_id, device_name);
@@ -450,6 +464,9 @@ static void _gateway_message_handler(void *client, MQTTMessage *message, void *u
         Log_e("shouldnt reach here: unknown type %s", type);
     }
 exit:
+    if (json_buf != gateway->recv_buf) {
+        HAL_Free(json_buf);
+    }
     HAL_Free(type);
     HAL_Free(devices);
     HAL_Free(product_id);
@@ -526,23 +543,153 @@ int gateway_subscribe_unsubscribe_default(Gateway *gateway, GatewayParam *param)
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+/* FNV-1a over product_id and device_name, with the terminator of product_id as separator */
+static uint32_t _subdev_session_hash(const char *product_id, const char *device_name)
+{
+    uint32_t hash = 2166136261u;
+
+    do {
+        hash = (hash ^ (uint8_t)*product_id) * 16777619u;
+    } while (*product_id++);
+
+    while (*device_name) {
+        hash = (hash ^ (uint8_t)*device_name++) * 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief find the hash slot of session, or the empty slot it would go to
+ */
+static uint32_t _subdev_session_slot(SubdevSessionTable *table, uint32_t hash, const char *product_id,
+                                     const char *device_name)
+{
+    uint32_t       slot = hash & table->mask;
+    SubdevSession *session;
+
+    while (NULL != (session = table->index[slot])) {
+        if (session->hash == hash && 0 == strcmp(session->product_id, product_id) &&
+            0 == strcmp(session->device_name, device_name)) {
+            break;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief add a chunk of records, and move the sessions to a larger hash index if needed
+ */
+static int _subdev_session_grow(SubdevSessionTable *table)
+{
+    SubdevSessionChunk *chunk;
+    SubdevSession **    index;
+    uint32_t            add   = table->capacity ? table->capacity : table->limit;
+    uint32_t            slots = table->mask + 1;
+    uint32_t            i, slot;
+
+    if (0 == add) {
+        add = GATEWAY_INIT_SUBDEV_SESSIONS;
+    }
+    if (table->limit) {
+        add = Min(add, table->limit - table->capacity);
+        if (0 == add) {
+            Log_e("session table is full, max %u sessions", (unsigned int)table->limit);
+            return QCLOUD_ERR_GATEWAY_CREATE_SESSION_FAIL;
+        }
+    }
+
+    /* keep load factor under 1/2 so probing always meets an empty slot soon */
+    while (slots < (table->capacity + add) * 2) {
+        slots <<= 1;
+    }
+
+    chunk = HAL_Malloc(sizeof(SubdevSessionChunk) + add * sizeof(SubdevSession));
+    if (NULL == chunk) {
+        Log_e("Not enough memory for %u sessions", (unsigned int)(table->capacity + add));
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    if (NULL == table->index || slots != table->mask + 1) {
+        index = HAL_Malloc(slots * sizeof(SubdevSession *));
+        if (NULL == index) {
+            Log_e("Not enough memory for %u sessions", (unsigned int)(table->capacity + add));
+            HAL_Free(chunk);
+            return QCLOUD_ERR_MALLOC;
+        }
+        memset(index, 0, slots * sizeof(SubdevSession *));
+
+        for (i = 0; NULL != table->index && i <= table->mask; i++) {
+            if (NULL != table->index[i]) {
+                slot = table->index[i]->hash & (slots - 1);
+                while (NULL != index[slot]) {
+                    slot = (slot + 1) & (slots - 1);
+                }
+                index[slot] = table->index[i];
+            }
+        }
+        HAL_Free(table->index);
+        table->index = index;
+        table->mask  = slots - 1;
+    }
+
+    for (i = add; i > 0; i--) {
+        chunk->records[i - 1].in_use = false;
+        chunk->records[i - 1].batch  = NULL;
+        chunk->records[i - 1].next   = table->free_list;
+        table->free_list             = &chunk->records[i - 1];
+    }
+    chunk->next     = table->chunks;
+    table->chunks   = chunk;
+    table->capacity += add;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int subdev_session_table_init(Gateway *gateway, uint32_t limit)
+{
+    POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_INVAL);
+
+    SubdevSessionTable *table = &gateway->sessions;
+
+    memset(table, 0, sizeof(SubdevSessionTable));
+    table->limit = limit;
+
+    IOT_FUNC_EXIT_RC(_subdev_session_grow(table));
+}
+
+void subdev_session_table_deinit(Gateway *gateway)
+{
+    POINTER_SANITY_CHECK_RTN(gateway);
+
+    SubdevSessionChunk *chunk;
+
+    while (NULL != (chunk = gateway->sessions.chunks)) {
+        gateway->sessions.chunks = chunk->next;
+        HAL_Free(chunk);
+    }
+    HAL_Free(gateway->sessions.index);
+    memset(&gateway->sessions, 0, sizeof(SubdevSessionTable));
+}
+
 SubdevSession *subdev_find_session(Gateway *gateway, char *product_id, char *device_name)
 {
     POINTER_SANITY_CHECK(gateway, NULL);
     STRING_PTR_SANITY_CHECK(product_id, NULL);
     STRING_PTR_SANITY_CHECK(device_name, NULL);
 
-    SubdevSession *session = gateway->session_list;
+    SubdevSessionTable *table = &gateway->sessions;
+    uint32_t            slot;
 
-    /* session is exist */
-    while (session) {
-        if (0 == strcmp(session->product_id, product_id) && 0 == strcmp(session->device_name, device_name)) {
-            IOT_FUNC_EXIT_RC(session);
-        }
-        session = session->next;
+    if (0 == table->count) {
+        IOT_FUNC_EXIT_RC(NULL);
     }
 
-    IOT_FUNC_EXIT_RC(NULL);
+    slot = _subdev_session_slot(table, _subdev_session_hash(product_id, device_name), product_id, device_name);
+
+    IOT_FUNC_EXIT_RC(table->index[slot]);
 }
 
 SubdevSession *subdev_add_session(Gateway *gateway, char *product_id, char *device_name)
@@ -551,58 +698,91 @@ SubdevSession *subdev_add_session(Gateway *gateway, char *product_id, char *devi
     STRING_PTR_SANITY_CHECK(product_id, NULL);
     STRING_PTR_SANITY_CHECK(device_name, NULL);
 
-    SubdevSession *session = HAL_Malloc(sizeof(SubdevSession));
-    if (session == NULL) {
-        Log_e("Not enough memory");
+    SubdevSessionTable *table   = &gateway->sessions;
+    SubdevSession *     session = NULL;
+    uint32_t            hash    = 0;
+    uint32_t            slot    = 0;
+
+    if (strlen(product_id) > MAX_SIZE_OF_PRODUCT_ID || strlen(device_name) > MAX_SIZE_OF_DEVICE_NAME) {
+        Log_e("invalid sub-device %s/%s", product_id, device_name);
         IOT_FUNC_EXIT_RC(NULL);
     }
 
+    hash = _subdev_session_hash(product_id, device_name);
+    slot = _subdev_session_slot(table, hash, product_id, device_name);
+    if (NULL != table->index[slot]) {
+        IOT_FUNC_EXIT_RC(table->index[slot]);
+    }
+
+    if (NULL == table->free_list) {
+        if (QCLOUD_RET_SUCCESS != _subdev_session_grow(table)) {
+            IOT_FUNC_EXIT_RC(NULL);
+        }
+        /* index may be rebuilt larger */
+        slot = _subdev_session_slot(table, hash, product_id, device_name);
+    }
+
+    session          = table->free_list;
+    table->free_list = session->next;
     memset(session, 0, sizeof(SubdevSession));
-    /* add session to list */
-    session->next         = gateway->session_list;
-    gateway->session_list = session;
-
-    int size = strlen(product_id);
-    strncpy(session->product_id, product_id, size);
-    session->product_id[size] = '\0';
-    size                      = strlen(device_name);
-    strncpy(session->device_name, device_name, size);
-    session->device_name[size] = '\0';
-    session->session_status    = SUBDEV_SEESION_STATUS_INIT;
+    strcpy(session->product_id, product_id);
+    strcpy(session->device_name, device_name);
+    session->session_status = SUBDEV_SEESION_STATUS_INIT;
+    session->hash           = hash;
+    session->in_use         = true;
+
+    table->index[slot] = session;
+    table->count++;
 
     IOT_FUNC_EXIT_RC(session);
 }
 
 int subdev_remove_session(Gateway *gateway, char *product_id, char *device_name)
 {
-    SubdevSession *cur_session = NULL, *pre_session = NULL;
-
     POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_FAILURE);
     STRING_PTR_SANITY_CHECK(product_id, QCLOUD_ERR_FAILURE);
     STRING_PTR_SANITY_CHECK(device_name, QCLOUD_ERR_FAILURE);
 
-    pre_session = cur_session = gateway->session_list;
-    if (NULL == cur_session) {
+    SubdevSessionTable *table = &gateway->sessions;
+    SubdevSession *     session;
+    uint32_t            hole, slot, home;
+
+    if (0 == table->count) {
         Log_e("session list is empty");
         IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
     }
 
-    while (cur_session) {
-        if (0 == strncmp(cur_session->product_id, product_id, MAX_SIZE_OF_PRODUCT_ID) &&
-            0 == strncmp(cur_session->device_name, device_name, MAX_SIZE_OF_DEVICE_NAME)) {
-            if (cur_session == gateway->session_list) {
-                gateway->session_list = cur_session->next;
-            } else {
-                pre_session->next = cur_session->next;
-            }
-            HAL_Free(cur_session);
-            IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    hole    = _subdev_session_slot(table, _subdev_session_hash(product_id, device_name), product_id, device_name);
+    session = table->index[hole];
+    if (NULL == session) {
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+    }
+
+    /* shift the following entries of the probe run back, so no tombstone is needed */
+    table->index[hole] = NULL;
+    slot               = hole;
+    for (;;) {
+        slot = (slot + 1) & table->mask;
+        if (NULL == table->index[slot]) {
+            break;
         }
-        pre_session = cur_session;
-        cur_session = cur_session->next;
+        home = table->index[slot]->hash & table->mask;
+        /* leave the entry if its home slot lies cyclically in (hole, slot] */
+        if (hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot)) {
+            continue;
+        }
+        table->index[hole] = table->index[slot];
+        table->index[slot] = NULL;
+        hole               = slot;
     }
 
-    IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+    session->in_use  = false;
+    session->batch   = NULL;
+    session->next    = table->free_list;
+    table->free_list = session;
+    table->count--;
+
+    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
 int gateway_publish_sync(Gateway *gateway, char *topic, PublishParams *params, int32_t *result)
@@ -636,6 +816,372 @@ int gateway_publish_sync(Gateway *gateway, char *topic, PublishParams *params, i
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+/* The result of one batch device, called back after the gateway lock is released */
+typedef struct _SubdevBatchResult {
+    char                        product_id[MAX_SIZE_OF_PRODUCT_ID + 1];
+    char                        device_name[MAX_SIZE_OF_DEVICE_NAME + 1];
+    int                         result;
+    GatewaySubdevResultCallback callback;
+    void *                      user_data;
+} SubdevBatchResult;
+
+static void _subdev_batch_free(Gateway *gateway, SubdevBatch *batch)
+{
+    SubdevBatch **cur = &gateway->batch_list;
+
+    while (*cur && *cur != batch) {
+        cur = &(*cur)->next;
+    }
+    if (*cur) {
+        *cur = batch->next;
+    }
+    HAL_Free(batch);
+}
+
+/**
+ * @brief finish one device of its batch, gateway lock should be held
+ */
+static void _subdev_batch_finish(Gateway *gateway, SubdevSession *session, int result, SubdevBatchResult *out)
+{
+    SubdevBatch *batch = session->batch;
+
+    memcpy(out->product_id, session->product_id, sizeof(out->product_id));
+    memcpy(out->device_name, session->device_name, sizeof(out->device_name));
+    out->result    = result;
+    out->callback  = batch->callback;
+    out->user_data = batch->user_data;
+
+    batch->members[session->batch_pos] = NULL;
+    session->batch                     = NULL;
+    if (0 == result) {
+        session->session_status = batch->target_status;
+    }
+
+    /* same as the sync request, session is dropped after failed online or successful offline */
+    if ((0 != result && SUBDEV_SEESION_STATUS_ONLINE == batch->target_status) ||
+        (0 == result && SUBDEV_SEESION_STATUS_OFFLINE == batch->target_status)) {
+        subdev_remove_session(gateway, out->product_id, out->device_name);
+    }
+
+    if (--batch->pending == 0) {
+        _subdev_batch_free(gateway, batch);
+    }
+}
+
+static void _subdev_batch_callback(Gateway *gateway, SubdevBatchResult *res)
+{
+    if (NULL != res->callback) {
+        res->callback(gateway, res->product_id, res->device_name, res->result, res->user_data);
+    }
+}
+
+/**
+ * @brief take batch, or any timed out batch if batch is NULL, for failing its devices, gateway
+ * lock should be held
+ *
+ * @return the batch, or NULL if there is no such batch any more
+ */
+static SubdevBatch *_subdev_batch_claim(Gateway *gateway, SubdevBatch *batch)
+{
+    SubdevBatch *cur;
+
+    for (cur = gateway->batch_list; cur; cur = cur->next) {
+        if (!cur->failing && ((NULL == batch && expired(&cur->timer)) || cur == batch)) {
+            cur->failing = true;
+            return cur;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief fail the devices of a claimed batch still waiting, in one pass over its members
+ *
+ * replies skip a failing batch, so only this pass finishes its devices and frees it with the last one
+ */
+static void _subdev_batch_fail(Gateway *gateway, SubdevBatch *batch, int result)
+{
+    SubdevBatchResult res;
+    int               i;
+    bool              last = false;
+
+    for (i = 0; i < GATEWAY_BATCH_MAX_DEVICES && !last; i++) {
+        res.callback = NULL;
+
+        HAL_MutexLock(gateway->lock);
+        if (i >= batch->member_cnt) {
+            /* nothing waiting at all */
+            _subdev_batch_free(gateway, batch);
+            last = true;
+        } else if (NULL != batch->members[i]) {
+            last = 1 == batch->pending;
+            _subdev_batch_finish(gateway, batch->members[i], result, &res);
+        }
+        HAL_MutexUnlock(gateway->lock);
+
+        /* one device at a time, callback is called without lock */
+        _subdev_batch_callback(gateway, &res);
+    }
+}
+
+/**
+ * @brief attach one sub-device to batch, gateway lock should be held
+ */
+static int _subdev_batch_add(Gateway *gateway, SubdevBatch *batch, GatewayParam *param)
+{
+    SubdevSession *session = subdev_find_session(gateway, param->subdev_product_id, param->subdev_device_name);
+
+    if (SUBDEV_SEESION_STATUS_ONLINE == batch->target_status) {
+        if (NULL == session) {
+            session = subdev_add_session(gateway, param->subdev_product_id, param->subdev_device_name);
+            if (NULL == session) {
+                return QCLOUD_ERR_GATEWAY_CREATE_SESSION_FAIL;
+            }
+        } else if (NULL != session->batch) {
+            return QCLOUD_ERR_GATEWAY_SUBDEV_BUSY;
+        } else if (SUBDEV_SEESION_STATUS_ONLINE == session->session_status) {
+            return QCLOUD_ERR_GATEWAY_SUBDEV_ONLINE;
+        }
+    } else {
+        if (NULL == session) {
+            return QCLOUD_ERR_GATEWAY_SESSION_NO_EXIST;
+        } else if (NULL != session->batch) {
+            return QCLOUD_ERR_GATEWAY_SUBDEV_BUSY;
+        } else if (SUBDEV_SEESION_STATUS_OFFLINE == session->session_status) {
+            subdev_remove_session(gateway, param->subdev_product_id, param->subdev_device_name);
+            return QCLOUD_ERR_GATEWAY_SUBDEV_OFFLINE;
+        }
+    }
+
+    session->batch     = batch;
+    session->batch_pos = batch->member_cnt;
+    batch->members[batch->member_cnt++] = session;
+    batch->pending++;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int gateway_subdev_status_batch(Gateway *gateway, GatewayParam param[], int count, bool online,
+                                GatewaySubdevResultCallback callback, void *user_data)
+{
+    int           rc                                 = QCLOUD_RET_SUCCESS;
+    int           index                              = 0;
+    int           size                               = 0;
+    size_t        len                                = 0;
+    char          topic[MAX_SIZE_OF_CLOUD_TOPIC + 1] = {0};
+    char *        payload                            = NULL;
+    SubdevBatch * batch                              = NULL;
+    PublishParams params                             = DEFAULT_PUB_PARAMS;
+    const char *  op_str                             = online ? GATEWAY_ONLINE_OP_STR : GATEWAY_OFFLIN_OP_STR;
+    size_t        payload_size                       = 0;
+    size_t        reply_room                         = 0;
+    size_t        reply_len                          = 0;
+    size_t        entry_len                          = 0;
+
+    POINTER_SANITY_CHECK(gateway, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(param, QCLOUD_ERR_INVAL);
+    NUMBERIC_SANITY_CHECK(count, QCLOUD_ERR_INVAL);
+
+    for (index = 0; index < count; index++) {
+        STRING_PTR_SANITY_CHECK(param[index].subdev_product_id, QCLOUD_ERR_INVAL);
+        STRING_PTR_SANITY_CHECK(param[index].subdev_device_name, QCLOUD_ERR_INVAL);
+        if (strlen(param[index].subdev_product_id) > MAX_SIZE_OF_PRODUCT_ID ||
+            strlen(param[index].subdev_device_name) > MAX_SIZE_OF_DEVICE_NAME) {
+            Log_e("invalid sub-device %s/%s", param[index].subdev_product_id, param[index].subdev_device_name);
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+        }
+    }
+
+    size = HAL_Snprintf(topic, MAX_SIZE_OF_CLOUD_TOPIC + 1, GATEWAY_TOPIC_OPERATION_FMT,
+                        STRING_PTR_PRINT_SANITY_CHECK(param[0].product_id),
+                        STRING_PTR_PRINT_SANITY_CHECK(param[0].device_name));
+    if (size < 0 || size > MAX_SIZE_OF_CLOUD_TOPIC) {
+        Log_e("buf size < topic length!");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+    }
+
+    /* room for a full batch, ids are checked above */
+    payload_size = sizeof(GATEWAY_PAYLOAD_STATUS_BATCH_PREFIX_FMT) + sizeof(GATEWAY_OFFLIN_OP_STR) +
+                   GATEWAY_BATCH_MAX_DEVICES * (sizeof(GATEWAY_PAYLOAD_STATUS_BATCH_ENTRY_FMT) +
+                                                MAX_SIZE_OF_PRODUCT_ID + MAX_SIZE_OF_DEVICE_NAME);
+    payload      = HAL_Malloc(payload_size);
+    if (NULL == payload) {
+        Log_e("Not enough memory");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MALLOC);
+    }
+
+    /* the reply lists every device of the batch, it must fit in the MQTT read buffer */
+    reply_room = ((Qcloud_IoT_Client *)gateway->mqtt)->read_buf_size;
+    reply_room = reply_room > GATEWAY_BATCH_REPLY_RESERVE ? reply_room - GATEWAY_BATCH_REPLY_RESERVE : 0;
+
+    index = 0;
+    while (index < count && QCLOUD_RET_SUCCESS == rc) {
+        batch = HAL_Malloc(sizeof(SubdevBatch));
+        if (NULL == batch) {
+            Log_e("Not enough memory");
+            rc = QCLOUD_ERR_MALLOC;
+            break;
+        }
+        memset(batch, 0, sizeof(SubdevBatch));
+        batch->target_status = online ? SUBDEV_SEESION_STATUS_ONLINE : SUBDEV_SEESION_STATUS_OFFLINE;
+        batch->callback      = callback;
+        batch->user_data     = user_data;
+        InitTimer(&batch->timer);
+        countdown_ms(&batch->timer, GATEWAY_BATCH_TIMEOUT_MS);
+
+        HAL_MutexLock(gateway->lock);
+        batch->next         = gateway->batch_list;
+        gateway->batch_list = batch;
+        HAL_MutexUnlock(gateway->lock);
+
+        len       = HAL_Snprintf(payload, payload_size, GATEWAY_PAYLOAD_STATUS_BATCH_PREFIX_FMT, op_str);
+        reply_len = 0;
+        for (; index < count && batch->member_cnt < GATEWAY_BATCH_MAX_DEVICES; index++) {
+            GatewayParam *    subdev = &param[index];
+            SubdevBatchResult res;
+
+            entry_len = sizeof(GATEWAY_BATCH_REPLY_ENTRY) + strlen(subdev->subdev_product_id) +
+                        strlen(subdev->subdev_device_name);
+            if (batch->member_cnt > 0 && reply_len + entry_len > reply_room) {
+                break;
+            }
+
+            HAL_MutexLock(gateway->lock);
+            res.result = _subdev_batch_add(gateway, batch, subdev);
+            HAL_MutexUnlock(gateway->lock);
+
+            if (QCLOUD_RET_SUCCESS != res.result) {
+                Log_w("skip sub-device %s/%s: %d", subdev->subdev_product_id, subdev->subdev_device_name,
+                      res.result);
+                HAL_Snprintf(res.product_id, sizeof(res.product_id), "%s", subdev->subdev_product_id);
+                HAL_Snprintf(res.device_name, sizeof(res.device_name), "%s", subdev->subdev_device_name);
+                res.callback  = callback;
+                res.user_data = user_data;
+                _subdev_batch_callback(gateway, &res);
+                continue;
+            }
+
+            len += HAL_Snprintf(payload + len, payload_size - len, GATEWAY_PAYLOAD_STATUS_BATCH_ENTRY_FMT,
+                                subdev->subdev_product_id, subdev->subdev_device_name);
+            reply_len += entry_len;
+        }
+
+        if (0 == batch->pending) {
+            HAL_MutexLock(gateway->lock);
+            _subdev_batch_free(gateway, batch);
+            HAL_MutexUnlock(gateway->lock);
+            continue;
+        }
+
+        /* replace the trailing comma of the last entry */
+        len += HAL_Snprintf(payload + len - 1, payload_size - len + 1, GATEWAY_PAYLOAD_STATUS_BATCH_SUFFIX) - 1;
+
+        params.qos         = QOS0;
+        params.payload_len = len;
+        params.payload     = payload;
+
+        rc = IOT_Gateway_Publish(gateway, topic, &params);
+        if (rc < 0) {
+            Log_e("publish batch fail: %d", rc);
+            HAL_MutexLock(gateway->lock);
+            batch = _subdev_batch_claim(gateway, batch);
+            HAL_MutexUnlock(gateway->lock);
+            if (NULL != batch) {
+                _subdev_batch_fail(gateway, batch, rc);
+            }
+        } else {
+            rc = QCLOUD_RET_SUCCESS;
+        }
+    }
+
+    HAL_Free(payload);
+
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+void gateway_subdev_batch_reply(Gateway *gateway, char *devices, bool online)
+{
+    char *            product_id  = NULL;
+    char *            device_name = NULL;
+    char *            pos         = NULL;
+    char *            entry       = NULL;
+    int               entry_len   = 0;
+    int               entry_type  = 0;
+    char              old_ch      = 0;
+    int32_t           result      = 0;
+    SubdevSession *   session     = NULL;
+    SubdevBatchResult res;
+
+    json_array_for_each_entry(devices, pos, entry, entry_len, entry_type)
+    {
+        if (!entry)
+            continue;
+        backup_json_str_last_char(entry, entry_len, old_ch);
+        res.callback = NULL;
+
+        if (get_json_product_id(entry, &product_id) && get_json_device_name(entry, &device_name) &&
+            get_json_result(entry, &result)) {
+            HAL_MutexLock(gateway->lock);
+            session = subdev_find_session(gateway, product_id, device_name);
+            if (session && session->batch && !session->batch->failing &&
+                session->batch->target_status ==
+                    (online ? SUBDEV_SEESION_STATUS_ONLINE : SUBDEV_SEESION_STATUS_OFFLINE)) {
+                _subdev_batch_finish(gateway, session, result, &res);
+            }
+            HAL_MutexUnlock(gateway->lock);
+        }
+
+        HAL_Free(product_id);
+        HAL_Free(device_name);
+        product_id  = NULL;
+        device_name = NULL;
+        restore_json_str_last_char(entry, entry_len, old_ch);
+
+        _subdev_batch_callback(gateway, &res);
+    }
+}
+
+int gateway_subdev_batch_expire(Gateway *gateway)
+{
+    SubdevBatch *batch;
+    int          pending = 0;
+
+    for (;;) {
+        HAL_MutexLock(gateway->lock);
+        batch = _subdev_batch_claim(gateway, NULL);
+        HAL_MutexUnlock(gateway->lock);
+        if (NULL == batch) {
+            break;
+        }
+        _subdev_batch_fail(gateway, batch, QCLOUD_ERR_GATEWAY_SESSION_TIMEOUT);
+    }
+
+    HAL_MutexLock(gateway->lock);
+    for (batch = gateway->batch_list; batch; batch = batch->next) {
+        pending += batch->pending;
+    }
+    HAL_MutexUnlock(gateway->lock);
+
+    return pending;
+}
+
+void gateway_subdev_batch_clear(Gateway *gateway)
+{
+    int i;
+
+    HAL_MutexLock(gateway->lock);
+    while (gateway->batch_list) {
+        for (i = 0; i < gateway->batch_list->member_cnt; i++) {
+            if (NULL != gateway->batch_list->members[i]) {
+                gateway->batch_list->members[i]->batch = NULL;
+            }
+        }
+        _subdev_batch_free(gateway, gateway->batch_list);
+    }
+    HAL_MutexUnlock(gateway->lock);
+}
+
 #ifdef AUTH_MODE_CERT
 static int gen_key_from_cert_file(const char *file_path, char *keybuff, int buff_len)
 {
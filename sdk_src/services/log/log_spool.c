@@ -0,0 +1,361 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "qcloud_iot_export.h"
+#include "qcloud_iot_import.h"
+
+#ifdef LOG_UPLOAD
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_spool.h"
+
+#define LOG_SPOOL_INDEX_MAGIC  (0x58444953) /* "SIDX" */
+#define LOG_SPOOL_RECORD_MAGIC (0x44524353) /* "SCRD" */
+#define LOG_SPOOL_NAME_LEN     (LOG_SPOOL_PATH_LEN + 16)
+
+#define SPOOL_SEG_SIZE(spool, seq) ((spool)->index.seg_size[(seq) % LOG_SPOOL_MAX_SEGMENTS])
+
+typedef struct {
+    uint32_t magic;
+    uint32_t len;
+    uint32_t crc;
+} LogSpoolRecordHead;
+
+static uint32_t _spool_crc32(uint32_t crc, const void *data, size_t len)
+{
+    /* half-byte table of the reflected polynomial 0xEDB88320 */
+    static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    const uint8_t *       p         = data;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+static void _spool_seg_name(LogSpool *spool, uint32_t seq, char *name)
+{
+    HAL_Snprintf(name, LOG_SPOOL_NAME_LEN, "%s.%u", spool->path, (unsigned int)seq);
+}
+
+static int _spool_save_index(LogSpool *spool)
+{
+    char   name[LOG_SPOOL_NAME_LEN];
+    char   tmp_name[LOG_SPOOL_NAME_LEN];
+    void * fp;
+    size_t len;
+
+    spool->index.crc = _spool_crc32(0, &spool->index, offsetof(LogSpoolIndex, crc));
+
+    HAL_Snprintf(name, sizeof(name), "%s.idx", spool->path);
+    HAL_Snprintf(tmp_name, sizeof(tmp_name), "%s.idx.tmp", spool->path);
+
+    /* write a new index then rename it over the old one */
+    if ((fp = HAL_FileOpen(tmp_name, "wb")) == NULL) {
+        UPLOAD_ERR("fail to open file %s", tmp_name);
+        return QCLOUD_ERR_FAILURE;
+    }
+    len = HAL_FileWrite(&spool->index, 1, sizeof(spool->index), fp);
+    HAL_FileFlush(fp);
+    HAL_FileClose(fp);
+    if (len != sizeof(spool->index)) {
+        UPLOAD_ERR("fail to write file %s", tmp_name);
+        HAL_FileRemove(tmp_name);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    if (HAL_FileRename(tmp_name, name) != 0) {
+        /* some file systems refuse to rename over an existing file */
+        HAL_FileRemove(name);
+        if (HAL_FileRename(tmp_name, name) != 0) {
+            UPLOAD_ERR("fail to rename file %s", tmp_name);
+            return QCLOUD_ERR_FAILURE;
+        }
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static bool _spool_load_index(LogSpool *spool)
+{
+    char          name[LOG_SPOOL_NAME_LEN];
+    void *        fp;
+    size_t        len;
+    LogSpoolIndex *index = &spool->index;
+
+    HAL_Snprintf(name, sizeof(name), "%s.idx", spool->path);
+    if ((fp = HAL_FileOpen(name, "rb")) == NULL) {
+        return false;
+    }
+    len = HAL_FileRead(index, 1, sizeof(LogSpoolIndex), fp);
+    HAL_FileClose(fp);
+
+    return len == sizeof(LogSpoolIndex) && index->magic == LOG_SPOOL_INDEX_MAGIC &&
+           index->crc == _spool_crc32(0, index, offsetof(LogSpoolIndex, crc)) &&
+           index->tail_seq - index->head_seq < LOG_SPOOL_MAX_SEGMENTS &&
+           index->head_offset <= SPOOL_SEG_SIZE(spool, index->head_seq);
+}
+
+static void _spool_evict_head(LogSpool *spool)
+{
+    char           name[LOG_SPOOL_NAME_LEN];
+    LogSpoolIndex *index = &spool->index;
+
+    UPLOAD_ERR("spool full, drop segment %u of %u bytes", (unsigned int)index->head_seq,
+               (unsigned int)(SPOOL_SEG_SIZE(spool, index->head_seq) - index->head_offset));
+
+    _spool_seg_name(spool, index->head_seq, name);
+    HAL_FileRemove(name);
+    SPOOL_SEG_SIZE(spool, index->head_seq) = 0;
+
+    if (spool->peek_seq == index->head_seq) {
+        spool->peek_seq    = index->head_seq + 1;
+        spool->peek_offset = 0;
+    }
+    index->head_seq++;
+    index->head_offset = 0;
+}
+
+int log_spool_init(LogSpool *spool, const char *path, size_t max_size)
+{
+    if (spool == NULL || path == NULL || strlen(path) >= LOG_SPOOL_PATH_LEN) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    memset(spool, 0, sizeof(LogSpool));
+    strncpy(spool->path, path, LOG_SPOOL_PATH_LEN - 1);
+
+    spool->max_segments = max_size / LOG_SPOOL_SEGMENT_SIZE;
+    if (spool->max_segments == 0) {
+        spool->max_segments = 1;
+    } else if (spool->max_segments > LOG_SPOOL_MAX_SEGMENTS) {
+        spool->max_segments = LOG_SPOOL_MAX_SEGMENTS;
+    }
+
+    if (!_spool_load_index(spool)) {
+        /* stale segment files are truncated when their seq is reused */
+        memset(&spool->index, 0, sizeof(LogSpoolIndex));
+        spool->index.magic = LOG_SPOOL_INDEX_MAGIC;
+    }
+    spool->peek_seq    = spool->index.head_seq;
+    spool->peek_offset = spool->index.head_offset;
+
+    /* the cap may be smaller than last time */
+    while (spool->index.tail_seq - spool->index.head_seq + 1 > spool->max_segments) {
+        _spool_evict_head(spool);
+    }
+
+    return _spool_save_index(spool);
+}
+
+int log_spool_append(LogSpool *spool, const char *data, size_t len)
+{
+    char               name[LOG_SPOOL_NAME_LEN];
+    void *             fp;
+    uint32_t           offset;
+    size_t             written;
+    LogSpoolRecordHead head;
+    LogSpoolIndex *    index   = &spool->index;
+    size_t             rec_len = sizeof(LogSpoolRecordHead) + len;
+
+    if (data == NULL || len == 0 || rec_len > LOG_SPOOL_SEGMENT_SIZE) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    /* roll to a new segment, evicting the oldest ones beyond the cap */
+    if (SPOOL_SEG_SIZE(spool, index->tail_seq) + rec_len > LOG_SPOOL_SEGMENT_SIZE) {
+        index->tail_seq++;
+        SPOOL_SEG_SIZE(spool, index->tail_seq) = 0;
+        while (index->tail_seq - index->head_seq + 1 > spool->max_segments) {
+            _spool_evict_head(spool);
+        }
+    }
+
+    /* write at the indexed size, so a torn record of a failed append is overwritten */
+    offset = SPOOL_SEG_SIZE(spool, index->tail_seq);
+    _spool_seg_name(spool, index->tail_seq, name);
+    fp = offset ? HAL_FileOpen(name, "rb+") : NULL;
+    if (fp == NULL) {
+        offset = 0;
+        fp     = HAL_FileOpen(name, "wb");
+    }
+    if (fp == NULL) {
+        UPLOAD_ERR("fail to open file %s", name);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    head.magic = LOG_SPOOL_RECORD_MAGIC;
+    head.len   = len;
+    head.crc   = _spool_crc32(0, data, len);
+
+    written = 0;
+    if (HAL_FileSeek(fp, offset, SEEK_SET) == 0) {
+        written = HAL_FileWrite(&head, 1, sizeof(head), fp);
+        written += HAL_FileWrite(data, 1, len, fp);
+    }
+    HAL_FileClose(fp);
+    if (written != rec_len) {
+        UPLOAD_ERR("fail to write file %s. %u of %u", name, (unsigned int)written, (unsigned int)rec_len);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    SPOOL_SEG_SIZE(spool, index->tail_seq) = offset + rec_len;
+
+    return _spool_save_index(spool);
+}
+
+int log_spool_peek(LogSpool *spool, char *buf, size_t buf_len, size_t *data_len)
+{
+    char               name[LOG_SPOOL_NAME_LEN];
+    void *             fp = NULL;
+    LogSpoolRecordHead head;
+    LogSpoolIndex *    index  = &spool->index;
+    uint32_t           seq    = index->head_seq;
+    uint32_t           offset = index->head_offset;
+
+    *data_len = 0;
+
+    while (1) {
+        if (offset >= SPOOL_SEG_SIZE(spool, seq)) {
+            if (seq == index->tail_seq) {
+                break;
+            }
+            if (fp) {
+                HAL_FileClose(fp);
+                fp = NULL;
+            }
+            seq++;
+            offset = 0;
+            continue;
+        }
+
+        if (fp == NULL) {
+            _spool_seg_name(spool, seq, name);
+            if ((fp = HAL_FileOpen(name, "rb")) == NULL) {
+                UPLOAD_ERR("fail to open file %s, skip it", name);
+                offset = SPOOL_SEG_SIZE(spool, seq);
+                continue;
+            }
+        }
+
+        if (HAL_FileSeek(fp, offset, SEEK_SET) != 0 || HAL_FileRead(&head, 1, sizeof(head), fp) != sizeof(head) ||
+            head.magic != LOG_SPOOL_RECORD_MAGIC || head.len == 0 ||
+            offset + sizeof(head) + head.len > SPOOL_SEG_SIZE(spool, seq)) {
+            /* records are not self-synchronizing, drop the rest of this segment */
+            UPLOAD_ERR("corrupted spool segment %u at %u, skip it", (unsigned int)seq, (unsigned int)offset);
+            offset = SPOOL_SEG_SIZE(spool, seq);
+            continue;
+        }
+
+        if (*data_len + head.len > buf_len) {
+            if (*data_len) {
+                break;
+            }
+            UPLOAD_ERR("spooled record of %u bytes exceeds buffer, drop it", (unsigned int)head.len);
+            offset += sizeof(head) + head.len;
+            continue;
+        }
+
+        if (HAL_FileRead(buf + *data_len, 1, head.len, fp) != head.len) {
+            UPLOAD_ERR("fail to read spool segment %u at %u, skip it", (unsigned int)seq, (unsigned int)offset);
+            offset = SPOOL_SEG_SIZE(spool, seq);
+            continue;
+        }
+        offset += sizeof(head) + head.len;
+
+        if (_spool_crc32(0, buf + *data_len, head.len) != head.crc) {
+            UPLOAD_ERR("spooled record CRC mismatch in segment %u, drop it", (unsigned int)seq);
+            continue;
+        }
+        *data_len += head.len;
+    }
+
+    if (fp) {
+        HAL_FileClose(fp);
+    }
+
+    spool->peek_seq    = seq;
+    spool->peek_offset = offset;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int log_spool_commit(LogSpool *spool)
+{
+    char           name[LOG_SPOOL_NAME_LEN];
+    LogSpoolIndex *index = &spool->index;
+
+    /* peek position was evicted meanwhile */
+    if (spool->peek_seq - index->head_seq > index->tail_seq - index->head_seq) {
+        spool->peek_seq    = index->head_seq;
+        spool->peek_offset = index->head_offset;
+    }
+
+    while (index->head_seq != spool->peek_seq) {
+        _spool_seg_name(spool, index->head_seq, name);
+        HAL_FileRemove(name);
+        SPOOL_SEG_SIZE(spool, index->head_seq) = 0;
+        index->head_seq++;
+    }
+    index->head_offset = spool->peek_offset;
+
+    /* fully drained, restart the last segment from the beginning */
+    if (index->head_offset >= SPOOL_SEG_SIZE(spool, index->head_seq)) {
+        _spool_seg_name(spool, index->head_seq, name);
+        HAL_FileRemove(name);
+        SPOOL_SEG_SIZE(spool, index->head_seq) = 0;
+        index->head_offset                     = 0;
+        spool->peek_offset                     = 0;
+    }
+
+    return _spool_save_index(spool);
+}
+
+size_t log_spool_size(LogSpool *spool)
+{
+    LogSpoolIndex *index = &spool->index;
+    size_t         total = 0;
+    uint32_t       seq;
+
+    for (seq = index->head_seq; seq != index->tail_seq + 1; seq++) {
+        total += SPOOL_SEG_SIZE(spool, seq);
+    }
+
+    return total - index->head_offset;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
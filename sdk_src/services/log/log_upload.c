@@ -36,9 +36,11 @@ extern "C" {
 
 #include "lite-utils.h"
 #include "utils_param_check.h"
+#include "log_spool.h"
 #include "log_upload.h"
 #include "qcloud_iot_common.h"
 #include "qcloud_iot_ca.h"
+#include "utils_deflate.h"
 #include "utils_hmac.h"
 #include "utils_httpc.h"
 #include "utils_timer.h"
@@ -55,6 +57,10 @@ extern "C" {
 #define LOG_LOW_BUFFER_THRESHOLD (LOG_UPLOAD_BUFFER_SIZE / 4)
 #define SIGN_KEY_SIZE            (24)
 
+/* size of one deflated chunk of the log post body */
+#define LOG_DEFLATE_CHUNK_SIZE (512)
+#define LOG_HTTP_SEND_TIMEOUT_MS (5000)
+
 #define POINTER_CHECK_RET_ERR(ptr, err) \
     do {                                \
         if (NULL == (ptr)) {            \
@@ -88,7 +94,9 @@ typedef struct {
     LogHTTPStruct *http_client;
     bool           upload_only_in_comm_err;
 
+    /* producers append to log_buffer while upload_buffer is being posted */
     char *   log_buffer;
+    char *   upload_buffer;
     uint32_t log_index;
     void *   lock_buf;
     char     sign_key[SIGN_KEY_SIZE + 1];
@@ -102,7 +110,12 @@ typedef struct {
     LogDelFunc     del_func;
     LogGetSizeFunc get_size_func;
 
+    LogSpool spool;
+    Timer    replay_timer;
+
     bool log_save_enabled;
+    bool spool_enabled;
+    bool compress_enabled;
     bool log_client_init_done;
 } Qcloud_IoT_Log;
 static Qcloud_IoT_Log *sg_log_client = NULL;
@@ -227,6 +240,7 @@ int init_log_uploader(LogUploadInitParams *init_params)
     pLogClient->mqtt_client             = NULL;
     pLogClient->system_time             = 0;
     pLogClient->upload_only_in_comm_err = false;
+    pLogClient->compress_enabled        = init_params->compress_enabled;
 
     /* all the call back functions are necessary to handle log save and re-upload*/
     if (init_params->save_func != NULL && init_params->read_func != NULL && init_params->del_func != NULL &&
@@ -240,15 +254,27 @@ int init_log_uploader(LogUploadInitParams *init_params)
         pLogClient->log_save_enabled = false;
     }
 
+    if (init_params->spool_path != NULL) {
+        size_t max_size = init_params->spool_max_size ? init_params->spool_max_size : LOG_SPOOL_MAX_SIZE;
+        if (log_spool_init(&pLogClient->spool, init_params->spool_path, max_size) == QCLOUD_RET_SUCCESS) {
+            pLogClient->spool_enabled    = true;
+            pLogClient->log_save_enabled = true;
+        } else {
+            UPLOAD_ERR("log spool init failed: %s", init_params->spool_path);
+        }
+    }
+
     InitTimer(&pLogClient->upload_timer);
     InitTimer(&pLogClient->time_update_timer);
+    InitTimer(&pLogClient->replay_timer);
     if ((pLogClient->lock_buf = HAL_MutexCreate()) == NULL) {
         UPLOAD_ERR("mutex create failed");
         goto err_exit;
     }
 
-    pLogClient->log_buffer = HAL_Malloc(LOG_UPLOAD_BUFFER_SIZE);
-    if (pLogClient->log_buffer == NULL) {
+    pLogClient->log_buffer    = HAL_Malloc(LOG_UPLOAD_BUFFER_SIZE);
+    pLogClient->upload_buffer = HAL_Malloc(LOG_UPLOAD_BUFFER_SIZE);
+    if (pLogClient->log_buffer == NULL || pLogClient->upload_buffer == NULL) {
         UPLOAD_ERR("malloc log buffer failed");
         goto err_exit;
     }
@@ -270,6 +296,7 @@ int init_log_uploader(LogUploadInitParams *init_params)
     memcpy(pLogClient->log_buffer + SIGNATURE_SIZE + CTRL_BYTES_SIZE, init_params->product_id, MAX_SIZE_OF_PRODUCT_ID);
     memcpy(pLogClient->log_buffer + SIGNATURE_SIZE + CTRL_BYTES_SIZE + MAX_SIZE_OF_PRODUCT_ID, init_params->device_name,
            strlen(init_params->device_name));
+    memcpy(pLogClient->upload_buffer, pLogClient->log_buffer, LOG_BUF_FIXED_HEADER_SIZE);
 
     pLogClient->http_client = HAL_Malloc(sizeof(LogHTTPStruct));
     if (NULL == pLogClient->http_client) {
@@ -279,7 +306,8 @@ int init_log_uploader(LogUploadInitParams *init_params)
     memset(pLogClient->http_client, 0, sizeof(LogHTTPStruct));
 
     /* set http request-header parameter */
-    pLogClient->http_client->http.header = "Accept:application/json;*/*\r\n";
+    pLogClient->http_client->http.header     = "Accept:application/json;*/*\r\n";
+    pLogClient->http_client->http.keep_alive = true;
     pLogClient->http_client->url         = iot_get_log_domain(init_params->region);
     pLogClient->http_client->port        = LOG_UPLOAD_SERVER_PORT;
     pLogClient->http_client->ca_crt      = NULL;
@@ -303,6 +331,11 @@ err_exit:
             pLogClient->log_buffer = NULL;
         }
 
+        if (pLogClient->upload_buffer) {
+            HAL_Free(pLogClient->upload_buffer);
+            pLogClient->upload_buffer = NULL;
+        }
+
         if (pLogClient->lock_buf) {
             HAL_MutexDestroy(pLogClient->lock_buf);
             pLogClient->lock_buf = NULL;
@@ -325,9 +358,12 @@ void fini_log_uploader(void)
 
     HAL_MutexLock(pLogClient->lock_buf);
     HAL_Free(pLogClient->http_client);
+    qcloud_http_client_pool_clear();
     pLogClient->http_client = NULL;
     HAL_Free(pLogClient->log_buffer);
     pLogClient->log_buffer = NULL;
+    HAL_Free(pLogClient->upload_buffer);
+    pLogClient->upload_buffer = NULL;
     HAL_MutexUnlock(pLogClient->lock_buf);
     HAL_MutexDestroy(pLogClient->lock_buf);
     HAL_Free(pLogClient);
@@ -369,10 +405,8 @@ int append_to_upload_buffer(const char *log_content, size_t log_size)
         return -1;
     }
 
-    if (HAL_MutexTryLock(pLogClient->lock_buf) != 0) {
-        UPLOAD_ERR("trylock buffer failed!");
-        return -1;
-    }
+    /* upload works on the other buffer, so the lock is only held for buffer swap */
+    HAL_MutexLock(pLogClient->lock_buf);
 
     if ((pLogClient->log_index + log_size + 1) > LOG_UPLOAD_BUFFER_SIZE) {
         countdown_ms(&pLogClient->upload_timer, 0);
@@ -461,6 +495,11 @@ static bool _get_json_ret_code(char *json, int32_t *res)
 }
 #endif
 
+static int _send_deflated_chunk(void *user_data, const uint8_t *data, size_t len)
+{
+    return qcloud_http_send_chunk((HTTPClient *)user_data, (const char *)data, (int)len, LOG_HTTP_SEND_TIMEOUT_MS);
+}
+
 static int _post_one_http_to_server(char *post_buf, size_t post_size)
 {
     int             rc         = 0;
@@ -472,8 +511,18 @@ static int _post_one_http_to_server(char *post_buf, size_t post_size)
     }
 
     pLogClient->http_client->http_data.post_content_type = "text/plain;charset=utf-8";
-    pLogClient->http_client->http_data.post_buf          = post_buf;
-    pLogClient->http_client->http_data.post_buf_len      = post_size;
+    if (pLogClient->compress_enabled) {
+        /* only send the header here, body follows as deflated chunks */
+        pLogClient->http_client->http_data.post_buf              = NULL;
+        pLogClient->http_client->http_data.post_buf_len          = 0;
+        pLogClient->http_client->http_data.is_post_chunked       = true;
+        pLogClient->http_client->http_data.post_content_encoding = "deflate";
+    } else {
+        pLogClient->http_client->http_data.post_buf              = post_buf;
+        pLogClient->http_client->http_data.post_buf_len          = post_size;
+        pLogClient->http_client->http_data.is_post_chunked       = false;
+        pLogClient->http_client->http_data.post_content_encoding = NULL;
+    }
     rc = qcloud_http_client_common(&pLogClient->http_client->http, pLogClient->http_client->url,
                                    pLogClient->http_client->port, pLogClient->http_client->ca_crt, HTTP_POST,
                                    &pLogClient->http_client->http_data);
@@ -481,6 +530,22 @@ static int _post_one_http_to_server(char *post_buf, size_t post_size)
         UPLOAD_ERR("qcloud_http_client_common failed, rc = %d", rc);
         return rc;
     }
+
+    if (pLogClient->compress_enabled) {
+        uint8_t chunk_buf[LOG_DEFLATE_CHUNK_SIZE];
+
+        rc = utils_deflate((const uint8_t *)post_buf, post_size, chunk_buf, sizeof(chunk_buf), _send_deflated_chunk,
+                           &pLogClient->http_client->http);
+        if (rc >= 0) {
+            UPLOAD_DBG("Log client deflate size: %d -> %d", post_size, rc);
+            rc = qcloud_http_send_chunk(&pLogClient->http_client->http, NULL, 0, LOG_HTTP_SEND_TIMEOUT_MS);
+        }
+        if (rc != QCLOUD_RET_SUCCESS) {
+            UPLOAD_ERR("send deflated log failed, rc = %d", rc);
+            qcloud_http_client_close(&pLogClient->http_client->http);
+            return rc;
+        }
+    }
     UPLOAD_DBG("Log client POST size: %d", post_size);
 
 #ifdef LOG_CHECK_HTTP_RET_CODE
@@ -618,6 +683,11 @@ static int _save_log(char *log_buf, size_t log_size)
     if (!pLogClient->log_client_init_done) {
         return QCLOUD_ERR_FAILURE;
     }
+
+    if (pLogClient->spool_enabled) {
+        return log_spool_append(&pLogClient->spool, log_buf, log_size);
+    }
+
     current_size = pLogClient->get_size_func();
 
     /* overwrite the previous saved log to avoid too many saved logs */
@@ -688,6 +758,41 @@ static int _handle_saved_log(void)
     return rc;
 }
 
+/* replay one batch of spooled log, return QCLOUD_RET_SUCCESS when the spool is drained */
+static int _handle_spooled_log(Qcloud_IoT_Log *pLogClient)
+{
+    int    rc;
+    size_t log_size, actual_post_payload;
+    /* the standby buffer is idle outside of do_log_upload's batch upload */
+    char *log_buf = pLogClient->upload_buffer;
+
+    /* rate limit the replay so a long backlog doesn't stall the yield thread */
+    if (!expired(&pLogClient->replay_timer)) {
+        return QCLOUD_ERR_FAILURE;
+    }
+    countdown_ms(&pLogClient->replay_timer, LOG_SPOOL_REPLAY_INTERVAL_MS);
+
+    rc = log_spool_peek(&pLogClient->spool, log_buf + LOG_BUF_FIXED_HEADER_SIZE,
+                        LOG_UPLOAD_BUFFER_SIZE - LOG_BUF_FIXED_HEADER_SIZE - 1, &log_size);
+    if (rc != QCLOUD_RET_SUCCESS) {
+        return rc;
+    }
+
+    if (log_size > 0) {
+        log_buf[LOG_BUF_FIXED_HEADER_SIZE + log_size] = '\0';
+        rc = post_log_to_server(log_buf, LOG_BUF_FIXED_HEADER_SIZE + log_size, &actual_post_payload);
+        if (rc != QCLOUD_RET_SUCCESS && rc != QCLOUD_ERR_INVAL) {
+            UPLOAD_DBG("replay spooled log failed, %u left", (unsigned int)log_spool_size(&pLogClient->spool));
+            return rc;
+        }
+        UPLOAD_DBG("replay spooled log %u", (unsigned int)log_size);
+    }
+
+    log_spool_commit(&pLogClient->spool);
+
+    return log_spool_size(&pLogClient->spool) ? QCLOUD_ERR_FAILURE : QCLOUD_RET_SUCCESS;
+}
+
 static bool _check_force_upload(bool force_upload)
 {
     Qcloud_IoT_Log *pLogClient = get_log_client();
@@ -724,6 +829,7 @@ int do_log_upload(bool force_upload)
 {
     int         rc;
     int         upload_log_size    = 0;
+    char *      upload_buf         = NULL;
     static bool unhandle_saved_log = true;
 
     Qcloud_IoT_Log *pLogClient = get_log_client();
@@ -738,56 +844,38 @@ int do_log_upload(bool force_upload)
 
     /* handle previously saved log */
     if (pLogClient->log_save_enabled && unhandle_saved_log) {
-        rc = _handle_saved_log();
+        rc = pLogClient->spool_enabled ? _handle_spooled_log(pLogClient) : _handle_saved_log();
         if (rc == QCLOUD_RET_SUCCESS) {
             unhandle_saved_log = false;
         }
     }
 
-    /* no more log in buffer */
+    /* swap the buffers so producers keep appending while this batch uploads */
+    HAL_MutexLock(pLogClient->lock_buf);
     if (pLogClient->log_index == LOG_BUF_FIXED_HEADER_SIZE) {
+        /* no more log in buffer */
+        HAL_MutexUnlock(pLogClient->lock_buf);
         return QCLOUD_RET_SUCCESS;
     }
-
-    HAL_MutexLock(pLogClient->lock_buf);
-    upload_log_size = pLogClient->log_index;
+    upload_buf                = pLogClient->log_buffer;
+    upload_log_size           = pLogClient->log_index;
+    pLogClient->log_buffer    = pLogClient->upload_buffer;
+    pLogClient->upload_buffer = upload_buf;
+    _reset_log_buffer(pLogClient);
     HAL_MutexUnlock(pLogClient->lock_buf);
 
     size_t actual_post_payload;
-    rc = post_log_to_server(pLogClient->log_buffer, upload_log_size, &actual_post_payload);
+    rc = post_log_to_server(upload_buf, upload_log_size, &actual_post_payload);
     if (rc != QCLOUD_RET_SUCCESS) {
-        /* save log via user callbacks when log upload fail */
+        /* save log via user callbacks when log upload fail, the uploaded parts
+         * have been moved out of the batch already */
         if (pLogClient->log_save_enabled) {
-            /* new error logs should have been added, update log size */
-            HAL_MutexLock(pLogClient->lock_buf);
-            /* parts of log were uploaded succesfully. Need to move the new logs
-             * forward */
-            if (actual_post_payload) {
-                UPLOAD_DBG("move the new log %d forward", actual_post_payload);
-                memmove(pLogClient->log_buffer + upload_log_size - actual_post_payload,
-                        pLogClient->log_buffer + upload_log_size, pLogClient->log_index - upload_log_size);
-                pLogClient->log_index = pLogClient->log_index - actual_post_payload;
-                memset(pLogClient->log_buffer + pLogClient->log_index, 0,
-                       LOG_UPLOAD_BUFFER_SIZE - pLogClient->log_index);
-            }
-            upload_log_size = pLogClient->log_index;
-            HAL_MutexUnlock(pLogClient->lock_buf);
-            _save_log(pLogClient->log_buffer + LOG_BUF_FIXED_HEADER_SIZE, upload_log_size - LOG_BUF_FIXED_HEADER_SIZE);
+            _save_log(upload_buf + LOG_BUF_FIXED_HEADER_SIZE,
+                      upload_log_size - actual_post_payload - LOG_BUF_FIXED_HEADER_SIZE);
             unhandle_saved_log = true;
         }
     }
 
-    /* move the new log during send_log_to_server */
-    HAL_MutexLock(pLogClient->lock_buf);
-    if (upload_log_size == pLogClient->log_index) {
-        _reset_log_buffer(pLogClient);
-    } else {
-        memmove(pLogClient->log_buffer + LOG_BUF_FIXED_HEADER_SIZE, pLogClient->log_buffer + upload_log_size,
-                pLogClient->log_index - upload_log_size);
-        pLogClient->log_index = pLogClient->log_index - upload_log_size + LOG_BUF_FIXED_HEADER_SIZE;
-        memset(pLogClient->log_buffer + pLogClient->log_index, 0, LOG_UPLOAD_BUFFER_SIZE - pLogClient->log_index);
-    }
-    HAL_MutexUnlock(pLogClient->lock_buf);
     countdown_ms(&pLogClient->upload_timer, LOG_UPLOAD_INTERVAL_MS);
 
     return QCLOUD_RET_SUCCESS;
@@ -31,12 +31,27 @@ extern "C" {
 #include "ota_fetch.h"
 #include "ota_lib.h"
 #include "qcloud_iot_export.h"
+#include "utils_md5.h"
 #include "utils_param_check.h"
 #include "utils_timer.h"
 
 #define OTA_VERSION_STR_LEN_MIN (1)
 #define OTA_VERSION_STR_LEN_MAX (32)
 
+#define OTA_CHECKPOINT_PATH_LEN (128)
+#define OTA_CHECKPOINT_MAGIC    (0x4F54434B)
+
+/* checkpoint record of download, followed by the MD5 digest of itself */
+typedef struct {
+    uint32_t        magic;
+    uint32_t        offset;                            /* size of firmware downloaded */
+    uint32_t        size_file;                         /* size of firmware */
+    char            version[OTA_VERSION_STR_LEN_MAX + 1];
+    char            md5sum[33];                        /* MD5 of firmware */
+    unsigned char   url_hash[16];                      /* MD5 of URL without query */
+    iot_md5_context md5;                               /* MD5 state of the downloaded part */
+} OTACheckpoint;
+
 typedef struct {
     const char *product_id;  /* point to product id */
     const char *device_name; /* point to device name */
@@ -61,6 +76,21 @@ typedef struct {
 
     Timer report_timer;
 
+    IOT_OTA_Segment * segs;                           /* segments of segmented download, NULL if not used */
+    uint32_t          seg_cnt;                        /* number of segments */
+    uint32_t          seg_next;                       /* segment read first in next yield */
+    void *            seg_fetch[OTA_SEGMENT_MAX_NUM]; /* download channel of each segment */
+    uint8_t           seg_retry[OTA_SEGMENT_MAX_NUM]; /* reconnect times since last data */
+    bool              seg_ranged[OTA_SEGMENT_MAX_NUM]; /* response of channel checked to be the range asked */
+    OTASegmentWriteCb seg_write;
+    OTASegmentReadCb  seg_read;
+    void *            seg_user_data;
+
+    char  ckpt_path[OTA_CHECKPOINT_PATH_LEN]; /* checkpoint file, empty if not used */
+    Timer ckpt_timer;                         /* next checkpoint not before it expires */
+
+    bool decode_content; /* accept compressed firmware from offset 0 */
+
 } OTA_Struct_t;
 
 /* check ota progress */
@@ -322,6 +352,18 @@ do_exit:
 #undef AOM_INFO_MSG_LEN
 }
 
+/* close the download channels of segments */
+static void _ota_segments_stop(OTA_Struct_t *h_ota)
+{
+    int i;
+
+    for (i = 0; i < OTA_SEGMENT_MAX_NUM; i++) {
+        qcloud_ofc_deinit(h_ota->seg_fetch[i]);
+        h_ota->seg_fetch[i] = NULL;
+    }
+    h_ota->segs = NULL;
+}
+
 /* Destroy OTA handle and resource */
 int IOT_OTA_Destroy(void *handle)
 {
@@ -340,6 +382,7 @@ int IOT_OTA_Destroy(void *handle)
 
     qcloud_osc_deinit(h_ota->ch_signal);
     qcloud_ofc_deinit(h_ota->ch_fetch);
+    _ota_segments_stop(h_ota);
     qcloud_otalib_md5_deinit(h_ota->md5);
 
     if (NULL != h_ota->purl) {
@@ -356,6 +399,20 @@ int IOT_OTA_Destroy(void *handle)
     return QCLOUD_RET_SUCCESS;
 }
 
+int IOT_OTA_SetContentDecode(void *handle, bool enable)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+
+    if (NULL == handle) {
+        Log_e("handle is NULL");
+        return QCLOUD_ERR_INVAL;
+    }
+
+    h_ota->decode_content = enable;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
 /*support continuous transmission of breakpoints*/
 int IOT_OTA_StartDownload(void *handle, uint32_t offset, uint32_t size)
 {
@@ -375,6 +432,7 @@ int IOT_OTA_StartDownload(void *handle, uint32_t offset, uint32_t size)
     }
 
     // reinit ofc
+    _ota_segments_stop(h_ota);
     qcloud_ofc_deinit(h_ota->ch_fetch);
     h_ota->ch_fetch = ofc_Init(h_ota->purl, offset, size);
     if (NULL == h_ota->ch_fetch) {
@@ -382,6 +440,10 @@ int IOT_OTA_StartDownload(void *handle, uint32_t offset, uint32_t size)
         return QCLOUD_ERR_FAILURE;
     }
 
+    if (h_ota->decode_content && offset == 0) {
+        qcloud_ofc_set_decode(h_ota->ch_fetch, true);
+    }
+
     Ret = qcloud_ofc_connect(h_ota->ch_fetch);
     if (QCLOUD_RET_SUCCESS != Ret) {
         Log_e("Connect fetch module failed");
@@ -391,6 +453,197 @@ int IOT_OTA_StartDownload(void *handle, uint32_t offset, uint32_t size)
     return Ret;
 }
 
+int IOT_OTA_StartSegmentedDownload(void *handle, IOT_OTA_Segment *segs, uint32_t seg_cnt, OTASegmentWriteCb write_cb,
+                                   OTASegmentReadCb read_cb, void *user_data)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+    uint32_t      i, offset, fetched;
+
+    POINTER_SANITY_CHECK(handle, IOT_OTA_ERR_INVALID_PARAM);
+    POINTER_SANITY_CHECK(segs, IOT_OTA_ERR_INVALID_PARAM);
+    POINTER_SANITY_CHECK(write_cb, IOT_OTA_ERR_INVALID_PARAM);
+
+    if (0 == seg_cnt || seg_cnt > OTA_SEGMENT_MAX_NUM || seg_cnt > h_ota->size_file) {
+        Log_e("invalid segment number %u for firmware size %u", seg_cnt, h_ota->size_file);
+        return IOT_OTA_ERR_INVALID_PARAM;
+    }
+
+    if (0 == segs[0].size) {
+        for (i = 0; i < seg_cnt; i++) {
+            segs[i].offset  = i * (h_ota->size_file / seg_cnt);
+            segs[i].size    = (i == seg_cnt - 1) ? h_ota->size_file - segs[i].offset : h_ota->size_file / seg_cnt;
+            segs[i].fetched = 0;
+        }
+    }
+
+    // segments saved from former download should still cover the firmware
+    offset  = 0;
+    fetched = 0;
+    for (i = 0; i < seg_cnt; i++) {
+        if (segs[i].offset != offset || segs[i].fetched > segs[i].size) {
+            break;
+        }
+        offset += segs[i].size;
+        fetched += segs[i].fetched;
+    }
+    if (i != seg_cnt || offset != h_ota->size_file) {
+        Log_e("segments don't match firmware size %u", h_ota->size_file);
+        return IOT_OTA_ERR_INVALID_PARAM;
+    }
+
+    Log_d("to download FW in %u segments, fetched: %u, size: %u", seg_cnt, fetched, h_ota->size_file);
+
+    if (0 == fetched && IOT_OTA_ResetClientMD5(h_ota)) {
+        Log_e("initialize md5 failed");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    qcloud_ofc_deinit(h_ota->ch_fetch);
+    h_ota->ch_fetch = NULL;
+    _ota_segments_stop(h_ota);
+
+    memset(h_ota->seg_retry, 0, sizeof(h_ota->seg_retry));
+    memset(h_ota->seg_ranged, 0, sizeof(h_ota->seg_ranged));
+    h_ota->segs          = segs;
+    h_ota->seg_cnt       = seg_cnt;
+    h_ota->seg_next      = 0;
+    h_ota->seg_write     = write_cb;
+    h_ota->seg_read      = read_cb;
+    h_ota->seg_user_data = user_data;
+    h_ota->size_fetched  = fetched;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/* fill checkpoint of current download, except the MD5 state */
+static void _ota_checkpoint_fill(OTA_Struct_t *h_ota, OTACheckpoint *ckpt)
+{
+    const char *query = strchr(h_ota->purl, '?');
+
+    // the query of a signed URL changes with each request, the rest is the file
+    memset(ckpt, 0, sizeof(OTACheckpoint));
+    ckpt->magic     = OTA_CHECKPOINT_MAGIC;
+    ckpt->size_file = h_ota->size_file;
+    strncpy(ckpt->version, h_ota->version, OTA_VERSION_STR_LEN_MAX);
+    memcpy(ckpt->md5sum, h_ota->md5sum, sizeof(ckpt->md5sum));
+    utils_md5((unsigned char *)h_ota->purl, query ? query - h_ota->purl : strlen(h_ota->purl), ckpt->url_hash);
+}
+
+int IOT_OTA_ResumeFromCheckpoint(void *handle, const char *path, uint32_t *offset)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+    OTACheckpoint ckpt, cur;
+    unsigned char digest[16], digest_read[16];
+    void *        fp;
+    size_t        len;
+
+    POINTER_SANITY_CHECK(handle, IOT_OTA_ERR_INVALID_PARAM);
+    POINTER_SANITY_CHECK(path, IOT_OTA_ERR_INVALID_PARAM);
+    POINTER_SANITY_CHECK(offset, IOT_OTA_ERR_INVALID_PARAM);
+
+    if (IOT_OTAS_FETCHING != h_ota->state || strlen(path) >= OTA_CHECKPOINT_PATH_LEN) {
+        h_ota->err = IOT_OTA_ERR_INVALID_STATE;
+        return IOT_OTA_ERR_INVALID_STATE;
+    }
+
+    strcpy(h_ota->ckpt_path, path);
+    InitTimer(&h_ota->ckpt_timer);
+    *offset = 0;
+
+    fp = HAL_FileOpen(path, "rb");
+    if (NULL == fp) {
+        return QCLOUD_RET_SUCCESS;
+    }
+    len = HAL_FileRead(&ckpt, 1, sizeof(ckpt), fp);
+    len += HAL_FileRead(digest_read, 1, sizeof(digest_read), fp);
+    HAL_FileClose(fp);
+
+    utils_md5((unsigned char *)&ckpt, sizeof(ckpt), digest);
+    _ota_checkpoint_fill(h_ota, &cur);
+    if (len != sizeof(ckpt) + sizeof(digest_read) || memcmp(digest, digest_read, sizeof(digest)) ||
+        OTA_CHECKPOINT_MAGIC != ckpt.magic || ckpt.size_file != cur.size_file || ckpt.offset > ckpt.size_file ||
+        strcmp(ckpt.version, cur.version) || strcmp(ckpt.md5sum, cur.md5sum) ||
+        memcmp(ckpt.url_hash, cur.url_hash, sizeof(cur.url_hash))) {
+        Log_w("checkpoint %s is invalid or of other firmware, download from scratch", path);
+        HAL_FileRemove(path);
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    utils_md5_clone((iot_md5_context *)h_ota->md5, &ckpt.md5);
+    *offset = ckpt.offset;
+    Log_i("resume download from checkpoint offset: %u", ckpt.offset);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int IOT_OTA_SaveCheckpoint(void *handle, bool force)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+    OTACheckpoint ckpt;
+    unsigned char digest[16];
+    char          tmp_path[OTA_CHECKPOINT_PATH_LEN + 4];
+    void *        fp;
+    size_t        len;
+
+    POINTER_SANITY_CHECK(handle, IOT_OTA_ERR_INVALID_PARAM);
+
+    // segmented download resumes by its segments, and hashes the firmware at the end
+    if ('\0' == h_ota->ckpt_path[0] || NULL != h_ota->segs || h_ota->state < IOT_OTAS_FETCHING) {
+        h_ota->err = IOT_OTA_ERR_INVALID_STATE;
+        return IOT_OTA_ERR_INVALID_STATE;
+    }
+
+    if (!force && !expired(&h_ota->ckpt_timer)) {
+        return QCLOUD_RET_SUCCESS;
+    }
+    countdown_ms(&h_ota->ckpt_timer, OTA_CHECKPOINT_INTERVAL_MS);
+
+    _ota_checkpoint_fill(h_ota, &ckpt);
+    ckpt.offset = h_ota->size_fetched;
+    utils_md5_clone(&ckpt.md5, (iot_md5_context *)h_ota->md5);
+    utils_md5((unsigned char *)&ckpt, sizeof(ckpt), digest);
+
+    // write a new checkpoint then rename it over the old one
+    HAL_Snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", h_ota->ckpt_path);
+    fp = HAL_FileOpen(tmp_path, "wb");
+    if (NULL == fp) {
+        Log_e("open file %s failed", tmp_path);
+        return QCLOUD_ERR_FAILURE;
+    }
+    len = HAL_FileWrite(&ckpt, 1, sizeof(ckpt), fp);
+    len += HAL_FileWrite(digest, 1, sizeof(digest), fp);
+    HAL_FileFlush(fp);
+    HAL_FileClose(fp);
+    if (len != sizeof(ckpt) + sizeof(digest)) {
+        Log_e("write file %s failed", tmp_path);
+        HAL_FileRemove(tmp_path);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    if (HAL_FileRename(tmp_path, h_ota->ckpt_path) != 0) {
+        /* some file systems refuse to rename over an existing file */
+        HAL_FileRemove(h_ota->ckpt_path);
+        if (HAL_FileRename(tmp_path, h_ota->ckpt_path) != 0) {
+            Log_e("rename file %s failed", tmp_path);
+            return QCLOUD_ERR_FAILURE;
+        }
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+void IOT_OTA_ClearCheckpoint(void *handle)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+
+    if (NULL == handle || '\0' == h_ota->ckpt_path[0]) {
+        return;
+    }
+
+    HAL_FileRemove(h_ota->ckpt_path);
+    h_ota->ckpt_path[0] = '\0';
+}
+
 /*support continuous transmission of breakpoints*/
 void IOT_OTA_UpdateClientMd5(void *handle, char *buff, uint32_t size)
 {
@@ -542,6 +795,52 @@ int IOT_OTA_IsFetchFinish(void *handle)
     return (IOT_OTAS_FETCHED == h_ota->state);
 }
 
+/* download failed: report the reason */
+static void _ota_fetch_failed(OTA_Struct_t *h_ota, int ret)
+{
+    h_ota->state = IOT_OTAS_FETCHED;
+    h_ota->err   = IOT_OTA_ERR_FETCH_FAILED;
+
+    if (ret == IOT_OTA_ERR_FETCH_AUTH_FAIL) {  // OTA auth failed
+        IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_AUTH_FAIL);
+        h_ota->err = ret;
+    } else if (ret == IOT_OTA_ERR_FETCH_NOT_EXIST) {  // fetch not existed
+        IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_FILE_NOT_EXIST);
+        h_ota->err = ret;
+    } else if (ret == IOT_OTA_ERR_FETCH_TIMEOUT) {  // fetch timeout
+        IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_DOWNLOAD_TIMEOUT);
+        h_ota->err = ret;
+    }
+}
+
+/* count the data fetched and report progress */
+static void _ota_fetch_progress(OTA_Struct_t *h_ota, uint32_t len)
+{
+    if (0 == h_ota->size_fetched) {
+        /* force report status in the first */
+        IOT_OTA_ReportProgress(h_ota, IOT_OTAP_FETCH_PERCENTAGE_MIN, IOT_OTAR_DOWNLOAD_BEGIN);
+
+        InitTimer(&h_ota->report_timer);
+        countdown(&h_ota->report_timer, 1);
+    }
+
+    h_ota->size_last_fetched = len;
+    h_ota->size_fetched += len;
+
+    /* report percent every second. */
+    uint32_t percent = ((uint64_t)h_ota->size_fetched * 100) / h_ota->size_file;
+    if (percent == 100) {
+        IOT_OTA_ReportProgress(h_ota, percent, IOT_OTAR_DOWNLOADING);
+    } else if (h_ota->size_last_fetched > 0 && expired(&h_ota->report_timer)) {
+        IOT_OTA_ReportProgress(h_ota, percent, IOT_OTAR_DOWNLOADING);
+        countdown(&h_ota->report_timer, 1);
+    }
+
+    if (h_ota->size_fetched >= h_ota->size_file) {
+        h_ota->state = IOT_OTAS_FETCHED;
+    }
+}
+
 int IOT_OTA_FetchYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_ms)
 {
     int           ret;
@@ -558,48 +857,153 @@ int IOT_OTA_FetchYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeo
 
     ret = qcloud_ofc_fetch(h_ota->ch_fetch, buf, buf_len, timeout_ms);
     if (ret < 0) {
-        h_ota->state = IOT_OTAS_FETCHED;
-        h_ota->err   = IOT_OTA_ERR_FETCH_FAILED;
-
-        if (ret == IOT_OTA_ERR_FETCH_AUTH_FAIL) {  // OTA auth failed
-            IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_AUTH_FAIL);
-            h_ota->err = ret;
-        } else if (ret == IOT_OTA_ERR_FETCH_NOT_EXIST) {  // fetch not existed
-            IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_FILE_NOT_EXIST);
-            h_ota->err = ret;
-        } else if (ret == IOT_OTA_ERR_FETCH_TIMEOUT) {  // fetch timeout
-            IOT_OTA_ReportUpgradeResult(h_ota, h_ota->version, IOT_OTAR_DOWNLOAD_TIMEOUT);
-            h_ota->err = ret;
+        _ota_fetch_failed(h_ota, ret);
+        return ret;
+    }
+
+    _ota_fetch_progress(h_ota, ret);
+
+    qcloud_otalib_md5_update(h_ota->md5, buf, ret);
+
+    return ret;
+}
+
+/* read from the channel of one segment, (re)connecting it from where the segment stops */
+static int _ota_segment_fetch(OTA_Struct_t *h_ota, uint32_t idx, char *buf, uint32_t buf_len, uint32_t timeout_s)
+{
+    IOT_OTA_Segment *seg = &h_ota->segs[idx];
+    int              ret, code;
+
+    if (seg->fetched >= seg->size) {
+        return 0;
+    }
+
+    if (NULL == h_ota->seg_fetch[idx]) {
+        h_ota->seg_fetch[idx] = ofc_Init(h_ota->purl, seg->offset + seg->fetched, seg->offset + seg->size - 1);
+        if (NULL == h_ota->seg_fetch[idx]) {
+            Log_e("Initialize fetch module of segment %u failed", idx);
+            return IOT_OTA_ERR_NOMEM;
         }
+        h_ota->seg_ranged[idx] = false;
 
-        return ret;
-    } else if (0 == h_ota->size_fetched) {
-        /* force report status in the first */
-        IOT_OTA_ReportProgress(h_ota, IOT_OTAP_FETCH_PERCENTAGE_MIN, IOT_OTAR_DOWNLOAD_BEGIN);
+        ret = qcloud_ofc_connect(h_ota->seg_fetch[idx]);
+        if (QCLOUD_RET_SUCCESS != ret) {
+            Log_e("Connect fetch module of segment %u failed", idx);
+            goto retry;
+        }
+    }
 
-        InitTimer(&h_ota->report_timer);
-        countdown(&h_ota->report_timer, 1);
+    ret = qcloud_ofc_fetch(h_ota->seg_fetch[idx], buf, buf_len, timeout_s);
+    if (ret < 0) {
+        if (IOT_OTA_ERR_FETCH_NOT_EXIST == ret || IOT_OTA_ERR_FETCH_AUTH_FAIL == ret) {
+            return ret;
+        }
+        goto retry;
     }
 
-    h_ota->size_last_fetched = ret;
-    h_ota->size_fetched += ret;
+    if (ret > 0 && !h_ota->seg_ranged[idx]) {
+        // a server ignoring Range sends the whole firmware from offset 0
+        code = qcloud_ofc_response_code(h_ota->seg_fetch[idx]);
+        if (206 != code && (seg->offset + seg->fetched != 0 || 1 != h_ota->seg_cnt)) {
+            Log_e("server doesn't support range download, code: %d", code);
+            return IOT_OTA_ERR_FETCH_FAILED;
+        }
+        h_ota->seg_ranged[idx] = true;
+    }
 
-    /* report percent every second. */
-    uint32_t percent = (h_ota->size_fetched * 100) / h_ota->size_file;
-    if (percent == 100) {
-        IOT_OTA_ReportProgress(h_ota, percent, IOT_OTAR_DOWNLOADING);
-    } else if (h_ota->size_last_fetched > 0 && expired(&h_ota->report_timer)) {
-        IOT_OTA_ReportProgress(h_ota, percent, IOT_OTAR_DOWNLOADING);
-        countdown(&h_ota->report_timer, 1);
+    if ((uint32_t)ret > seg->size - seg->fetched) {
+        ret = seg->size - seg->fetched;
     }
 
-    if (h_ota->size_fetched >= h_ota->size_file) {
-        h_ota->state = IOT_OTAS_FETCHED;
+    if (ret > 0) {
+        if (QCLOUD_RET_SUCCESS != h_ota->seg_write(h_ota->seg_user_data, seg->offset + seg->fetched, buf, ret)) {
+            Log_e("write segment %u at %u failed", idx, seg->offset + seg->fetched);
+            return IOT_OTA_ERR_FAIL;
+        }
+        seg->fetched += ret;
+        h_ota->seg_retry[idx] = 0;
     }
 
-    qcloud_otalib_md5_update(h_ota->md5, buf, ret);
+    if (seg->fetched >= seg->size) {
+        qcloud_ofc_deinit(h_ota->seg_fetch[idx]);
+        h_ota->seg_fetch[idx] = NULL;
+    }
 
     return ret;
+
+retry:
+    qcloud_ofc_deinit(h_ota->seg_fetch[idx]);
+    h_ota->seg_fetch[idx] = NULL;
+    if (++h_ota->seg_retry[idx] > OTA_SEGMENT_RETRY) {
+        Log_e("segment %u failed after %d retries", idx, OTA_SEGMENT_RETRY);
+        return ret < 0 ? ret : IOT_OTA_ERR_FETCH_FAILED;
+    }
+    Log_w("segment %u to reconnect from %u", idx, seg->offset + seg->fetched);
+
+    return 0;
+}
+
+/* read the whole firmware back to get its MD5 */
+static int _ota_segment_md5(OTA_Struct_t *h_ota, char *buf, uint32_t buf_len)
+{
+    uint32_t offset = 0;
+    int      ret;
+
+    if (IOT_OTA_ResetClientMD5(h_ota)) {
+        return IOT_OTA_ERR_NOMEM;
+    }
+
+    while (offset < h_ota->size_file) {
+        ret = h_ota->seg_read(h_ota->seg_user_data, offset, buf,
+                              buf_len < h_ota->size_file - offset ? buf_len : h_ota->size_file - offset);
+        if (ret <= 0) {
+            Log_e("read firmware back at %u failed: %d", offset, ret);
+            return IOT_OTA_ERR_FAIL;
+        }
+        qcloud_otalib_md5_update(h_ota->md5, buf, ret);
+        offset += ret;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+int IOT_OTA_SegmentedFetchYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s)
+{
+    OTA_Struct_t *h_ota = (OTA_Struct_t *)handle;
+    uint32_t      i, total = 0;
+    int           ret;
+
+    POINTER_SANITY_CHECK(handle, IOT_OTA_ERR_INVALID_PARAM);
+    POINTER_SANITY_CHECK(buf, IOT_OTA_ERR_INVALID_PARAM);
+    NUMBERIC_SANITY_CHECK(buf_len, IOT_OTA_ERR_INVALID_PARAM);
+
+    if (IOT_OTAS_FETCHING != h_ota->state || NULL == h_ota->segs) {
+        h_ota->err = IOT_OTA_ERR_INVALID_STATE;
+        return IOT_OTA_ERR_INVALID_STATE;
+    }
+
+    /* all the channels keep receiving while one of them is read */
+    for (i = 0; i < h_ota->seg_cnt; i++) {
+        ret = _ota_segment_fetch(h_ota, (h_ota->seg_next + i) % h_ota->seg_cnt, buf, buf_len, timeout_s);
+        if (ret < 0) {
+            _ota_segments_stop(h_ota);
+            _ota_fetch_failed(h_ota, ret);
+            return ret;
+        }
+        total += ret;
+    }
+    h_ota->seg_next = (h_ota->seg_next + 1) % h_ota->seg_cnt;
+
+    _ota_fetch_progress(h_ota, total);
+
+    if (IOT_OTAS_FETCHED == h_ota->state) {
+        if (NULL != h_ota->seg_read && QCLOUD_RET_SUCCESS != _ota_segment_md5(h_ota, buf, buf_len)) {
+            h_ota->err = IOT_OTA_ERR_FAIL;
+        }
+        _ota_segments_stop(h_ota);
+    }
+
+    return total;
 }
 
 int IOT_OTA_Ioctl(void *handle, IOT_OTA_CmdType type, void *buf, size_t buf_len)
@@ -36,6 +36,11 @@ void *ofc_Init(const char *url, uint32_t offset, uint32_t size)
     return qcloud_url_download_init(url, offset, size);
 }
 
+int qcloud_ofc_set_decode(void *handle, bool decode)
+{
+    return qcloud_url_download_set_decode(handle, decode);
+}
+
 int32_t qcloud_ofc_connect(void *handle)
 {
 #ifdef OTA_USE_HTTPS
@@ -65,6 +70,11 @@ int qcloud_ofc_deinit(void *handle)
     return qcloud_url_download_deinit(handle);
 }
 
+int qcloud_ofc_response_code(void *handle)
+{
+    return qcloud_url_download_response_code(handle);
+}
+
 #ifdef __cplusplus
 }
 #endif
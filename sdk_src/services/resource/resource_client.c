@@ -631,15 +631,8 @@ int IOT_Resource_UploadRecvResult(void *handle, void *buf, int buf_len)
     return ret;
 }
 
-int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s)
+static int _qcloud_iot_resource_upload_check(QCLOUD_RESOURCE_CONTEXT_T *resource_handle)
 {
-    int                        ret;
-    QCLOUD_RESOURCE_CONTEXT_T *resource_handle = (QCLOUD_RESOURCE_CONTEXT_T *)handle;
-
-    POINTER_SANITY_CHECK(handle, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
-    POINTER_SANITY_CHECK(buf, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
-    NUMBERIC_SANITY_CHECK(buf_len, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
-
     if ((QCLOUD_RESOURCE_STATE_START_E != resource_handle->upload.state) ||
         (resource_handle->upload.result_code != 0)) {
         Log_e("upload result code :%d", resource_handle->upload.result_code);
@@ -647,7 +640,13 @@ int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t
         return QCLOUD_RESOURCE_ERRCODE_INVALID_STATE_E;
     }
 
-    ret = qcloud_resource_upload_http_send_body(resource_handle->upload.channel, buf, buf_len, timeout_s);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/* account the result of sending len bytes, buf receives the server reply after the last data */
+static int _qcloud_iot_resource_upload_sent(QCLOUD_RESOURCE_CONTEXT_T *resource_handle, int ret, uint32_t len,
+                                            char *buf, uint32_t buf_len)
+{
     if (ret < 0) {
         resource_handle->upload.state = QCLOUD_RESOURCE_STATE_END_E;
         resource_handle->upload.err   = QCLOUD_RESOURCE_ERRCODE_FETCH_FAILED_E;
@@ -655,7 +654,7 @@ int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t
             _qcloud_iot_resource_report_upload_result(resource_handle, resource_handle->upload.resource_name,
                                                       QCLOUD_RESOURCE_RESULTCODE_SIGN_INVALID_E);
             resource_handle->upload.err = ret;
-            buf_len                     = IOT_Resource_UploadRecvResult(resource_handle, buf, buf_len);
+            IOT_Resource_UploadRecvResult(resource_handle, buf, buf_len);
         }
 
         return ret;
@@ -668,8 +667,8 @@ int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t
         countdown(&resource_handle->upload.report_timer, 1);
     }
 
-    resource_handle->upload.size_last = buf_len;
-    resource_handle->upload.size_prepared += buf_len;
+    resource_handle->upload.size_last = len;
+    resource_handle->upload.size_prepared += len;
 
     /* report percent every second. */
     uint32_t percent = (resource_handle->upload.size_prepared * 100) / resource_handle->upload.resource_size;
@@ -680,16 +679,63 @@ int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t
         countdown(&resource_handle->upload.report_timer, 1);
     }
 
-    qcloud_lib_md5_update(&(resource_handle->upload.md5), buf, buf_len);
-
     if (resource_handle->upload.size_prepared >= resource_handle->upload.resource_size) {
         resource_handle->upload.state = QCLOUD_RESOURCE_STATE_END_E;
 
         /* send data complete recv server reply */
-        buf_len = IOT_Resource_UploadRecvResult(resource_handle, buf, buf_len);
+        return IOT_Resource_UploadRecvResult(resource_handle, buf, buf_len);
+    }
+
+    return len;
+}
+
+int IOT_Resource_UploadYield(void *handle, char *buf, uint32_t buf_len, uint32_t timeout_s)
+{
+    int                        ret;
+    QCLOUD_RESOURCE_CONTEXT_T *resource_handle = (QCLOUD_RESOURCE_CONTEXT_T *)handle;
+
+    POINTER_SANITY_CHECK(handle, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+    POINTER_SANITY_CHECK(buf, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+    NUMBERIC_SANITY_CHECK(buf_len, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+
+    ret = _qcloud_iot_resource_upload_check(resource_handle);
+    if (ret != QCLOUD_RET_SUCCESS) {
+        return ret;
+    }
+
+    ret = qcloud_resource_upload_http_send_body(resource_handle->upload.channel, buf, buf_len, timeout_s);
+    if (ret >= 0) {
+        qcloud_lib_md5_update(&(resource_handle->upload.md5), buf, buf_len);
+    }
+
+    return _qcloud_iot_resource_upload_sent(resource_handle, ret, buf_len, buf, buf_len);
+}
+
+int IOT_Resource_UploadFileYield(void *handle, void *fp, uint32_t len, uint32_t timeout_s)
+{
+#define RESOURCE_UPLOAD_REPLY_LEN 256
+    int                        ret;
+    char                       reply[RESOURCE_UPLOAD_REPLY_LEN];
+    QCLOUD_RESOURCE_CONTEXT_T *resource_handle = (QCLOUD_RESOURCE_CONTEXT_T *)handle;
+
+    POINTER_SANITY_CHECK(handle, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+    POINTER_SANITY_CHECK(fp, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+    NUMBERIC_SANITY_CHECK(len, QCLOUD_RESOURCE_ERRCODE_INVALID_PARAM_E);
+
+    ret = _qcloud_iot_resource_upload_check(resource_handle);
+    if (ret != QCLOUD_RET_SUCCESS) {
+        return ret;
+    }
+
+    if (len > resource_handle->upload.resource_size - resource_handle->upload.size_prepared) {
+        len = resource_handle->upload.resource_size - resource_handle->upload.size_prepared;
     }
+    ret = qcloud_resource_upload_http_send_file(resource_handle->upload.channel, fp, len,
+                                                &(resource_handle->upload.md5), timeout_s);
 
-    return buf_len;
+    memset(reply, 0, sizeof(reply));
+    return _qcloud_iot_resource_upload_sent(resource_handle, ret, len, reply, sizeof(reply));
+#undef RESOURCE_UPLOAD_REPLY_LEN
 }
 
 /* check whether fetch over */
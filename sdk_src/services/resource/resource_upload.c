@@ -54,6 +54,12 @@ int32_t qcloud_resource_upload_http_send_body(void *handle, char *buf, uint32_t
     return qcloud_url_upload_body(handle, buf, buf_len, timeout_s);
 }
 
+int32_t qcloud_resource_upload_http_send_file(void *handle, void *fp, uint32_t len, iot_md5_context *md5,
+                                              uint32_t timeout_s)
+{
+    return qcloud_url_upload_file(handle, fp, len, md5, timeout_s * 1000);
+}
+
 int32_t qcloud_resource_upload_http_recv(void *handle, char *buf, uint32_t bufLen, uint32_t timeout_s)
 {
     IOT_FUNC_ENTRY;
@@ -23,9 +23,12 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "log_upload.h"
+#include "qcloud_iot_export_error.h"
 #include "qcloud_iot_export_log.h"
 #include "qcloud_iot_import.h"
 
@@ -110,12 +113,610 @@ int IOT_Log_Upload(bool force_upload)
 #endif
 }
 
+static void _log_output(int level, char *text)
+{
+#ifdef LOG_UPLOAD
+    /* append to upload buffer */
+    if (level <= g_log_upload_level) {
+        append_to_upload_buffer(text, strlen(text));
+    }
+#endif
+
+    if (level <= g_log_print_level) {
+        /* customer defined log print handler */
+        if (sg_log_message_handler != NULL && sg_log_message_handler(text)) {
+            return;
+        }
+
+        /* default log handler: print to console */
+        HAL_Printf("%s", text);
+    }
+}
+
+#if defined(MULTITHREAD_ENABLED) && (defined(__GNUC__) || defined(__clang__))
+#define LOG_ASYNC_SUPPORTED
+
+#define LOG_ASYNC_IDLE_MS    (10)
+#define LOG_ASYNC_STOP_WAIT  (200)  // x LOG_ASYNC_IDLE_MS
+#define LOG_ASYNC_SPEC_LEN   (32)
+#define LOG_ASYNC_TRUNC_MARK "..."
+
+typedef enum {
+    eLOG_ARG_NONE = 0,
+    eLOG_ARG_INT,
+    eLOG_ARG_LONG,
+    eLOG_ARG_LLONG,
+    eLOG_ARG_SIZE,
+    eLOG_ARG_INTMAX,
+    eLOG_ARG_PTRDIFF,
+    eLOG_ARG_DOUBLE,
+    eLOG_ARG_LDOUBLE,
+    eLOG_ARG_PTR,
+    eLOG_ARG_STR,
+} LogArgType;
+
+/* one conversion of a printf format, parsed from just after the '%' */
+typedef struct {
+    char       text[LOG_ASYNC_SPEC_LEN];  // '%' up to the conversion char, '*' kept
+    bool       star_width;
+    bool       star_prec;
+    LogArgType type;
+} LogSpec;
+
+/* one log record. seq is the slot sequence of the bounded MPMC ring, the
+ * arguments are packed into args in format order. time_sec is taken when the
+ * record is written and formatted by the drain thread */
+typedef struct {
+    uint32_t    seq;
+    uint8_t     level;
+    uint16_t    arg_len;
+    int         line;
+    long        time_sec;
+    const char *file;
+    const char *func;
+    const char *fmt;
+    uint8_t     args[LOG_ASYNC_ARG_LEN];
+} LogRecord;
+
+typedef struct {
+    LogRecord *   slots;
+    uint32_t      mask;
+    uint32_t      enqueue_pos;
+    uint32_t      dequeue_pos;  // only the drain thread touches it
+    uint32_t      dropped;
+    bool          running;
+    bool          exited;
+    ThreadParams  thread;
+    long          time_sec;  // second of time_str
+    char          time_str[TIME_FORMAT_STR_LEN];
+    char          text[MAX_LOG_MSG_LEN + 1];
+} LogAsyncRing;
+
+static LogAsyncRing *sg_log_async         = NULL;
+static uint32_t      sg_log_async_writers = 0;
+
+static const char *_log_parse_spec(const char *p, LogSpec *spec)
+{
+    const char *start = p - 1;
+    size_t      len;
+    int         lmod = 0;  // 1:h 2:hh 3:l 4:ll 5:z 6:j 7:t 8:L
+
+    spec->star_width = false;
+    spec->star_prec  = false;
+
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        spec->star_width = true;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_prec = true;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    switch (*p) {
+        case 'h':
+            lmod = (p[1] == 'h') ? 2 : 1;
+            p += lmod;
+            break;
+        case 'l':
+            lmod = (p[1] == 'l') ? 4 : 3;
+            p += lmod - 2;
+            break;
+        case 'z':
+            lmod = 5;
+            p++;
+            break;
+        case 'j':
+            lmod = 6;
+            p++;
+            break;
+        case 't':
+            lmod = 7;
+            p++;
+            break;
+        case 'L':
+            lmod = 8;
+            p++;
+            break;
+        default:
+            break;
+    }
+
+    switch (*p) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec->type = (lmod == 3)   ? eLOG_ARG_LONG
+                         : (lmod == 4) ? eLOG_ARG_LLONG
+                         : (lmod == 5) ? eLOG_ARG_SIZE
+                         : (lmod == 6) ? eLOG_ARG_INTMAX
+                         : (lmod == 7) ? eLOG_ARG_PTRDIFF
+                                       : eLOG_ARG_INT;
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec->type = (lmod == 8) ? eLOG_ARG_LDOUBLE : eLOG_ARG_DOUBLE;
+            break;
+        case 'c':
+            spec->type = eLOG_ARG_INT;
+            break;
+        case 's':
+            spec->type = eLOG_ARG_STR;
+            break;
+        case 'p':
+        case 'n':
+            spec->type = eLOG_ARG_PTR;
+            break;
+        default:
+            /* "%%" or an unknown conversion, printed as is */
+            spec->type = eLOG_ARG_NONE;
+            break;
+    }
+
+    if (*p) {
+        p++;
+    }
+    len = p - start;
+    if (len >= LOG_ASYNC_SPEC_LEN) {
+        len = LOG_ASYNC_SPEC_LEN - 1;
+    }
+    memcpy(spec->text, start, len);
+    spec->text[len] = '\0';
+
+    return p;
+}
+
+static size_t _log_arg_size(LogArgType type)
+{
+    switch (type) {
+        case eLOG_ARG_INT:
+            return sizeof(int);
+        case eLOG_ARG_LONG:
+            return sizeof(long);
+        case eLOG_ARG_LLONG:
+            return sizeof(long long);
+        case eLOG_ARG_SIZE:
+            return sizeof(size_t);
+        case eLOG_ARG_INTMAX:
+            return sizeof(intmax_t);
+        case eLOG_ARG_PTRDIFF:
+            return sizeof(ptrdiff_t);
+        case eLOG_ARG_DOUBLE:
+            return sizeof(double);
+        case eLOG_ARG_LDOUBLE:
+            return sizeof(long double);
+        case eLOG_ARG_PTR:
+            return sizeof(void *);
+        case eLOG_ARG_STR:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* copy the arguments of fmt out of ap, strings are copied by value since
+ * the caller's buffers may be gone by the time the record is formatted.
+ * false when they do not fit in args */
+static bool _log_pack_args(LogRecord *rec, const char *fmt, va_list ap)
+{
+    LogSpec     spec;
+    uint8_t *   arg = rec->args;
+    uint8_t *   end = rec->args + LOG_ASYNC_ARG_LEN;
+    const char *str;
+    size_t      len;
+    int         star;
+
+    while ((fmt = strchr(fmt, '%')) != NULL) {
+        fmt = _log_parse_spec(fmt + 1, &spec);
+        if (spec.type == eLOG_ARG_NONE) {
+            continue;
+        }
+        if (arg + (spec.star_width + spec.star_prec) * sizeof(int) + _log_arg_size(spec.type) > end) {
+            return false;
+        }
+
+        if (spec.star_width) {
+            star = va_arg(ap, int);
+            memcpy(arg, &star, sizeof(int));
+            arg += sizeof(int);
+        }
+        if (spec.star_prec) {
+            star = va_arg(ap, int);
+            memcpy(arg, &star, sizeof(int));
+            arg += sizeof(int);
+        }
+
+        switch (spec.type) {
+#define LOG_ARG_PUT(type)                        \
+    {                                            \
+        type _v = va_arg(ap, type);              \
+        memcpy(arg, &_v, sizeof(type));          \
+        arg += sizeof(type);                     \
+        break;                                   \
+    }
+            case eLOG_ARG_INT:
+                LOG_ARG_PUT(int)
+            case eLOG_ARG_LONG:
+                LOG_ARG_PUT(long)
+            case eLOG_ARG_LLONG:
+                LOG_ARG_PUT(long long)
+            case eLOG_ARG_SIZE:
+                LOG_ARG_PUT(size_t)
+            case eLOG_ARG_INTMAX:
+                LOG_ARG_PUT(intmax_t)
+            case eLOG_ARG_PTRDIFF:
+                LOG_ARG_PUT(ptrdiff_t)
+            case eLOG_ARG_DOUBLE:
+                LOG_ARG_PUT(double)
+            case eLOG_ARG_LDOUBLE:
+                LOG_ARG_PUT(long double)
+            case eLOG_ARG_PTR:
+                LOG_ARG_PUT(void *)
+#undef LOG_ARG_PUT
+            default:
+                str = va_arg(ap, const char *);
+                str = STRING_PTR_PRINT_SANITY_CHECK(str);
+                len = strlen(str);
+                if (arg + len + 1 > end) {
+                    return false;
+                }
+                memcpy(arg, str, len + 1);
+                arg += len + 1;
+                break;
+        }
+    }
+
+    rec->arg_len = arg - rec->args;
+    return true;
+}
+
+/* format one record the way IOT_Log_Gen does, into ring->text */
+static void _log_render(LogAsyncRing *ring, LogRecord *rec)
+{
+    char *      out    = ring->text;
+    int         remain = MAX_LOG_MSG_LEN - 2;
+    const char *fmt    = rec->fmt;
+    const char *next;
+    char        spec_text[LOG_ASYNC_SPEC_LEN + 24];
+    LogSpec     spec;
+    uint8_t *   arg = rec->args;
+    uint8_t *   end = rec->args + rec->arg_len;
+    int         n, star[2], nstar;
+    char *      o;
+    const char *t;
+
+    if (rec->time_sec != ring->time_sec) {
+        HAL_Timer_format(rec->time_sec, ring->time_str);
+        ring->time_sec = rec->time_sec;
+    }
+
+    n = HAL_Snprintf(out, remain, "%s|%s|%s|%s(%d): ", level_str[rec->level], ring->time_str,
+                     STRING_PTR_PRINT_SANITY_CHECK(_get_filename(rec->file)), STRING_PTR_PRINT_SANITY_CHECK(rec->func),
+                     rec->line);
+
+    while (1) {
+        n = (n < 0) ? 0 : (n >= remain ? remain - 1 : n);
+        out += n;
+        remain -= n;
+        if (!*fmt || remain <= 1) {
+            break;
+        }
+
+        next = strchr(fmt, '%');
+        if (next != fmt) {
+            n = next ? next - fmt : strlen(fmt);
+            n = (n >= remain) ? remain - 1 : n;
+            memcpy(out, fmt, n);
+            fmt += n;
+            continue;
+        }
+
+        fmt = _log_parse_spec(fmt + 1, &spec);
+        if (spec.type == eLOG_ARG_NONE) {
+            n = HAL_Snprintf(out, remain, (strcmp(spec.text, "%%") == 0) ? "%%" : "%s", spec.text);
+            continue;
+        }
+
+        nstar = spec.star_width + spec.star_prec;
+        if (arg + nstar * sizeof(int) + _log_arg_size(spec.type) > end) {
+            n = HAL_Snprintf(out, remain, "%s", LOG_ASYNC_TRUNC_MARK);
+            fmt = "";
+            continue;
+        }
+        memcpy(star, arg, nstar * sizeof(int));
+        arg += nstar * sizeof(int);
+
+        /* put the '*' values back into the spec */
+        o = spec_text;
+        for (t = spec.text, nstar = 0; *t; t++) {
+            if (*t == '*') {
+                o += HAL_Snprintf(o, 12, "%d", star[nstar++]);
+            } else {
+                *o++ = *t;
+            }
+        }
+        *o = '\0';
+
+        switch (spec.type) {
+#define LOG_ARG_GET(type)                                  \
+    {                                                      \
+        type _v;                                           \
+        memcpy(&_v, arg, sizeof(type));                    \
+        arg += sizeof(type);                               \
+        n = HAL_Snprintf(out, remain, spec_text, _v);      \
+        break;                                             \
+    }
+            case eLOG_ARG_INT:
+                LOG_ARG_GET(int)
+            case eLOG_ARG_LONG:
+                LOG_ARG_GET(long)
+            case eLOG_ARG_LLONG:
+                LOG_ARG_GET(long long)
+            case eLOG_ARG_SIZE:
+                LOG_ARG_GET(size_t)
+            case eLOG_ARG_INTMAX:
+                LOG_ARG_GET(intmax_t)
+            case eLOG_ARG_PTRDIFF:
+                LOG_ARG_GET(ptrdiff_t)
+            case eLOG_ARG_DOUBLE:
+                LOG_ARG_GET(double)
+            case eLOG_ARG_LDOUBLE:
+                LOG_ARG_GET(long double)
+#undef LOG_ARG_GET
+            case eLOG_ARG_PTR: {
+                void *v;
+                memcpy(&v, arg, sizeof(void *));
+                arg += sizeof(void *);
+                /* "%n" would write through a stale pointer */
+                n = (o[-1] == 'n') ? 0 : HAL_Snprintf(out, remain, spec_text, v);
+                break;
+            }
+            default:
+                n = HAL_Snprintf(out, remain, spec_text, (char *)arg);
+                arg += strlen((char *)arg) + 1;
+                break;
+        }
+    }
+
+    memcpy(out, "\r\n", 3);
+}
+
+static void _log_async_thread(void *arg)
+{
+    LogAsyncRing *ring = (LogAsyncRing *)arg;
+    LogRecord *   rec;
+    uint32_t      dropped;
+    int           level;
+
+    while (1) {
+        rec = &ring->slots[ring->dequeue_pos & ring->mask];
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != ring->dequeue_pos + 1) {
+            dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+            if (dropped) {
+                HAL_Snprintf(ring->text, sizeof(ring->text), "WRN|log ring full, %u records dropped\r\n", dropped);
+                _log_output(eLOG_WARN, ring->text);
+            }
+
+            /* ring empty, running is only cleared after the last writer left */
+            if (!__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE) &&
+                __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != ring->dequeue_pos + 1) {
+                break;
+            }
+            HAL_SleepMs(LOG_ASYNC_IDLE_MS);
+            continue;
+        }
+
+        _log_render(ring, rec);
+        level = rec->level;
+        __atomic_store_n(&rec->seq, ring->dequeue_pos + ring->mask + 1, __ATOMIC_RELEASE);
+        ring->dequeue_pos++;
+
+        _log_output(level, ring->text);
+    }
+
+    __atomic_store_n(&ring->exited, true, __ATOMIC_RELEASE);
+}
+
+/* queue one record, false when it has to be logged synchronously: async
+ * logging is off or the arguments do not fit in LOG_ASYNC_ARG_LEN */
+static bool _log_async_write(const char *file, const char *func, int line, int level, const char *fmt, va_list ap)
+{
+    LogAsyncRing *ring;
+    LogRecord *   rec;
+    LogRecord     tmp;
+    uint32_t      pos;
+    int32_t       dif;
+
+    /* packed before a slot is taken, a claimed slot can not be given back */
+    if (!_log_pack_args(&tmp, fmt, ap)) {
+        return false;
+    }
+    tmp.time_sec = HAL_Timer_current_sec();
+
+    __atomic_add_fetch(&sg_log_async_writers, 1, __ATOMIC_ACQUIRE);
+    ring = __atomic_load_n(&sg_log_async, __ATOMIC_ACQUIRE);
+    if (ring == NULL) {
+        __atomic_sub_fetch(&sg_log_async_writers, 1, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    /* bounded MPMC ring: a slot is free for position pos when its seq == pos */
+    pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    while (1) {
+        rec = &ring->slots[pos & ring->mask];
+        dif = (int32_t)(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&sg_log_async_writers, 1, __ATOMIC_RELEASE);
+            return true;
+        } else {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    rec->level    = level;
+    rec->line     = line;
+    rec->time_sec = tmp.time_sec;
+    rec->file     = file;
+    rec->func     = func;
+    rec->fmt      = fmt;
+    rec->arg_len  = tmp.arg_len;
+    memcpy(rec->args, tmp.args, tmp.arg_len);
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_sub_fetch(&sg_log_async_writers, 1, __ATOMIC_RELEASE);
+    return true;
+}
+#endif
+
+int IOT_Log_Init_Async(uint32_t ring_records)
+{
+#ifdef LOG_ASYNC_SUPPORTED
+    LogAsyncRing *ring;
+    uint32_t      size = 1, i;
+
+    if (sg_log_async != NULL) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    if (ring_records == 0) {
+        ring_records = LOG_ASYNC_RING_RECORDS;
+    }
+    while (size < ring_records) {
+        size <<= 1;
+    }
+
+    ring = (LogAsyncRing *)HAL_Malloc(sizeof(LogAsyncRing));
+    if (ring == NULL) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(ring, 0, sizeof(LogAsyncRing));
+
+    ring->slots = (LogRecord *)HAL_Malloc(size * sizeof(LogRecord));
+    if (ring->slots == NULL) {
+        HAL_Free(ring);
+        return QCLOUD_ERR_MALLOC;
+    }
+    for (i = 0; i < size; i++) {
+        ring->slots[i].seq = i;
+    }
+    ring->mask     = size - 1;
+    ring->time_sec = -1;
+    ring->running  = true;
+
+    ring->thread.thread_func = _log_async_thread;
+    ring->thread.thread_name = "log_async_thread";
+    ring->thread.user_arg    = ring;
+    ring->thread.stack_size  = 4096;
+    ring->thread.priority    = 1;
+    if (HAL_ThreadCreate(&ring->thread)) {
+        HAL_Free(ring->slots);
+        HAL_Free(ring);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    __atomic_store_n(&sg_log_async, ring, __ATOMIC_RELEASE);
+    return QCLOUD_RET_SUCCESS;
+#else
+    Log_e("async log needs MULTITHREAD_ENABLED and atomic builtins");
+    return QCLOUD_ERR_FAILURE;
+#endif
+}
+
+void IOT_Log_Fini_Async(void)
+{
+#ifdef LOG_ASYNC_SUPPORTED
+    LogAsyncRing *ring = __atomic_exchange_n(&sg_log_async, NULL, __ATOMIC_ACQ_REL);
+    int           i;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    /* new records go the synchronous way now, wait for the ones in flight */
+    while (__atomic_load_n(&sg_log_async_writers, __ATOMIC_ACQUIRE)) {
+        HAL_SleepMs(1);
+    }
+    __atomic_store_n(&ring->running, false, __ATOMIC_RELEASE);
+
+    for (i = 0; i < LOG_ASYNC_STOP_WAIT && !__atomic_load_n(&ring->exited, __ATOMIC_ACQUIRE); i++) {
+        HAL_SleepMs(LOG_ASYNC_IDLE_MS);
+    }
+    if (!ring->exited) {
+        /* the thread is stuck in an output handler, leave the ring to it */
+        HAL_Printf("log async thread did not exit\r\n");
+        return;
+    }
+
+    HAL_Free(ring->slots);
+    HAL_Free(ring);
+#endif
+}
+
 void IOT_Log_Gen(const char *file, const char *func, const int line, const int level, const char *fmt, ...)
 {
     if (level > g_log_print_level && level > g_log_upload_level) {
         return;
     }
 
+    va_list ap;
+
+#ifdef LOG_ASYNC_SUPPORTED
+    if (sg_log_async != NULL) {
+        bool queued;
+        va_start(ap, fmt);
+        queued = _log_async_write(file, func, line, level, fmt, ap);
+        va_end(ap);
+        if (queued) {
+            return;
+        }
+    }
+#endif
+
     /* format log content */
     const char *file_name = _get_filename(file);
 
@@ -129,31 +730,13 @@ void IOT_Log_Gen(const char *file, const char *func, const int line, const int l
                       STRING_PTR_PRINT_SANITY_CHECK(HAL_Timer_current(time_str)),
                       STRING_PTR_PRINT_SANITY_CHECK(file_name), STRING_PTR_PRINT_SANITY_CHECK(func), line);
 
-    va_list ap;
     va_start(ap, fmt);
     HAL_Vsnprintf(o, MAX_LOG_MSG_LEN - 2 - strlen(tmp_buf), fmt, ap);
     va_end(ap);
 
     strcat(tmp_buf, "\r\n");
 
-#ifdef LOG_UPLOAD
-    /* append to upload buffer */
-    if (level <= g_log_upload_level) {
-        append_to_upload_buffer(tmp_buf, strlen(tmp_buf));
-    }
-#endif
-
-    if (level <= g_log_print_level) {
-        /* customer defined log print handler */
-        if (sg_log_message_handler != NULL && sg_log_message_handler(tmp_buf)) {
-            return;
-        }
-
-        /* default log handler: print to console */
-        HAL_Printf("%s", tmp_buf);
-    }
-
-    return;
+    _log_output(level, tmp_buf);
 }
 
 #ifdef __cplusplus
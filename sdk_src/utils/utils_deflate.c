@@ -0,0 +1,246 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils_deflate.h"
+
+#include <string.h>
+
+#include "qcloud_iot_export_error.h"
+#include "qcloud_iot_import.h"
+
+#define DEFLATE_MIN_MATCH  (3)
+#define DEFLATE_MAX_MATCH  (258)
+#define DEFLATE_WINDOW     (32768)
+#define DEFLATE_HASH_SIZE  (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_END_OF_BLK (256)
+#define ADLER32_BASE       (65521)
+
+typedef struct {
+    uint8_t *       buf;
+    size_t          size;
+    size_t          used;
+    uint32_t        bits;
+    int             bit_cnt;
+    int             total;
+    int             err;
+    DeflateOutputCb out_cb;
+    void *          user_data;
+} DeflateOutput;
+
+static const uint16_t sg_len_base[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t  sg_len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const uint16_t sg_dist_base[] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t  sg_dist_extra[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static void _deflate_flush(DeflateOutput *out)
+{
+    if (out->used && !out->err) {
+        out->err = out->out_cb(out->user_data, out->buf, out->used);
+    }
+    out->used = 0;
+}
+
+static void _deflate_put_byte(DeflateOutput *out, uint8_t byte)
+{
+    if (out->used == out->size) {
+        _deflate_flush(out);
+    }
+    out->buf[out->used++] = byte;
+    out->total++;
+}
+
+/* deflate packs data elements starting from the least significant bit */
+static void _deflate_put_bits(DeflateOutput *out, uint32_t value, int bit_cnt)
+{
+    out->bits |= value << out->bit_cnt;
+    out->bit_cnt += bit_cnt;
+    while (out->bit_cnt >= 8) {
+        _deflate_put_byte(out, (uint8_t)out->bits);
+        out->bits >>= 8;
+        out->bit_cnt -= 8;
+    }
+}
+
+/* huffman codes are packed starting from the most significant bit */
+static void _deflate_put_code(DeflateOutput *out, uint32_t code, int bit_cnt)
+{
+    uint32_t rev = 0;
+    int      i;
+
+    for (i = 0; i < bit_cnt; i++) {
+        rev  = (rev << 1) | (code & 1);
+        code = code >> 1;
+    }
+    _deflate_put_bits(out, rev, bit_cnt);
+}
+
+/* fixed literal/length huffman table of RFC1951 3.2.6 */
+static void _deflate_put_symbol(DeflateOutput *out, int sym)
+{
+    if (sym <= 143) {
+        _deflate_put_code(out, 0x30 + sym, 8);
+    } else if (sym <= 255) {
+        _deflate_put_code(out, 0x190 + sym - 144, 9);
+    } else if (sym <= 279) {
+        _deflate_put_code(out, sym - 256, 7);
+    } else {
+        _deflate_put_code(out, 0xC0 + sym - 280, 8);
+    }
+}
+
+static void _deflate_put_match(DeflateOutput *out, int len, int dist)
+{
+    int i;
+
+    for (i = sizeof(sg_len_base) / sizeof(sg_len_base[0]) - 1; sg_len_base[i] > len; i--) {
+    }
+    _deflate_put_symbol(out, 257 + i);
+    _deflate_put_bits(out, len - sg_len_base[i], sg_len_extra[i]);
+
+    for (i = sizeof(sg_dist_base) / sizeof(sg_dist_base[0]) - 1; sg_dist_base[i] > dist; i--) {
+    }
+    _deflate_put_code(out, i, 5);
+    _deflate_put_bits(out, dist - sg_dist_base[i], sg_dist_extra[i]);
+}
+
+static uint32_t _deflate_hash(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+uint32_t utils_adler32(uint32_t adler, const uint8_t *data, size_t len)
+{
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    size_t   n;
+
+    while (len) {
+        /* 5552 is the largest n keeping b below 2^32 before the modulo */
+        n = len < 5552 ? len : 5552;
+        len -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    return (b << 16) | a;
+}
+
+int utils_deflate(const uint8_t *src, size_t src_len, uint8_t *out_buf, size_t out_buf_len, DeflateOutputCb out_cb,
+                  void *user_data)
+{
+    DeflateOutput out;
+    int32_t *     head;
+    size_t        pos = 0;
+    uint32_t      adler;
+
+    if ((src == NULL && src_len) || out_buf == NULL || out_buf_len == 0 || out_cb == NULL) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    head = HAL_Malloc(DEFLATE_HASH_SIZE * sizeof(int32_t));
+    if (head == NULL) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(head, 0xff, DEFLATE_HASH_SIZE * sizeof(int32_t));
+
+    memset(&out, 0, sizeof(out));
+    out.buf       = out_buf;
+    out.size      = out_buf_len;
+    out.out_cb    = out_cb;
+    out.user_data = user_data;
+
+    /* zlib header: deflate with 32K window, fastest level */
+    _deflate_put_byte(&out, 0x78);
+    _deflate_put_byte(&out, 0x01);
+
+    /* single final block with fixed huffman codes */
+    _deflate_put_bits(&out, 1, 1);
+    _deflate_put_bits(&out, 1, 2);
+
+    while (pos < src_len && !out.err) {
+        size_t match_len = 0;
+        size_t match_pos = 0;
+
+        if (pos + DEFLATE_MIN_MATCH <= src_len) {
+            uint32_t h    = _deflate_hash(src + pos);
+            int32_t  cand = head[h];
+
+            head[h] = (int32_t)pos;
+            if (cand >= 0 && pos - cand <= DEFLATE_WINDOW) {
+                size_t max_len = src_len - pos;
+
+                if (max_len > DEFLATE_MAX_MATCH) {
+                    max_len = DEFLATE_MAX_MATCH;
+                }
+                while (match_len < max_len && src[cand + match_len] == src[pos + match_len]) {
+                    match_len++;
+                }
+                match_pos = cand;
+            }
+        }
+
+        if (match_len >= DEFLATE_MIN_MATCH) {
+            size_t end = pos + match_len;
+
+            _deflate_put_match(&out, (int)match_len, (int)(pos - match_pos));
+            for (pos++; pos < end; pos++) {
+                if (pos + DEFLATE_MIN_MATCH <= src_len) {
+                    head[_deflate_hash(src + pos)] = (int32_t)pos;
+                }
+            }
+        } else {
+            _deflate_put_symbol(&out, src[pos]);
+            pos++;
+        }
+    }
+    HAL_Free(head);
+
+    _deflate_put_symbol(&out, DEFLATE_END_OF_BLK);
+    /* pad to byte boundary */
+    _deflate_put_bits(&out, 0, 7);
+    out.bits    = 0;
+    out.bit_cnt = 0;
+
+    adler = utils_adler32(1, src, src_len);
+    _deflate_put_byte(&out, (uint8_t)(adler >> 24));
+    _deflate_put_byte(&out, (uint8_t)(adler >> 16));
+    _deflate_put_byte(&out, (uint8_t)(adler >> 8));
+    _deflate_put_byte(&out, (uint8_t)adler);
+    _deflate_flush(&out);
+
+    return out.err ? out.err : out.total;
+}
+
+#ifdef __cplusplus
+}
+#endif
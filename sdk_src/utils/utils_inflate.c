@@ -0,0 +1,675 @@
+/*
+ * Tencent is pleased to support the open source community by making IoT Hub
+ available.
+ * Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+ * Licensed under the MIT License (the "License"); you may not use this file
+ except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+
+ * Unless required by applicable law or agreed to in writing, software
+ distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND,
+ * either express or implied. See the License for the specific language
+ governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "qcloud_iot_export_error.h"
+#include "qcloud_iot_export_log.h"
+#include "qcloud_iot_import.h"
+#include "utils_deflate.h"
+
+#define INFLATE_MAX_BITS   (15)
+#define INFLATE_MAX_LIT    (288)
+#define INFLATE_MAX_DIST   (30)
+#define INFLATE_MAX_WINDOW (32768)
+
+/* internal step result: input ran out, the step is rolled back and retried with more input */
+#define INFLATE_NEED_INPUT (-1)
+
+typedef enum {
+    INFLATE_ST_HEADER,  // gzip/zlib header, or detection of raw deflate
+    INFLATE_ST_BLOCK,   // block header
+    INFLATE_ST_STORED,  // data of a stored block
+    INFLATE_ST_CODES,   // huffman coded data
+    INFLATE_ST_TRAILER, // gzip/zlib checksum
+    INFLATE_ST_END,
+} InflateState;
+
+typedef enum { INFLATE_RAW, INFLATE_ZLIB, INFLATE_GZIP } InflateFormat;
+
+typedef struct {
+    uint16_t count[INFLATE_MAX_BITS + 1]; // number of codes of each length
+    uint16_t symbol[INFLATE_MAX_LIT];     // symbols ordered by code
+} InflateHuffman;
+
+typedef struct {
+    InflateState   state;
+    InflateFormat  format;
+    bool           last;
+    size_t         max_window;
+    const uint8_t *in;
+    size_t         in_len;
+    size_t         in_pos;
+    uint32_t       bits;
+    int            bit_cnt;
+    uint8_t *      out;
+    size_t         out_len;
+    size_t         out_pos;
+    size_t         check_pos; // out data before it is already in check
+    uint32_t       check;     // adler32 (zlib) or crc32 (gzip) of decompressed data
+    uint32_t       total;     // decompressed size mod 2^32
+    uint8_t *      window;
+    uint32_t       window_mask;
+    uint32_t       window_pos;
+    uint32_t       window_have;
+    uint32_t       stored_left;
+    uint32_t       match_len; // pending match copy, left when out is full
+    uint32_t       match_dist;
+    InflateHuffman lit;
+    InflateHuffman dist;
+} InflateCtx;
+
+static const uint16_t sg_len_base[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t  sg_len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const uint16_t sg_dist_base[] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t  sg_dist_extra[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t _inflate_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    /* half-byte table of the reflected polynomial 0xEDB88320 */
+    static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+static void _inflate_update_check(InflateCtx *ctx)
+{
+    const uint8_t *data = ctx->out + ctx->check_pos;
+    size_t         len  = ctx->out_pos - ctx->check_pos;
+
+    if (ctx->format == INFLATE_ZLIB) {
+        ctx->check = utils_adler32(ctx->check, data, len);
+    } else if (ctx->format == INFLATE_GZIP) {
+        ctx->check = _inflate_crc32(ctx->check, data, len);
+    }
+    ctx->check_pos = ctx->out_pos;
+}
+
+/* deflate packs data elements starting from the least significant bit */
+static bool _inflate_bits(InflateCtx *ctx, int cnt, uint32_t *value)
+{
+    while (ctx->bit_cnt < cnt) {
+        if (ctx->in_pos == ctx->in_len) {
+            return false;
+        }
+        ctx->bits |= (uint32_t)ctx->in[ctx->in_pos++] << ctx->bit_cnt;
+        ctx->bit_cnt += 8;
+    }
+    *value = ctx->bits & ((1u << cnt) - 1);
+    ctx->bits >>= cnt;
+    ctx->bit_cnt -= cnt;
+
+    return true;
+}
+
+static void _inflate_align(InflateCtx *ctx)
+{
+    ctx->bits >>= ctx->bit_cnt & 7;
+    ctx->bit_cnt -= ctx->bit_cnt & 7;
+}
+
+static void _inflate_put(InflateCtx *ctx, uint8_t byte)
+{
+    ctx->out[ctx->out_pos++]     = byte;
+    ctx->window[ctx->window_pos] = byte;
+    ctx->window_pos              = (ctx->window_pos + 1) & ctx->window_mask;
+    if (ctx->window_have <= ctx->window_mask) {
+        ctx->window_have++;
+    }
+    ctx->total++;
+}
+
+/* canonical huffman code from code lengths, returns 0 for a complete code,
+ * > 0 for an incomplete one, < 0 for an over-subscribed one */
+static int _inflate_build(InflateHuffman *h, const uint8_t *lengths, int n)
+{
+    uint16_t offs[INFLATE_MAX_BITS + 1];
+    int      left = 1;
+    int      len, sym;
+
+    memset(h->count, 0, sizeof(h->count));
+    for (sym = 0; sym < n; sym++) {
+        h->count[lengths[sym]]++;
+    }
+    if (h->count[0] == n) {
+        return 0;
+    }
+
+    for (len = 1; len <= INFLATE_MAX_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) {
+            return left;
+        }
+    }
+
+    offs[1] = 0;
+    for (len = 1; len < INFLATE_MAX_BITS; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for (sym = 0; sym < n; sym++) {
+        if (lengths[sym]) {
+            h->symbol[offs[lengths[sym]]++] = sym;
+        }
+    }
+
+    return left;
+}
+
+/* huffman codes are packed starting from the most significant bit */
+static int _inflate_decode(InflateCtx *ctx, const InflateHuffman *h)
+{
+    int      code = 0, first = 0, index = 0;
+    int      len;
+    uint32_t bit;
+
+    for (len = 1; len <= INFLATE_MAX_BITS; len++) {
+        if (!_inflate_bits(ctx, 1, &bit)) {
+            return INFLATE_NEED_INPUT;
+        }
+        code |= bit;
+        if (code - first < h->count[len]) {
+            return h->symbol[index + code - first];
+        }
+        index += h->count[len];
+        first = (first + h->count[len]) << 1;
+        code <<= 1;
+    }
+
+    Log_e("invalid huffman code");
+    return QCLOUD_ERR_FAILURE;
+}
+
+static int _inflate_skip_string(InflateCtx *ctx)
+{
+    uint32_t byte;
+
+    do {
+        if (!_inflate_bits(ctx, 8, &byte)) {
+            return INFLATE_NEED_INPUT;
+        }
+    } while (byte);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_header(InflateCtx *ctx)
+{
+    const uint8_t *p      = ctx->in + ctx->in_pos;
+    size_t         window = ctx->max_window;
+    uint32_t       value, flags, xlen;
+
+    if (ctx->in_len - ctx->in_pos < 2) {
+        return INFLATE_NEED_INPUT;
+    }
+
+    if (p[0] == 0x1f && p[1] == 0x8b) {
+        /* RFC1952: magic, method, flags, mtime, xfl, os and the optional fields */
+        if (ctx->in_len - ctx->in_pos < 10) {
+            return INFLATE_NEED_INPUT;
+        }
+        if (p[2] != 8) {
+            Log_e("unsupported gzip method %d", p[2]);
+            return QCLOUD_ERR_FAILURE;
+        }
+        flags = p[3];
+        ctx->in_pos += 10;
+        if (flags & 0x04) {
+            if (!_inflate_bits(ctx, 16, &xlen)) {
+                return INFLATE_NEED_INPUT;
+            }
+            while (xlen--) {
+                if (!_inflate_bits(ctx, 8, &value)) {
+                    return INFLATE_NEED_INPUT;
+                }
+            }
+        }
+        if ((flags & 0x08) && _inflate_skip_string(ctx) != QCLOUD_RET_SUCCESS) {
+            return INFLATE_NEED_INPUT;
+        }
+        if ((flags & 0x10) && _inflate_skip_string(ctx) != QCLOUD_RET_SUCCESS) {
+            return INFLATE_NEED_INPUT;
+        }
+        if ((flags & 0x02) && !_inflate_bits(ctx, 16, &value)) {
+            return INFLATE_NEED_INPUT;
+        }
+        ctx->format = INFLATE_GZIP;
+        ctx->check  = 0;
+    } else if ((p[0] & 0x0f) == 8 && (p[0] * 256 + p[1]) % 31 == 0) {
+        /* RFC1950: method/window, flags with check bits */
+        if (p[1] & 0x20) {
+            Log_e("zlib preset dictionary not supported");
+            return QCLOUD_ERR_FAILURE;
+        }
+        window = (size_t)1 << ((p[0] >> 4) + 8);
+        if (window > ctx->max_window) {
+            Log_e("zlib window %u larger than %u", (unsigned)window, (unsigned)ctx->max_window);
+            return QCLOUD_ERR_FAILURE;
+        }
+        ctx->in_pos += 2;
+        ctx->format = INFLATE_ZLIB;
+        ctx->check  = 1;
+    } else {
+        ctx->format = INFLATE_RAW;
+    }
+
+    ctx->window = HAL_Malloc(window);
+    if (ctx->window == NULL) {
+        Log_e("malloc inflate window %u failed", (unsigned)window);
+        return QCLOUD_ERR_MALLOC;
+    }
+    ctx->window_mask = window - 1;
+    ctx->state       = INFLATE_ST_BLOCK;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_fixed(InflateCtx *ctx)
+{
+    uint8_t lengths[INFLATE_MAX_LIT];
+    int     sym;
+
+    for (sym = 0; sym < INFLATE_MAX_LIT; sym++) {
+        lengths[sym] = sym < 144 ? 8 : sym < 256 ? 9 : sym < 280 ? 7 : 8;
+    }
+    _inflate_build(&ctx->lit, lengths, INFLATE_MAX_LIT);
+
+    for (sym = 0; sym < INFLATE_MAX_DIST; sym++) {
+        lengths[sym] = 5;
+    }
+    _inflate_build(&ctx->dist, lengths, INFLATE_MAX_DIST);
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_dynamic(InflateCtx *ctx)
+{
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t              lengths[INFLATE_MAX_LIT + INFLATE_MAX_DIST];
+    InflateHuffman       lencode;
+    uint32_t             nlen, ndist, ncode, value;
+    uint32_t             index, rep;
+    int                  sym, len, rc;
+
+    if (!_inflate_bits(ctx, 5, &nlen) || !_inflate_bits(ctx, 5, &ndist) || !_inflate_bits(ctx, 4, &ncode)) {
+        return INFLATE_NEED_INPUT;
+    }
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > 286 || ndist > INFLATE_MAX_DIST) {
+        Log_e("bad dynamic block counts");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    memset(lengths, 0, 19);
+    for (index = 0; index < ncode; index++) {
+        if (!_inflate_bits(ctx, 3, &value)) {
+            return INFLATE_NEED_INPUT;
+        }
+        lengths[order[index]] = value;
+    }
+    if (_inflate_build(&lencode, lengths, 19) != 0) {
+        Log_e("bad code lengths code");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    index = 0;
+    while (index < nlen + ndist) {
+        sym = _inflate_decode(ctx, &lencode);
+        if (sym < 0) {
+            return sym;
+        }
+        if (sym < 16) {
+            lengths[index++] = sym;
+            continue;
+        }
+
+        len = 0;
+        if (sym == 16) {
+            if (index == 0) {
+                Log_e("repeat with no first length");
+                return QCLOUD_ERR_FAILURE;
+            }
+            len = lengths[index - 1];
+            if (!_inflate_bits(ctx, 2, &rep)) {
+                return INFLATE_NEED_INPUT;
+            }
+            rep += 3;
+        } else if (sym == 17) {
+            if (!_inflate_bits(ctx, 3, &rep)) {
+                return INFLATE_NEED_INPUT;
+            }
+            rep += 3;
+        } else {
+            if (!_inflate_bits(ctx, 7, &rep)) {
+                return INFLATE_NEED_INPUT;
+            }
+            rep += 11;
+        }
+        if (index + rep > nlen + ndist) {
+            Log_e("too many code lengths");
+            return QCLOUD_ERR_FAILURE;
+        }
+        while (rep--) {
+            lengths[index++] = len;
+        }
+    }
+
+    if (lengths[256] == 0) {
+        Log_e("no end-of-block code");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    /* an incomplete code is only allowed for a single length */
+    rc = _inflate_build(&ctx->lit, lengths, nlen);
+    if (rc < 0 || (rc > 0 && nlen - ctx->lit.count[0] != 1)) {
+        Log_e("bad literal/length code");
+        return QCLOUD_ERR_FAILURE;
+    }
+    rc = _inflate_build(&ctx->dist, lengths + nlen, ndist);
+    if (rc < 0 || (rc > 0 && ndist - ctx->dist.count[0] != 1)) {
+        Log_e("bad distance code");
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_block(InflateCtx *ctx)
+{
+    uint32_t last, type, len, nlen;
+    int      rc;
+
+    if (!_inflate_bits(ctx, 1, &last) || !_inflate_bits(ctx, 2, &type)) {
+        return INFLATE_NEED_INPUT;
+    }
+
+    switch (type) {
+        case 0:
+            _inflate_align(ctx);
+            if (!_inflate_bits(ctx, 16, &len) || !_inflate_bits(ctx, 16, &nlen)) {
+                return INFLATE_NEED_INPUT;
+            }
+            if (len != (~nlen & 0xffff)) {
+                Log_e("stored block length mismatch");
+                return QCLOUD_ERR_FAILURE;
+            }
+            ctx->stored_left = len;
+            ctx->state       = INFLATE_ST_STORED;
+            break;
+        case 1:
+            _inflate_fixed(ctx);
+            ctx->state = INFLATE_ST_CODES;
+            break;
+        case 2:
+            rc = _inflate_dynamic(ctx);
+            if (rc != QCLOUD_RET_SUCCESS) {
+                return rc;
+            }
+            ctx->state = INFLATE_ST_CODES;
+            break;
+        default:
+            Log_e("invalid block type");
+            return QCLOUD_ERR_FAILURE;
+    }
+    ctx->last = last;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_codes(InflateCtx *ctx)
+{
+    uint32_t len, dist;
+    int      sym;
+
+    sym = _inflate_decode(ctx, &ctx->lit);
+    if (sym < 0) {
+        return sym;
+    }
+    if (sym < 256) {
+        _inflate_put(ctx, sym);
+        return QCLOUD_RET_SUCCESS;
+    }
+    if (sym == 256) {
+        ctx->state = ctx->last ? INFLATE_ST_TRAILER : INFLATE_ST_BLOCK;
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    sym -= 257;
+    if (sym >= sizeof(sg_len_base) / sizeof(sg_len_base[0])) {
+        Log_e("invalid length symbol");
+        return QCLOUD_ERR_FAILURE;
+    }
+    if (!_inflate_bits(ctx, sg_len_extra[sym], &len)) {
+        return INFLATE_NEED_INPUT;
+    }
+    len += sg_len_base[sym];
+
+    sym = _inflate_decode(ctx, &ctx->dist);
+    if (sym < 0) {
+        return sym;
+    }
+    if (sym >= INFLATE_MAX_DIST) {
+        Log_e("invalid distance symbol");
+        return QCLOUD_ERR_FAILURE;
+    }
+    if (!_inflate_bits(ctx, sg_dist_extra[sym], &dist)) {
+        return INFLATE_NEED_INPUT;
+    }
+    dist += sg_dist_base[sym];
+    if (dist > ctx->window_have) {
+        Log_e("distance %u too far back", (unsigned)dist);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    ctx->match_len  = len;
+    ctx->match_dist = dist;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+static int _inflate_trailer(InflateCtx *ctx)
+{
+    uint32_t value[2] = {0, 0};
+    uint32_t byte;
+    int      i;
+
+    _inflate_align(ctx);
+    if (ctx->format == INFLATE_ZLIB) {
+        /* adler32, big endian */
+        for (i = 0; i < 4; i++) {
+            if (!_inflate_bits(ctx, 8, &byte)) {
+                return INFLATE_NEED_INPUT;
+            }
+            value[0] = (value[0] << 8) | byte;
+        }
+        value[1] = ctx->total;
+    } else if (ctx->format == INFLATE_GZIP) {
+        /* crc32 and size mod 2^32, little endian */
+        for (i = 0; i < 8; i++) {
+            if (!_inflate_bits(ctx, 8, &byte)) {
+                return INFLATE_NEED_INPUT;
+            }
+            value[i / 4] |= byte << (8 * (i % 4));
+        }
+    } else {
+        value[1] = ctx->total;
+    }
+
+    _inflate_update_check(ctx);
+    if (ctx->format != INFLATE_RAW && (value[0] != ctx->check || value[1] != ctx->total)) {
+        Log_e("inflate check mismatch: %08x/%u, expected %08x/%u", (unsigned)ctx->check, (unsigned)ctx->total,
+              (unsigned)value[0], (unsigned)value[1]);
+        return QCLOUD_ERR_FAILURE;
+    }
+    ctx->state = INFLATE_ST_END;
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+void *utils_inflate_init(size_t max_window)
+{
+    InflateCtx *ctx;
+
+    if (max_window < 256 || max_window > INFLATE_MAX_WINDOW || (max_window & (max_window - 1))) {
+        Log_e("invalid inflate window %u", (unsigned)max_window);
+        return NULL;
+    }
+
+    ctx = HAL_Malloc(sizeof(InflateCtx));
+    if (ctx == NULL) {
+        Log_e("malloc inflate ctx failed");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(InflateCtx));
+    ctx->max_window = max_window;
+
+    return ctx;
+}
+
+int utils_inflate(void *handle, const uint8_t *in, size_t in_len, size_t *in_used, uint8_t *out, size_t out_len,
+                  size_t *out_produced)
+{
+    InflateCtx *ctx = (InflateCtx *)handle;
+    int         rc  = QCLOUD_RET_SUCCESS;
+
+    if (ctx == NULL || (in == NULL && in_len) || (out == NULL && out_len) || in_used == NULL ||
+        out_produced == NULL) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    ctx->in        = in;
+    ctx->in_len    = in_len;
+    ctx->in_pos    = 0;
+    ctx->out       = out;
+    ctx->out_len   = out_len;
+    ctx->out_pos   = 0;
+    ctx->check_pos = 0;
+
+    while (rc == QCLOUD_RET_SUCCESS && ctx->state != INFLATE_ST_END) {
+        size_t   in_pos  = ctx->in_pos;
+        uint32_t bits    = ctx->bits;
+        int      bit_cnt = ctx->bit_cnt;
+
+        if (ctx->match_len) {
+            if (ctx->out_pos == ctx->out_len) {
+                break;
+            }
+            while (ctx->match_len && ctx->out_pos < ctx->out_len) {
+                _inflate_put(ctx, ctx->window[(ctx->window_pos - ctx->match_dist) & ctx->window_mask]);
+                ctx->match_len--;
+            }
+            continue;
+        }
+
+        switch (ctx->state) {
+            case INFLATE_ST_HEADER:
+                rc = _inflate_header(ctx);
+                break;
+            case INFLATE_ST_BLOCK:
+                rc = _inflate_block(ctx);
+                break;
+            case INFLATE_ST_STORED:
+                /* bit buffer is empty after the byte aligned stored block header */
+                if (ctx->stored_left == 0) {
+                    ctx->state = ctx->last ? INFLATE_ST_TRAILER : INFLATE_ST_BLOCK;
+                } else if (ctx->out_pos == ctx->out_len) {
+                    rc = INFLATE_NEED_INPUT;
+                } else if (ctx->in_pos == ctx->in_len) {
+                    rc = INFLATE_NEED_INPUT;
+                } else {
+                    while (ctx->stored_left && ctx->out_pos < ctx->out_len && ctx->in_pos < ctx->in_len) {
+                        _inflate_put(ctx, ctx->in[ctx->in_pos++]);
+                        ctx->stored_left--;
+                    }
+                }
+                break;
+            case INFLATE_ST_CODES:
+                if (ctx->out_pos == ctx->out_len) {
+                    rc = INFLATE_NEED_INPUT;
+                } else {
+                    rc = _inflate_codes(ctx);
+                }
+                break;
+            case INFLATE_ST_TRAILER:
+                rc = _inflate_trailer(ctx);
+                break;
+            default:
+                break;
+        }
+
+        if (rc == INFLATE_NEED_INPUT) {
+            /* undo the partial step, it is redone when more input or output space is given */
+            ctx->in_pos  = in_pos;
+            ctx->bits    = bits;
+            ctx->bit_cnt = bit_cnt;
+            rc           = QCLOUD_RET_SUCCESS;
+            break;
+        }
+    }
+
+    if (ctx->state != INFLATE_ST_HEADER) {
+        _inflate_update_check(ctx);
+    }
+    *in_used      = ctx->in_pos;
+    *out_produced = ctx->out_pos;
+
+    if (rc != QCLOUD_RET_SUCCESS) {
+        return rc;
+    }
+
+    return ctx->state == INFLATE_ST_END ? INFLATE_STREAM_END : QCLOUD_RET_SUCCESS;
+}
+
+void utils_inflate_deinit(void *handle)
+{
+    InflateCtx *ctx = (InflateCtx *)handle;
+
+    if (ctx) {
+        if (ctx->window) {
+            HAL_Free(ctx->window);
+        }
+        HAL_Free(ctx);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -95,3 +95,139 @@ int ring_buff_pop_data(sRingbuff *ring_buff, uint8_t *pData, int len)
 
     return i;
 }
+
+/*
+ * head/tail are published with release stores and read with acquire loads so
+ * the bytes copied before an index update are visible to the other side.
+ * Toolchains without the GCC builtins fall back to volatile word access,
+ * which is enough on the single core MCUs they target.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define SPSC_LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SPSC_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define SPSC_LOAD_ACQUIRE(p)     (*(p))
+#define SPSC_STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+
+int spsc_ring_buff_init(sSpscRingbuff *ring_buff, void *buff, uint32_t size)
+{
+    if (!ring_buff || !buff || !size || (size & (size - 1))) {
+        return RINGBUFF_ERR;
+    }
+
+    ring_buff->buffer = (uint8_t *)buff;
+    ring_buff->size   = size;
+    ring_buff->mask   = size - 1;
+    ring_buff->head   = 0;
+    ring_buff->tail   = 0;
+
+    return RINGBUFF_OK;
+}
+
+void spsc_ring_buff_flush(sSpscRingbuff *ring_buff)
+{
+    SPSC_STORE_RELEASE(&ring_buff->tail, SPSC_LOAD_ACQUIRE(&ring_buff->head));
+}
+
+uint32_t spsc_ring_buff_used(sSpscRingbuff *ring_buff)
+{
+    return SPSC_LOAD_ACQUIRE(&ring_buff->head) - SPSC_LOAD_ACQUIRE(&ring_buff->tail);
+}
+
+uint32_t spsc_ring_buff_free(sSpscRingbuff *ring_buff)
+{
+    return ring_buff->size - spsc_ring_buff_used(ring_buff);
+}
+
+uint32_t spsc_ring_buff_push(sSpscRingbuff *ring_buff, const void *pData, uint32_t len)
+{
+    uint32_t head  = ring_buff->head;
+    uint32_t tail  = SPSC_LOAD_ACQUIRE(&ring_buff->tail);
+    uint32_t space = ring_buff->size - (head - tail);
+    uint32_t off   = head & ring_buff->mask;
+    uint32_t first;
+
+    if (len > space) {
+        len = space;
+    }
+    if (!len) {
+        return 0;
+    }
+
+    first = ring_buff->size - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring_buff->buffer + off, pData, first);
+    memcpy(ring_buff->buffer, (const uint8_t *)pData + first, len - first);
+
+    SPSC_STORE_RELEASE(&ring_buff->head, head + len);
+
+    return len;
+}
+
+uint32_t spsc_ring_buff_pop(sSpscRingbuff *ring_buff, void *pData, uint32_t len)
+{
+    uint32_t tail  = ring_buff->tail;
+    uint32_t head  = SPSC_LOAD_ACQUIRE(&ring_buff->head);
+    uint32_t avail = head - tail;
+    uint32_t off   = tail & ring_buff->mask;
+    uint32_t first;
+
+    if (len > avail) {
+        len = avail;
+    }
+    if (!len) {
+        return 0;
+    }
+
+    first = ring_buff->size - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(pData, ring_buff->buffer + off, first);
+    memcpy((uint8_t *)pData + first, ring_buff->buffer, len - first);
+
+    SPSC_STORE_RELEASE(&ring_buff->tail, tail + len);
+
+    return len;
+}
+
+uint32_t spsc_ring_buff_reserve(sSpscRingbuff *ring_buff, uint8_t **ppData)
+{
+    uint32_t head  = ring_buff->head;
+    uint32_t space = ring_buff->size - (head - SPSC_LOAD_ACQUIRE(&ring_buff->tail));
+    uint32_t off   = head & ring_buff->mask;
+
+    if (space > ring_buff->size - off) {
+        space = ring_buff->size - off;
+    }
+    *ppData = ring_buff->buffer + off;
+
+    return space;
+}
+
+void spsc_ring_buff_commit(sSpscRingbuff *ring_buff, uint32_t len)
+{
+    SPSC_STORE_RELEASE(&ring_buff->head, ring_buff->head + len);
+}
+
+uint32_t spsc_ring_buff_peek(sSpscRingbuff *ring_buff, const uint8_t **ppData)
+{
+    uint32_t tail  = ring_buff->tail;
+    uint32_t avail = SPSC_LOAD_ACQUIRE(&ring_buff->head) - tail;
+    uint32_t off   = tail & ring_buff->mask;
+
+    if (avail > ring_buff->size - off) {
+        avail = ring_buff->size - off;
+    }
+    *ppData = ring_buff->buffer + off;
+
+    return avail;
+}
+
+void spsc_ring_buff_consume(sSpscRingbuff *ring_buff, uint32_t len)
+{
+    SPSC_STORE_RELEASE(&ring_buff->tail, ring_buff->tail + len);
+}